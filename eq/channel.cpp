@@ -53,6 +53,7 @@
 #include <eq/util/accum.h>
 #include <eq/util/objectManager.h>
 #include <eq/fabric/commands.h>
+#include <eq/fabric/equalizerTypes.h>
 #include <eq/fabric/frameData.h>
 #include <eq/fabric/task.h>
 #include <eq/fabric/tile.h>
@@ -62,6 +63,7 @@
 #include <co/objectICommand.h>
 #include <co/queueSlave.h>
 #include <co/sendToken.h>
+#include <lunchbox/omp.h>
 #include <lunchbox/rng.h>
 #include <lunchbox/scopedMutex.h>
 #include <pression/plugins/compressor.h>
@@ -71,7 +73,9 @@
 #  include <GLStats/GLStats.h>
 #endif
 
+#include <algorithm>
 #include <bitset>
+#include <deque>
 #include <set>
 
 #include "detail/channel.ipp"
@@ -457,6 +461,12 @@ void Channel::_overrideContext( RenderContext& context )
     window->_addRenderContext( context );
 }
 
+RenderContext Channel::_readContext( co::ObjectICommand& command )
+{
+    _impl->lastContext.deserialize( command );
+    return _impl->lastContext;
+}
+
 Frustumf Channel::getScreenFrustum() const
 {
     const Pixel& pixel = getPixel();
@@ -488,11 +498,12 @@ const View* Channel::getView() const
     return pipe->getView( getContext().view );
 }
 
-co::QueueSlave* Channel::_getQueue( const uint128_t& queueID )
+co::QueueSlave* Channel::_getQueue( const uint128_t& queueID,
+                                   const uint32_t batchSize )
 {
     LB_TS_THREAD( _pipeThread );
     Pipe* pipe = getPipe();
-    return pipe->getQueue( queueID );
+    return pipe->getQueue( queueID, batchSize );
 }
 
 View* Channel::getNativeView()
@@ -531,6 +542,23 @@ void Channel::removeResultImageListener( ResultImageListener* listener )
     _impl->removeResultImageListener( listener );
 }
 
+void Channel::setDumpImageDrop( const bool drop )
+{
+    typedef detail::FileFrameWriter Writer;
+    _impl->frameWriter.setPolicy( drop ? Writer::POLICY_DROP :
+                                         Writer::POLICY_BLOCK );
+}
+
+size_t Channel::getNumDumpedImages() const
+{
+    return _impl->frameWriter.getNumWritten();
+}
+
+size_t Channel::getNumDroppedImages() const
+{
+    return _impl->frameWriter.getNumDropped();
+}
+
 std::string Channel::getDumpImageFileName() const
 {
     std::stringstream name;
@@ -1035,7 +1063,8 @@ private:
 typedef lunchbox::RefPtr< detail::RBStat > RBStatPtr;
 
 void Channel::_frameTiles( RenderContext& context, const bool isLocal,
-                           const uint128_t& queueID, const uint32_t tasks,
+                           const std::vector< uint128_t >& queueIDs,
+                           const uint32_t batchSize, const uint32_t tasks,
                            const co::ObjectVersions& frameIDs )
 {
     _overrideContext( context );
@@ -1049,20 +1078,46 @@ void Channel::_frameTiles( RenderContext& context, const bool isLocal,
         stat = new detail::RBStat( this );
     }
 
-    int64_t startTime = getConfig()->getTime();
+    const int64_t startTime = getConfig()->getTime();
     int64_t clearTime = 0;
-    int64_t drawTime = 0;
     int64_t readbackTime = 0;
+    int64_t waitTime = 0;
+    int64_t stealTime = 0;
+    uint32_t nRequests = 0;
+    uint32_t nStolen = 0;
     bool hasAsyncReadback = false;
     const uint32_t timeout = getConfig()->getTimeout();
 
-    co::QueueSlave* queue = _getQueue( queueID );
-    LBASSERT( queue );
-    for( ;; )
+    // Async readbacks of the last tiles are finished only after the next tiles
+    // are drawn, overlapping the download with rendering. The compression and
+    // transmission of finished tiles runs on the transmit thread.
+    const size_t depth = _getTilePipelineDepth();
+    std::deque< AsyncImages > pending;
+
+    // The first queue holds the tile range of this node, taken in batches.
+    // The others are the ranges of the other nodes, stolen one tile at a time.
+    size_t current = 0;
+    co::QueueSlave* queue = queueIDs.empty() ? 0 :
+                            _getQueue( queueIDs.front(), batchSize );
+    while( queue )
     {
+        const int64_t waitStart = getConfig()->getTime();
         co::ObjectICommand tileCmd = queue->pop( timeout );
+        const int64_t waited = getConfig()->getTime() - waitStart;
+        ++nRequests;
+        waitTime += waited;
+        if( current > 0 )
+            stealTime += waited;
+
         if( !tileCmd.isValid( ))
-            break;
+        {
+            if( ++current >= queueIDs.size( ))
+                break;
+            queue = _getQueue( queueIDs[ current ], 1 );
+            continue;
+        }
+        if( current > 0 )
+            ++nStolen;
 
         const Tile& tile = tileCmd.read< Tile >();
         context.apply( tile, isLocal );
@@ -1077,9 +1132,9 @@ void Channel::_frameTiles( RenderContext& context, const bool isLocal,
 
         if( tasks & fabric::TASK_DRAW )
         {
-            const int64_t time = getConfig()->getTime();
+            // sampled per tile, used by the tile equalizer to adapt the size
+            ChannelStatistics event( Statistic::CHANNEL_DRAW, this );
             frameDraw( context.frameID );
-            drawTime += getConfig()->getTime() - time;
             // Set to full region if application has declared nothing
             if( !getRegion().isValid( ))
                 declareRegion( getPixelViewport( ));
@@ -1099,7 +1154,6 @@ void Channel::_frameTiles( RenderContext& context, const bool isLocal,
             }
 
             frameReadback( context.frameID, frames );
-            readbackTime += getConfig()->getTime() - time;
 
             for( size_t i = 0; i < nFrames; ++i )
             {
@@ -1114,32 +1168,57 @@ void Channel::_frameTiles( RenderContext& context, const bool isLocal,
                 }
             }
 
-            if( _asyncFinishReadback( nImages, frames ))
+            if( depth > 1 )
+            {
+                pending.push_back( AsyncImages( ));
+                _asyncFinishReadback( nImages, frames, &pending.back( ));
+                while( pending.size() >= depth )
+                {
+                    _finishTileReadback( pending.front( ));
+                    pending.pop_front();
+                }
+            }
+            else if( _asyncFinishReadback( nImages, frames ))
                 hasAsyncReadback = true;
+            readbackTime += getConfig()->getTime() - time;
         }
     }
 
+    if( !pending.empty( ))
+    {
+        const int64_t time = getConfig()->getTime();
+        for( const AsyncImages& images : pending )
+            _finishTileReadback( images );
+        readbackTime += getConfig()->getTime() - time;
+    }
+
     if( tasks & fabric::TASK_CLEAR )
     {
         ChannelStatistics event( Statistic::CHANNEL_CLEAR, this );
         event.event.data.statistic.startTime = startTime;
-        startTime += clearTime;
-        event.event.data.statistic.endTime = startTime;
+        event.event.data.statistic.endTime = startTime + clearTime;
     }
 
-    if( tasks & fabric::TASK_DRAW )
     {
-        ChannelStatistics event( Statistic::CHANNEL_DRAW, this );
+        ChannelStatistics event( Statistic::CHANNEL_TILES_WAIT, this );
         event.event.data.statistic.startTime = startTime;
-        startTime += drawTime;
-        event.event.data.statistic.endTime = startTime;
+        event.event.data.statistic.endTime = startTime + waitTime;
+        event.event.data.statistic.count = nRequests;
+    }
+
+    if( nStolen > 0 )
+    {
+        ChannelStatistics event( Statistic::CHANNEL_TILES_STEAL, this );
+        event.event.data.statistic.startTime = startTime;
+        event.event.data.statistic.endTime = startTime + stealTime;
+        event.event.data.statistic.count = nStolen;
     }
 
     if( tasks & fabric::TASK_READBACK )
     {
-        stat->event.event.data.statistic.startTime = startTime;
-        startTime += readbackTime;
-        stat->event.event.data.statistic.endTime = startTime;
+        const int64_t endTime = getConfig()->getTime();
+        stat->event.event.data.statistic.startTime = endTime - readbackTime;
+        stat->event.event.data.statistic.endTime = endTime;
 
         _setReady( hasAsyncReadback, stat.get(), frames );
     }
@@ -1212,7 +1291,8 @@ void Channel::_frameReadback( const uint128_t& frameID,
 }
 
 bool Channel::_asyncFinishReadback( const std::vector< size_t >& imagePos,
-                                    const Frames& frames )
+                                    const Frames& frames,
+                                    AsyncImages* deferred )
 {
     LB_TS_THREAD( _pipeThread );
 
@@ -1238,6 +1318,12 @@ bool Channel::_asyncFinishReadback( const std::vector< size_t >& imagePos,
         {
             if( images[j]->hasAsyncReadback( )) // finish async readback
             {
+                if( deferred )
+                {
+                    deferred->push_back( std::make_pair( frame, size_t( j )));
+                    continue;
+                }
+
                 _createTransferWindow();
 
                 hasAsyncReadback = true;
@@ -1255,6 +1341,42 @@ bool Channel::_asyncFinishReadback( const std::vector< size_t >& imagePos,
     return hasAsyncReadback;
 }
 
+void Channel::_finishTileReadback( const AsyncImages& images )
+{
+    const uint32_t frameNumber = getCurrentFrame();
+    const Eye eye = getEye();
+
+    for( const std::pair< Frame*, size_t >& i : images )
+    {
+        Frame* frame = i.first;
+        FrameDataPtr frameData = frame->getFrameData();
+        Image* image = frameData->getImages()[ i.second ];
+        LBASSERT( image->hasAsyncReadback( ));
+
+        image->finishReadback( glewGetContext( ));
+        _asyncTransmit( frameData, frameNumber, i.second,
+                        frame->getInputNodes( eye ),
+                        frame->getInputNetNodes( eye ), getTaskID( ));
+    }
+}
+
+size_t Channel::_getTilePipelineDepth() const
+{
+    // An explicit depth of 1 can't be told apart from ON, which pipelines
+    // two tiles. OFF is the only way to disable pipelining.
+    const int32_t depth = getIAttribute( IATTR_HINT_TILE_PIPELINE );
+    switch( depth )
+    {
+    case OFF:
+        return 1;
+    case ON: // == 1
+    case AUTO:
+        return 2; // draw the next tile while the last one is downloaded
+    default:
+        return depth > 1 ? size_t( depth ) : 1;
+    }
+}
+
 void Channel::_finishReadback( const co::ObjectVersion& frameDataVersion,
                                const uint64_t imageIndex,
                                const uint32_t frameNumber,
@@ -1309,6 +1431,26 @@ void Channel::_asyncTransmit( FrameDataPtr frame, const uint32_t frameNumber,
     }
 }
 
+namespace detail
+{
+/** The compression statistic of one row band, gathered without locking. */
+struct BandStat
+{
+    BandStat() : startTime( 0 ), endTime( 0 ), uncompressed( 0 )
+               , compressed( 0 )
+    {
+        plugins[0] = EQ_COMPRESSOR_NONE;
+        plugins[1] = EQ_COMPRESSOR_NONE;
+    }
+
+    int64_t startTime;
+    int64_t endTime;
+    uint64_t uncompressed;
+    uint64_t compressed;
+    uint32_t plugins[2];
+};
+}
+
 void Channel::_transmitImage( const co::ObjectVersion& frameDataVersion,
                               const uint128_t& nodeID,
                               const co::NodeID& netNodeID,
@@ -1355,7 +1497,114 @@ void Channel::_transmitImage( const co::ObjectVersion& frameDataVersion,
 
     // use compression on links up to 2 GBit/s
     const bool useCompression = ( description->bandwidth <= 262144 );
+    const size_t nBands = useCompression ? _getNumTransmitBands( *image ) : 1;
+
+    if( nBands == 1 )
+    {
+        _transmitBand( frameDataVersion, nodeID, toNode, *image, 0, 1,
+                       useCompression, true /* acquire send token */,
+                       frameNumber, taskID, 0 );
+        return;
+    }
+
+    // Large images are split into row bands, which are compressed concurrently
+    // and sent as soon as they are ready. The receiver adds each band as a
+    // separate image, and can decompress it while later bands are in transit.
+    //
+    // Bands of depth images without any foreground pixel are not sent. They
+    // would not change the destination of the depth-based assembly.
+    const bool useSpans = image->computeSpans();
+    const int32_t height = image->getPixelViewport().h;
 
+    co::LocalNode::SendToken token;
+    if( getIAttribute( IATTR_HINT_SENDTOKEN ) == ON )
+    {
+        ChannelStatistics waitEvent( Statistic::CHANNEL_FRAME_WAIT_SENDTOKEN,
+                                     this, frameNumber );
+        waitEvent.event.data.statistic.task = taskID;
+        token = getLocalNode()->acquireSendToken( toNode );
+    }
+
+    // Statistics are not thread-safe, each band records its compression in
+    // its own slot, and one statistic is emitted for the image below.
+    std::vector< detail::BandStat > bandStats( nBands );
+
+#pragma omp parallel for schedule( dynamic )
+    for( int64_t i = 0; i < int64_t( nBands ); ++i )
+    {
+        if( useSpans &&
+            image->isBackground( int32_t( height * i / int64_t( nBands )),
+                                 int32_t( height * ( i + 1 ) /
+                                          int64_t( nBands ))))
+        {
+            continue;
+        }
+        _transmitBand( frameDataVersion, nodeID, toNode, *image, size_t( i ),
+                       nBands, true, false, frameNumber, taskID,
+                       &bandStats[ i ] );
+    }
+
+    detail::BandStat total;
+    for( const detail::BandStat& stat : bandStats )
+    {
+        if( stat.endTime == 0 ) // background band
+            continue;
+
+        if( total.endTime == 0 || stat.startTime < total.startTime )
+            total.startTime = stat.startTime;
+        total.endTime = std::max( total.endTime, stat.endTime );
+        total.uncompressed += stat.uncompressed;
+        total.compressed += stat.compressed;
+        for( unsigned j = 0; j < 2; ++j )
+            if( total.plugins[j] == EQ_COMPRESSOR_NONE )
+                total.plugins[j] = stat.plugins[j];
+    }
+    if( total.endTime == 0 )
+        return;
+
+    ChannelStatistics compressEvent( Statistic::CHANNEL_FRAME_COMPRESS, this,
+                                     frameNumber );
+    Statistic& statistic = compressEvent.event.data.statistic;
+    statistic.task = taskID;
+    statistic.startTime = total.startTime;
+    statistic.endTime = total.endTime;
+    statistic.ratio = total.uncompressed > 0 ?
+        float( total.compressed ) / float( total.uncompressed ) : 1.0f;
+    statistic.plugins[0] = total.plugins[0];
+    statistic.plugins[1] = total.plugins[1];
+}
+
+size_t Channel::_getNumTransmitBands( const Image& image ) const
+{
+    static const int32_t minBandHeight = 64;
+
+    const PixelViewport& pvp = image.getPixelViewport();
+    const Frame::Buffer buffers[] = { Frame::BUFFER_COLOR,
+                                      Frame::BUFFER_DEPTH };
+    for( const Frame::Buffer buffer : buffers )
+    {
+        // color and depth bands have to cover the same rows
+        if( image.hasPixelData( buffer ) &&
+            image.getPixelData( buffer ).pvp != pvp )
+        {
+            return 1;
+        }
+    }
+
+    // two bands per thread for load balancing
+    const size_t maxBands = size_t( pvp.h / minBandHeight );
+    const size_t nBands = lunchbox::OMP::getNThreads() * 2;
+    return std::max( size_t( 1 ), std::min( nBands, maxBands ));
+}
+
+void Channel::_transmitBand( const co::ObjectVersion& frameDataVersion,
+                             const uint128_t& nodeID, co::NodePtr toNode,
+                             Image& image, const size_t band,
+                             const size_t nBands, const bool useCompression,
+                             const bool acquireToken,
+                             const uint32_t frameNumber, const uint32_t taskID,
+                             detail::BandStat* bandStat )
+{
     std::vector< const PixelData* > pixelDatas;
     std::vector< float > qualities;
 
@@ -1365,7 +1614,9 @@ void Channel::_transmitImage( const co::ObjectVersion& frameDataVersion,
         uint64_t rawSize( 0 );
         ChannelStatistics compressEvent( Statistic::CHANNEL_FRAME_COMPRESS,
                                          this, frameNumber,
-                                         useCompression ? AUTO : OFF );
+                                         useCompression && !bandStat ?
+                                         AUTO : OFF );
+        const int64_t compressStart = bandStat ? getConfig()->getTime() : 0;
         compressEvent.event.data.statistic.task = taskID;
         compressEvent.event.data.statistic.ratio = 1.0f;
         compressEvent.event.data.statistic.plugins[0] = EQ_COMPRESSOR_NONE;
@@ -1378,17 +1629,19 @@ void Channel::_transmitImage( const co::ObjectVersion& frameDataVersion,
         for( unsigned j = 0; j < 2; ++j )
         {
             Frame::Buffer buffer = buffers[j];
-            if( image->hasPixelData( buffer ))
+            if( image.hasPixelData( buffer ))
             {
                 // format, type, nChunks, compressor name
                 imageDataSize += sizeof( FrameData::ImageHeader );
 
-                const PixelData& data = useCompression ?
-                    image->compressPixelData( buffer ) :
-                    image->getPixelData( buffer );
+                const PixelData& data = !useCompression ?
+                    image.getPixelData( buffer ) : nBands == 1 ?
+                    image.compressPixelData( buffer ) :
+                    image.compressPixelData( buffer, band, nBands );
                 pixelDatas.push_back( &data );
-                qualities.push_back( image->getQuality( buffer ));
+                qualities.push_back( image.getQuality( buffer ));
 
+                const uint64_t dataSize = data.pvp.getArea() * data.pixelSize;
                 if( data.compressedData.isCompressed( ))
                 {
                     imageDataSize += data.compressedData.getSize() +
@@ -1397,17 +1650,29 @@ void Channel::_transmitImage( const co::ObjectVersion& frameDataVersion,
                         data.compressedData.compressor;
                 }
                 else
-                    imageDataSize += sizeof( uint64_t ) +
-                                     image->getPixelDataSize( buffer );
+                    imageDataSize += sizeof( uint64_t ) + dataSize;
 
                 commandBuffers |= buffer;
-                rawSize += image->getPixelDataSize( buffer );
+                rawSize += dataSize;
             }
         }
 
         if( rawSize > 0 )
             compressEvent.event.data.statistic.ratio =
                 float( imageDataSize ) / float( rawSize );
+
+        if( bandStat && rawSize > 0 )
+        {
+            bandStat->startTime = compressStart;
+            bandStat->endTime = std::max( getConfig()->getTime(),
+                                          compressStart + 1 );
+            bandStat->uncompressed = rawSize;
+            bandStat->compressed = imageDataSize;
+            bandStat->plugins[0] =
+                compressEvent.event.data.statistic.plugins[0];
+            bandStat->plugins[1] =
+                compressEvent.event.data.statistic.plugins[1];
+        }
     }
 
     if( pixelDatas.empty( ))
@@ -1415,22 +1680,26 @@ void Channel::_transmitImage( const co::ObjectVersion& frameDataVersion,
 
     // send image pixel data command
     co::LocalNode::SendToken token;
-    if( getIAttribute( IATTR_HINT_SENDTOKEN ) == ON )
+    if( acquireToken && getIAttribute( IATTR_HINT_SENDTOKEN ) == ON )
     {
         ChannelStatistics waitEvent( Statistic::CHANNEL_FRAME_WAIT_SENDTOKEN,
                                      this, frameNumber );
         waitEvent.event.data.statistic.task = taskID;
         token = getLocalNode()->acquireSendToken( toNode );
     }
-    LBASSERT( image->getPixelViewport().isValid( ));
 
+    const PixelViewport& pvp = nBands == 1 ? image.getPixelViewport() :
+                                             pixelDatas.front()->pvp;
+    LBASSERT( pvp.isValid( ));
+
+    co::ConnectionPtr connection = toNode->getConnection();
     co::ObjectOCommand command( co::Connections( 1, connection ),
                                 fabric::CMD_NODE_FRAMEDATA_TRANSMIT,
                                 co::COMMANDTYPE_OBJECT, nodeID,
                                 CO_INSTANCE_ALL );
-    command << frameDataVersion << image->getPixelViewport() << image->getZoom()
-            << image->getContext() << commandBuffers << frameNumber
-            << image->getAlphaUsage();
+    command << frameDataVersion << pvp << image.getZoom()
+            << image.getContext() << commandBuffers << frameNumber
+            << image.getAlphaUsage();
     command.sendHeader( imageDataSize );
 
 #ifndef NDEBUG
@@ -1607,6 +1876,7 @@ bool Channel::_cmdConfigInit( co::ICommand& cmd )
 
     LBLOG( LOG_INIT ) << "TASK channel config init " << command << std::endl;
 
+    _impl->lastContext = RenderContext(); // server resets on config init
     const Config* config = getConfig();
     changeLatency( config->getLatency( ));
 
@@ -1656,7 +1926,7 @@ bool Channel::_cmdFrameStart( co::ICommand& cmd )
 {
     co::ObjectICommand command( cmd );
 
-    RenderContext context = command.read< RenderContext >();
+    RenderContext context = _readContext( command );
     const uint128_t& version = command.read< uint128_t >();
     const uint32_t frameNumber = command.read< uint32_t >();
 
@@ -1685,7 +1955,7 @@ bool Channel::_cmdFrameFinish( co::ICommand& cmd )
 {
     co::ObjectICommand command( cmd );
 
-    RenderContext context = command.read< RenderContext >();
+    RenderContext context = _readContext( command );
     const uint32_t frameNumber = command.read< uint32_t >();
 
     LBLOG( LOG_TASKS ) << "TASK frame finish " << getName() <<  " " << command
@@ -1704,7 +1974,7 @@ bool Channel::_cmdFrameClear( co::ICommand& cmd )
     LBASSERT( _impl->state == STATE_RUNNING );
 
     co::ObjectICommand command( cmd );
-    RenderContext context  = command.read< RenderContext >();
+    RenderContext context = _readContext( command );
 
     LBLOG( LOG_TASKS ) << "TASK clear " << getName() <<  " " << command
                        << " " << context << std::endl;
@@ -1722,7 +1992,7 @@ bool Channel::_cmdFrameClear( co::ICommand& cmd )
 bool Channel::_cmdFrameDraw( co::ICommand& cmd )
 {
     co::ObjectICommand command( cmd );
-    RenderContext context  = command.read< RenderContext >();
+    RenderContext context = _readContext( command );
     const bool finish = command.read< bool >();
 
     LBLOG( LOG_TASKS ) << "TASK draw " << getName() <<  " " << command
@@ -1731,6 +2001,12 @@ bool Channel::_cmdFrameDraw( co::ICommand& cmd )
     bindDrawFrameBuffer();
     _overrideContext( context );
     const uint32_t frameNumber = getCurrentFrame();
+    if( context.qualityStage != fabric::QUALITY_NONE )
+    {
+        ChannelStatistics quality( Statistic::CHANNEL_QUALITY, this );
+        quality.event.data.statistic.count = context.qualityStage;
+        quality.event.data.statistic.ratio = context.qualityRatio;
+    }
     ChannelStatistics event( Statistic::CHANNEL_DRAW, this, frameNumber,
                              finish ? NICEST : AUTO );
 
@@ -1766,7 +2042,7 @@ bool Channel::_cmdFrameDrawFinish( co::ICommand& cmd )
 bool Channel::_cmdFrameAssemble( co::ICommand& cmd )
 {
     co::ObjectICommand command( cmd );
-    RenderContext context = command.read< RenderContext >();
+    RenderContext context = _readContext( command );
     const co::ObjectVersions& frameIDs = command.read< co::ObjectVersions >();
 
     LBLOG( LOG_TASKS | LOG_ASSEMBLY )
@@ -1786,7 +2062,7 @@ bool Channel::_cmdFrameAssemble( co::ICommand& cmd )
 bool Channel::_cmdFrameReadback( co::ICommand& cmd )
 {
     co::ObjectICommand command( cmd );
-    RenderContext context = command.read< RenderContext >();
+    RenderContext context = _readContext( command );
     const co::ObjectVersions& frames = command.read< co::ObjectVersions >();
     LBLOG( LOG_TASKS | LOG_ASSEMBLY ) << "TASK readback " << getName() <<  " "
                                       << command << " " << context<< " nFrames "
@@ -1900,7 +2176,7 @@ bool Channel::_cmdFrameSetReadyNode( co::ICommand& cmd )
 bool Channel::_cmdFrameViewStart( co::ICommand& cmd )
 {
     co::ObjectICommand command( cmd );
-    RenderContext context = command.read< RenderContext >();
+    RenderContext context = _readContext( command );
 
     LBLOG( LOG_TASKS ) << "TASK view start " << getName() <<  " " << command
                        << " " << context << std::endl;
@@ -1915,7 +2191,7 @@ bool Channel::_cmdFrameViewStart( co::ICommand& cmd )
 bool Channel::_cmdFrameViewFinish( co::ICommand& cmd )
 {
     co::ObjectICommand command( cmd );
-    RenderContext context = command.read< RenderContext >();
+    RenderContext context = _readContext( command );
 
     LBLOG( LOG_TASKS ) << "TASK view finish " << getName() <<  " " << command
                        << " " << context << std::endl;
@@ -1944,16 +2220,18 @@ bool Channel::_cmdStopFrame( co::ICommand& cmd )
 bool Channel::_cmdFrameTiles( co::ICommand& cmd )
 {
     co::ObjectICommand command( cmd );
-    RenderContext context = command.read< RenderContext >();
+    RenderContext context = _readContext( command );
     const bool isLocal = command.read< bool >();
-    const uint128_t& queueID = command.read< uint128_t >();
+    const std::vector< uint128_t >& queueIDs =
+        command.read< std::vector< uint128_t > >();
+    const uint32_t batchSize = command.read< uint32_t >();
     const uint32_t tasks = command.read< uint32_t >();
     const co::ObjectVersions& frames = command.read< co::ObjectVersions >();
 
     LBLOG( LOG_TASKS ) << "TASK channel frame tiles " << getName() <<  " "
                        << command << " " << context << std::endl;
 
-    _frameTiles( context, isLocal, queueID, tasks, frames );
+    _frameTiles( context, isLocal, queueIDs, batchSize, tasks, frames );
     return true;
 }
 
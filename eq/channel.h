@@ -27,7 +27,7 @@
 
 namespace eq
 {
-namespace detail { class Channel; struct RBStat; }
+namespace detail { class Channel; struct RBStat; struct BandStat; }
 
 /**
  * A channel represents a two-dimensional viewport within a Window.
@@ -399,6 +399,32 @@ public:
      */
     EQ_API virtual std::string getDumpImageFileName() const;
 
+    /**
+     * Set the behaviour when the images of SATTR_DUMP_IMAGE are produced
+     * faster than they can be written.
+     *
+     * By default, the render thread waits for a free image buffer. When drop
+     * is set, the image is not written instead. The initial value is true if
+     * the environment variable EQ_DUMP_IMAGE_DROP is set.
+     *
+     * @param drop true to drop images, false to wait for the writer.
+     * @version 1.13
+     */
+    EQ_API void setDumpImageDrop( bool drop );
+
+    /**
+     * @return the number of images written for SATTR_DUMP_IMAGE.
+     * @version 1.13
+     */
+    EQ_API size_t getNumDumpedImages() const;
+
+    /**
+     * @return the number of images of SATTR_DUMP_IMAGE dropped because the
+     *         writer could not keep up.
+     * @version 1.13
+     */
+    EQ_API size_t getNumDroppedImages() const;
+
 protected:
     /** @internal */
     EQ_API void attach( const uint128_t& id, const uint32_t instanceID );
@@ -622,12 +648,16 @@ private:
     /** Setup the current rendering context. */
     void _overrideContext( RenderContext& context );
 
+    /** @return the render context sent as a delta by the server. */
+    RenderContext _readContext( co::ObjectICommand& command );
+
     /** Initialize the channel's drawable config. */
     void _initDrawableConfig();
 
     /** Tile render loop. */
     void _frameTiles( RenderContext& context, const bool isLocal,
-                      const uint128_t& queueID, const uint32_t tasks,
+                      const std::vector< uint128_t >& queueIDs,
+                      const uint32_t batchSize, const uint32_t tasks,
                       const co::ObjectVersions& frames );
 
     /** Reference the frame for an async operation. */
@@ -644,6 +674,23 @@ private:
                          const uint32_t frameNumber,
                          const uint32_t taskID );
 
+    /** @return the number of row bands used to transmit the image. */
+    size_t _getNumTransmitBands( const Image& image ) const;
+
+    /**
+     * Compress and send one row band of an image to one node.
+     *
+     * Without a band statistic, the compression statistic is emitted
+     * directly. Otherwise it is gathered in the given band statistic, and
+     * emitted by the caller once for the whole image.
+     */
+    void _transmitBand( const co::ObjectVersion& frameDataVersion,
+                        const uint128_t& nodeID, co::NodePtr toNode,
+                        Image& image, size_t band, size_t nBands,
+                        bool useCompression, bool acquireToken,
+                        uint32_t frameNumber, uint32_t taskID,
+                        detail::BandStat* bandStat );
+
     void _frameReadback( const uint128_t& frameID,
                          const co::ObjectVersions& frames );
     void _finishReadback( const co::ObjectVersion& frameDataVersion,
@@ -653,8 +700,18 @@ private:
                           const std::vector< uint128_t >& nodes,
                           const co::NodeIDs& netNodes );
 
+    /** Images of a frame with an async readback, finished by the caller. */
+    typedef std::vector< std::pair< Frame*, size_t > > AsyncImages;
+
     bool _asyncFinishReadback( const std::vector< size_t >& imagePos,
-                               const Frames& frames );
+                               const Frames& frames,
+                               AsyncImages* deferred = 0 );
+
+    /** Finish the deferred readback of a tile and transmit its images. */
+    void _finishTileReadback( const AsyncImages& images );
+
+    /** @return the number of tiles in flight in the tile render loop. */
+    size_t _getTilePipelineDepth() const;
 
     void _asyncTransmit( FrameDataPtr frame, const uint32_t frameNumber,
                          const uint64_t image,
@@ -673,7 +730,8 @@ private:
                     const co::NodeIDs& netNodes );
 
     /** Getsthe channel's current input queue. */
-    co::QueueSlave* _getQueue( const uint128_t& queueID );
+    co::QueueSlave* _getQueue( const uint128_t& queueID,
+                               const uint32_t batchSize );
 
     Frames _getFrames( const co::ObjectVersions& frameIDs,
                        const bool isOutput );
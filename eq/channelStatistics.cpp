@@ -58,7 +58,10 @@ ChannelStatistics::ChannelStatistics( const Statistic::Type type,
         type != Statistic::CHANNEL_ASYNC_READBACK &&
         type != Statistic::CHANNEL_FRAME_TRANSMIT &&
         type != Statistic::CHANNEL_FRAME_COMPRESS &&
-        type != Statistic::CHANNEL_FRAME_WAIT_SENDTOKEN )
+        type != Statistic::CHANNEL_FRAME_WAIT_SENDTOKEN &&
+        type != Statistic::CHANNEL_TILES_WAIT &&
+        type != Statistic::CHANNEL_TILES_STEAL &&
+        type != Statistic::CHANNEL_QUALITY )
     {
         channel->getWindow()->finish();
     }
@@ -77,7 +80,10 @@ ChannelStatistics::~ChannelStatistics()
         type != Statistic::CHANNEL_ASYNC_READBACK &&
         type != Statistic::CHANNEL_FRAME_TRANSMIT &&
         type != Statistic::CHANNEL_FRAME_COMPRESS &&
-        type != Statistic::CHANNEL_FRAME_WAIT_SENDTOKEN )
+        type != Statistic::CHANNEL_FRAME_WAIT_SENDTOKEN &&
+        type != Statistic::CHANNEL_TILES_WAIT &&
+        type != Statistic::CHANNEL_TILES_STEAL &&
+        type != Statistic::CHANNEL_QUALITY )
     {
         _owner->getWindow()->finish();
     }
@@ -35,6 +35,8 @@
 #include "window.h"
 #include "windowSystem.h"
 
+#include "detail/cpuCompositor.h"
+
 #include <eq/util/accum.h>
 #include <eq/util/objectManager.h>
 #include <eq/util/shader.h>
@@ -45,6 +47,8 @@
 #include <lunchbox/os.h>
 #include <pression/plugins/compressor.h>
 
+#include <algorithm>
+
 using lunchbox::Monitor;
 
 namespace eq
@@ -112,6 +116,15 @@ bool _useCPUAssembly( const Image* image, CPUAssemblyFormat& format )
     case EQ_COMPRESSOR_DATATYPE_BGRA:
         break;
 
+    case EQ_COMPRESSOR_DATATYPE_RGBA16F:
+    case EQ_COMPRESSOR_DATATYPE_BGRA16F:
+    case EQ_COMPRESSOR_DATATYPE_RGBA32F:
+    case EQ_COMPRESSOR_DATATYPE_BGRA32F:
+        if( hasDepth )
+            // depth-compositing of float colors not implemented
+            return false;
+        break;
+
     default:
         return false;
     }
@@ -269,150 +282,386 @@ bool _collectOutputData( const ImageOps& ops, PixelViewport& destPVP,
     return destPVP.hasArea();
 }
 
-void _mergeDBImage( void* destColor, void* destDepth,
-                    const PixelViewport& destPVP, const Image* image,
-                    const Vector2i& offset )
+enum MergeMode
 {
-    LBASSERT( destColor && destDepth );
-
-    LBVERB << "CPU-DB assembly" << std::endl;
-
-    uint32_t* destC = reinterpret_cast< uint32_t* >( destColor );
-    uint32_t* destD = reinterpret_cast< uint32_t* >( destDepth );
+    MERGE_DB,    //!< depth-based merge of color and depth
+    MERGE_BLEND, //!< alpha-blending of color
+    MERGE_2D     //!< copy color, clear depth
+};
 
-    const PixelViewport&  pvp    = image->getPixelViewport();
+MergeMode _getMergeMode( const ImageOp& op, const bool blend )
+{
+    if( op.image->hasPixelData( Frame::BUFFER_DEPTH ))
+        return MERGE_DB;
+    if( blend && op.image->hasAlpha( ))
+        return MERGE_BLEND;
+    return MERGE_2D;
+}
 
-    const int32_t         destX  = offset.x() + pvp.x - destPVP.x;
-    const int32_t         destY  = offset.y() + pvp.y - destPVP.y;
+/** The destination of a CPU merge operation. */
+struct MergeTarget
+{
+    MergeTarget( void* color_, void* depth_, const PixelViewport& pvp_,
+                 const size_t pixelSize_ )
+        : color( reinterpret_cast< uint8_t* >( color_ ))
+        , depth( reinterpret_cast< uint8_t* >( depth_ ))
+        , pvp( pvp_ )
+        , pixelSize( pixelSize_ )
+    {}
+
+    uint8_t* const color;
+    uint8_t* const depth;
+    const PixelViewport pvp;
+    const size_t pixelSize; //!< color pixel size, depth is always 4 bytes
+};
 
-    const uint32_t* color = reinterpret_cast< const uint32_t* >
-        ( image->getPixelPointer( Frame::BUFFER_COLOR ));
-    const uint32_t* depth = reinterpret_cast< const uint32_t* >
-        ( image->getPixelPointer( Frame::BUFFER_DEPTH ));
+/** Merge row y (in image coordinates) of the given image into the target. */
+void _mergeRow( const MergeMode mode, const MergeTarget& target,
+                const Image* image, const Vector2i& offset, const int32_t y )
+{
+    const PixelViewport& pvp = image->getPixelViewport();
+    const int32_t destX = offset.x() + pvp.x - target.pvp.x;
+    const int32_t destY = offset.y() + pvp.y - target.pvp.y;
+    const size_t destPixel = size_t( destY + y ) * target.pvp.w + destX;
+    const size_t srcPixel = size_t( y ) * pvp.w;
 
-#pragma omp parallel for
-    for( int32_t y = 0; y < pvp.h; ++y )
+    switch( mode )
+    {
+    case MERGE_DB:
     {
-        const uint32_t skip =  (destY + y) * destPVP.w + destX;
-        uint32_t* destColorIt = destC + skip;
-        uint32_t* destDepthIt = destD + skip;
-        const uint32_t* colorIt = color + y * pvp.w;
-        const uint32_t* depthIt = depth + y * pvp.w;
+        LBASSERT( target.color && target.depth );
+        const uint32_t* color = reinterpret_cast< const uint32_t* >
+            ( image->getPixelPointer( Frame::BUFFER_COLOR ));
+        const uint32_t* depth = reinterpret_cast< const uint32_t* >
+            ( image->getPixelPointer( Frame::BUFFER_DEPTH ));
+        uint32_t* destColor = reinterpret_cast< uint32_t* >( target.color ) +
+                              destPixel;
+        uint32_t* destDepth = reinterpret_cast< uint32_t* >( target.depth ) +
+                              destPixel;
+
+        if( !image->hasSpans( ))
+        {
+            detail::cpuCompositor::mergeDepth( destColor, destDepth,
+                                               color + srcPixel,
+                                               depth + srcPixel, pvp.w );
+            return;
+        }
 
-        for( int32_t x = 0; x < pvp.w; ++x )
+        // background pixels never pass the depth test, skip them
+        size_t nSpans = 0;
+        const Vector2i* spans = image->getSpans( y, nSpans );
+        for( size_t i = 0; i < nSpans; ++i )
         {
-            if( *destDepthIt > *depthIt )
-            {
-                *destColorIt = *colorIt;
-                *destDepthIt = *depthIt;
-            }
+            const int32_t x = spans[i].x();
+            detail::cpuCompositor::mergeDepth( destColor + x, destDepth + x,
+                                               color + srcPixel + x,
+                                               depth + srcPixel + x,
+                                               spans[i].y() - x );
+        }
+        return;
+    }
 
-            ++destColorIt;
-            ++destDepthIt;
-            ++colorIt;
-            ++depthIt;
+    case MERGE_BLEND:
+    {
+        // Blending of two slices, none of which is on final image (i.e.
+        // result could be blended on to something else) should be performed
+        // with: glBlendFuncSeparate( GL_ONE, GL_SRC_ALPHA, GL_ZERO,
+        // GL_SRC_ALPHA ) which means:
+        // dstColor = 1*srcColor + srcAlpha*dstColor
+        // dstAlpha = 0*srcAlpha + srcAlpha*dstAlpha
+        // because we accumulate light which is go through (= 1-Alpha) and we
+        // already have colors as Alpha*Color
+        LBASSERT( image->hasAlpha( ));
+        const size_t pixelSize = image->getPixelSize( Frame::BUFFER_COLOR );
+        const uint8_t* src = image->getPixelPointer( Frame::BUFFER_COLOR ) +
+                             srcPixel * pixelSize;
+        uint8_t* dst = target.color + destPixel * pixelSize;
+
+        switch( image->getExternalFormat( Frame::BUFFER_COLOR ))
+        {
+        case EQ_COMPRESSOR_DATATYPE_RGBA16F:
+        case EQ_COMPRESSOR_DATATYPE_BGRA16F:
+            LBASSERT( pixelSize == 8 );
+            detail::cpuCompositor::blendRGBA16F(
+                reinterpret_cast< uint16_t* >( dst ),
+                reinterpret_cast< const uint16_t* >( src ), pvp.w );
+            return;
+
+        case EQ_COMPRESSOR_DATATYPE_RGBA32F:
+        case EQ_COMPRESSOR_DATATYPE_BGRA32F:
+            LBASSERT( pixelSize == 16 );
+            detail::cpuCompositor::blendRGBA32F(
+                reinterpret_cast< float* >( dst ),
+                reinterpret_cast< const float* >( src ), pvp.w );
+            return;
+
+        default:
+            LBASSERT( pixelSize == 4 );
+            detail::cpuCompositor::blendRGBA8(
+                reinterpret_cast< uint32_t* >( dst ),
+                reinterpret_cast< const uint32_t* >( src ), pvp.w );
+            return;
         }
     }
+
+    case MERGE_2D:
+    {
+        const size_t pixelSize = image->getPixelSize( Frame::BUFFER_COLOR );
+        const uint8_t* color = image->getPixelPointer( Frame::BUFFER_COLOR );
+        const size_t rowLength = pvp.w * pixelSize;
+
+        memcpy( target.color + destPixel * pixelSize,
+                color + srcPixel * pixelSize, rowLength );
+        // clear depth, for depth-assembly into existing FB
+        if( target.depth )
+            lunchbox::setZero( target.depth + destPixel * 4, pvp.w * 4 );
+        return;
+    }
+    }
 }
 
-void _merge2DImage( void* destColor, void* destDepth,
-                    const eq::PixelViewport& destPVP, const Image* image,
-                    const Vector2i& offset )
+/** Merge one image after another, each one parallelized over its rows. */
+void _mergeImagesSequential( const ImageOps& ops, const bool blend,
+                             const MergeTarget& target )
 {
-    // This is mostly copy&paste code from _mergeDBImage :-/
-    LBVERB << "CPU-2D assembly" << std::endl;
+    for( const ImageOp& op : ops )
+    {
+        if( !op.image->hasPixelData( Frame::BUFFER_COLOR ))
+            continue;
 
-    uint8_t* destC = reinterpret_cast< uint8_t* >( destColor );
-    uint8_t* destD = reinterpret_cast< uint8_t* >( destDepth );
+        const MergeMode mode = _getMergeMode( op, blend );
+        const int32_t height = op.image->getPixelViewport().h;
+        LBVERB << "CPU-" << ( mode == MERGE_DB ? "DB" :
+                              mode == MERGE_BLEND ? "Blend" : "2D" )
+               << " assembly" << std::endl;
 
-    const PixelViewport&  pvp    = image->getPixelViewport();
-    const int32_t         destX  = offset.x() + pvp.x - destPVP.x;
-    const int32_t         destY  = offset.y() + pvp.y - destPVP.y;
+#pragma omp parallel for
+        for( int32_t y = 0; y < height; ++y )
+            _mergeRow( mode, target, op.image, op.offset, y );
+    }
+}
 
-    LBASSERT( image->hasPixelData( Frame::BUFFER_COLOR ));
+/**
+ * Merge all images band by band. Each thread owns a band of destination rows
+ * and merges all inputs, in order, into it, which keeps the destination band
+ * in the cache.
+ */
+void _mergeImagesBands( const ImageOps& ops, const bool blend,
+                        const MergeTarget& target )
+{
+    // aim for destination bands fitting into a per-core L2 cache
+    static const size_t bandSize = 256 * 1024;
+    const size_t rowSize = target.pvp.w *
+                           ( target.pixelSize + ( target.depth ? 4 : 0 ));
+    const int32_t bandHeight = int32_t(
+        std::max( size_t( 1 ), std::min( bandSize / rowSize,
+                                         size_t( target.pvp.h ))));
+    const int32_t nBands = ( target.pvp.h + bandHeight - 1 ) / bandHeight;
+
+#pragma omp parallel for schedule( dynamic )
+    for( int32_t band = 0; band < nBands; ++band )
+    {
+        const int32_t bandStart = target.pvp.y + band * bandHeight;
+        const int32_t bandEnd = std::min( bandStart + bandHeight,
+                                          target.pvp.getYEnd( ));
+
+        for( const ImageOp& op : ops )
+        {
+            if( !op.image->hasPixelData( Frame::BUFFER_COLOR ))
+                continue;
+
+            // image rows overlapping this band
+            const PixelViewport& pvp = op.image->getPixelViewport();
+            const int32_t imageY = pvp.y + op.offset.y();
+            const int32_t start = std::max( bandStart, imageY ) - imageY;
+            const int32_t end = std::min( bandEnd, imageY + pvp.h ) - imageY;
+
+            const MergeMode mode = _getMergeMode( op, blend );
+            for( int32_t y = start; y < end; ++y )
+                _mergeRow( mode, target, op.image, op.offset, y );
+        }
+    }
+}
 
-    const uint8_t*   color = image->getPixelPointer( Frame::BUFFER_COLOR );
-    const size_t pixelSize = image->getPixelSize( Frame::BUFFER_COLOR );
-    const size_t rowLength = pvp.w * pixelSize;
+/** An intermediate depth image of the tree reduction. */
+struct DepthLayer
+{
+    PixelViewport pvp;
+    std::vector< uint32_t > color;
+    std::vector< uint32_t > depth;
+};
 
-#pragma omp parallel for
-    for( int32_t y = 0; y < pvp.h; ++y )
+/** Depth-merge rows of a layer into the target, in destination coordinates. */
+void _mergeLayer( const DepthLayer& layer, const int32_t start,
+                  const int32_t end, const MergeTarget& target )
+{
+    for( int32_t y = start; y < end; ++y )
     {
-        const size_t skip = ( (destY + y) * destPVP.w + destX ) * pixelSize;
-        memcpy( destC + skip, color + y * pvp.w * pixelSize, rowLength);
-        // clear depth, for depth-assembly into existing FB
-        if( destD )
-            lunchbox::setZero( destD + skip, rowLength );
+        const size_t src = size_t( y ) * layer.pvp.w;
+        const size_t dst = size_t( layer.pvp.y - target.pvp.y + y ) *
+                           target.pvp.w + layer.pvp.x - target.pvp.x;
+
+        detail::cpuCompositor::mergeDepth(
+            reinterpret_cast< uint32_t* >( target.color ) + dst,
+            reinterpret_cast< uint32_t* >( target.depth ) + dst,
+            &layer.color[ src ], &layer.depth[ src ], layer.pvp.w );
     }
 }
 
-void _blendImage( void* dest, const eq::PixelViewport& destPVP,
-                  const Image* image, const Vector2i& offset )
+/**
+ * Depth-merge the images pairwise in a binary tree. All pairs of one tree
+ * level are merged in parallel into thread-local layers, the root layer is
+ * finally gathered into the destination.
+ *
+ * Depth merging is associative if ties resolve to the earlier input, so the
+ * result is identical to the sequential merge. Only valid if all inputs have
+ * depth.
+ */
+void _mergeImagesTree( const ImageOps& ops, const MergeTarget& target )
 {
-    LBVERB << "CPU-Blend assembly" << std::endl;
+    // Layers start at the far plane. Their initial color is irrelevant, since
+    // pixels at the far plane are never merged into the next level.
 
-    int32_t* destColor = reinterpret_cast< int32_t* >( dest );
+    // leaves: each input merged into its own layer
+    std::vector< DepthLayer > layers( ops.size( ));
+#pragma omp parallel for schedule( dynamic )
+    for( int32_t i = 0; i < int32_t( ops.size( )); ++i )
+    {
+        const ImageOp& op = ops[i];
+        DepthLayer& layer = layers[i];
+        layer.pvp = op.image->getPixelViewport() + op.offset;
+        layer.color.assign( layer.pvp.getArea(), 0 );
+        layer.depth.assign( layer.pvp.getArea(), 0xffffffffu );
+
+        const MergeTarget leaf( layer.color.data(), layer.depth.data(),
+                                layer.pvp, 4 );
+        for( int32_t y = 0; y < layer.pvp.h; ++y )
+            _mergeRow( MERGE_DB, leaf, op.image, op.offset, y );
+    }
 
-    const PixelViewport&  pvp    = image->getPixelViewport();
-    const int32_t         destX  = offset.x() + pvp.x - destPVP.x;
-    const int32_t         destY  = offset.y() + pvp.y - destPVP.y;
+    // reduce pairwise until one layer is left
+    while( layers.size() > 1 )
+    {
+        const int32_t nPairs = int32_t( layers.size() / 2 );
+        std::vector< DepthLayer > next( ( layers.size() + 1 ) / 2 );
 
-    LBASSERT( image->getPixelSize( Frame::BUFFER_COLOR ) == 4 );
-    LBASSERT( image->hasPixelData( Frame::BUFFER_COLOR ));
-    LBASSERT( image->hasAlpha( ));
+#pragma omp parallel for schedule( dynamic )
+        for( int32_t i = 0; i < nPairs; ++i )
+        {
+            const DepthLayer& left = layers[ 2 * i ];
+            const DepthLayer& right = layers[ 2 * i + 1 ];
+            DepthLayer& layer = next[i];
+
+            layer.pvp = left.pvp;
+            layer.pvp.merge( right.pvp );
+            layer.color.assign( layer.pvp.getArea(), 0 );
+            layer.depth.assign( layer.pvp.getArea(), 0xffffffffu );
+
+            const MergeTarget pair( layer.color.data(), layer.depth.data(),
+                                    layer.pvp, 4 );
+            _mergeLayer( left, 0, left.pvp.h, pair );
+            _mergeLayer( right, 0, right.pvp.h, pair );
+        }
+        if( layers.size() % 2 )
+            next.back() = std::move( layers.back( ));
+        layers.swap( next );
+    }
 
-    const int32_t* color = reinterpret_cast< const int32_t* >
-                               ( image->getPixelPointer( Frame::BUFFER_COLOR ));
+    // final gather of the root layer, parallel over its rows
+    const DepthLayer& root = layers.front();
+#pragma omp parallel for
+    for( int32_t y = 0; y < root.pvp.h; ++y )
+        _mergeLayer( root, y, y + 1, target );
+}
 
-    // Blending of two slices, none of which is on final image (i.e. result
-    // could be blended on to something else) should be performed with:
-    // glBlendFuncSeparate( GL_ONE, GL_SRC_ALPHA, GL_ZERO, GL_SRC_ALPHA )
-    // which means:
-    // dstColor = 1*srcColor + srcAlpha*dstColor
-    // dstAlpha = 0*srcAlpha + srcAlpha*dstAlpha
-    // because we accumulate light which is go through (= 1-Alpha) and we
-    // already have colors as Alpha*Color
+bool _canMergeTree( const ImageOps& ops, const MergeTarget& target )
+{
+    if( !target.depth || target.pixelSize != 4 || ops.size() < 2 )
+        return false;
 
-    int32_t* destColorStart = destColor + destY*destPVP.w + destX;
-    const uint32_t step = sizeof( int32_t );
+    for( const ImageOp& op : ops )
+        if( !op.image->hasPixelData( Frame::BUFFER_COLOR ) ||
+            _getMergeMode( op, false ) != MERGE_DB )
+        {
+            return false;
+        }
+    return true;
+}
 
-#pragma omp parallel for
-    for( int32_t y = 0; y < pvp.h; ++y )
+/**
+ * @return true if all images are copied and together cover the destination,
+ *         that is, if the destination does not need to be cleared.
+ */
+bool _isCoveredBy2D( const ImageOps& ops, const bool blend,
+                     const PixelViewport& destPVP )
+{
+    std::vector< PixelViewport > pvps;
+    std::vector< int32_t > rows;
+    for( const ImageOp& op : ops )
     {
-        const unsigned char* src =
-            reinterpret_cast< const uint8_t* >( color + pvp.w * y );
-        unsigned char*       dst =
-            reinterpret_cast< uint8_t* >( destColorStart + destPVP.w * y );
+        if( !op.image->hasPixelData( Frame::BUFFER_COLOR ))
+            continue;
+        if( _getMergeMode( op, blend ) != MERGE_2D )
+            return false;
 
-        for( int32_t x = 0; x < pvp.w; ++x )
-        {
-            dst[0] = LB_MIN( src[0] + (src[3]*dst[0] >> 8), 255 );
-            dst[1] = LB_MIN( src[1] + (src[3]*dst[1] >> 8), 255 );
-            dst[2] = LB_MIN( src[2] + (src[3]*dst[2] >> 8), 255 );
-            dst[3] =                   src[3]*dst[3] >> 8;
+        pvps.push_back( op.image->getPixelViewport() + op.offset );
+        rows.push_back( pvps.back().y );
+        rows.push_back( pvps.back().getYEnd( ));
+    }
+    std::sort( rows.begin(), rows.end( ));
+    rows.erase( std::unique( rows.begin(), rows.end( )), rows.end( ));
+
+    // for each group of rows between two image edges, the images covering
+    // the group have to cover the full destination width
+    std::vector< Vector2i > columns;
+    for( size_t i = 1; i < rows.size(); ++i )
+    {
+        columns.clear();
+        for( const PixelViewport& pvp : pvps )
+            if( pvp.y <= rows[i-1] && pvp.getYEnd() >= rows[i] )
+                columns.push_back( Vector2i( pvp.x, pvp.getXEnd( )));
+
+        std::sort( columns.begin(), columns.end(),
+                   []( const Vector2i& a, const Vector2i& b )
+                       { return a.x() < b.x(); } );
 
-            src += step;
-            dst += step;
+        int32_t x = destPVP.x;
+        for( const Vector2i& column : columns )
+        {
+            if( column.x() > x )
+                return false;
+            x = std::max( x, column.y( ));
         }
+        if( x < destPVP.getXEnd( ))
+            return false;
     }
+    return !rows.empty();
 }
 
-void _mergeImages( const ImageOps& ops, const bool blend, void* colorBuffer,
-                   void* depthBuffer, const PixelViewport& destPVP )
+void _mergeImages( const ImageOps& ops, const bool blend,
+                   Compositor::MergeStrategy strategy,
+                   const MergeTarget& target )
 {
-    for( const ImageOp& op : ops )
+    if( strategy == Compositor::MERGE_TREE && !_canMergeTree( ops, target ))
+        strategy = Compositor::MERGE_BANDS;
+
+    switch( strategy )
     {
-        if( !op.image->hasPixelData( Frame::BUFFER_COLOR ))
-            continue;
+    case Compositor::MERGE_SEQUENTIAL:
+        _mergeImagesSequential( ops, blend, target );
+        return;
 
-        if( op.image->hasPixelData( Frame::BUFFER_DEPTH ))
-            _mergeDBImage( colorBuffer, depthBuffer, destPVP, op.image,
-                           op.offset );
-        else if( blend && op.image->hasAlpha( ))
-            _blendImage( colorBuffer, destPVP, op.image, op.offset );
-        else
-            _merge2DImage( colorBuffer, depthBuffer, destPVP, op.image,
-                           op.offset );
+    case Compositor::MERGE_TREE:
+        LBVERB << "CPU-DB tree assembly" << std::endl;
+        _mergeImagesTree( ops, target );
+        return;
+
+    case Compositor::MERGE_BANDS:
+    case Compositor::MERGE_AUTO:
+    default:
+        LBVERB << "CPU banded assembly" << std::endl;
+        _mergeImagesBands( ops, blend, target );
+        return;
     }
 }
 
@@ -1039,6 +1288,12 @@ const Image* Compositor::mergeFramesCPU( const Frames& frames, const bool blend,
 }
 
 const Image* Compositor::mergeImagesCPU( const ImageOps& ops, const bool blend )
+{
+    return mergeImagesCPU( ops, blend, MERGE_AUTO );
+}
+
+const Image* Compositor::mergeImagesCPU( const ImageOps& ops, const bool blend,
+                                         const MergeStrategy strategy )
 {
     LBVERB << "Sorted CPU assembly" << std::endl;
 
@@ -1067,12 +1322,17 @@ const Image* Compositor::mergeImagesCPU( const ImageOps& ops, const bool blend )
 
     result->setPixelViewport( destPVP );
 
+    // The result image keeps its memory between calls. Clear it only if some
+    // pixels are not overwritten by the merge.
     PixelData colorPixels;
     colorPixels.internalFormat = colorInt;
     colorPixels.externalFormat = colorExt;
     colorPixels.pixelSize      = colorPixelSize;
     colorPixels.pvp            = destPVP;
-    result->setPixelData( Frame::BUFFER_COLOR, colorPixels );
+    if( depthInt == 0 && _isCoveredBy2D( ops, blend, destPVP ))
+        result->allocPixelData( Frame::BUFFER_COLOR, colorPixels );
+    else
+        result->setPixelData( Frame::BUFFER_COLOR, colorPixels );
 
     void* destDepth = 0;
     if( depthInt != 0 ) // at least one depth assembly
@@ -1089,8 +1349,9 @@ const Image* Compositor::mergeImagesCPU( const ImageOps& ops, const bool blend )
     }
 
     // assembly
-    _mergeImages( ops, blend, result->getPixelPointer( Frame::BUFFER_COLOR ),
-                  destDepth, destPVP );
+    const MergeTarget target( result->getPixelPointer( Frame::BUFFER_COLOR ),
+                              destDepth, destPVP, colorPixelSize );
+    _mergeImages( ops, blend, strategy, target );
     return result;
 }
 
@@ -42,6 +42,23 @@ namespace eq
 class EQ_API Compositor
 {
 public:
+    /** The algorithm used to merge images on the CPU. @version 1.13 */
+    enum MergeStrategy
+    {
+        /** One image after another, each parallelized over its rows. */
+        MERGE_SEQUENTIAL,
+        /**
+         * Each thread merges all images into one band of destination rows.
+         */
+        MERGE_BANDS,
+        /**
+         * Pairwise depth merges in parallel, followed by a final gather. Falls
+         * back to MERGE_BANDS unless all images have color and depth.
+         */
+        MERGE_TREE,
+        MERGE_AUTO //!< Use the fastest strategy, currently MERGE_BANDS
+    };
+
     /** @name Frame-based operations. */
     //@{
     /**
@@ -125,6 +142,18 @@ public:
                                const uint32_t timeout = LB_TIMEOUT_INDEFINITE );
     static const Image* mergeImagesCPU( const ImageOps& ops, const bool blend );
 
+    /**
+     * Merge the provided images in the given order into one image in main
+     * memory, using the given merge strategy.
+     *
+     * All strategies produce the same result. The returned image is valid
+     * until the next usage of the compositor in the current thread.
+     *
+     * @version 1.13
+     */
+    static const Image* mergeImagesCPU( const ImageOps& ops, const bool blend,
+                                        MergeStrategy strategy );
+
     /**
      * Assemble a frame into the frame buffer using the default algorithm.
      * @version 1.0
@@ -38,6 +38,7 @@
 #include "window.h"
 
 #include <eq/fabric/commands.h>
+#include <eq/fabric/equalizerTypes.h>
 #include <eq/fabric/task.h>
 
 #include <co/object.h>
@@ -801,6 +802,9 @@ void Config::addStatistic( const uint32_t originator LB_UNUSED,
           item.thread = THREAD_ASYNC2;
           // no break;
       case Statistic::CHANNEL_FRAME_WAIT_READY:
+      case Statistic::CHANNEL_TILES_WAIT:
+      case Statistic::CHANNEL_TILES_STEAL:
+      case Statistic::CHANNEL_QUALITY:
           type.group = "channel";
           item.layer = 1;
           break;
@@ -891,6 +895,20 @@ void Config::addStatistic( const uint32_t originator LB_UNUSED,
           item.text = text.str();
           break;
       }
+      case Statistic::CHANNEL_QUALITY:
+      {
+          std::stringstream text;
+          switch( stat.count )
+          {
+            case fabric::QUALITY_COMPRESSION: text << "compression "; break;
+            case fabric::QUALITY_SUBPIXEL:    text << "subpixel "; break;
+            case fabric::QUALITY_ZOOM:        text << "zoom "; break;
+            default:                          text << "full "; break;
+          }
+          text << unsigned( 100.f * stat.ratio ) << '%';
+          item.text = text.str();
+          break;
+      }
       default:
           break;
     }
@@ -158,6 +158,9 @@ public:
     /** The number of the last finished frame. */
     lunchbox::Monitor< uint32_t > finishedFrame;
 
+    /** The last render context received, mirrors the server channel. */
+    RenderContext lastContext;
+
     /** Listeners that get notified on each new rendered image */
     typedef std::vector< ResultImageListener* > ResultImageListeners;
     ResultImageListeners resultImageListeners;
@@ -0,0 +1,551 @@
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "cpuCompositor.h"
+
+#include "../half.h"
+
+#include <lunchbox/debug.h>
+#include <lunchbox/log.h>
+
+#include <cstdlib>
+#include <cstring>
+
+#if defined( __GNUC__ ) && ( defined( __x86_64__ ) || defined( __i386__ ))
+#  define EQ_CPU_COMPOSITOR_X86
+#  define EQ_TARGET( isa ) __attribute__(( target( isa )))
+#  include <immintrin.h>
+#elif defined( _MSC_VER ) && ( defined( _M_X64 ) || defined( _M_IX86 ))
+#  define EQ_CPU_COMPOSITOR_X86
+#  define EQ_TARGET( isa )
+#  include <immintrin.h>
+#  include <intrin.h>
+#endif
+
+namespace eq
+{
+namespace detail
+{
+namespace cpuCompositor
+{
+namespace
+{
+//----------------------------------------------------------------------
+// scalar reference implementation
+//----------------------------------------------------------------------
+void _mergeDepthScalar( uint32_t* destColor, uint32_t* destDepth,
+                        const uint32_t* color, const uint32_t* depth,
+                        const size_t n )
+{
+    for( size_t i = 0; i < n; ++i )
+    {
+        if( destDepth[i] > depth[i] )
+        {
+            destColor[i] = color[i];
+            destDepth[i] = depth[i];
+        }
+    }
+}
+
+void _blendRGBA8Scalar( uint32_t* dest, const uint32_t* color, const size_t n )
+{
+    const uint8_t* src = reinterpret_cast< const uint8_t* >( color );
+    uint8_t* dst = reinterpret_cast< uint8_t* >( dest );
+
+    for( size_t i = 0; i < n; ++i )
+    {
+        dst[0] = LB_MIN( src[0] + (src[3]*dst[0] >> 8), 255 );
+        dst[1] = LB_MIN( src[1] + (src[3]*dst[1] >> 8), 255 );
+        dst[2] = LB_MIN( src[2] + (src[3]*dst[2] >> 8), 255 );
+        dst[3] =                   src[3]*dst[3] >> 8;
+
+        src += 4;
+        dst += 4;
+    }
+}
+
+void _blendRGBA16FScalar( uint16_t* dest, const uint16_t* color,
+                          const size_t n )
+{
+    for( size_t i = 0; i < n; ++i )
+    {
+        const float alpha = half_to_float( color[3] );
+        for( size_t j = 0; j < 3; ++j )
+            dest[j] = half_from_float( half_to_float( color[j] ) +
+                                       alpha * half_to_float( dest[j] ));
+        dest[3] = half_from_float( alpha * half_to_float( dest[3] ));
+
+        color += 4;
+        dest += 4;
+    }
+}
+
+void _blendRGBA32FScalar( float* dest, const float* color, const size_t n )
+{
+    for( size_t i = 0; i < n; ++i )
+    {
+        const float alpha = color[3];
+        dest[0] = color[0] + alpha * dest[0];
+        dest[1] = color[1] + alpha * dest[1];
+        dest[2] = color[2] + alpha * dest[2];
+        dest[3] =            alpha * dest[3];
+
+        color += 4;
+        dest += 4;
+    }
+}
+
+#ifdef EQ_CPU_COMPOSITOR_X86
+//----------------------------------------------------------------------
+// SSE4.1: 4 pixels per iteration
+//----------------------------------------------------------------------
+EQ_TARGET( "sse4.1" )
+void _mergeDepthSSE41( uint32_t* destColor, uint32_t* destDepth,
+                       const uint32_t* color, const uint32_t* depth,
+                       const size_t n )
+{
+    size_t i = 0;
+    for( ; i + 4 <= n; i += 4 )
+    {
+        const __m128i dstD = _mm_loadu_si128( (const __m128i*)(destDepth + i));
+        const __m128i srcD = _mm_loadu_si128( (const __m128i*)(depth + i));
+        const __m128i dstC = _mm_loadu_si128( (const __m128i*)(destColor + i));
+        const __m128i srcC = _mm_loadu_si128( (const __m128i*)(color + i));
+
+        // min( dst, src ) == dst <=> dst <= src <=> keep destination
+        const __m128i minD = _mm_min_epu32( dstD, srcD );
+        const __m128i keep = _mm_cmpeq_epi32( minD, dstD );
+
+        _mm_storeu_si128( (__m128i*)(destDepth + i), minD );
+        _mm_storeu_si128( (__m128i*)(destColor + i),
+                          _mm_blendv_epi8( srcC, dstC, keep ));
+    }
+    _mergeDepthScalar( destColor + i, destDepth + i, color + i, depth + i,
+                       n - i );
+}
+
+// Blends 8 bit channels using 16 bit products of alpha and destination:
+// (a * d) >> 8 never exceeds 254, so the saturated add of the source color
+// equals the clamping of the scalar code.
+EQ_TARGET( "sse4.1" )
+void _blendRGBA8SSE41( uint32_t* dest, const uint32_t* color, const size_t n )
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alphaLo = _mm_setr_epi8( 3, -1, 3, -1, 3, -1, 3, -1,
+                                           7, -1, 7, -1, 7, -1, 7, -1 );
+    const __m128i alphaHi = _mm_setr_epi8( 11, -1, 11, -1, 11, -1, 11, -1,
+                                           15, -1, 15, -1, 15, -1, 15, -1 );
+    const __m128i colorMask = _mm_set1_epi32( 0x00ffffff );
+
+    size_t i = 0;
+    for( ; i + 4 <= n; i += 4 )
+    {
+        const __m128i src = _mm_loadu_si128( (const __m128i*)(color + i));
+        const __m128i dst = _mm_loadu_si128( (const __m128i*)(dest + i));
+
+        const __m128i lo = _mm_srli_epi16(
+            _mm_mullo_epi16( _mm_shuffle_epi8( src, alphaLo ),
+                             _mm_unpacklo_epi8( dst, zero )), 8 );
+        const __m128i hi = _mm_srli_epi16(
+            _mm_mullo_epi16( _mm_shuffle_epi8( src, alphaHi ),
+                             _mm_unpackhi_epi8( dst, zero )), 8 );
+
+        _mm_storeu_si128( (__m128i*)(dest + i),
+                          _mm_adds_epu8( _mm_packus_epi16( lo, hi ),
+                                         _mm_and_si128( src, colorMask )));
+    }
+    _blendRGBA8Scalar( dest + i, color + i, n - i );
+}
+
+// One pixel per register, the alpha result is selected from the product
+EQ_TARGET( "sse4.1" )
+void _blendRGBA32FSSE41( float* dest, const float* color, const size_t n )
+{
+    for( size_t i = 0; i < n; ++i )
+    {
+        const __m128 src = _mm_loadu_ps( color + 4 * i );
+        const __m128 dst = _mm_loadu_ps( dest + 4 * i );
+        const __m128 alpha = _mm_shuffle_ps( src, src, _MM_SHUFFLE( 3,3,3,3 ));
+        const __m128 product = _mm_mul_ps( alpha, dst );
+
+        _mm_storeu_ps( dest + 4 * i,
+                       _mm_blend_ps( _mm_add_ps( src, product ), product, 8 ));
+    }
+}
+
+//----------------------------------------------------------------------
+// AVX2: 8 pixels per iteration
+//----------------------------------------------------------------------
+EQ_TARGET( "avx2" )
+void _mergeDepthAVX2( uint32_t* destColor, uint32_t* destDepth,
+                      const uint32_t* color, const uint32_t* depth,
+                      const size_t n )
+{
+    size_t i = 0;
+    for( ; i + 8 <= n; i += 8 )
+    {
+        const __m256i dstD = _mm256_loadu_si256( (const __m256i*)(destDepth+i));
+        const __m256i srcD = _mm256_loadu_si256( (const __m256i*)(depth + i));
+        const __m256i dstC = _mm256_loadu_si256( (const __m256i*)(destColor+i));
+        const __m256i srcC = _mm256_loadu_si256( (const __m256i*)(color + i));
+
+        const __m256i minD = _mm256_min_epu32( dstD, srcD );
+        const __m256i keep = _mm256_cmpeq_epi32( minD, dstD );
+
+        _mm256_storeu_si256( (__m256i*)(destDepth + i), minD );
+        _mm256_storeu_si256( (__m256i*)(destColor + i),
+                             _mm256_blendv_epi8( srcC, dstC, keep ));
+    }
+    _mergeDepthScalar( destColor + i, destDepth + i, color + i, depth + i,
+                       n - i );
+}
+
+EQ_TARGET( "avx2" )
+void _blendRGBA8AVX2( uint32_t* dest, const uint32_t* color, const size_t n )
+{
+    // byte shuffles and unpacks operate on 128 bit lanes
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i alphaLo = _mm256_setr_epi8(
+        3, -1, 3, -1, 3, -1, 3, -1, 7, -1, 7, -1, 7, -1, 7, -1,
+        3, -1, 3, -1, 3, -1, 3, -1, 7, -1, 7, -1, 7, -1, 7, -1 );
+    const __m256i alphaHi = _mm256_setr_epi8(
+        11, -1, 11, -1, 11, -1, 11, -1, 15, -1, 15, -1, 15, -1, 15, -1,
+        11, -1, 11, -1, 11, -1, 11, -1, 15, -1, 15, -1, 15, -1, 15, -1 );
+    const __m256i colorMask = _mm256_set1_epi32( 0x00ffffff );
+
+    size_t i = 0;
+    for( ; i + 8 <= n; i += 8 )
+    {
+        const __m256i src = _mm256_loadu_si256( (const __m256i*)(color + i));
+        const __m256i dst = _mm256_loadu_si256( (const __m256i*)(dest + i));
+
+        const __m256i lo = _mm256_srli_epi16(
+            _mm256_mullo_epi16( _mm256_shuffle_epi8( src, alphaLo ),
+                                _mm256_unpacklo_epi8( dst, zero )), 8 );
+        const __m256i hi = _mm256_srli_epi16(
+            _mm256_mullo_epi16( _mm256_shuffle_epi8( src, alphaHi ),
+                                _mm256_unpackhi_epi8( dst, zero )), 8 );
+
+        _mm256_storeu_si256( (__m256i*)(dest + i),
+                            _mm256_adds_epu8( _mm256_packus_epi16( lo, hi ),
+                                           _mm256_and_si256( src, colorMask )));
+    }
+    _blendRGBA8Scalar( dest + i, color + i, n - i );
+}
+
+EQ_TARGET( "avx2" )
+inline __m256 _blendRGBA32FAVX2( const __m256 src, const __m256 dst )
+{
+    const __m256 alpha = _mm256_permute_ps( src, _MM_SHUFFLE( 3, 3, 3, 3 ));
+    const __m256 product = _mm256_mul_ps( alpha, dst );
+    return _mm256_blend_ps( _mm256_add_ps( src, product ), product, 0x88 );
+}
+
+EQ_TARGET( "avx2" )
+void _blendRGBA32FAVX2( float* dest, const float* color, const size_t n )
+{
+    size_t i = 0;
+    for( ; i + 2 <= n; i += 2 )
+    {
+        const __m256 src = _mm256_loadu_ps( color + 4 * i );
+        const __m256 dst = _mm256_loadu_ps( dest + 4 * i );
+        _mm256_storeu_ps( dest + 4 * i, _blendRGBA32FAVX2( src, dst ));
+    }
+    _blendRGBA32FScalar( dest + 4 * i, color + 4 * i, n - i );
+}
+
+// All AVX2-capable CPUs implement F16C
+EQ_TARGET( "avx2,f16c" )
+void _blendRGBA16FAVX2( uint16_t* dest, const uint16_t* color, const size_t n )
+{
+    size_t i = 0;
+    for( ; i + 2 <= n; i += 2 )
+    {
+        const __m256 src = _mm256_cvtph_ps(
+            _mm_loadu_si128( (const __m128i*)(color + 4 * i )));
+        const __m256 dst = _mm256_cvtph_ps(
+            _mm_loadu_si128( (const __m128i*)(dest + 4 * i )));
+        _mm_storeu_si128( (__m128i*)(dest + 4 * i ),
+                          _mm256_cvtps_ph( _blendRGBA32FAVX2( src, dst ),
+                                           _MM_FROUND_TO_NEAREST_INT ));
+    }
+    _blendRGBA16FScalar( dest + 4 * i, color + 4 * i, n - i );
+}
+
+//----------------------------------------------------------------------
+// AVX-512: 16 pixels per iteration, masked stores only touch changed pixels
+//----------------------------------------------------------------------
+EQ_TARGET( "avx512f" )
+void _mergeDepthAVX512( uint32_t* destColor, uint32_t* destDepth,
+                        const uint32_t* color, const uint32_t* depth,
+                        const size_t n )
+{
+    size_t i = 0;
+    for( ; i + 16 <= n; i += 16 )
+    {
+        const __m512i dstD = _mm512_loadu_si512( destDepth + i );
+        const __m512i srcD = _mm512_loadu_si512( depth + i );
+        const __mmask16 replace = _mm512_cmpgt_epu32_mask( dstD, srcD );
+        if( !replace )
+            continue;
+
+        const __m512i srcC = _mm512_loadu_si512( color + i );
+        _mm512_mask_storeu_epi32( destDepth + i, replace, srcD );
+        _mm512_mask_storeu_epi32( destColor + i, replace, srcC );
+    }
+    if( i < n )
+    {
+        const __mmask16 tail = __mmask16( (1u << (n - i)) - 1 );
+        const __m512i dstD = _mm512_maskz_loadu_epi32( tail, destDepth + i );
+        const __m512i srcD = _mm512_maskz_loadu_epi32( tail, depth + i );
+        const __mmask16 replace = _mm512_mask_cmpgt_epu32_mask( tail, dstD,
+                                                                srcD );
+        const __m512i srcC = _mm512_maskz_loadu_epi32( replace, color + i );
+        _mm512_mask_storeu_epi32( destDepth + i, replace, srcD );
+        _mm512_mask_storeu_epi32( destColor + i, replace, srcC );
+    }
+}
+
+EQ_TARGET( "avx512f,avx512bw" )
+inline __m512i _blendRGBA8AVX512( const __m512i src, const __m512i dst )
+{
+    const __m512i zero = _mm512_setzero_si512();
+    // same per-lane shuffle as the SSE and AVX2 code
+    const __m512i alphaLo = _mm512_set4_epi64(
+        0xff07ff07ff07ff07ll, 0xff03ff03ff03ff03ll,
+        0xff07ff07ff07ff07ll, 0xff03ff03ff03ff03ll );
+    const __m512i alphaHi = _mm512_set4_epi64(
+        0xff0fff0fff0fff0fll, 0xff0bff0bff0bff0bll,
+        0xff0fff0fff0fff0fll, 0xff0bff0bff0bff0bll );
+    const __m512i colorMask = _mm512_set1_epi32( 0x00ffffff );
+
+    const __m512i lo = _mm512_srli_epi16(
+        _mm512_mullo_epi16( _mm512_shuffle_epi8( src, alphaLo ),
+                            _mm512_unpacklo_epi8( dst, zero )), 8 );
+    const __m512i hi = _mm512_srli_epi16(
+        _mm512_mullo_epi16( _mm512_shuffle_epi8( src, alphaHi ),
+                            _mm512_unpackhi_epi8( dst, zero )), 8 );
+    return _mm512_adds_epu8( _mm512_packus_epi16( lo, hi ),
+                             _mm512_and_si512( src, colorMask ));
+}
+
+EQ_TARGET( "avx512f,avx512bw" )
+void _blendRGBA8AVX512( uint32_t* dest, const uint32_t* color,
+                        const size_t n )
+{
+    size_t i = 0;
+    for( ; i + 16 <= n; i += 16 )
+    {
+        const __m512i src = _mm512_loadu_si512( color + i );
+        const __m512i dst = _mm512_loadu_si512( dest + i );
+        _mm512_storeu_si512( dest + i, _blendRGBA8AVX512( src, dst ));
+    }
+    if( i < n )
+    {
+        const __mmask16 tail = __mmask16( (1u << (n - i)) - 1 );
+        const __m512i src = _mm512_maskz_loadu_epi32( tail, color + i );
+        const __m512i dst = _mm512_maskz_loadu_epi32( tail, dest + i );
+        _mm512_mask_storeu_epi32( dest + i, tail,
+                                  _blendRGBA8AVX512( src, dst ));
+    }
+}
+
+ISA _detectISA()
+{
+#  ifdef _MSC_VER
+    int info[4];
+    __cpuid( info, 0 );
+    const int nIds = info[0];
+    if( nIds < 1 )
+        return ISA_SCALAR;
+
+    __cpuid( info, 1 );
+    const bool sse41 = ( info[2] & (1 << 19) ) != 0;
+    const bool osxsave = ( info[2] & (1 << 27) ) != 0;
+    const unsigned long long xcr0 = osxsave ? _xgetbv( 0 ) : 0;
+    const bool ymm = ( xcr0 & 0x6 ) == 0x6;
+    const bool zmm = ( xcr0 & 0xe6 ) == 0xe6;
+    bool avx2 = false;
+    bool avx512 = false;
+    if( nIds >= 7 )
+    {
+        __cpuidex( info, 7, 0 );
+        avx2 = ymm && ( info[1] & (1 << 5) ) != 0;
+        avx512 = zmm && ( info[1] & (1 << 16) ) != 0 && // F
+                        ( info[1] & (1 << 30) ) != 0;   // BW
+    }
+#  else
+    __builtin_cpu_init();
+    const bool sse41 = __builtin_cpu_supports( "sse4.1" );
+    const bool avx2 = __builtin_cpu_supports( "avx2" );
+    const bool avx512 = __builtin_cpu_supports( "avx512f" ) &&
+                        __builtin_cpu_supports( "avx512bw" );
+#  endif
+
+    if( avx512 )
+        return ISA_AVX512;
+    if( avx2 )
+        return ISA_AVX2;
+    if( sse41 )
+        return ISA_SSE41;
+    return ISA_SCALAR;
+}
+#else
+ISA _detectISA() { return ISA_SCALAR; }
+#endif
+
+ISA _getDetectedISA()
+{
+    static const ISA isa = _detectISA();
+    return isa;
+}
+
+ISA _selectISA()
+{
+    ISA isa = _getDetectedISA();
+
+    const char* env = ::getenv( "EQ_CPU_COMPOSITOR_ISA" );
+    if( env )
+    {
+        for( int i = ISA_SCALAR; i <= ISA_AVX512; ++i )
+        {
+            if( ::strcmp( env, getName( ISA( i ))) == 0 )
+            {
+                if( i < isa )
+                    isa = ISA( i );
+                break;
+            }
+        }
+    }
+
+    LBVERB << "CPU compositor using " << getName( isa ) << " kernels"
+           << std::endl;
+    return isa;
+}
+
+typedef void (*MergeDepthFunc)( uint32_t*, uint32_t*, const uint32_t*,
+                                const uint32_t*, size_t );
+
+MergeDepthFunc _selectMergeDepth( const ISA isa )
+{
+    switch( isa )
+    {
+#ifdef EQ_CPU_COMPOSITOR_X86
+    case ISA_AVX512: return _mergeDepthAVX512;
+    case ISA_AVX2:   return _mergeDepthAVX2;
+    case ISA_SSE41:  return _mergeDepthSSE41;
+#endif
+    default:         return _mergeDepthScalar;
+    }
+}
+
+typedef void (*BlendRGBA8Func)( uint32_t*, const uint32_t*, size_t );
+typedef void (*BlendRGBA16FFunc)( uint16_t*, const uint16_t*, size_t );
+typedef void (*BlendRGBA32FFunc)( float*, const float*, size_t );
+
+BlendRGBA8Func _selectBlendRGBA8()
+{
+    switch( getISA( ))
+    {
+#ifdef EQ_CPU_COMPOSITOR_X86
+    case ISA_AVX512: return _blendRGBA8AVX512;
+    case ISA_AVX2:   return _blendRGBA8AVX2;
+    case ISA_SSE41:  return _blendRGBA8SSE41;
+#endif
+    default:         return _blendRGBA8Scalar;
+    }
+}
+
+BlendRGBA16FFunc _selectBlendRGBA16F()
+{
+#ifdef EQ_CPU_COMPOSITOR_X86
+    if( getISA() >= ISA_AVX2 )
+        return _blendRGBA16FAVX2;
+#endif
+    return _blendRGBA16FScalar;
+}
+
+BlendRGBA32FFunc _selectBlendRGBA32F()
+{
+    switch( getISA( ))
+    {
+#ifdef EQ_CPU_COMPOSITOR_X86
+    case ISA_AVX512:
+    case ISA_AVX2:   return _blendRGBA32FAVX2;
+    case ISA_SSE41:  return _blendRGBA32FSSE41;
+#endif
+    default:         return _blendRGBA32FScalar;
+    }
+}
+}
+
+ISA getISA()
+{
+    static const ISA isa = _selectISA();
+    return isa;
+}
+
+bool isSupported( const ISA isa )
+{
+    return isa <= _getDetectedISA();
+}
+
+const char* getName( const ISA isa )
+{
+    switch( isa )
+    {
+    case ISA_SSE41:  return "sse41";
+    case ISA_AVX2:   return "avx2";
+    case ISA_AVX512: return "avx512";
+    default:         return "scalar";
+    }
+}
+
+void mergeDepth( uint32_t* destColor, uint32_t* destDepth,
+                 const uint32_t* color, const uint32_t* depth, const size_t n )
+{
+    static const MergeDepthFunc func = _selectMergeDepth( getISA( ));
+    func( destColor, destDepth, color, depth, n );
+}
+
+void mergeDepth( const ISA isa, uint32_t* destColor, uint32_t* destDepth,
+                 const uint32_t* color, const uint32_t* depth, const size_t n )
+{
+    LBASSERT( isSupported( isa ));
+    _selectMergeDepth( isa )( destColor, destDepth, color, depth, n );
+}
+
+void blendRGBA8( uint32_t* dest, const uint32_t* color, const size_t n )
+{
+    static const BlendRGBA8Func func = _selectBlendRGBA8();
+    func( dest, color, n );
+}
+
+void blendRGBA16F( uint16_t* dest, const uint16_t* color, const size_t n )
+{
+    static const BlendRGBA16FFunc func = _selectBlendRGBA16F();
+    func( dest, color, n );
+}
+
+void blendRGBA32F( float* dest, const float* color, const size_t n )
+{
+    static const BlendRGBA32FFunc func = _selectBlendRGBA32F();
+    func( dest, color, n );
+}
+
+}
+}
+}
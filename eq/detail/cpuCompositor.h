@@ -0,0 +1,107 @@
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQ_DETAIL_CPUCOMPOSITOR_H
+#define EQ_DETAIL_CPUCOMPOSITOR_H
+
+#include <eq/api.h>
+
+#include <cstddef>
+#include <stdint.h>
+
+namespace eq
+{
+namespace detail
+{
+/**
+ * Row kernels used by the CPU compositor.
+ *
+ * Each kernel has a scalar reference implementation and, on x86, SSE4.1, AVX2
+ * and AVX-512 variants. The fastest variant supported by the CPU is selected
+ * once at runtime. All integer variants produce bit-identical results to the
+ * scalar code.
+ */
+namespace cpuCompositor
+{
+/** The instruction sets for which kernels are implemented. */
+enum ISA
+{
+    ISA_SCALAR,
+    ISA_SSE41,
+    ISA_AVX2,
+    ISA_AVX512 //!< AVX-512 F and BW
+};
+
+/**
+ * @return the instruction set used by the kernels.
+ *
+ * The environment variable EQ_CPU_COMPOSITOR_ISA (scalar, sse41, avx2 or
+ * avx512) can be used to lower the detected instruction set for debugging.
+ */
+ISA getISA();
+
+/** @return a human-readable name of the given instruction set. */
+const char* getName( ISA isa );
+
+/** @return true if the kernels of the given instruction set run on this CPU. */
+EQ_API bool isSupported( ISA isa );
+
+/**
+ * Depth-merge one row of 32 bit color and depth values.
+ *
+ * Where the source depth is strictly smaller than the destination depth, the
+ * source color and depth replace the destination values.
+ */
+void mergeDepth( uint32_t* destColor, uint32_t* destDepth,
+                 const uint32_t* color, const uint32_t* depth, size_t n );
+
+/**
+ * Depth-merge one row using the kernel of the given, supported instruction set.
+ *
+ * Used to compare all kernels against the scalar code.
+ */
+EQ_API void mergeDepth( ISA isa, uint32_t* destColor, uint32_t* destDepth,
+                        const uint32_t* color, const uint32_t* depth,
+                        size_t n );
+
+/**
+ * Blend one row of premultiplied 8 bit RGBA or BGRA pixels.
+ *
+ * Implements glBlendFuncSeparate( GL_ONE, GL_SRC_ALPHA, GL_ZERO, GL_SRC_ALPHA)
+ * with 8 bit fixed point arithmetic: dst.c = min( src.c + src.a * dst.c / 256,
+ * 255 ) and dst.a = src.a * dst.a / 256.
+ */
+void blendRGBA8( uint32_t* dest, const uint32_t* color, size_t n );
+
+/**
+ * Blend one row of premultiplied half float RGBA or BGRA pixels.
+ *
+ * Same blend function as blendRGBA8(), without clamping. Results of the F16C
+ * variant may differ from the scalar code in the rounding of ties.
+ */
+void blendRGBA16F( uint16_t* dest, const uint16_t* color, size_t n );
+
+/**
+ * Blend one row of premultiplied float RGBA or BGRA pixels.
+ *
+ * Same blend function as blendRGBA8(), without clamping.
+ */
+void blendRGBA32F( float* dest, const float* color, size_t n );
+}
+}
+}
+
+#endif // EQ_DETAIL_CPUCOMPOSITOR_H
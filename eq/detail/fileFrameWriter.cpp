@@ -1,4 +1,4 @@
-/* Copyright (c) 2013-2015, Julio Delgado Mangas <julio.delgadomangas@epfl.ch>
+/* Copyright (c) 2013-2016, Julio Delgado Mangas <julio.delgadomangas@epfl.ch>
  *                          Daniel Nachbaur <danielnachbaur@gmail.com>
  *
  * This library is free software; you can redistribute it and/or modify it under
@@ -19,15 +19,126 @@
 
 #include <eq/channel.h>
 #include <eq/image.h>
+#include <eq/pixelData.h>
 
+#include <lunchbox/atomic.h>
 #include <lunchbox/log.h>
+#include <lunchbox/mtQueue.h>
+#include <lunchbox/thread.h>
+
+#include <cstdlib>
 
 namespace eq
 {
 namespace detail
 {
+namespace
+{
+/** Number of image buffers, limits the memory used for pending writes. */
+static const size_t nBuffers = 8;
+
+/** Number of encoder threads. */
+static const size_t nEncoders = 2;
+
+/** An image waiting to be written. */
+struct Slot
+{
+    eq::Image image;
+    std::string fileName;
+};
+typedef lunchbox::MTQueue< Slot* > SlotQueue;
+}
+
+class FileFrameWriter::Impl
+{
+public:
+    Impl()
+        : policy( ::getenv( "EQ_DUMP_IMAGE_DROP" ) ? POLICY_DROP :
+                                                     POLICY_BLOCK )
+        , slots( nBuffers )
+    {
+        for( Slot& slot : slots )
+            freeSlots.push( &slot );
+    }
+
+    ~Impl()
+    {
+        for( size_t i = 0; i < encoders.size(); ++i )
+            pendingSlots.push( 0 ); // wake up to exit
+        for( EncoderPtr& encoder : encoders )
+            encoder->join();
+
+        for( Slot& slot : slots )
+            slot.image.flush();
+
+        if( written > 0 || dropped > 0 )
+            LBINFO << "Wrote " << written << " images, dropped " << dropped
+                   << std::endl;
+    }
+
+    void startEncoders()
+    {
+        if( !encoders.empty( ))
+            return;
+
+        for( size_t i = 0; i < nEncoders; ++i )
+        {
+            encoders.push_back( EncoderPtr( new Encoder( *this )));
+            encoders.back()->start();
+        }
+    }
+
+    void write( Slot& slot )
+    {
+        if( slot.image.writeImage( slot.fileName, eq::Frame::BUFFER_COLOR ))
+            ++written;
+        else
+            LBWARN << "Could not write file " << slot.fileName << std::endl;
+    }
+
+    class Encoder : public lunchbox::Thread
+    {
+    public:
+        explicit Encoder( Impl& impl ) : _impl( impl ) {}
+
+    protected:
+        bool init() override { setName( "ImgWrite" ); return true; }
+
+        void run() override
+        {
+            while( true )
+            {
+                Slot* slot = _impl.pendingSlots.pop();
+                if( !slot )
+                    return; // exit thread
+
+                _impl.write( *slot );
+                _impl.freeSlots.push( slot );
+            }
+        }
+
+    private:
+        Impl& _impl;
+    };
+
+    Policy policy;
+    std::vector< Slot > slots;
+    SlotQueue freeSlots;
+    SlotQueue pendingSlots;
+    typedef std::unique_ptr< Encoder > EncoderPtr;
+    std::vector< EncoderPtr > encoders;
+
+    lunchbox::a_int32_t written;
+    lunchbox::a_int32_t dropped;
+};
+
 FileFrameWriter::FileFrameWriter()
     : ResultImageListener()
+    , _impl( new Impl )
+{
+}
+
+FileFrameWriter::~FileFrameWriter()
 {
 }
 
@@ -37,13 +148,46 @@ void FileFrameWriter::notifyNewImage( eq::Channel& channel,
     const std::string& prefix =
             channel.getSAttribute( eq::Channel::SATTR_DUMP_IMAGE );
     LBASSERT( !prefix.empty( ));
-    const std::string fileName = prefix + channel.getDumpImageFileName();
-    if( !image.writeImage( fileName, eq::Frame::BUFFER_COLOR ))
-        LBWARN << "Could not write file " << fileName << std::endl;
+    if( !image.hasPixelData( eq::Frame::BUFFER_COLOR ))
+        return;
+
+    _impl->startEncoders();
+
+    Slot* slot = 0;
+    if( _impl->policy == POLICY_DROP )
+    {
+        if( !_impl->freeSlots.tryPop( slot ))
+        {
+            ++_impl->dropped;
+            return;
+        }
+    }
+    else
+        slot = _impl->freeSlots.pop();
+
+    // copy the pixels into the reused buffer of the slot, the encoders work
+    // on the copy while the next frame is rendered
+    slot->fileName = prefix + channel.getDumpImageFileName();
+    slot->image.setAlphaUsage( image.getAlphaUsage( ));
+    slot->image.setPixelViewport( image.getPixelViewport( ));
+    slot->image.setPixelData( eq::Frame::BUFFER_COLOR,
+                              image.getPixelData( eq::Frame::BUFFER_COLOR ));
+    _impl->pendingSlots.push( slot );
 }
 
-FileFrameWriter::~FileFrameWriter()
+void FileFrameWriter::setPolicy( const Policy policy )
+{
+    _impl->policy = policy;
+}
+
+size_t FileFrameWriter::getNumWritten() const
+{
+    return _impl->written;
+}
+
+size_t FileFrameWriter::getNumDropped() const
 {
+    return _impl->dropped;
 }
 
 }
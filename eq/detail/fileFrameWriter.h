@@ -1,4 +1,4 @@
-/* Copyright (c) 2013-2015, Julio Delgado Mangas <julio.delgadomangas@epfl.ch>
+/* Copyright (c) 2013-2016, Julio Delgado Mangas <julio.delgadomangas@epfl.ch>
  *                          Daniel Nachbaur <danielnachbaur@gmail.com>
  *
  * This library is free software; you can redistribute it and/or modify it under
@@ -21,6 +21,8 @@
 #include <eq/resultImageListener.h> // base class
 #include <eq/types.h>
 
+#include <memory>
+
 namespace eq
 {
 namespace detail
@@ -29,14 +31,40 @@ namespace detail
 /**
  * Persist the color buffer of a channel to a file.
  * The name of the file is Channel::SATTR_DUMP_IMAGE.rgb
+ *
+ * The image is copied into one of a fixed number of buffers and written by
+ * background encoder threads, which are started on the first image. When all
+ * buffers are waiting to be written, the render thread either waits for a
+ * free buffer (the default) or drops the image if the environment variable
+ * EQ_DUMP_IMAGE_DROP is set.
  */
 class FileFrameWriter : public ResultImageListener
 {
 public:
+    /** The behaviour when no buffer is available for a new image. */
+    enum Policy
+    {
+        POLICY_BLOCK, //!< wait for an encoder to finish a buffer
+        POLICY_DROP   //!< do not write the image
+    };
+
     FileFrameWriter();
     ~FileFrameWriter();
 
     void notifyNewImage( eq::Channel& channel, const eq::Image& image ) final;
+
+    /** Set the policy used when all buffers are in use. */
+    void setPolicy( Policy policy );
+
+    /** @return the number of images written to disk. */
+    size_t getNumWritten() const;
+
+    /** @return the number of images dropped due to busy encoders. */
+    size_t getNumDropped() const;
+
+private:
+    class Impl;
+    std::unique_ptr< Impl > _impl;
 };
 
 }
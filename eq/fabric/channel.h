@@ -292,6 +292,12 @@ public:
         IATTR_HINT_STATISTICS,
         /** Use a send token for output frames (OFF, ON) */
         IATTR_HINT_SENDTOKEN,
+        /**
+         * Tiles in flight between draw and transmission (OFF, ON, AUTO, n).
+         * OFF is one tile. ON, AUTO and 1, which is the value of ON, are two
+         * tiles. A value n > 1 is n tiles.
+         */
+        IATTR_HINT_TILE_PIPELINE,
         IATTR_LAST,
         IATTR_ALL = IATTR_LAST + 5
     };
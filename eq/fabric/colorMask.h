@@ -42,6 +42,17 @@ namespace fabric
                    const bool a = true )
                 : red( r ), green( g ), blue( b ), alpha( a ) {}
 
+        /** @return true if both masks are equal. @version 1.13 */
+        bool operator == ( const ColorMask& rhs ) const
+        {
+            return red == rhs.red && green == rhs.green && blue == rhs.blue &&
+                   alpha == rhs.alpha;
+        }
+
+        /** @return true if both masks are not equal. @version 1.13 */
+        bool operator != ( const ColorMask& rhs ) const
+            { return !( *this == rhs ); }
+
         bool red;
         bool green;
         bool blue;
@@ -44,7 +44,10 @@ public:
         , resistance2i( 0, 0 )
         , tilesize( 64, 64 )
         , mode( fabric::Equalizer::MODE_2D )
+        , tileStrategy( fabric::Equalizer::TILE_ZIGZAG )
+        , calibrationFrames( 0 )
         , frozen( false )
+        , autoTileSize( false )
     {
         const uint32_t flags = eq::fabric::Global::getFlags();
         switch( flags & fabric::ConfigParams::FLAG_LOAD_EQ_ALL )
@@ -75,7 +78,10 @@ public:
         , resistance2i( rhs.resistance2i )
         , tilesize( rhs.tilesize )
         , mode( rhs.mode )
+        , tileStrategy( rhs.tileStrategy )
+        , calibrationFrames( rhs.calibrationFrames )
         , frozen( rhs.frozen )
+        , autoTileSize( rhs.autoTileSize )
     {}
 
     float damping;
@@ -87,7 +93,10 @@ public:
     Vector2i resistance2i;
     Vector2i tilesize;
     fabric::Equalizer::Mode mode;
+    fabric::Equalizer::TileStrategy tileStrategy;
+    uint32_t calibrationFrames;
     bool frozen;
+    bool autoTileSize;
 };
 }
 
@@ -218,12 +227,43 @@ const Vector2i& Equalizer::getTileSize() const
     return _data->tilesize;
 }
 
+void Equalizer::setTileStrategy( const TileStrategy strategy )
+{
+    _data->tileStrategy = strategy;
+}
+
+Equalizer::TileStrategy Equalizer::getTileStrategy() const
+{
+    return _data->tileStrategy;
+}
+
+void Equalizer::setAutoTileSize( const bool onOff )
+{
+    _data->autoTileSize = onOff;
+}
+
+bool Equalizer::hasAutoTileSize() const
+{
+    return _data->autoTileSize;
+}
+
+void Equalizer::setCalibrationFrames( const uint32_t frames )
+{
+    _data->calibrationFrames = frames;
+}
+
+uint32_t Equalizer::getCalibrationFrames() const
+{
+    return _data->calibrationFrames;
+}
+
 void Equalizer::serialize( co::DataOStream& os ) const
 {
     os << _data->damping << _data->boundaryf << _data->resistancef
        << _data->assembleOnlyLimit << _data->frameRate << _data->boundary2i
        << _data->resistance2i << _data->tilesize << _data->mode
-       << _data->frozen;
+       << _data->tileStrategy << _data->calibrationFrames << _data->frozen
+       << _data->autoTileSize;
 }
 
 void Equalizer::deserialize( co::DataIStream& is )
@@ -231,7 +271,8 @@ void Equalizer::deserialize( co::DataIStream& is )
     is >> _data->damping >> _data->boundaryf >> _data->resistancef
        >> _data->assembleOnlyLimit >> _data->frameRate >> _data->boundary2i
        >> _data->resistance2i >> _data->tilesize >> _data->mode
-       >> _data->frozen;
+       >> _data->tileStrategy >> _data->calibrationFrames >> _data->frozen
+       >> _data->autoTileSize;
 }
 
 void Equalizer::backup()
@@ -268,5 +309,15 @@ std::ostream& operator << ( std::ostream& os, const Equalizer::Mode mode )
     return os;
 }
 
+std::ostream& operator << ( std::ostream& os,
+                            const Equalizer::TileStrategy strategy )
+{
+    os << ( strategy == Equalizer::TILE_ZIGZAG ? "ZIGZAG" :
+            strategy == Equalizer::TILE_RASTER ? "RASTER" :
+            strategy == Equalizer::TILE_SPIRAL ? "SPIRAL" :
+            strategy == Equalizer::TILE_SQUARE ? "SQUARE" : "ERROR" );
+    return os;
+}
+
 }
 }
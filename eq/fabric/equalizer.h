@@ -58,6 +58,15 @@ public:
         MODE_2D          //!< Adapt for a sort-first decomposition
     };
 
+    /** The order in which the TileEqualizer queues the tiles. */
+    enum TileStrategy
+    {
+        TILE_ZIGZAG = 0, //!< Rows of alternating direction
+        TILE_RASTER,     //!< Rows from left to right
+        TILE_SPIRAL,     //!< Rings from the center outwards
+        TILE_SQUARE      //!< Squares from the center outwards
+    };
+
     /** @name Data Access. */
     //@{
     /** Set the equalizer to freeze the current state. */
@@ -119,6 +128,39 @@ public:
 
     /** @return the tile size for the TileEqualizer. */
     EQFABRIC_API const Vector2i& getTileSize() const;
+
+    /** Set the order in which the TileEqualizer queues the tiles. */
+    EQFABRIC_API void setTileStrategy( const TileStrategy strategy );
+
+    /** @return the order in which the TileEqualizer queues the tiles. */
+    EQFABRIC_API TileStrategy getTileStrategy() const;
+
+    /**
+     * Enable the per-frame adaption of the tile size for the TileEqualizer.
+     *
+     * The tile size set by setTileSize() is used as the initial size.
+     */
+    EQFABRIC_API void setAutoTileSize( const bool onOff );
+
+    /** @return true if the TileEqualizer adapts the tile size. */
+    EQFABRIC_API bool hasAutoTileSize() const;
+
+    /**
+     * Set the number of frames used to measure the speed of each resource.
+     *
+     * The load and tree equalizer let all children render the same work for
+     * the given number of frames after initialization, and derive the
+     * relative speed of each child from the render times. 0 disables the
+     * calibration and uses the configured usage of the children only.
+     *
+     * The load equalizer measures the calibration frames from its load
+     * history, which is not recorded with a damping of 1. It ignores the
+     * calibration with a warning in this case.
+     */
+    EQFABRIC_API void setCalibrationFrames( const uint32_t frames );
+
+    /** @return the number of frames used for the resource calibration. */
+    EQFABRIC_API uint32_t getCalibrationFrames() const;
     //@}
 
     EQFABRIC_API void serialize( co::DataOStream& os ) const; //!< @internal
@@ -140,6 +182,9 @@ EQFABRIC_API co::DataIStream& operator >> ( co::DataIStream& is,
 
 EQFABRIC_API std::ostream& operator << ( std::ostream& os,
                                          const Equalizer::Mode );
+
+EQFABRIC_API std::ostream& operator << ( std::ostream& os,
+                                         const Equalizer::TileStrategy );
 }
 }
 
@@ -147,6 +192,8 @@ namespace lunchbox
 {
 template<> inline void byteswap( eq::fabric::Equalizer::Mode& value )
     { byteswap( reinterpret_cast< uint32_t& >( value )); }
+template<> inline void byteswap( eq::fabric::Equalizer::TileStrategy& value )
+    { byteswap( reinterpret_cast< uint32_t& >( value )); }
 }
 
 #endif // EQFABRIC_EQUALIZER_H
@@ -34,6 +34,15 @@ static const uint32_t DFR_EQUALIZER         = LOAD_EQUALIZER << 5;
 static const uint32_t FRAMERATE_EQUALIZER   = LOAD_EQUALIZER << 6;
 static const uint32_t EQUALIZER_ALL         = LB_BIT_ALL_32;
 
+/** @name Stages of the dynamic quality ladder of the DFR equalizer. */
+//@{
+static const uint32_t QUALITY_NONE          = 0; //!< no dynamic quality
+static const uint32_t QUALITY_FULL          = 1; //!< all stages at full quality
+static const uint32_t QUALITY_COMPRESSION   = 2; //!< lossy frame compression
+static const uint32_t QUALITY_SUBPIXEL      = 3; //!< fewer subpixel samples
+static const uint32_t QUALITY_ZOOM          = 4; //!< reduced resolution
+//@}
+
 }
 }
 #endif //EQFABRIC_EQUALIZERTYPES_H
@@ -82,6 +82,8 @@ public:
         IATTR_THREAD_MODEL,
         IATTR_LAUNCH_TIMEOUT, //!< Timeout when auto-launching the node
         IATTR_HINT_AFFINITY,
+        /** Reference received uncompressed images in place (OFF, ON) */
+        IATTR_HINT_ZERO_COPY,
         IATTR_LAST,
         IATTR_ALL = IATTR_LAST + 5
     };
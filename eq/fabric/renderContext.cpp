@@ -16,12 +16,40 @@
  */
 
 #include "renderContext.h"
+#include "equalizerTypes.h"
 #include "tile.h"
 
+#include <co/dataIStream.h>
+#include <co/dataOStream.h>
+
 namespace eq
 {
 namespace fabric
 {
+namespace
+{
+enum DirtyBits
+{
+    DIRTY_FRUSTUM    = LB_BIT1,
+    DIRTY_TRANSFORM  = LB_BIT2,
+    DIRTY_VIEW       = LB_BIT3,
+    DIRTY_FRAMEID    = LB_BIT4,
+    DIRTY_PVP        = LB_BIT5,
+    DIRTY_PIXEL      = LB_BIT6,
+    DIRTY_OVERDRAW   = LB_BIT7,
+    DIRTY_VP         = LB_BIT8,
+    DIRTY_OFFSET     = LB_BIT9,
+    DIRTY_RANGE      = LB_BIT10,
+    DIRTY_SUBPIXEL   = LB_BIT11,
+    DIRTY_ZOOM       = LB_BIT12,
+    DIRTY_BUFFER     = LB_BIT13,
+    DIRTY_TASKID     = LB_BIT14,
+    DIRTY_DPLEX      = LB_BIT15,
+    DIRTY_EYE        = LB_BIT16,
+    DIRTY_BUFFERMASK = LB_BIT17,
+    DIRTY_QUALITY    = LB_BIT18
+};
+}
 
 // cppcheck-suppress uninitMemberVar
 RenderContext::RenderContext()
@@ -33,6 +61,9 @@ RenderContext::RenderContext()
     , period( 1 )
     , phase( 0 )
     , eye( EYE_CYCLOP )
+    , quality( 1.f )
+    , qualityStage( QUALITY_NONE )
+    , qualityRatio( 0.f )
 {
 }
 
@@ -49,6 +80,134 @@ void RenderContext::apply( const Tile& tile, const bool local )
     }
 }
 
+void RenderContext::serialize( co::DataOStream& os,
+                               const RenderContext& previous ) const
+{
+    uint32_t dirty = 0;
+    if( frustum != previous.frustum || ortho != previous.ortho )
+        dirty |= DIRTY_FRUSTUM;
+    if( headTransform != previous.headTransform ||
+        orthoTransform != previous.orthoTransform )
+    {
+        dirty |= DIRTY_TRANSFORM;
+    }
+    if( view != previous.view )
+        dirty |= DIRTY_VIEW;
+    if( frameID != previous.frameID )
+        dirty |= DIRTY_FRAMEID;
+    if( pvp != previous.pvp )
+        dirty |= DIRTY_PVP;
+    if( pixel != previous.pixel )
+        dirty |= DIRTY_PIXEL;
+    if( overdraw != previous.overdraw )
+        dirty |= DIRTY_OVERDRAW;
+    if( vp != previous.vp )
+        dirty |= DIRTY_VP;
+    if( offset != previous.offset )
+        dirty |= DIRTY_OFFSET;
+    if( range != previous.range )
+        dirty |= DIRTY_RANGE;
+    if( subPixel != previous.subPixel )
+        dirty |= DIRTY_SUBPIXEL;
+    if( zoom != previous.zoom )
+        dirty |= DIRTY_ZOOM;
+    if( buffer != previous.buffer )
+        dirty |= DIRTY_BUFFER;
+    if( taskID != previous.taskID )
+        dirty |= DIRTY_TASKID;
+    if( period != previous.period || phase != previous.phase )
+        dirty |= DIRTY_DPLEX;
+    if( eye != previous.eye )
+        dirty |= DIRTY_EYE;
+    if( bufferMask != previous.bufferMask )
+        dirty |= DIRTY_BUFFERMASK;
+    if( quality != previous.quality || qualityStage != previous.qualityStage ||
+        qualityRatio != previous.qualityRatio )
+    {
+        dirty |= DIRTY_QUALITY;
+    }
+
+    os << dirty;
+    if( dirty & DIRTY_FRUSTUM )
+        os << frustum << ortho;
+    if( dirty & DIRTY_TRANSFORM )
+        os << headTransform << orthoTransform;
+    if( dirty & DIRTY_VIEW )
+        os << view;
+    if( dirty & DIRTY_FRAMEID )
+        os << frameID;
+    if( dirty & DIRTY_PVP )
+        os << pvp;
+    if( dirty & DIRTY_PIXEL )
+        os << pixel;
+    if( dirty & DIRTY_OVERDRAW )
+        os << overdraw;
+    if( dirty & DIRTY_VP )
+        os << vp;
+    if( dirty & DIRTY_OFFSET )
+        os << offset;
+    if( dirty & DIRTY_RANGE )
+        os << range;
+    if( dirty & DIRTY_SUBPIXEL )
+        os << subPixel;
+    if( dirty & DIRTY_ZOOM )
+        os << zoom;
+    if( dirty & DIRTY_BUFFER )
+        os << buffer;
+    if( dirty & DIRTY_TASKID )
+        os << taskID;
+    if( dirty & DIRTY_DPLEX )
+        os << period << phase;
+    if( dirty & DIRTY_EYE )
+        os << eye;
+    if( dirty & DIRTY_BUFFERMASK )
+        os << bufferMask;
+    if( dirty & DIRTY_QUALITY )
+        os << quality << qualityStage << qualityRatio;
+}
+
+void RenderContext::deserialize( co::DataIStream& is )
+{
+    uint32_t dirty = 0;
+    is >> dirty;
+    if( dirty & DIRTY_FRUSTUM )
+        is >> frustum >> ortho;
+    if( dirty & DIRTY_TRANSFORM )
+        is >> headTransform >> orthoTransform;
+    if( dirty & DIRTY_VIEW )
+        is >> view;
+    if( dirty & DIRTY_FRAMEID )
+        is >> frameID;
+    if( dirty & DIRTY_PVP )
+        is >> pvp;
+    if( dirty & DIRTY_PIXEL )
+        is >> pixel;
+    if( dirty & DIRTY_OVERDRAW )
+        is >> overdraw;
+    if( dirty & DIRTY_VP )
+        is >> vp;
+    if( dirty & DIRTY_OFFSET )
+        is >> offset;
+    if( dirty & DIRTY_RANGE )
+        is >> range;
+    if( dirty & DIRTY_SUBPIXEL )
+        is >> subPixel;
+    if( dirty & DIRTY_ZOOM )
+        is >> zoom;
+    if( dirty & DIRTY_BUFFER )
+        is >> buffer;
+    if( dirty & DIRTY_TASKID )
+        is >> taskID;
+    if( dirty & DIRTY_DPLEX )
+        is >> period >> phase;
+    if( dirty & DIRTY_EYE )
+        is >> eye;
+    if( dirty & DIRTY_BUFFERMASK )
+        is >> bufferMask;
+    if( dirty & DIRTY_QUALITY )
+        is >> quality >> qualityStage >> qualityRatio;
+}
+
 std::ostream& operator << ( std::ostream& os, const RenderContext& ctx )
 {
     return os << "ID " << ctx.frameID << " pvp " << ctx.pvp << " vp " << ctx.vp
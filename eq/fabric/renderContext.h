@@ -40,6 +40,20 @@ public:
     EQFABRIC_API RenderContext();
     EQFABRIC_API void apply( const Tile& tile, bool local ); //!< @internal
 
+    /**
+     * @internal
+     * Serialize the fields which differ from the previous context.
+     *
+     * The receiver has to deserialize into a copy of the same previous
+     * context, i.e., both sides keep the last context of an ordered command
+     * stream.
+     */
+    EQFABRIC_API void serialize( co::DataOStream& os,
+                                 const RenderContext& previous ) const;
+
+    /** @internal Apply the fields changed since the previous context. */
+    EQFABRIC_API void deserialize( co::DataIStream& is );
+
     Frustumf       frustum;        //!< frustum for projection matrix
     Frustumf       ortho;          //!< ortho frustum for projection matrix
 
@@ -66,7 +80,10 @@ public:
     uint32_t       alignToEight;   //!< @internal padding
 
     ColorMask      bufferMask;     //!< color mask for anaglyph stereo
-    bool           alignDummy[28]; //!< @internal padding
+    float          quality;        //!< maximum compression quality of frames
+    uint32_t       qualityStage;   //!< active stage of the quality ladder
+    float          qualityRatio;   //!< degradation of the active stage, 0..1
+    bool           alignDummy[16]; //!< @internal padding
 };
 
 EQFABRIC_API std::ostream& operator << ( std::ostream&, const RenderContext& );
@@ -102,6 +119,9 @@ template<> inline void byteswap( eq::fabric::RenderContext& value )
     byteswap( value.eye );
 
     byteswap( value.bufferMask );
+    byteswap( value.quality );
+    byteswap( value.qualityStage );
+    byteswap( value.qualityRatio );
 }
 }
 
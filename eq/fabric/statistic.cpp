@@ -64,6 +64,12 @@ static StatisticData _statisticData[] =
    "compress",     Vector3f( 0.f, .7f, 1.f ) },
  { Statistic::CHANNEL_FRAME_WAIT_SENDTOKEN,
    "wait send token", Vector3f( 1.f, 0.f, 0.f ) },
+ { Statistic::CHANNEL_TILES_WAIT,
+   "wait tiles",   Vector3f( 1.f, .5f, 0.f ) },
+ { Statistic::CHANNEL_TILES_STEAL,
+   "steal tiles",  Vector3f( .5f, 0.f, 1.f ) },
+ { Statistic::CHANNEL_QUALITY,
+   "quality",      Vector3f( 0.f, 1.f, 1.f ) },
  { Statistic::WINDOW_FINISH,
    "finish",       Vector3f( 1.0f, 1.0f, 0.f ) },
  { Statistic::WINDOW_THROTTLE_FRAMERATE,
@@ -54,6 +54,9 @@ struct Statistic
         CHANNEL_FRAME_COMPRESS, //!< Sampling of frame compression
         /** Sampling of waiting for a send token from the receiver */
         CHANNEL_FRAME_WAIT_SENDTOKEN,
+        CHANNEL_TILES_WAIT, //!< Sampling of waiting on the tile queue
+        CHANNEL_TILES_STEAL, //!< Tiles taken from the range of another node
+        CHANNEL_QUALITY, //!< Active stage of the dynamic quality ladder
         WINDOW_FINISH, //!< Sampling of Window::finish before a swap barrier
         /** Sampling of throttling of framerate_equalizer */
         WINDOW_THROTTLE_FRAMERATE,
@@ -79,10 +82,12 @@ struct Statistic
     int64_t  idleTime;  //!< Absolute idle time of PIPE_IDLE
     int64_t  totalTime;  //!< Total time of a pipe frame (PIPE_IDLE)
 
-    float    ratio; //!< compression ratio (transfer, compression)
+    /** compression ratio (transfer, compression), degradation (quality) */
+    float    ratio;
     float    currentFPS; //!< FPS of last frame (WINDOW_FPS)
     float    averageFPS; //!< Weighted sum averaging of FPS (WINDOW_FPS)
-    float    pad; //!< @internal
+    /** Number of requests or tiles (CHANNEL_TILES_*), stage (quality) */
+    uint32_t count;
 
     char resourceName[32]; //!< A non-unique name of the originator
 
@@ -122,6 +127,7 @@ template<> inline void byteswap( eq::fabric::Statistic& value )
     byteswap( value.ratio );
     byteswap( value.currentFPS );
     byteswap( value.averageFPS );
+    byteswap( value.count );
 }
 }
 
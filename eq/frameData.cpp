@@ -60,6 +60,8 @@ public:
         , depthQuality( 1.f )
         , colorCompressor( EQ_COMPRESSOR_AUTO )
         , depthCompressor( EQ_COMPRESSOR_AUTO )
+        , nPendingDecodes( 0 )
+        , hasDeferredReady( false )
     {}
 
     Images images;
@@ -84,6 +86,17 @@ public:
 
     uint32_t colorCompressor;
     uint32_t depthCompressor;
+
+    /** Protects the pending images and the deferred ready data. */
+    lunchbox::Lock pendingLock;
+
+    /** Announced images which are not yet added. */
+    size_t nPendingDecodes;
+
+    /** Ready data received while images were still decompressed. */
+    bool hasDeferredReady;
+    co::ObjectVersion deferredVersion;
+    fabric::FrameData deferredData;
 };
 }
 
@@ -162,6 +175,10 @@ void FrameData::applyInstanceData( co::DataIStream& is )
 
 void FrameData::clear()
 {
+    // release the received commands referenced by the pixel data
+    for( Image* image : _impl->images )
+        image->reset();
+
     _impl->imageCacheLock.set();
     _impl->imageCache.insert( _impl->imageCache.end(), _impl->images.begin(),
                               _impl->images.end( ));
@@ -233,7 +250,10 @@ Image* FrameData::_allocImage( const eq::Frame::Type type,
     image->setStorageType( type );
     if( setQuality_ )
     {
-        image->setQuality( Frame::BUFFER_COLOR, _impl->colorQuality );
+        // the server lowers the quality to keep the DFR target frame rate
+        image->setQuality( Frame::BUFFER_COLOR,
+                           std::min( _impl->colorQuality,
+                                     getContext().quality ));
         image->setQuality( Frame::BUFFER_DEPTH, _impl->depthQuality );
     }
 
@@ -354,6 +374,21 @@ void FrameData::setReady()
 
 void FrameData::setReady( const co::ObjectVersion& frameData,
                           const fabric::FrameData& data )
+{
+    lunchbox::ScopedWrite mutex( _impl->pendingLock );
+    if( _impl->nPendingDecodes > 0 )
+    {
+        LBASSERT( !_impl->hasDeferredReady );
+        _impl->hasDeferredReady = true;
+        _impl->deferredVersion = frameData;
+        _impl->deferredData = data;
+        return;
+    }
+    _applyReady( frameData, data );
+}
+
+void FrameData::_applyReady( const co::ObjectVersion& frameData,
+                             const fabric::FrameData& data )
 {
     clear();
     LBASSERT(  frameData.version.high() == 0 );
@@ -407,10 +442,36 @@ void FrameData::removeListener( Listener& listener )
     _impl->listeners->erase( i );
 }
 
+void FrameData::beginAddImage()
+{
+    lunchbox::ScopedWrite mutex( _impl->pendingLock );
+    ++_impl->nPendingDecodes;
+}
+
 bool FrameData::addImage( const co::ObjectVersion& frameDataVersion,
                           const PixelViewport& pvp, const Zoom& zoom,
-                          const RenderContext& context, const uint32_t buffers_,
-                          const bool useAlpha, uint8_t* data )
+                          const RenderContext& context, const uint32_t buffers,
+                          const bool useAlpha, uint8_t* data,
+                          const co::ICommand* command )
+{
+    const bool result = _addImage( frameDataVersion, pvp, zoom, context,
+                                   buffers, useAlpha, data, command );
+
+    lunchbox::ScopedWrite mutex( _impl->pendingLock );
+    LBASSERT( _impl->nPendingDecodes > 0 );
+    if( --_impl->nPendingDecodes == 0 && _impl->hasDeferredReady )
+    {
+        _impl->hasDeferredReady = false;
+        _applyReady( _impl->deferredVersion, _impl->deferredData );
+    }
+    return result;
+}
+
+bool FrameData::_addImage( const co::ObjectVersion& frameDataVersion,
+                           const PixelViewport& pvp, const Zoom& zoom,
+                           const RenderContext& context,
+                           const uint32_t buffers_, const bool useAlpha,
+                           uint8_t* data, const co::ICommand* command )
 {
     LBASSERT( _impl->readyVersion < frameDataVersion.version.low( ));
     if( _impl->readyVersion >= frameDataVersion.version.low( ))
@@ -470,10 +531,18 @@ bool FrameData::addImage( const co::ObjectVersion& frameDataVersion,
             image->setZoom( zoom );
             image->setContext( context );
             image->setQuality( buffer, header->quality );
-            image->setPixelData( buffer, pixelData );
+            if( command )
+                image->setPixelData( buffer, pixelData, *command );
+            else
+                image->setPixelData( buffer, pixelData );
         }
     }
 
+    // used by the CPU compositor to skip the background of DB images
+    if( buffers_ & Frame::BUFFER_DEPTH )
+        image->computeSpans();
+
+    lunchbox::ScopedWrite mutex( _impl->pendingLock );
     _impl->pendingImages.push_back( image );
     return true;
 }
@@ -122,7 +122,12 @@ public:
     EQ_API Image* newImage( const Frame::Type type,
                             const DrawableConfig& config );
 
-    /** Clear the frame by recycling the attached images. @version 1.0 */
+    /**
+     * Clear the frame by recycling the attached images.
+     *
+     * The images release the received commands holding their pixel data.
+     * @version 1.0
+     */
     EQ_API void clear();
 
     /** Flush the frame by deleting all images. @version 1.0 */
@@ -195,11 +200,25 @@ public:
     void removeListener( Listener& listener );
     //@}
 
-    /** @internal */
+    /**
+     * @internal Announce an image to be added using addImage().
+     *
+     * A received setReady() is deferred until all announced images have been
+     * added, which allows to add images from multiple threads.
+     */
+    void beginAddImage();
+
+    /**
+     * @internal Add an announced image.
+     *
+     * If a command is given, uncompressed pixel data is referenced in place
+     * instead of being copied, and the command is kept alive by the image.
+     */
     bool addImage( const co::ObjectVersion& frameDataVersion,
                    const PixelViewport& pvp, const Zoom& zoom,
                    const RenderContext& context, const uint32_t buffers,
-                   const bool useAlpha, uint8_t* data );
+                   const bool useAlpha, uint8_t* data,
+                   const co::ICommand* command );
     void setReady( const co::ObjectVersion& frameData,
                    const fabric::FrameData& data ); //!< @internal
 
@@ -222,6 +241,16 @@ private:
     /** Set a specific version ready. */
     void _setReady( const uint64_t version );
 
+    bool _addImage( const co::ObjectVersion& frameDataVersion,
+                    const PixelViewport& pvp, const Zoom& zoom,
+                    const RenderContext& context, const uint32_t buffers,
+                    const bool useAlpha, uint8_t* data,
+                    const co::ICommand* command );
+
+    /** Apply the received images and ready data. */
+    void _applyReady( const co::ObjectVersion& frameData,
+                      const fabric::FrameData& data );
+
     LB_TS_VAR( _commandThread );
 };
 
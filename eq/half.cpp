@@ -368,8 +368,11 @@ half_from_float( float f_ )
   const uint32_t f_m_round_offset           = _uint32_sll( f_m_round_mask,  one              );
   const uint32_t f_m_rounded                = _uint32_add( f_m,             f_m_round_offset );
   const uint32_t f_m_denorm_sa              = _uint32_sub( one,             f_e_half_bias    );
-  const uint32_t f_m_with_hidden            = _uint32_or(  f_m_rounded,     f_m_hidden_bit   );
-  const uint32_t f_m_denorm                 = _uint32_srl( f_m_with_hidden, f_m_denorm_sa    );
+  // add, the rounding may carry into the hidden bit
+  const uint32_t f_m_with_hidden            = _uint32_add( f_m_rounded,     f_m_hidden_bit   );
+  // shifts of 32 bits and more are undefined, values this small underflow to 0
+  const uint32_t f_m_denorm                 = f_m_denorm_sa > 31 ? 0 :
+                                              _uint32_srl( f_m_with_hidden, f_m_denorm_sa );
   const uint32_t h_m_denorm                 = _uint32_srl( f_m_denorm,      f_h_m_pos_offset );
   const uint32_t f_m_rounded_overflow       = _uint32_and( f_m_rounded,     f_m_hidden_bit   );
   const uint32_t m_nan                      = _uint32_srl( f_m,             f_h_m_pos_offset );
@@ -31,10 +31,12 @@
 #include <eq/fabric/renderContext.h>
 
 #include <co/global.h>
+#include <co/iCommand.h>
 
 #include <lunchbox/buffer.h>
 #include <lunchbox/memoryMap.h>
 #include <lunchbox/omp.h>
+#include <lunchbox/scopedMutex.h>
 #include <pression/compressor.h>
 #include <pression/decompressor.h>
 #include <pression/downloader.h>
@@ -43,6 +45,7 @@
 
 #include <boost/filesystem.hpp>
 #include <fstream>
+#include <memory>
 
 #ifdef _WIN32
 #  include <malloc.h>
@@ -74,6 +77,7 @@ public:
         PixelData::reset();
         state = INVALID;
         localBuffer.clear();
+        command = co::ICommand();
         hasAlpha = true;
     }
 
@@ -84,10 +88,25 @@ public:
         LBASSERT( pixelSize > 0 );
         LBASSERT( pvp.hasArea( ));
 
+        releaseCommandBuffer();
         localBuffer.resize( pvp.getArea() * pixelSize );
         pixels = localBuffer.getData();
     }
 
+    void useCommandBuffer( const co::ICommand& owner, void* data )
+    {
+        command = owner;
+        pixels = data;
+    }
+
+    void releaseCommandBuffer()
+    {
+        if( !command.isValid( ))
+            return;
+        command = co::ICommand();
+        pixels = 0;
+    }
+
     enum State
     {
         INVALID,
@@ -102,9 +121,20 @@ public:
      * allocates the memory. */
     lunchbox::Bufferb localBuffer;
 
+    /** Keeps the received command alive while pixels point into it. */
+    co::ICommand command;
+
     bool hasAlpha; //!< The uncompressed pixels contain alpha
 };
 
+/** @internal A row band of the pixel data, compressed independently. */
+struct Band
+{
+    pression::Compressor compressor;
+    PixelData data;
+};
+typedef std::unique_ptr< Band > BandPtr;
+
 enum ActivePlugin
 {
     PLUGIN_FULL,
@@ -130,9 +160,33 @@ struct Attachment
 
     Zoom zoom; //!< zoom factor of pending readback
 
+    /** Row bands of the pixel data for concurrent compression. */
+    std::vector< BandPtr > bands;
+    uint32_t bandCompressor; //!< compressor selected for the current bands
+    lunchbox::Lock bandLock;
+
+    /** Formats of the last transferer lookup and its alpha result. */
+    uint32_t transferInternalFormat;
+    uint32_t transferExternalFormat;
+    float transferQuality;
+    bool transferIgnoreAlpha;
+    bool transferHasAlpha;
+
+    /** Foreground spans of the pixel data, see Image::computeSpans(). */
+    std::vector< Vector2i > spans;
+    std::vector< uint32_t > spanRows; //!< first span of each row, and end
+    bool hasSpans;
+
     Attachment()
         : active( PLUGIN_FULL )
         , quality( 1.f )
+        , bandCompressor( EQ_COMPRESSOR_INVALID )
+        , transferInternalFormat( 0 )
+        , transferExternalFormat( 0 )
+        , transferQuality( 0.f )
+        , transferIgnoreAlpha( false )
+        , transferHasAlpha( false )
+        , hasSpans( false )
         , texture( GL_TEXTURE_RECTANGLE_ARB )
         {}
 
@@ -151,6 +205,9 @@ struct Attachment
         memory.flush();
         texture.flush();
         resetPlugins();
+        spans.clear();
+        spanRows.clear();
+        hasSpans = false;
     }
 
     void resetPlugins()
@@ -161,6 +218,19 @@ struct Attachment
         decompressor[ PLUGIN_LOSSY ].clear();
         downloader[ PLUGIN_FULL ].clear();
         downloader[ PLUGIN_LOSSY ].clear();
+        bands.clear();
+        bandCompressor = EQ_COMPRESSOR_INVALID;
+    }
+
+    /** Invalidate the data derived from the current pixels. */
+    void resetCompressedData()
+    {
+        memory.compressedData = pression::CompressorResult();
+        bandCompressor = EQ_COMPRESSOR_INVALID;
+        for( BandPtr& band : bands )
+            if( band )
+                band->data.compressedData = pression::CompressorResult();
+        hasSpans = false;
     }
 };
 }
@@ -229,6 +299,56 @@ public:
     const Memory& getMemory( const eq::Frame::Buffer buffer ) const
         { return getAttachment( buffer ).memory; }
 
+    /** Select, if needed, the compressor for the buffer's pixel data. */
+    pression::Compressor& setupCompressor( const eq::Frame::Buffer buffer )
+    {
+        Attachment& attachment = getAttachment( buffer );
+        const Memory& memory = attachment.memory;
+        pression::Compressor& compressor =
+            attachment.compressor[ attachment.active ];
+        const uint32_t tokenType = memory.externalFormat;
+
+        if( compressor.isGood() &&
+            compressor.getInfo().tokenType == tokenType &&
+            memory.compressorName != EQ_COMPRESSOR_AUTO )
+        {
+            return compressor;
+        }
+
+        if( memory.compressorName == EQ_COMPRESSOR_AUTO )
+        {
+            const float downloadQuality =
+                attachment.downloader[ attachment.active ].getInfo().quality;
+            const float quality = attachment.quality / downloadQuality;
+
+            compressor.setup( co::Global::getPluginRegistry(), tokenType,
+                              quality, ignoreAlpha );
+        }
+        else
+            compressor.setup( co::Global::getPluginRegistry(),
+                              memory.compressorName );
+
+        if( !compressor.isGood( ))
+        {
+            LBWARN << "No compressor found for token type 0x" << std::hex
+                   << tokenType << std::dec << std::endl;
+            compressor.clear();
+        }
+        return compressor;
+    }
+
+    /** @return the compressor flags for the buffer's pixel data. */
+    uint32_t getCompressorFlags( const eq::Frame::Buffer buffer ) const
+    {
+        uint32_t flags = EQ_COMPRESSOR_DATA_2D;
+        if( ignoreAlpha && getMemory( buffer ).hasAlpha )
+        {
+            LBASSERT( buffer == eq::Frame::BUFFER_COLOR );
+            flags |= EQ_COMPRESSOR_IGNORE_ALPHA;
+        }
+        return flags;
+    }
+
     EqCompressorInfos findTransferers( const eq::Frame::Buffer buffer,
                                        const GLEWContext* gl ) const
     {
@@ -257,6 +377,8 @@ void Image::reset()
 {
     _impl->ignoreAlpha = false;
     _impl->hasPremultipliedAlpha = false;
+    _impl->color.memory.releaseCommandBuffer();
+    _impl->depth.memory.releaseCommandBuffer();
     setPixelViewport( PixelViewport( ));
     setContext( RenderContext( ));
 }
@@ -420,8 +542,8 @@ void Image::setAlphaUsage( const bool enabled )
         return;
 
     _impl->ignoreAlpha = !enabled;
-    _impl->color.memory.compressedData = pression::CompressorResult();
-    _impl->depth.memory.compressedData = pression::CompressorResult();
+    _impl->color.resetCompressedData();
+    _impl->depth.resetCompressedData();
 }
 
 void Image::setQuality( const Frame::Buffer buffer, const float quality )
@@ -548,7 +670,8 @@ bool Image::_startReadback( const Frame::Buffer buffer, const Zoom& zoom,
                             util::ObjectManager& glObjects )
 {
     Attachment& attachment = _impl->getAttachment( buffer );
-    attachment.memory.compressedData = pression::CompressorResult();
+    attachment.resetCompressedData();
+    attachment.memory.releaseCommandBuffer();
 
     if( _impl->type == Frame::TYPE_TEXTURE )
     {
@@ -796,8 +919,8 @@ void Image::setPixelViewport( const PixelViewport& pvp )
     _impl->pvp = pvp;
     _impl->color.memory.state = Memory::INVALID;
     _impl->depth.memory.state = Memory::INVALID;
-    _impl->color.memory.compressedData = pression::CompressorResult();
-    _impl->depth.memory.compressedData = pression::CompressorResult();
+    _impl->color.resetCompressedData();
+    _impl->depth.resetCompressedData();
 }
 
 void Image::clearPixelData( const Frame::Buffer buffer )
@@ -831,6 +954,30 @@ void Image::clearPixelData( const Frame::Buffer buffer )
 #endif
         break;
       }
+
+      // opaque black, like the 8 bit formats above
+      case EQ_COMPRESSOR_DATATYPE_RGBA16F:
+      case EQ_COMPRESSOR_DATATYPE_BGRA16F:
+      {
+        uint16_t* data = reinterpret_cast< uint16_t* >( memory.pixels );
+        const ssize_t nElements = size / sizeof( uint16_t );
+        const uint16_t one = half_from_float( 1.f );
+#pragma omp parallel for
+        for( ssize_t i = 0; i < nElements; ++i )
+            data[i] = ( i % 4 == 3 ) ? one : 0;
+        break;
+      }
+      case EQ_COMPRESSOR_DATATYPE_RGBA32F:
+      case EQ_COMPRESSOR_DATATYPE_BGRA32F:
+      {
+        float* data = reinterpret_cast< float* >( memory.pixels );
+        const ssize_t nElements = size / sizeof( float );
+#pragma omp parallel for
+        for( ssize_t i = 0; i < nElements; ++i )
+            data[i] = ( i % 4 == 3 ) ? 1.f : 0.f;
+        break;
+      }
+
       default:
         LBWARN << "Unknown external format " << memory.externalFormat
                << ", initializing to 0" << std::endl;
@@ -841,42 +988,87 @@ void Image::clearPixelData( const Frame::Buffer buffer )
 
 void Image::validatePixelData( const Frame::Buffer buffer )
 {
-    Memory& memory = _impl->getAttachment( buffer ).memory;
-    memory.useLocalBuffer();
-    memory.state = Memory::VALID;
-    memory.compressedData = pression::CompressorResult();
+    Attachment& attachment = _impl->getAttachment( buffer );
+    attachment.memory.useLocalBuffer();
+    attachment.memory.state = Memory::VALID;
+    attachment.resetCompressedData();
 }
 
 void Image::setPixelData( const Frame::Buffer buffer, const PixelData& pixels )
 {
-    Memory& memory = _impl->getMemory( buffer );
+    _setPixelData( buffer, pixels, 0 );
+}
+
+void Image::setPixelData( const Frame::Buffer buffer, const PixelData& pixels,
+                          const co::ICommand& command )
+{
+    _setPixelData( buffer, pixels, &command );
+}
+
+void Image::allocPixelData( const Frame::Buffer buffer,
+                            const PixelData& pixels )
+{
+    _setPixelFormat( buffer, pixels );
+    if( getPixelDataSize( buffer ) > 0 )
+        validatePixelData( buffer );
+}
+
+void Image::_setPixelFormat( const Frame::Buffer buffer,
+                             const PixelData& pixels )
+{
+    Attachment& attachment = _impl->getAttachment( buffer );
+    Memory& memory = attachment.memory;
     memory.externalFormat = pixels.externalFormat;
     memory.internalFormat = pixels.internalFormat;
     memory.pixelSize = pixels.pixelSize;
     memory.pvp       = pixels.pvp;
     memory.state     = Memory::INVALID;
-    memory.compressedData = pression::CompressorResult();
-    memory.hasAlpha = false;
+    attachment.resetCompressedData();
+
+    // The transferer lookup walks and copies all plugin infos. Images are
+    // typically set with the same formats every frame, reuse the last result.
+    if( attachment.transferInternalFormat == memory.internalFormat &&
+        attachment.transferExternalFormat == memory.externalFormat &&
+        attachment.transferQuality == attachment.quality &&
+        attachment.transferIgnoreAlpha == _impl->ignoreAlpha )
+    {
+        memory.hasAlpha = attachment.transferHasAlpha;
+        return;
+    }
 
+    memory.hasAlpha = false;
     const EqCompressorInfos& transferrers = _impl->findTransferers( buffer,
                                                            0 /*GLEW context*/ );
     if( transferrers.empty( ))
-        LBWARN << "No upload engines found for given pixel data" << std::endl;
-    else
     {
-        memory.hasAlpha =
-            transferrers.front().capabilities & EQ_COMPRESSOR_IGNORE_ALPHA;
+        LBWARN << "No upload engines found for given pixel data" << std::endl;
+        return;
+    }
+
+    memory.hasAlpha =
+        transferrers.front().capabilities & EQ_COMPRESSOR_IGNORE_ALPHA;
 #ifndef NDEBUG
-        for( EqCompressorInfosCIter i = transferrers.begin();
-             i != transferrers.end(); ++i )
-        {
-            LBASSERTINFO( memory.hasAlpha ==
-                          bool( i->capabilities & EQ_COMPRESSOR_IGNORE_ALPHA ),
-                          "Uploaders don't agree on alpha state of external " <<
-                          "format: " << transferrers.front() << " != " << *i );
-        }
-#endif
+    for( EqCompressorInfosCIter i = transferrers.begin();
+         i != transferrers.end(); ++i )
+    {
+        LBASSERTINFO( memory.hasAlpha ==
+                      bool( i->capabilities & EQ_COMPRESSOR_IGNORE_ALPHA ),
+                      "Uploaders don't agree on alpha state of external " <<
+                      "format: " << transferrers.front() << " != " << *i );
     }
+#endif
+    attachment.transferInternalFormat = memory.internalFormat;
+    attachment.transferExternalFormat = memory.externalFormat;
+    attachment.transferQuality = attachment.quality;
+    attachment.transferIgnoreAlpha = _impl->ignoreAlpha;
+    attachment.transferHasAlpha = memory.hasAlpha;
+}
+
+void Image::_setPixelData( const Frame::Buffer buffer, const PixelData& pixels,
+                           const co::ICommand* command )
+{
+    _setPixelFormat( buffer, pixels );
+    Memory& memory = _impl->getMemory( buffer );
 
     const uint32_t size = getPixelDataSize( buffer );
     LBASSERT( size > 0 );
@@ -885,6 +1077,14 @@ void Image::setPixelData( const Frame::Buffer buffer, const PixelData& pixels )
 
     if( pixels.compressedData.compressor <= EQ_COMPRESSOR_NONE )
     {
+        if( pixels.pixels && command )
+        {
+            // reference the pixels in place, the command owns the memory
+            memory.useCommandBuffer( *command, pixels.pixels );
+            memory.state = Memory::VALID;
+            return;
+        }
+
         validatePixelData( buffer ); // alloc memory for pixels
 
         if( pixels.pixels )
@@ -938,7 +1138,7 @@ bool Image::allocCompressor( const Frame::Buffer buffer, const uint32_t name )
     pression::Compressor& compressor = attachment.compressor[attachment.active];
     if( name <= EQ_COMPRESSOR_NONE )
     {
-        attachment.memory.compressedData = pression::CompressorResult();
+        attachment.resetCompressedData();
         compressor.clear();
         return true;
     }
@@ -946,7 +1146,7 @@ bool Image::allocCompressor( const Frame::Buffer buffer, const uint32_t name )
     if( compressor.uses( name ))
         return true;
 
-    attachment.memory.compressedData = pression::CompressorResult();
+    attachment.resetCompressedData();
     compressor.setup( co::Global::getPluginRegistry(), name );
     LBLOG( LOG_PLUGIN ) << "Instantiated compressor of type 0x" << std::hex
                         << name << std::dec << std::endl;
@@ -1012,46 +1212,14 @@ const PixelData& Image::compressPixelData( const Frame::Buffer buffer )
         return memory;
     }
 
-    pression::Compressor& compressor = attachment.compressor[attachment.active];
-
-    if( !compressor.isGood() ||
-        compressor.getInfo().tokenType != getExternalFormat( buffer ) ||
-        memory.compressorName == EQ_COMPRESSOR_AUTO )
-    {
-        if( memory.compressorName == EQ_COMPRESSOR_AUTO )
-        {
-            const uint32_t tokenType = getExternalFormat( buffer );
-            const float downloadQuality =
-                attachment.downloader[ attachment.active ].getInfo().quality;
-            const float quality = attachment.quality / downloadQuality;
-
-            compressor.setup( co::Global::getPluginRegistry(), tokenType,
-                               quality, _impl->ignoreAlpha );
-        }
-        else
-            compressor.setup( co::Global::getPluginRegistry(),
-                              memory.compressorName );
-
-        if( !compressor.isGood( ))
-        {
-            LBWARN << "No compressor found for token type 0x" << std::hex
-                   << getExternalFormat( buffer ) << std::dec << std::endl;
-            compressor.clear();
-        }
-    }
-
+    pression::Compressor& compressor = _impl->setupCompressor( buffer );
     memory.compressedData.compressor = compressor.getInfo().name;
     LBASSERT( memory.compressedData.compressor != EQ_COMPRESSOR_AUTO );
     LBASSERT( memory.compressedData.compressor != EQ_COMPRESSOR_INVALID );
     if( memory.compressedData.compressor == EQ_COMPRESSOR_NONE )
         return memory;
 
-    memory.compressorFlags = EQ_COMPRESSOR_DATA_2D;
-    if( _impl->ignoreAlpha && memory.hasAlpha )
-    {
-        LBASSERT( buffer == Frame::BUFFER_COLOR );
-        memory.compressorFlags |= EQ_COMPRESSOR_IGNORE_ALPHA;
-    }
+    memory.compressorFlags = _impl->getCompressorFlags( buffer );
 
     uint64_t inDims[4];
     memory.pvp.convertToPlugin( inDims );
@@ -1060,6 +1228,162 @@ const PixelData& Image::compressPixelData( const Frame::Buffer buffer )
     return memory;
 }
 
+const PixelData& Image::compressPixelData( const Frame::Buffer buffer,
+                                           const size_t index,
+                                           const size_t nBands )
+{
+    LBASSERT( getPixelDataSize( buffer ) > 0 );
+    LBASSERT( index < nBands );
+
+    Attachment& attachment = _impl->getAttachment( buffer );
+    const Memory& memory = attachment.memory;
+    Band* band = 0;
+    uint32_t name = EQ_COMPRESSOR_INVALID;
+    {
+        lunchbox::ScopedWrite mutex( attachment.bandLock );
+        if( attachment.bands.size() != nBands )
+        {
+            attachment.bands.clear();
+            attachment.bands.resize( nBands );
+        }
+
+        BandPtr& bandPtr = attachment.bands[ index ];
+        if( !bandPtr )
+            bandPtr.reset( new Band );
+        band = bandPtr.get();
+        if( band->data.compressedData.isCompressed( ))
+            return band->data;
+
+        // all bands use the compressor selected for the full image
+        if( attachment.bandCompressor == EQ_COMPRESSOR_INVALID )
+            attachment.bandCompressor =
+                memory.compressorName == EQ_COMPRESSOR_NONE ?
+                    EQ_COMPRESSOR_NONE :
+                    _impl->setupCompressor( buffer ).getInfo().name;
+        name = attachment.bandCompressor;
+    }
+    LBASSERT( name != EQ_COMPRESSOR_AUTO );
+    LBASSERT( name != EQ_COMPRESSOR_INVALID );
+
+    // rows [begin, end) of the pixel data
+    const size_t height = memory.pvp.h;
+    const size_t begin = height * index / nBands;
+    const size_t end = height * ( index + 1 ) / nBands;
+    const size_t rowSize = memory.pvp.w * memory.pixelSize;
+
+    PixelData& data = band->data;
+    data.internalFormat = memory.internalFormat;
+    data.externalFormat = memory.externalFormat;
+    data.pixelSize = memory.pixelSize;
+    data.pvp = PixelViewport( memory.pvp.x, memory.pvp.y + int32_t( begin ),
+                              memory.pvp.w, int32_t( end - begin ));
+    data.pixels = reinterpret_cast< uint8_t* >( memory.pixels ) +
+                  begin * rowSize;
+    data.compressorName = name;
+    data.compressorFlags = _impl->getCompressorFlags( buffer );
+    data.compressedData = pression::CompressorResult();
+    data.compressedData.compressor = name;
+    if( name == EQ_COMPRESSOR_NONE || !data.pvp.hasArea( ))
+        return data;
+
+    pression::Compressor& compressor = band->compressor;
+    if( !compressor.uses( name ))
+        compressor.setup( co::Global::getPluginRegistry(), name );
+    if( !compressor.isGood( ))
+    {
+        LBWARN << "Can't instantiate compressor 0x" << std::hex << name
+               << std::dec << " for image band" << std::endl;
+        data.compressorName = EQ_COMPRESSOR_NONE;
+        data.compressedData.compressor = EQ_COMPRESSOR_NONE;
+        return data;
+    }
+
+    uint64_t inDims[4];
+    data.pvp.convertToPlugin( inDims );
+    compressor.compress( data.pixels, inDims, data.compressorFlags );
+    data.compressedData = compressor.getResult();
+    return data;
+}
+
+bool Image::computeSpans()
+{
+    // Shorter background gaps are merged into the spans, since they are
+    // cheaper to composite than to skip
+    static const int32_t minGap = 16;
+    static const uint32_t background = 0xffffffffu;
+
+    Attachment& attachment = _impl->depth;
+    const Memory& memory = attachment.memory;
+    if( !hasPixelData( Frame::BUFFER_DEPTH ) ||
+        memory.externalFormat != EQ_COMPRESSOR_DATATYPE_DEPTH_UNSIGNED_INT )
+    {
+        return false;
+    }
+    if( attachment.hasSpans )
+        return true;
+
+    const PixelViewport& pvp = memory.pvp;
+    const uint32_t* depth = reinterpret_cast< const uint32_t* >(
+        memory.pixels );
+    std::vector< Vector2i >& spans = attachment.spans;
+    std::vector< uint32_t >& rows = attachment.spanRows;
+
+    spans.clear();
+    rows.resize( pvp.h + 1 );
+    rows[0] = 0;
+    for( int32_t y = 0; y < pvp.h; ++y )
+    {
+        const uint32_t* row = depth + size_t( y ) * pvp.w;
+        const size_t first = spans.size();
+        int32_t x = 0;
+        while( x < pvp.w )
+        {
+            while( x < pvp.w && row[x] == background )
+                ++x;
+            if( x == pvp.w )
+                break;
+
+            const int32_t begin = x;
+            while( x < pvp.w && row[x] != background )
+                ++x;
+
+            if( spans.size() > first && begin - spans.back().y() < minGap )
+                spans.back().y() = x;
+            else
+                spans.push_back( Vector2i( begin, x ));
+        }
+        rows[ y + 1 ] = uint32_t( spans.size( ));
+    }
+
+    attachment.hasSpans = true;
+    return true;
+}
+
+bool Image::hasSpans() const
+{
+    return _impl->depth.hasSpans;
+}
+
+const Vector2i* Image::getSpans( const int32_t row, size_t& nSpans ) const
+{
+    const Attachment& attachment = _impl->depth;
+    LBASSERT( attachment.hasSpans );
+    LBASSERT( row >= 0 && row < attachment.memory.pvp.h );
+
+    const uint32_t begin = attachment.spanRows[ row ];
+    nSpans = attachment.spanRows[ row + 1 ] - begin;
+    return nSpans == 0 ? 0 : &attachment.spans[ begin ];
+}
+
+bool Image::isBackground( const int32_t begin, const int32_t end ) const
+{
+    const Attachment& attachment = _impl->depth;
+    LBASSERT( attachment.hasSpans );
+    LBASSERT( begin >= 0 && begin <= end && end <= attachment.memory.pvp.h );
+
+    return attachment.spanRows[ begin ] == attachment.spanRows[ end ];
+}
+
 
 //---------------------------------------------------------------------------
 // File IO
@@ -194,6 +194,24 @@ public:
     /** @return the pixel data, compressing it if needed. @version 1.0 */
     EQ_API const PixelData& compressPixelData( const Frame::Buffer );
 
+    /**
+     * Compress one horizontal band of the pixel data.
+     *
+     * The pixel data is split into nBands bands of full rows. Each band uses
+     * its own compressor instance, so that different bands of the same buffer
+     * can be compressed concurrently. Concurrent calls have to use the same
+     * number of bands. The returned pixel data references the image memory
+     * and stays valid until the pixel data of the buffer is modified.
+     *
+     * @param buffer the image buffer to compress.
+     * @param band the index of the band to compress.
+     * @param nBands the number of bands.
+     * @return the pixel data of the band, compressed if possible.
+     * @version 1.13
+     */
+    EQ_API const PixelData& compressPixelData( const Frame::Buffer buffer,
+                                               size_t band, size_t nBands );
+
     /**
      * @return true if the image has valid pixel data for the buffer.
      * @version 1.0
@@ -227,6 +245,20 @@ public:
     /** Allocate an image buffer without initialization. @version 1.0 */
     EQ_API void validatePixelData( const Frame::Buffer buffer );
 
+    /**
+     * Set the format and size of the pixel data without initialization.
+     *
+     * Same as setPixelData() without pixels, except that the buffer is not
+     * cleared. The pixels of the data are ignored. Memory allocated for
+     * previous pixel data is reused if it is large enough.
+     *
+     * @param buffer the image buffer to allocate.
+     * @param data the format and pixel viewport of the pixel data.
+     * @version 1.13
+     */
+    EQ_API void allocPixelData( const Frame::Buffer buffer,
+                                const PixelData& data );
+
     /**
      * Set the pixel data of the given image buffer.
      *
@@ -241,6 +273,61 @@ public:
     EQ_API void setPixelData( const Frame::Buffer buffer,
                               const PixelData& data );
 
+    /**
+     * Set the pixel data of the given image buffer from a received command.
+     *
+     * Uncompressed pixel data is not copied. The image references the pixels
+     * in the command buffer and keeps the command alive until the pixel data
+     * is replaced, or the image is reset or flushed. The referenced pixels must
+     * not be modified. Compressed pixel data is decompressed as usual.
+     *
+     * @param buffer the image buffer to set.
+     * @param data the pixel data.
+     * @param command the command holding the memory of the pixel data.
+     * @version 1.13
+     */
+    EQ_API void setPixelData( const Frame::Buffer buffer,
+                              const PixelData& data,
+                              const co::ICommand& command );
+
+    /**
+     * Compute the spans of foreground pixels of each row.
+     *
+     * Foreground pixels are the pixels with a depth value in front of the far
+     * plane. Background gaps shorter than a few pixels are included in the
+     * surrounding spans. The spans are kept until the pixel data is modified,
+     * and are used by the CPU compositor and the image transmission to skip
+     * background regions.
+     *
+     * @return true if the spans are available, false if the image has no
+     *         DEPTH_UNSIGNED_INT pixel data.
+     * @version 1.13
+     */
+    EQ_API bool computeSpans();
+
+    /** @return true if the spans are computed. @version 1.13 */
+    EQ_API bool hasSpans() const;
+
+    /**
+     * Get the foreground spans of one row.
+     *
+     * Each span contains the begin and end column of the foreground pixels,
+     * relative to the depth pixel viewport.
+     *
+     * @param row the row, relative to the depth pixel viewport.
+     * @param nSpans returns the number of spans.
+     * @return the spans of the row, or 0 if the row has no foreground pixels.
+     * @version 1.13
+     */
+    EQ_API const Vector2i* getSpans( int32_t row, size_t& nSpans ) const;
+
+    /**
+     * @return true if the rows [begin, end), relative to the depth pixel
+     *         viewport, have no foreground pixels according to the spans.
+     * @version 1.13
+     */
+    EQ_API bool isBackground( int32_t begin, int32_t end ) const;
+
     /**
      * Set alpha data preservation during download and compression.
      * @version 1.0
@@ -408,6 +495,12 @@ private:
                              const uint32_t pixelSize,
                              const bool hasAlpha );
 
+    /** Set the format of the pixel data, invalidating the buffer. */
+    void _setPixelFormat( const Frame::Buffer buffer, const PixelData& data );
+
+    void _setPixelData( const Frame::Buffer buffer, const PixelData& data,
+                        const co::ICommand* command );
+
     bool _readback( const Frame::Buffer buffer, const Zoom& zoom,
                     util::ObjectManager& glObjects );
 
@@ -40,8 +40,11 @@
 #include <co/connection.h>
 #include <co/global.h>
 #include <co/objectICommand.h>
+#include <lunchbox/omp.h>
 #include <lunchbox/scopedMutex.h>
 
+#include <algorithm>
+
 namespace eq
 {
 namespace
@@ -81,6 +84,32 @@ private:
     co::CommandQueue _queue;
 };
 
+/** Decompresses received images, all workers share one queue. */
+class DecompressThread : public lunchbox::Thread
+{
+public:
+    DecompressThread( eq::Node& node, co::CommandQueue& queue,
+                      const uint32_t index )
+        : _node( node )
+        , _queue( queue )
+        , _index( index )
+    {}
+    virtual ~DecompressThread() {}
+
+protected:
+    bool init() override
+    {
+        setName( "Decomp" + std::to_string( _index ));
+        return true;
+    }
+    void run() override;
+
+private:
+    eq::Node& _node;
+    co::CommandQueue& _queue;
+    const uint32_t _index;
+};
+
 class Node
 {
 public:
@@ -88,8 +117,34 @@ public:
         : state( STATE_STOPPED )
         , finishedFrame( 0 )
         , unlockedFrame( 0 )
+        , decompressQueue( co::Global::getCommandQueueLimit( ))
     {}
 
+    ~Node() { LBASSERT( decompressors.empty( )); }
+
+    void startDecompressors( eq::Node& node )
+    {
+        const uint32_t nThreads = std::max( 1u, lunchbox::OMP::getNThreads( ));
+        for( uint32_t i = 0; i < nThreads; ++i )
+        {
+            decompressors.push_back(
+                new DecompressThread( node, decompressQueue, i ));
+            decompressors.back()->start();
+        }
+    }
+
+    void joinDecompressors()
+    {
+        for( size_t i = 0; i < decompressors.size(); ++i )
+            decompressQueue.push( co::ICommand( )); // wake up to exit
+        for( DecompressThread* thread : decompressors )
+        {
+            thread->join();
+            delete thread;
+        }
+        decompressors.clear();
+    }
+
     /** The configInit/configExit state. */
     lunchbox::Monitor< State > state;
 
@@ -109,6 +164,10 @@ public:
     lunchbox::Lockable< FrameDataHash > frameDatas;
 
     TransmitThread transmitter;
+
+    /** Received image data to be decompressed by the decompressors. */
+    co::CommandQueue decompressQueue;
+    std::vector< DecompressThread* > decompressors;
 };
 
 }
@@ -513,6 +572,18 @@ void detail::TransmitThread::run()
     }
 }
 
+void detail::DecompressThread::run()
+{
+    while( true )
+    {
+        co::ICommand command = _queue.pop();
+        if( !command.isValid( ))
+            return; // exit thread
+
+        _node._decompressFrameData( command, _index );
+    }
+}
+
 void Node::dirtyClientExit()
 {
     const Pipes& pipes = getPipes();
@@ -523,6 +594,7 @@ void Node::dirtyClientExit()
     }
     getTransmitterQueue()->push( co::ICommand( )); // wake up to exit
     _impl->transmitter.join();
+    _impl->joinDecompressors();
 }
 
 //---------------------------------------------------------------------------
@@ -590,6 +662,7 @@ bool Node::_cmdConfigInit( co::ICommand& cmd )
     _setAffinity();
 
     _impl->transmitter.start();
+    _impl->startDecompressors( *this );
     const uint64_t result = configInit( initID );
 
     if( getIAttribute( IATTR_THREAD_MODEL ) == eq::UNDEFINED )
@@ -620,6 +693,7 @@ bool Node::_cmdConfigExit( co::ICommand& cmd )
     _impl->state = configExit() ? STATE_STOPPED : STATE_FAILED;
     getTransmitterQueue()->push( co::ICommand( )); // wake up to exit
     _impl->transmitter.join();
+    _impl->joinDecompressors();
     _flushObjects();
 
     getConfig()->send( getLocalNode(),
@@ -711,6 +785,22 @@ bool Node::_cmdFrameDataTransmit( co::ICommand& cmd )
 {
     co::ObjectICommand command( cmd );
 
+    const co::ObjectVersion& frameDataVersion =
+                                            command.read< co::ObjectVersion >();
+    FrameDataPtr frameData = getFrameData( frameDataVersion );
+    LBASSERT( !frameData->isReady() );
+
+    // decompress on the worker threads, the frame data delays its readiness
+    // until all announced images are added
+    frameData->beginAddImage();
+    _impl->decompressQueue.push( cmd );
+    return true;
+}
+
+void Node::_decompressFrameData( co::ICommand& cmd, const uint32_t worker )
+{
+    co::ObjectICommand command( cmd );
+
     const co::ObjectVersion& frameDataVersion =
                                             command.read< co::ObjectVersion >();
     const PixelViewport& pvp = command.read< PixelViewport >();
@@ -732,14 +822,18 @@ bool Node::_cmdFrameDataTransmit( co::ICommand& cmd )
     LBASSERT( !frameData->isReady() );
 
     NodeStatistics event( Statistic::NODE_FRAME_DECOMPRESS, this,
-                          frameNumber );
+                          frameNumber, worker );
+
+    // Uncompressed images may reference the command buffer in place, which
+    // saves one copy of the pixels on fast links without compression.
+    const bool zeroCopy = getIAttribute( IATTR_HINT_ZERO_COPY ) == ON;
 
     // Note on the const_cast: since the PixelData structure stores non-const
     // pointers, we have to go non-const at some point, even though we do not
     // modify the data.
     LBCHECK( frameData->addImage( frameDataVersion, pvp, zoom, context, buffers,
-                                  useAlpha, const_cast< uint8_t* >( data )));
-    return true;
+                                  useAlpha, const_cast< uint8_t* >( data ),
+                                  zeroCopy ? &cmd : 0 ));
 }
 
 bool Node::_cmdFrameDataReady( co::ICommand& cmd )
@@ -757,7 +851,6 @@ bool Node::_cmdFrameDataReady( co::ICommand& cmd )
     LBASSERT( frameData );
     LBASSERT( !frameData->isReady() );
     frameData->setReady( frameDataVersion, data );
-    LBASSERT( frameData->isReady() );
     return true;
 }
 
@@ -28,7 +28,7 @@
 
 namespace eq
 {
-namespace detail { class Node; }
+namespace detail { class Node; class DecompressThread; }
 
 /**
  * A Node represents a single computer in the cluster.
@@ -284,6 +284,10 @@ private:
     bool _cmdFrameDataReady( co::ICommand& command );
     bool _cmdSetAffinity( co::ICommand& command );
 
+    /** Decompress received image data, called by the decompress threads. */
+    void _decompressFrameData( co::ICommand& command, uint32_t worker );
+    friend class detail::DecompressThread;
+
     LB_TS_VAR( _nodeThread );
 };
 }
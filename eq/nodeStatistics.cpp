@@ -24,6 +24,7 @@
 #include "node.h"
 
 #include <cstdio>
+#include <cstring>
 
 #ifdef _MSC_VER
 #  define snprintf _snprintf
@@ -33,7 +34,8 @@ namespace eq
 {
 
 NodeStatistics::NodeStatistics( const Statistic::Type type, Node* node,
-                                const uint32_t frameNumber )
+                                const uint32_t frameNumber,
+                                const int32_t worker )
         : StatisticSampler< Node >( type, node, frameNumber )
 {
     const std::string& name = node->getName();
@@ -43,6 +45,13 @@ NodeStatistics::NodeStatistics( const Statistic::Type type, Node* node,
     else
         snprintf( event.data.statistic.resourceName, 32, "%s", name.c_str( ));
 
+    if( worker >= 0 )
+    {
+        char* resourceName = event.data.statistic.resourceName;
+        const size_t length = strnlen( resourceName, 31 );
+        snprintf( resourceName + length, 32 - length, " #%d", worker );
+    }
+
     event.data.statistic.resourceName[31] = 0;
 
     co::LocalNodePtr localNode = node->getLocalNode();
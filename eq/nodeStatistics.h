@@ -27,8 +27,14 @@ namespace eq
     class NodeStatistics : public StatisticSampler< Node >
     {
     public:
+        /**
+         * Construct a new statistics sampler.
+         *
+         * Samples of different workers, e.g., decompression threads, are
+         * reported as separate resources.
+         */
         NodeStatistics( const Statistic::Type type, Node* node,
-                        const uint32_t frameNumber );
+                        const uint32_t frameNumber, const int32_t worker = -1 );
         ~NodeStatistics();
     };
 }
@@ -92,7 +92,9 @@ enum State
 typedef stde::hash_map< uint128_t, Frame* > FrameHash;
 typedef stde::hash_map< uint128_t, FrameDataPtr > FrameDataHash;
 typedef stde::hash_map< uint128_t, View* > ViewHash;
-typedef stde::hash_map< uint128_t, co::QueueSlave* > QueueHash;
+/** A mapped tile queue slave and the batch size it prefetches. */
+typedef std::pair< co::QueueSlave*, uint32_t > Queue;
+typedef stde::hash_map< uint128_t, Queue > QueueHash;
 typedef FrameHash::const_iterator FrameHashCIter;
 typedef FrameDataHash::const_iterator FrameDataHashCIter;
 typedef ViewHash::const_iterator ViewHashCIter;
@@ -678,23 +680,31 @@ void Pipe::flushFrames( util::ObjectManager& om )
     _impl->outputFrameDatas.clear();
 }
 
-co::QueueSlave* Pipe::getQueue( const uint128_t& queueID )
+co::QueueSlave* Pipe::getQueue( const uint128_t& queueID,
+                                const uint32_t batchSize )
 {
     LB_TS_THREAD( _pipeThread );
     if( queueID == 0 )
         return 0;
 
-    co::QueueSlave* queue = _impl->queues[ queueID ];
-    if( !queue )
-    {
-        queue = new co::QueueSlave;
-        ClientPtr client = getClient();
-        LBCHECK( client->mapObject( queue, queueID ));
+    Queue& queue = _impl->queues[ queueID ];
+    if( queue.first && queue.second == batchSize )
+        return queue.first;
 
-        _impl->queues[ queueID ] = queue;
+    // The prefetch of a slave is fixed when it is created. The tile equalizer
+    // changes batch sizes between frames, when the old slave has been drained.
+    ClientPtr client = getClient();
+    if( queue.first )
+    {
+        client->unmapObject( queue.first );
+        delete queue.first;
     }
 
-    return queue;
+    // request the next batch when half of the current one is drawn
+    queue.first = new co::QueueSlave( batchSize / 2, batchSize );
+    queue.second = batchSize;
+    LBCHECK( client->mapObject( queue.first, queueID ));
+    return queue.first;
 }
 
 void Pipe::_flushQueues()
@@ -704,7 +714,7 @@ void Pipe::_flushQueues()
 
     for( QueueHashCIter i = _impl->queues.begin(); i !=_impl->queues.end(); ++i)
     {
-        co::QueueSlave* queue = i->second;
+        co::QueueSlave* queue = i->second.first;
         client->unmapObject( queue );
         delete queue;
     }
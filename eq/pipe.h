@@ -124,8 +124,15 @@ public:
     Frame* getFrame( const co::ObjectVersion& frameVersion,
                      const Eye eye, const bool output );
 
-    /** @internal @return the queue for the given identifier and version. */
-    co::QueueSlave* getQueue( const uint128_t& queueID );
+    /**
+     * @internal
+     * @param queueID the identifier of the queue.
+     * @param batchSize the number of items requested at once. The queue is
+     *                  re-created when it differs from the last call.
+     * @return the queue for the given identifier.
+     */
+    co::QueueSlave* getQueue( const uint128_t& queueID,
+                              const uint32_t batchSize );
 
     /** @internal Clear the frame cache and delete all frames. */
     void flushFrames( util::ObjectManager& om );
@@ -312,6 +312,7 @@ void Channel::configInit( const uint128_t& initID, const uint32_t /*frame*/ )
     LBLOG( LOG_INIT ) << "Init channel" << std::endl;
     getWindow()->send( fabric::CMD_WINDOW_CREATE_CHANNEL ) << getID();
     send( fabric::CMD_CHANNEL_CONFIG_INIT ) << initID;
+    _lastContext = RenderContext(); // client resets on config init
 }
 
 bool Channel::syncConfigInit()
@@ -381,8 +382,8 @@ bool Channel::update( const uint128_t& frameID, const uint32_t frameNumber )
 
     RenderContext context;
     _setupRenderContext( frameID, context );
-    send( fabric::CMD_CHANNEL_FRAME_START )
-            << context << getVersion() << frameNumber;
+    send( fabric::CMD_CHANNEL_FRAME_START, context )
+            << getVersion() << frameNumber;
     LBLOG( LOG_TASKS ) << "TASK channel " << getName() << " start frame  "
                        << frameNumber << std::endl;
 
@@ -406,7 +407,7 @@ bool Channel::update( const uint128_t& frameID, const uint32_t frameNumber )
         updated |= visitor.isUpdated();
     }
 
-    send( fabric::CMD_CHANNEL_FRAME_FINISH ) << context << frameNumber;
+    send( fabric::CMD_CHANNEL_FRAME_FINISH, context ) << frameNumber;
     LBLOG( LOG_TASKS ) << "TASK channel " << getName() << " finish frame  "
                            << frameNumber << std::endl;
     _lastDrawCompound = 0;
@@ -419,6 +420,15 @@ co::ObjectOCommand Channel::send( const uint32_t cmd )
     return getNode()->send( cmd, getID( ));
 }
 
+co::ObjectOCommand Channel::send( const uint32_t cmd,
+                                  const RenderContext& context )
+{
+    co::ObjectOCommand command = send( cmd );
+    context.serialize( command, _lastContext );
+    _lastContext = context;
+    return command;
+}
+
 //---------------------------------------------------------------------------
 // Listener interface
 //---------------------------------------------------------------------------
@@ -439,9 +449,9 @@ void Channel::removeListener(  ChannelListener* listener )
         _listeners.erase( i );
 }
 
-void Channel::_fireLoadData( const uint32_t frameNumber,
-                             const fabric::Statistics& statistics,
-                             const Viewport& region )
+void Channel::fireLoadData( const uint32_t frameNumber,
+                            const fabric::Statistics& statistics,
+                            const Viewport& region )
 {
     LB_TS_SCOPED( _serverThread );
     for( ChannelListener* listener : _listeners )
@@ -480,7 +490,7 @@ bool Channel::_cmdFrameFinishReply( co::ICommand& cmd )
     const uint32_t frameNumber = command.read< uint32_t >();
     const Statistics& statistics = command.read< Statistics >();
 
-    _fireLoadData( frameNumber, statistics, region );
+    fireLoadData( frameNumber, statistics, region );
     return true;
 }
 
@@ -511,6 +521,7 @@ void Channel::output( std::ostream& os ) const
 
         os << ( i==IATTR_HINT_STATISTICS ? "hint_statistics   " :
                 i==IATTR_HINT_SENDTOKEN ?  "hint_sendtoken    " :
+                i==IATTR_HINT_TILE_PIPELINE ? "hint_tile_pipeline " :
                                            "ERROR " )
            << static_cast< fabric::IAttribute >( value ) << std::endl;
     }
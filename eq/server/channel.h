@@ -25,6 +25,7 @@
 
 #include <eq/fabric/channel.h>       // base class
 #include <eq/fabric/pixelViewport.h> // member
+#include <eq/fabric/renderContext.h> // member
 #include <eq/fabric/viewport.h>      // member
 #include <lunchbox/monitor.h> // member
 
@@ -163,6 +164,14 @@ public:
     bool update( const uint128_t& frameID, const uint32_t frameNumber );
 
     co::ObjectOCommand send( const uint32_t cmd );
+
+    /**
+     * Send a task command starting with the given render context.
+     *
+     * Only the fields changed since the last context sent to this channel are
+     * transmitted.
+     */
+    co::ObjectOCommand send( const uint32_t cmd, const RenderContext& context );
     //@}
 
     /** @name Channel listener interface. */
@@ -173,6 +182,10 @@ public:
     void removeListener( ChannelListener* listener );
     /** @return true if the channel has listeners */
     bool hasListeners() const { return !_listeners.empty(); }
+    /** Notify all listeners of the load data of a finished frame. */
+    EQSERVER_API void fireLoadData( const uint32_t frameNumber,
+                                    const Statistics& statistics,
+                                    const Viewport& region );
     //@}
 
     bool omitOutput() const; //!< @internal
@@ -201,6 +214,9 @@ private:
     /** The last draw compound for this entity */
     const Compound* _lastDrawCompound;
 
+    /** The last render context sent, mirrored by the client channel. */
+    RenderContext _lastContext;
+
     typedef std::vector< ChannelListener* > ChannelListeners;
     ChannelListeners _listeners;
 
@@ -215,10 +231,6 @@ private:
     void _setupRenderContext( const uint128_t& frameID,
                               RenderContext& context );
 
-    void _fireLoadData( const uint32_t frameNumber,
-                        const Statistics& statistics,
-                        const Viewport& region );
-
     /* command handler functions. */
     bool _cmdConfigInitReply( co::ICommand& command );
     bool _cmdConfigExitReply( co::ICommand& command );
@@ -143,6 +143,9 @@ Compound::Data::Data()
         , period( LB_UNDEFINED_UINT32 )
         , phase( LB_UNDEFINED_UINT32 )
         , maxFPS( std::numeric_limits< float >::max( ))
+        , quality( 1.f )
+        , qualityStage( fabric::QUALITY_NONE )
+        , qualityRatio( 0.f )
 {
     const Global* global = Global::instance();
     for( int i=0; i<IATTR_ALL; ++i )
@@ -529,6 +532,9 @@ RenderContext Compound::setupRenderContext( const Eye eye ) const
     context.zoom = _inherit.zoom;
     context.period = _inherit.period;
     context.phase = _inherit.phase;
+    context.quality = _inherit.quality;
+    context.qualityStage = _inherit.qualityStage;
+    context.qualityRatio = _inherit.qualityRatio;
     context.offset.x() = context.pvp.x;
     context.offset.y() = context.pvp.y;
     context.eye = eye;
@@ -1211,6 +1217,13 @@ void Compound::update( const uint32_t frameNumber )
     CompoundUpdateInputVisitor updateInputVisitor( outputFrames, outputQueues );
     accept( updateInputVisitor );
 
+    // distribute tiles after all consumers have been added
+    for( TileQueueMap::const_iterator i = outputQueues.begin();
+         i != outputQueues.end(); ++i )
+    {
+        i->second->distributeTiles();
+    }
+
     // commit output frames after input frames have been set
     for( FrameMapCIter i = outputFrames.begin(); i != outputFrames.end(); ++i )
     {
@@ -1363,6 +1376,12 @@ void Compound::_updateInheritNode()
         _inherit.phase = _data.phase;
 
     _inherit.maxFPS = _data.maxFPS;
+    _inherit.quality = std::min( _inherit.quality, _data.quality );
+    if( _data.qualityStage != fabric::QUALITY_NONE )
+    {
+        _inherit.qualityStage = _data.qualityStage;
+        _inherit.qualityRatio = _data.qualityRatio;
+    }
 
     if( _data.buffers != Frame::BUFFER_UNDEFINED )
         _inherit.buffers = _data.buffers;
@@ -224,6 +224,15 @@ public:
     void setZoom( const Zoom& zoom )       { _data.zoom = zoom; }
     const Zoom& getZoom() const            { return _data.zoom; }
 
+    /** Limit the compression quality of the frames of this subtree. */
+    void setQuality( const float quality ) { _data.quality = quality; }
+    float getQuality() const               { return _data.quality; }
+
+    /** Set the active stage and its degradation of the quality ladder. */
+    void setQualityStage( const uint32_t stage, const float ratio )
+        { _data.qualityStage = stage; _data.qualityRatio = ratio; }
+    uint32_t getQualityStage() const       { return _data.qualityStage; }
+
     void setMaxFPS( const float fps )          { _data.maxFPS = fps; }
     float getMaxFPS() const                    { return _data.maxFPS; }
 
@@ -321,6 +330,7 @@ public:
     RenderContext setupRenderContext( Eye eye ) const;
     uint32_t getInheritBuffers() const { return _inherit.buffers; }
     const PixelViewport& getInheritPixelViewport() const { return _inherit.pvp;}
+    const Viewport& getInheritViewport() const { return _inherit.vp; }
     const Range& getInheritRange()   const { return _inherit.range; }
     const Pixel& getInheritPixel()   const { return _inherit.pixel; }
     const SubPixel& getInheritSubPixel() const { return _inherit.subPixel; }
@@ -545,6 +555,9 @@ private:
         uint32_t          phase;
         int32_t           iAttributes[IATTR_ALL];
         float             maxFPS;
+        float             quality;
+        uint32_t          qualityStage;
+        float             qualityRatio;
 
         // compound activation per eye
         uint32_t active[ fabric::NUM_EYES ];
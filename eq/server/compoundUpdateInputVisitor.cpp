@@ -17,6 +17,7 @@
  */
 
 #include "compoundUpdateInputVisitor.h"
+#include "channel.h"
 
 #include "frame.h"
 #include "frameData.h"
@@ -70,6 +71,10 @@ void CompoundUpdateInputVisitor::_updateQueues( const Compound* compound )
 
         TileQueue* outputQueue = j->second;
         queue->setOutputQueue( outputQueue, compound );
+
+        const Channel* channel = compound->getChannel();
+        if( channel && compound->testInheritTask( fabric::TASK_DRAW ))
+            outputQueue->addConsumer( channel->getNode( ));
     }
 }
 
@@ -26,6 +26,9 @@
 #include "tileQueue.h"
 #include "window.h"
 
+#include "tiles/rasterStrategy.h"
+#include "tiles/spiralStrategy.h"
+#include "tiles/squareStrategy.h"
 #include "tiles/zigzagStrategy.h"
 
 #include <eq/fabric/iAttribute.h>
@@ -188,7 +191,22 @@ void CompoundUpdateOutputVisitor::_generateTiles( TileQueue* queue,
     std::vector< Vector2i > tiles;
     tiles.reserve( dim.x() * dim.y() );
 
-    tiles::generateZigzag( tiles, dim );
+    switch( queue->getTileStrategy( ))
+    {
+    case fabric::Equalizer::TILE_RASTER:
+        tiles::RasterStrategy()( tiles, dim );
+        break;
+    case fabric::Equalizer::TILE_SPIRAL:
+        tiles::SpiralStrategy()( tiles, dim );
+        break;
+    case fabric::Equalizer::TILE_SQUARE:
+        tiles::SquareStrategy()( tiles, dim );
+        break;
+    case fabric::Equalizer::TILE_ZIGZAG:
+    default:
+        tiles::generateZigzag( tiles, dim );
+        break;
+    }
     _addTilesToQueue( queue, compound, tiles );
 }
 
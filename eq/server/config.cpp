@@ -20,6 +20,7 @@
 #include "config.h"
 
 #include "canvas.h"
+#include "channel.h"
 #include "changeLatencyVisitor.h"
 #include "compound.h"
 #include "compoundVisitor.h"
@@ -27,6 +28,7 @@
 #include "equalizers/equalizer.h"
 #include "global.h"
 #include "layout.h"
+#include "loadRecorder.h"
 #include "log.h"
 #include "node.h"
 #include "observer.h"
@@ -45,6 +47,9 @@
 #include <lunchbox/sleep.h>
 #include <boost/foreach.hpp>
 
+#include <algorithm>
+#include <set>
+
 #include "channelStopFrameVisitor.h"
 #include "configDeregistrator.h"
 #include "configRegistrator.h"
@@ -60,6 +65,69 @@ typedef co::CommandFunc<Config> ConfigFunc;
 using fabric::ON;
 using fabric::OFF;
 
+namespace
+{
+typedef std::set< const void* > ResourceSet; // nodes and views
+typedef std::vector< size_t > CompoundGroup; // indices into the compounds
+typedef std::vector< CompoundGroup > CompoundGroups;
+
+// View::updateFrusta updates the compounds of all channels of the view
+void _addResources( const Compound* compound, ResourceSet& resources )
+{
+    const Channel* channel = compound->getChannel();
+    if( channel )
+    {
+        resources.insert( channel->getNode( ));
+        if( channel->getView( ))
+            resources.insert( channel->getView( ));
+    }
+
+    for( const Compound* child : compound->getChildren( ))
+        _addResources( child, resources );
+}
+
+bool _intersects( const ResourceSet& a, const ResourceSet& b )
+{
+    for( const void* resource : a )
+        if( b.find( resource ) != b.end( ))
+            return true;
+    return false;
+}
+
+// Group the compounds by the nodes and views they use, keeping the config
+// order
+CompoundGroups _groupCompounds( const Compounds& compounds )
+{
+    CompoundGroups groups;
+    std::vector< ResourceSet > groupResources;
+    for( size_t i = 0; i < compounds.size(); ++i )
+    {
+        CompoundGroup group( 1, i );
+        ResourceSet resources;
+        _addResources( compounds[i], resources );
+
+        for( size_t j = 0; j < groups.size(); )
+        {
+            if( !_intersects( resources, groupResources[j] ))
+            {
+                ++j;
+                continue;
+            }
+            group.insert( group.end(), groups[j].begin(), groups[j].end( ));
+            resources.insert( groupResources[j].begin(),
+                              groupResources[j].end( ));
+            groups.erase( groups.begin() + j );
+            groupResources.erase( groupResources.begin() + j );
+        }
+
+        std::sort( group.begin(), group.end( ));
+        groups.push_back( group );
+        groupResources.push_back( resources );
+    }
+    return groups;
+}
+}
+
 Config::Config( ServerPtr parent )
         : Super( parent )
         , _currentFrame( 0 )
@@ -68,6 +136,7 @@ Config::Config( ServerPtr parent )
         , _state( STATE_UNUSED )
         , _needsFinish( false )
         , _lastCheck( 0 )
+        , _loadRecorder( 0 )
         , _private( 0 )
 {
     const Global* global = Global::instance();
@@ -85,6 +154,7 @@ Config::Config( ServerPtr parent )
 
 Config::~Config()
 {
+    delete _loadRecorder;
     while( !_compounds.empty( ))
     {
         Compound* compound = _compounds.back();
@@ -413,6 +483,17 @@ bool Config::removeCompound( Compound* compound )
     return true;
 }
 
+void Config::updateCompounds( const std::function< void( Compound* ) >& update )
+{
+    const CompoundGroups& groups = _groupCompounds( _compounds );
+    const int nGroups = int( groups.size( ));
+
+#pragma omp parallel for schedule( dynamic )
+    for( int i = 0; i < nGroups; ++i )
+        for( const size_t j : groups[i] )
+            update( _compounds[j] );
+}
+
 void Config::setApplicationNetNode( co::NodePtr netNode )
 {
     if( netNode.isValid( ))
@@ -813,6 +894,13 @@ bool Config::_init( const uint128_t& initID )
     UpdateEqualizersVisitor updater;
     accept( updater );
 
+    const char* trace = getenv( "EQ_LOAD_TRACE" );
+    if( trace )
+    {
+        delete _loadRecorder;
+        _loadRecorder = new LoadRecorder( *this, trace );
+    }
+
     _needsFinish = false;
     _state = STATE_RUNNING;
     return true;
@@ -846,6 +934,9 @@ bool Config::exit()
 
     const bool success = _updateRunning( true );
 
+    delete _loadRecorder;
+    _loadRecorder = 0;
+
     // TODO: is this needed? sender of CMD_CONFIG_EXIT is the appNode itself
     // which sets the running state to false anyway. Besides, this event is
     // not handled by the appNode because it is already in exiting procedure
@@ -872,22 +963,29 @@ void Config::_startFrame( const uint128_t& frameID )
     LBLOG( LOG_TASKS ) << "----- Start Frame ----- " << _currentFrame
                        << std::endl;
 
-    for( Compounds::const_iterator i = _compounds.begin();
-         i != _compounds.end(); ++i )
+    const uint32_t frameNumber = _currentFrame;
+    updateCompounds( [ frameNumber ]( Compound* compound )
+                     { compound->update( frameNumber ); });
+    if( _loadRecorder )
+        _loadRecorder->recordFrame( _currentFrame );
+
+    // Each node only touches its own entities and sends the tasks in order to
+    // its own send buffer, the nodes are therefore updated concurrently.
+    const Nodes& nodes = getNodes();
+    const int nNodes = int( nodes.size( ));
+#pragma omp parallel for schedule( dynamic )
+    for( int i = 0; i < nNodes; ++i )
     {
-        Compound* compound = *i;
-        compound->update( _currentFrame );
+        Node* node = nodes[i];
+        ConfigUpdateDataVisitor configDataVisitor;
+        node->accept( configDataVisitor );
+        node->update( frameID, frameNumber );
     }
 
-    ConfigUpdateDataVisitor configDataVisitor;
-    accept( configDataVisitor );
-
-    const Nodes& nodes = getNodes();
     co::NodePtr appNode = findApplicationNetNode();
     for( Nodes::const_iterator i = nodes.begin(); i != nodes.end(); ++i )
     {
-        Node* node = *i;
-        node->update( frameID, _currentFrame );
+        const Node* node = *i;
         if( node->isRunning() && node->isApplicationNode( ))
             appNode = 0; // release sent (see below)
     }
@@ -29,6 +29,7 @@
 #include <eq/fabric/config.h> // base class
 #include <lunchbox/monitor.h> // member
 
+#include <functional>
 #include <iostream>
 #include <vector>
 
@@ -85,6 +86,18 @@ public:
     /** @return the vector of compounds. */
     const Compounds& getCompounds() const { return _compounds; }
 
+    /**
+     * Apply the given function to all root compounds.
+     *
+     * Root compounds using disjoint sets of nodes and views share no
+     * channels, windows, frames or barriers, and are processed concurrently.
+     * Root compounds sharing a node or a view are processed in their config
+     * order by the same thread.
+     * @internal
+     */
+    EQSERVER_API void updateCompounds(
+        const std::function< void( Compound* ) >& update );
+
     /**
      * Find the first channel of a given name.
      *
@@ -166,6 +179,19 @@ public:
     /** Notify that a node of this config has finished a frame. */
     void notifyNodeFrameFinished( const uint32_t frameNumber );
 
+    /** @internal @return the number of the last started frame. */
+    uint32_t getCurrentFrame() const { return _currentFrame; }
+
+    /**
+     * Start a frame on the running nodes, used by the Simulator to run frames
+     * without an application.
+     * @internal
+     */
+    void startFrame( const uint128_t& frameID ) { _startFrame( frameID ); }
+
+    /** @internal Set the state of a config run without an application. */
+    void setState( const State state ) { _state = state; }
+
     // Used by Server::releaseConfig() to make sure config is exited
     bool exit();
 
@@ -252,6 +278,8 @@ private:
 
     int64_t _lastCheck;
 
+    LoadRecorder* _loadRecorder; //!< Load trace output, see EQ_LOAD_TRACE
+
     struct Private;
     Private* _private; // placeholder for binary-compatible changes
 
@@ -0,0 +1,196 @@
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "costMap.h"
+
+#include <lunchbox/debug.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace eq
+{
+namespace server
+{
+namespace
+{
+// Lower bound of a cell cost, keeps cells outside of the ROI correctable
+const float _minCost = 1e-6f;
+
+// The first and one-past-last cell of [start, end) on an axis with n cells
+void _getCells( const float start, const float end, const size_t n,
+                size_t& first, size_t& last )
+{
+    const float fn = float( n );
+    first = size_t( std::max( 0.f, std::floor( start * fn )));
+    last = size_t( std::max( 0.f, std::ceil( end * fn )));
+    first = std::min( first, n );
+    last = std::min( last, n );
+}
+
+// The fraction of cell i of n covered by [start, end)
+float _getCoverage( const size_t i, const size_t n, const float start,
+                    const float end )
+{
+    const float fn = float( n );
+    const float cellStart = float( i ) / fn;
+    const float cellEnd = float( i + 1 ) / fn;
+    const float overlap = std::min( end, cellEnd ) -
+                          std::max( start, cellStart );
+    return overlap > 0.f ? std::min( overlap * fn, 1.f ) : 0.f;
+}
+}
+
+CostMap::CostMap()
+    : _width( 0 )
+    , _height( 0 )
+    , _hasData( false )
+{}
+
+void CostMap::reset( const size_t width, const size_t height )
+{
+    _width = width;
+    _height = height;
+    _cells.assign( width * height, 1.f );
+    _hasData = false;
+}
+
+void CostMap::update( const Viewport& area, const Viewport& region,
+                      const float time )
+{
+    if( _cells.empty() || !area.hasArea( ))
+        return;
+
+    size_t x0, x1, y0, y1;
+    _getCells( area.x, area.getXEnd(), _width, x0, x1 );
+    _getCells( area.y, area.getYEnd(), _height, y0, y1 );
+
+    // predicted time of the rendered region
+    float predicted = 0.f;
+    for( size_t y = y0; y < y1; ++y )
+    {
+        const float cy = _getCoverage( y, _height, region.y,
+                                       region.getYEnd( ));
+        if( cy == 0.f )
+            continue;
+        for( size_t x = x0; x < x1; ++x )
+            predicted += cy * _getCoverage( x, _width, region.x,
+                                            region.getXEnd( )) *
+                         _cells[ y * _width + x ];
+    }
+    const float ratio = predicted > 0.f ? time / predicted : 0.f;
+
+    // Scale the covered part of each cell to the measurement. Cells in the
+    // area outside of the region did not cost anything.
+    for( size_t y = y0; y < y1; ++y )
+    {
+        const float ay = _getCoverage( y, _height, area.y, area.getYEnd( ));
+        const float ry = _getCoverage( y, _height, region.y,
+                                       region.getYEnd( ));
+        for( size_t x = x0; x < x1; ++x )
+        {
+            const float covered = ay * _getCoverage( x, _width, area.x,
+                                                     area.getXEnd( ));
+            const float rendered = ry * _getCoverage( x, _width, region.x,
+                                                      region.getXEnd( ));
+            float& cost = _cells[ y * _width + x ];
+            cost *= 1.f - covered + rendered * ratio;
+            cost = std::max( cost, _minCost );
+        }
+    }
+    _hasData = true;
+}
+
+float CostMap::getCost( const Viewport& area ) const
+{
+    size_t x0, x1, y0, y1;
+    _getCells( area.x, area.getXEnd(), _width, x0, x1 );
+    _getCells( area.y, area.getYEnd(), _height, y0, y1 );
+
+    float cost = 0.f;
+    for( size_t y = y0; y < y1; ++y )
+    {
+        const float cy = _getCoverage( y, _height, area.y, area.getYEnd( ));
+        for( size_t x = x0; x < x1; ++x )
+            cost += cy * _getCoverage( x, _width, area.x, area.getXEnd( )) *
+                    _cells[ y * _width + x ];
+    }
+    return cost;
+}
+
+float CostMap::splitX( const Viewport& area, const float fraction ) const
+{
+    return _split( area, fraction, true );
+}
+
+float CostMap::splitY( const Viewport& area, const float fraction ) const
+{
+    return _split( area, fraction, false );
+}
+
+float CostMap::_split( const Viewport& area, const float fraction,
+                       const bool inX ) const
+{
+    const float start = inX ? area.x : area.y;
+    const float end = inX ? area.getXEnd() : area.getYEnd();
+    const float otherStart = inX ? area.y : area.x;
+    const float otherEnd = inX ? area.getYEnd() : area.getXEnd();
+    const size_t n = inX ? _width : _height;
+    const size_t nOther = inX ? _height : _width;
+
+    size_t first, last, otherFirst, otherLast;
+    _getCells( start, end, n, first, last );
+    _getCells( otherStart, otherEnd, nOther, otherFirst, otherLast );
+
+    // cost profile along the split axis
+    std::vector< float > profile( last - first, 0.f );
+    float total = 0.f;
+    for( size_t i = first; i < last; ++i )
+    {
+        const float coverage = _getCoverage( i, n, start, end );
+        float& cost = profile[ i - first ];
+        for( size_t j = otherFirst; j < otherLast; ++j )
+        {
+            const size_t index = inX ? j * _width + i : i * _width + j;
+            cost += _getCoverage( j, nOther, otherStart, otherEnd ) *
+                    _cells[ index ];
+        }
+        cost *= coverage;
+        total += cost;
+    }
+
+    if( total <= 0.f )
+        return start + fraction * ( end - start );
+
+    const float target = fraction * total;
+    float accumulated = 0.f;
+    for( size_t i = first; i < last; ++i )
+    {
+        const float cost = profile[ i - first ];
+        if( cost > 0.f && accumulated + cost >= target )
+        {
+            const float cellStart = std::max( start, float( i ) / float( n ));
+            const float cellEnd = std::min( end, float( i + 1 ) / float( n ));
+            return cellStart + ( cellEnd - cellStart ) *
+                               ( target - accumulated ) / cost;
+        }
+        accumulated += cost;
+    }
+    return end;
+}
+
+}
+}
@@ -0,0 +1,89 @@
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQS_COSTMAP_H
+#define EQS_COSTMAP_H
+
+#include <eq/server/api.h>
+#include "../types.h"
+
+#include <eq/fabric/viewport.h> // used inline
+
+#include <vector>
+
+namespace eq
+{
+namespace server
+{
+/**
+ * A grid of rendering cost density over the normalized [0,1]^2 screen space.
+ *
+ * The map is refined using the time measured for each rendered region. The
+ * cost of all cells within the region is scaled to match the measurement,
+ * which accumulates the detail of all past region boundaries. A DB range is
+ * represented using a map with a height of one cell.
+ */
+class CostMap
+{
+public:
+    EQSERVER_API CostMap();
+
+    /** Reset the map to an uninitialized grid of the given size. */
+    EQSERVER_API void reset( size_t width, size_t height );
+
+    /** @return the number of cells in x. */
+    size_t getWidth() const { return _width; }
+
+    /** @return the number of cells in y. */
+    size_t getHeight() const { return _height; }
+
+    /** @return true if the map has been updated with a measurement. */
+    bool hasData() const { return _hasData; }
+
+    /**
+     * Correct the map with the time needed to render a region.
+     *
+     * @param area the area assigned to the resource.
+     * @param region the part of the area which was rendered (ROI).
+     * @param time the time used to render the region.
+     */
+    EQSERVER_API void update( const Viewport& area, const Viewport& region,
+                              float time );
+
+    /** @return the estimated time to render the given area. */
+    EQSERVER_API float getCost( const Viewport& area ) const;
+
+    /**
+     * @return the x position splitting the cost of the area such that the
+     *         left part has the given fraction of the total cost.
+     */
+    EQSERVER_API float splitX( const Viewport& area, float fraction ) const;
+
+    /** @return the y position splitting the cost of area at fraction. */
+    EQSERVER_API float splitY( const Viewport& area, float fraction ) const;
+
+private:
+    std::vector< float > _cells; // row-major cost per cell
+    size_t _width;
+    size_t _height;
+    bool _hasData;
+
+    float _split( const Viewport& area, float fraction, bool inX ) const;
+};
+}
+}
+
+#endif // EQS_COSTMAP_H
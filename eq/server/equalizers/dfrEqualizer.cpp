@@ -26,11 +26,40 @@
 #include <eq/fabric/zoom.h>
 #include <lunchbox/debug.h>
 
+#include <algorithm>
+#include <cmath>
+
 namespace eq
 {
 namespace server
 {
-static const float MINSIZE = 128.f; // pixels
+namespace
+{
+const float MINSIZE = 128.f; // pixels
+const float MINQUALITY = .5f; // lowest compression quality
+const float MAXERROR = 1.f; // clamp of the relative frame time error
+
+// PID gains, per level and relative error, for the default damping of .5
+const float KP = .2f;
+const float KI = .1f;
+const float KD = .02f;
+}
+
+float DFREqualizer::Controller::update( const float error, const float gain,
+                                        const float maxLevel )
+{
+    const float derivative = error - _error;
+    const float integral = _integral + error;
+    const float level = gain * ( KP * error + KI * integral + KD * derivative );
+    _error = error;
+
+    // anti-windup: don't integrate while the ladder is exhausted
+    if( level >= 0.f && level <= maxLevel )
+        _integral = integral;
+
+    _level = std::max( 0.f, std::min( level, maxLevel ));
+    return _level;
+}
 
 DFREqualizer::DFREqualizer()
         : _current ( getFrameRate( ))
@@ -58,6 +87,8 @@ void DFREqualizer::attach( Compound* compound )
     }
 
     Equalizer::attach( compound );
+    _subPixels.clear();
+    _tasks.clear();
 
     if( compound )
     {
@@ -76,21 +107,119 @@ void DFREqualizer::notifyUpdatePre( Compound* compound, const uint32_t/*frame*/)
 
     if( isFrozen() || !compound->isActive() || !isActive( ))
     {
-        compound->setZoom( Zoom::NONE );
+        _reset( compound );
         return;
     }
 
-    LBASSERT( getDamping() >= 0.f );
-    LBASSERT( getDamping() <= 1.f );
+    _updateStages( compound );
 
-    const float factor = ( sqrtf( _current / getFrameRate( )) - 1.f ) *
-                         getDamping() + 1.f;
+    const float level = _controller.getLevel();
+    uint32_t stage = fabric::QUALITY_FULL;
+    float stageRatio = 0.f;
+    for( size_t i = 0; i < _stages.size(); ++i )
+    {
+        // stages below the level are fully degraded, above at full quality
+        const float ratio = std::max( 0.f, std::min( level - float( i ), 1.f ));
+        if( ratio > 0.f )
+        {
+            stage = _stages[i];
+            stageRatio = ratio;
+        }
 
-    Zoom newZoom( compound->getZoom( ));
-    newZoom *= factor;
+        switch( _stages[i] )
+        {
+        case fabric::QUALITY_COMPRESSION:
+            _applyCompression( compound, ratio );
+            break;
+        case fabric::QUALITY_SUBPIXEL:
+            _applySubPixel( compound, ratio );
+            break;
+        case fabric::QUALITY_ZOOM:
+            _applyZoom( compound, ratio );
+            break;
+        default:
+            LBUNIMPLEMENTED;
+        }
+    }
+    compound->setQualityStage( stage, stageRatio );
+}
+
+void DFREqualizer::_reset( Compound* compound )
+{
+    compound->setZoom( Zoom::NONE );
+    compound->setQuality( 1.f );
+    compound->setQualityStage( fabric::QUALITY_NONE, 0.f );
+    if( _hasSubPixels( compound ))
+        _applySubPixel( compound, 0.f );
+    _controller.reset();
+}
 
-    //LBINFO << _current << ": " << factor << " = " << newZoom << std::endl;
+void DFREqualizer::_updateStages( Compound* compound )
+{
+    const Compounds& children = compound->getChildren();
+    if( _subPixels.size() != children.size( ))
+    {
+        // remember the configuration before the ladder changes it
+        _subPixels.clear();
+        _tasks.clear();
+        for( const Compound* child : children )
+        {
+            _subPixels.push_back( child->getSubPixel( ));
+            _tasks.push_back( child->getTasks( ));
+        }
+    }
 
+    _stages.clear();
+    if( !compound->getOutputFrames().empty( ))
+        _stages.push_back( fabric::QUALITY_COMPRESSION );
+    if( _hasSubPixels( compound ))
+        _stages.push_back( fabric::QUALITY_SUBPIXEL );
+    _stages.push_back( fabric::QUALITY_ZOOM );
+}
+
+bool DFREqualizer::_hasSubPixels( const Compound* compound ) const
+{
+    const size_t size = compound->getChildren().size();
+    if( size < 2 || _subPixels.size() != size )
+        return false;
+
+    for( const SubPixel& subPixel : _subPixels )
+        if( subPixel.size != size || subPixel.index >= size )
+            return false;
+    return true;
+}
+
+void DFREqualizer::_applyCompression( Compound* compound, const float ratio )
+{
+    compound->setQuality( 1.f - ratio * ( 1.f - MINQUALITY ));
+}
+
+void DFREqualizer::_applySubPixel( Compound* compound, const float ratio )
+{
+    // use the first samples, the other children don't render
+    const Compounds& children = compound->getChildren();
+    const uint32_t size = uint32_t( children.size( ));
+    const uint32_t samples = size - uint32_t( ratio * float( size - 1 ) + .5f );
+
+    for( size_t i = 0; i < children.size(); ++i )
+    {
+        Compound* child = children[i];
+        const SubPixel& subPixel = _subPixels[i];
+        if( subPixel.index < samples )
+        {
+            child->setSubPixel( SubPixel( subPixel.index, samples ));
+            child->setTasks( _tasks[i] );
+        }
+        else
+        {
+            child->setSubPixel( subPixel );
+            child->setTasks( fabric::TASK_NONE );
+        }
+    }
+}
+
+void DFREqualizer::_applyZoom( Compound* compound, const float ratio )
+{
     // clip zoom factor to min, max( channel pvp )
     const Compound*      parent = compound->getParent();
     const PixelViewport& pvp    = parent->getInheritPixelViewport();
@@ -105,11 +234,12 @@ void DFREqualizer::notifyUpdatePre( Compound* compound, const uint32_t/*frame*/)
                                   static_cast< float >( channelPVP.h ) /
                                   static_cast< float >( pvp.h ));
 
-    newZoom.x() = LB_MAX( newZoom.x(), minZoom );
-    newZoom.x() = LB_MIN( newZoom.x(), maxZoom );
-    newZoom.y() = newZoom.x();
+    // geometric interpolation, the rendered area changes evenly with ratio
+    const float fullZoom = LB_MIN( maxZoom, 1.f );
+    const float lowZoom = LB_MIN( minZoom, fullZoom );
+    const float zoom = fullZoom * std::pow( lowZoom / fullZoom, ratio );
 
-    compound->setZoom( newZoom );
+    compound->setZoom( Zoom( zoom, zoom ));
 }
 
 void DFREqualizer::notifyLoadData( Channel* channel, const uint32_t frameNumber,
@@ -145,8 +275,20 @@ void DFREqualizer::notifyLoadData( Channel* channel, const uint32_t frameNumber,
         return;
 
     _current = 1000.0f / static_cast< float >( time );
+    if( isFrozen() || !isActive( ))
+        return;
+
+    LBASSERT( getDamping() >= 0.f );
+    LBASSERT( getDamping() <= 1.f );
+
+    const float error = std::max( -MAXERROR,
+                                  std::min( getFrameRate() / _current - 1.f,
+                                            MAXERROR ));
+    const float level = _controller.update( error, 2.f * getDamping(),
+                                            float( _stages.size( )));
     LBLOG( LOG_LB1 ) << "Frame " << frameNumber << " channel "
-                     << channel->getName() << " time " << time << std::endl;
+                     << channel->getName() << " time " << time << " level "
+                     << level << std::endl;
 }
 
 std::ostream& operator << ( std::ostream& os, const DFREqualizer* lb )
@@ -1,5 +1,5 @@
 
-/* Copyright (c) 2009-2013, Stefan Eilemann <eile@equalizergraphics.com>
+/* Copyright (c) 2009-2016, Stefan Eilemann <eile@equalizergraphics.com>
  *
  * This library is free software; you can redistribute it and/or modify it under
  * the terms of the GNU Lesser General Public License version 2.1 as published
@@ -21,8 +21,7 @@
 #include "../channelListener.h" // base class
 #include "equalizer.h"       // base class
 
-#include <deque>
-#include <map>
+#include <vector>
 
 namespace eq
 {
@@ -30,7 +29,16 @@ namespace server
 {
     std::ostream& operator << ( std::ostream& os, const DFREqualizer* );
 
-    /** Tries to maintain a constant frame rate by adapting the compound zoom.*/
+    /**
+     * Tries to maintain a constant frame rate by degrading the rendering
+     * quality.
+     *
+     * The quality is degraded along a ladder of stages, which are used in
+     * order: lossy compression of the output frames, fewer subpixel samples if
+     * the children form a subpixel decomposition, and a lower resolution
+     * through the compound zoom. Stages not applicable to the compound are
+     * skipped. A PID controller on the frame time selects the quality level.
+     */
     class DFREqualizer : public Equalizer, protected ChannelListener
     {
     public:
@@ -53,6 +61,41 @@ namespace server
 
         uint32_t getType() const final { return fabric::DFR_EQUALIZER; }
 
+        /**
+         * PID controller of the quality level.
+         *
+         * Level 0 is full quality, each additional unit fully degrades one
+         * more stage of the ladder.
+         */
+        class Controller
+        {
+        public:
+            Controller() { reset(); }
+
+            /** Restart at full quality. */
+            void reset() { _level = _integral = _error = 0.f; }
+
+            /**
+             * Update the level with the error of the last frame.
+             *
+             * @param error the relative frame time error, positive if the
+             *              frame was too slow.
+             * @param gain the gain applied to all controller terms.
+             * @param maxLevel the number of available stages.
+             * @return the new level, between 0 and maxLevel.
+             */
+            EQSERVER_API float update( float error, float gain,
+                                       float maxLevel );
+
+            /** @return the current level. */
+            float getLevel() const { return _level; }
+
+        private:
+            float _level;
+            float _integral;
+            float _error;
+        };
+
     protected:
         void notifyChildAdded( Compound*, Compound* ) override {}
         void notifyChildRemove( Compound*, Compound* ) override {}
@@ -60,6 +103,19 @@ namespace server
     private:
         float _current; //!< Framerate of the last finished frame
         int64_t _lastTime; //!< Last frames' timestamp
+        Controller _controller;
+
+        std::vector< uint32_t > _stages; //!< used stages, in ladder order
+        std::vector< SubPixel > _subPixels; //!< configured child subpixels
+        std::vector< uint32_t > _tasks; //!< configured child tasks
+
+        void _reset( Compound* compound );
+        void _updateStages( Compound* compound );
+        bool _hasSubPixels( const Compound* compound ) const;
+
+        void _applyCompression( Compound* compound, float ratio );
+        void _applySubPixel( Compound* compound, float ratio );
+        void _applyZoom( Compound* compound, float ratio );
     };
 
 }
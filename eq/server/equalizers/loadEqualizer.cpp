@@ -21,6 +21,7 @@
 
 #include "../compound.h"
 #include "../log.h"
+#include "../node.h"
 
 #include <eq/fabric/statistic.h>
 #include <lunchbox/debug.h>
@@ -38,6 +39,8 @@ std::ostream& operator << ( std::ostream& os, const LoadEqualizer::Node* );
 
 LoadEqualizer::LoadEqualizer()
         : _tree( 0 )
+        , _costMapFrame( 0 )
+        , _calibrationFrame( 0 )
 {
     LBVERB << "New LoadEqualizer @" << (void*)this << std::endl;
 }
@@ -45,6 +48,8 @@ LoadEqualizer::LoadEqualizer()
 LoadEqualizer::LoadEqualizer( const fabric::Equalizer& from )
         : Equalizer( from )
         , _tree( 0 )
+        , _costMapFrame( 0 )
+        , _calibrationFrame( 0 )
 {}
 
 LoadEqualizer::~LoadEqualizer()
@@ -79,6 +84,14 @@ void LoadEqualizer::notifyUpdatePre( Compound* compound,
 
           default:
               _tree = _buildTree( children );
+              // the calibration frames are measured using the history, which
+              // is not recorded with full damping
+              if( getCalibrationFrames() > 0 && getDamping() >= 1.f )
+                  LBWARN << "Ignoring calibration of " << getCalibrationFrames()
+                         << " frames for load equalizer with damping "
+                         << getDamping() << std::endl;
+              _calibration.reset( children.size(), getDamping() < 1.f ?
+                                  getCalibrationFrames() : 0 );
               break;
         }
     }
@@ -91,9 +104,128 @@ void LoadEqualizer::notifyUpdatePre( Compound* compound,
     }
 
     _update( _tree, Viewport(), Range( ));
+    if( _calibrate( frameNumber ))
+        return;
+
+    _updateTransmitTime();
     _computeSplit();
 }
 
+bool LoadEqualizer::_calibrate( const uint32_t frameNumber )
+{
+    if( !_calibration.isEnabled( ))
+        return false;
+
+    const Compounds& children = getCompound()->getChildren();
+    LBFrameData& frameData = _history.front();
+    if( frameData.first != 0 && frameData.first <= _calibrationFrame )
+    {
+        // all children rendered everything, their time gives their speed
+        LBDatas& items = frameData.second;
+        ResourceCalibration::Floats work( children.size(), 0.f );
+        ResourceCalibration::Floats times( children.size(), 0.f );
+        for( size_t i = 0; i < children.size(); ++i )
+        {
+            const Data* data = _findData( items, children[i]->getChannel( ));
+            if( !data || data->time <= 0 )
+                continue;
+            work[i] = 1.f;
+            times[i] = float( data->time );
+        }
+
+        const bool wasCalibrating = _calibration.isCalibrating();
+        _calibration.addFrame( work, times );
+        if( wasCalibrating && !_calibration.isCalibrating( ))
+            _seedCostMap( items );
+
+        // The regions overlap, replace them by a fake set to not balance
+        // using them.
+        frameData.first = 0;
+        items.assign( 1, Data( ));
+        items.front().time = 1;
+    }
+
+    if( !_calibration.isCalibrating( ))
+        return false;
+
+    _calibrationFrame = frameNumber;
+    LBNodes leaves;
+    _getLeaves( _tree, leaves );
+    for( Node* leaf : leaves )
+    {
+        if( leaf->resources > 0.f )
+            _assign( leaf->compound, Viewport(), Range( ));
+        else if( getMode() == MODE_DB )
+            _assign( leaf->compound, Viewport(), Range( 0.f, 0.f ));
+        else
+            _assign( leaf->compound, Viewport( 0.f, 0.f, 0.f, 0.f ), Range( ));
+    }
+    LBLOG( LOG_LB1 ) << "Calibrating " << getCompound()->getChannel()->getName()
+                     << " using frame " << frameNumber << std::endl;
+    return true;
+}
+
+void LoadEqualizer::_updateCalibration( const LBDatas& items )
+{
+    // The cost map is normalized to an average resource, and predicts the
+    // work done by each child.
+    const bool isDB = getMode() == MODE_DB;
+    const Compounds& children = getCompound()->getChildren();
+    ResourceCalibration::Floats work( children.size(), 0.f );
+    ResourceCalibration::Floats times( children.size(), 0.f );
+    for( size_t i = 0; i < children.size(); ++i )
+    {
+        const Data* data = _findData( items, children[i]->getChannel( ));
+        if( !data || data->time <= 0 || !data->vp.hasArea() ||
+            !data->range.hasData( ))
+        {
+            continue;
+        }
+
+        const Viewport region = isDB ?
+            Viewport( data->range.start, 0.f, data->range.getSize(), 1.f ) :
+            data->vp;
+        work[i] = _costMap.getCost( region );
+        times[i] = float( data->time );
+    }
+    _calibration.addFrame( work, times );
+}
+
+void LoadEqualizer::_seedCostMap( const LBDatas& items )
+{
+    _resetCostMap( true );
+    for( const Data& data : items )
+    {
+        if( data.time <= 0 || !data.area.hasArea() || !data.range.hasData( ))
+            continue;
+
+        const Compound* child = 0;
+        for( const Compound* compound : getCompound()->getChildren( ))
+            if( compound->getChannel() == data.channel )
+                child = compound;
+        if( child )
+            _updateCostMap( data, float( data.time ) * _getWeight( child ));
+    }
+}
+
+float LoadEqualizer::_getWeight( const Compound* child ) const
+{
+    const Compounds& children = getCompound()->getChildren();
+    for( size_t i = 0; i < children.size(); ++i )
+        if( children[i] == child )
+            return _calibration.getWeight( i );
+    return 1.f;
+}
+
+const LoadEqualizer::Data* LoadEqualizer::_findData( const LBDatas& items,
+                                                     const Channel* channel )
+{
+    for( LBDatas::const_iterator i = items.begin(); i != items.end(); ++i )
+        if( i->channel == channel )
+            return &(*i);
+    return 0;
+}
+
 LoadEqualizer::Node* LoadEqualizer::_buildTree( const Compounds& compounds )
 {
     Node* node = new Node;
@@ -177,6 +309,10 @@ void LoadEqualizer::notifyLoadData( Channel* channel,
             int64_t endTime   = 0;
             bool    loadSet   = false;
             int64_t transmitTime = 0;
+            int64_t compressStart = std::numeric_limits< int64_t >::max();
+            int64_t compressEnd = 0;
+            float   ratio = 0.f;
+            size_t  nRatios = 0;
             for( size_t k = 0; k < statistics.size(); ++k )
             {
                 const Statistic& stat = statistics[k];
@@ -204,6 +340,14 @@ void LoadEqualizer::notifyLoadData( Channel* channel,
                     transmitTime -= stat.endTime - stat.startTime;
                     break;
 
+                // bands are compressed concurrently, use the covered time
+                case Statistic::CHANNEL_FRAME_COMPRESS:
+                    compressStart = LB_MIN( compressStart, stat.startTime );
+                    compressEnd = LB_MAX( compressEnd, stat.endTime );
+                    ratio += stat.ratio;
+                    ++nRatios;
+                    break;
+
                 // assemble blocks on input frames, stop using subsequent data
                 case Statistic::CHANNEL_ASSEMBLE:
                     loadSet = true;
@@ -220,10 +364,13 @@ void LoadEqualizer::notifyLoadData( Channel* channel,
             data.vp.apply( region ); // Update ROI
             data.time = endTime - startTime;
             data.time = LB_MAX( data.time, 1 );
-            data.time = LB_MAX( data.time, transmitTime );
+            data.transmitTime = LB_MAX( transmitTime, 0 );
+            data.compressTime = LB_MAX( compressEnd - compressStart, 0 );
+            data.ratio = nRatios > 0 ? ratio / float( nRatios ) : 1.f;
             data.assembleTime = LB_MAX( data.assembleTime, 0 );
             LBLOG( LOG_LB2 ) << "Added time " << data.time << " (+"
-                             << data.assembleTime << ") for "
+                             << data.assembleTime << ", transmit "
+                             << data.transmitTime << ") for "
                              << channel->getName() << " " << data.vp << ", "
                              << data.range << " @ " << frameNumber << std::endl;
             return;
@@ -301,11 +448,11 @@ float LoadEqualizer::_getTotalResources( ) const
     const Compounds& children = getCompound()->getChildren();
 
     float resources = 0.f;
-    for( CompoundsCIter i = children.begin(); i != children.end(); ++i )
+    for( size_t i = 0; i < children.size(); ++i )
     {
-       const Compound* compound = *i;
+       const Compound* compound = children[i];
        if( compound->isActive( ))
-           resources += compound->getUsage();
+           resources += compound->getUsage() * _calibration.getWeight( i );
     }
 
     return resources;
@@ -341,7 +488,8 @@ void LoadEqualizer::_updateLeaf( Node* node )
     const Channel* channel = compound->getChannel();
     LBASSERT( channel );
     const PixelViewport& pvp = channel->getPixelViewport();
-    node->resources = compound->isActive() ? compound->getUsage() : 0.f;
+    node->resources = compound->isActive() ?
+                      compound->getUsage() * _getWeight( compound ) : 0.f;
     LBLOG( LOG_LB2 ) << channel->getName() << " active " << compound->isActive()
                      << " using " << node->resources << std::endl;
     LBASSERT( node->resources >= 0.f );
@@ -486,6 +634,185 @@ void LoadEqualizer::_updateNode( Node* node, const Viewport& vp,
     }
 }
 
+void LoadEqualizer::_updateTransmitTime()
+{
+    LBNodes leaves;
+    _getLeaves( _tree, leaves );
+
+    const LBDatas& items = _history.front().second;
+    std::vector< const Data* > datas( leaves.size(), 0 );
+    float work = 0.f; // render time of everything on one resource
+    for( size_t i = 0; i < leaves.size(); ++i )
+    {
+        const Channel* channel = leaves[i]->compound->getChannel();
+        for( LBDatas::const_iterator j = items.begin(); j != items.end(); ++j )
+        {
+            const Data& data = *j;
+            if( data.channel != channel || data.time <= 0 ||
+                !data.area.hasArea() || !data.range.hasData( ))
+            {
+                continue;
+            }
+            datas[i] = &data;
+            work += float( data.time ) * leaves[i]->resources;
+            break;
+        }
+    }
+    if( work <= 0.f )
+        return;
+
+    ChildCosts costs( leaves.size( ));
+    bool hasTransmit = false;
+    for( size_t i = 0; i < leaves.size(); ++i )
+    {
+        Node* leaf = leaves[i];
+        if( leaf->resources <= 0.f )
+            continue;
+
+        ChildCost& cost = costs[i];
+        cost.renderTime = work / leaf->resources;
+        if( !datas[i] )
+            continue;
+
+        const float time = _getTransmitTime( leaf->compound, *datas[i] );
+        if( time <= 0.f )
+            continue;
+
+        hasTransmit = true;
+        if( getMode() == MODE_DB ) // full images, independent of the range
+            cost.fixedTime = time;
+        else // assumes the transmitted area grows linearly with the share
+            cost.areaTime = time / datas[i]->area.getArea();
+    }
+
+    if( !hasTransmit ) // all images are assembled locally
+        return;
+
+    const std::vector< float >& shares = computeShares( costs );
+    const float resources = _tree->resources;
+    for( size_t i = 0; i < leaves.size(); ++i )
+    {
+        LBLOG( LOG_LB2 ) << leaves[i]->compound->getChannel()->getName()
+                         << " render " << costs[i].renderTime << " transmit "
+                         << costs[i].fixedTime << "+" << costs[i].areaTime
+                         << " share " << shares[i] << std::endl;
+        leaves[i]->resources = shares[i] * resources;
+    }
+    _updateResources( _tree );
+}
+
+void LoadEqualizer::_getLeaves( Node* node, LBNodes& leaves )
+{
+    if( !node )
+        return;
+
+    if( node->compound )
+        leaves.push_back( node );
+    else
+    {
+        _getLeaves( node->left, leaves );
+        _getLeaves( node->right, leaves );
+    }
+}
+
+void LoadEqualizer::_updateResources( Node* node )
+{
+    if( !node || node->compound )
+        return;
+
+    _updateResources( node->left );
+    _updateResources( node->right );
+    node->resources = node->left->resources + node->right->resources;
+}
+
+float LoadEqualizer::_getTransmitTime( Compound* child, const Data& data )
+{
+    Compound* compound = getCompound();
+    const server::Node* node = child->getNode();
+    const server::Node* destNode = compound->getNode();
+    if( !node || node == destNode ) // assembled locally
+        return 0.f;
+
+    const uint32_t buffers = child->getInheritBuffers();
+    const float bytesPerPixel =
+        (( buffers & fabric::Frame::BUFFER_COLOR ) ? 4.f : 0.f ) +
+        (( buffers & fabric::Frame::BUFFER_DEPTH ) ? 4.f : 0.f );
+
+    // the link is limited by the slower of both nodes, in KB/s
+    int32_t bandwidth = std::numeric_limits< int32_t >::max();
+    const server::Node* nodes[] = { node, destNode };
+    for( const server::Node* i : nodes )
+    {
+        int32_t nodeBandwidth = 0;
+        const co::ConnectionDescriptions& descriptions =
+            i->getConnectionDescriptions();
+        for( co::ConstConnectionDescriptionPtr description : descriptions )
+            nodeBandwidth = LB_MAX( nodeBandwidth, description->bandwidth );
+        bandwidth = LB_MIN( bandwidth, nodeBandwidth );
+    }
+
+    if( bandwidth <= 0 || bytesPerPixel == 0.f ) // use the measured time
+        return float( data.transmitTime );
+
+    // The image covers the ROI of the child. It is compressed at the measured
+    // ratio and speed and then sent over the link.
+    const PixelViewport& pvp = compound->getChannel()->getPixelViewport();
+    const float bytes = float( pvp.getArea( )) * data.vp.getArea() *
+                        bytesPerPixel * data.ratio;
+    const float bytesPerMS = float( bandwidth ) * 1.024f;
+    return float( data.compressTime ) + bytes / bytesPerMS;
+}
+
+std::vector< float > LoadEqualizer::computeShares( const ChildCosts& costs )
+{
+    const size_t nChildren = costs.size();
+    std::vector< float > shares( nChildren, 0.f );
+    std::vector< bool > used( nChildren, false );
+    for( size_t i = 0; i < nChildren; ++i )
+        used[i] = costs[i].renderTime > 0.f;
+
+    // With s_i = ( time - fixedTime_i ) / ( renderTime_i + areaTime_i ) and
+    // the sum of all s_i being one, all children finish at
+    //   time = ( 1 + sum( fixedTime_i * rate_i )) / sum( rate_i ).
+    // Children which can't deliver their fixed part until then get no work,
+    // which only lowers the time for the others.
+    for( ;; )
+    {
+        float rates = 0.f;
+        float fixed = 0.f;
+        for( size_t i = 0; i < nChildren; ++i )
+        {
+            if( !used[i] )
+                continue;
+            const float rate = 1.f / ( costs[i].renderTime +
+                                       costs[i].areaTime );
+            rates += rate;
+            fixed += costs[i].fixedTime * rate;
+        }
+        if( rates <= 0.f )
+            return shares;
+
+        const float time = ( 1.f + fixed ) / rates;
+        bool dropped = false;
+        for( size_t i = 0; i < nChildren; ++i )
+        {
+            if( used[i] && costs[i].fixedTime >= time )
+            {
+                used[i] = false;
+                dropped = true;
+            }
+        }
+        if( dropped )
+            continue;
+
+        for( size_t i = 0; i < nChildren; ++i )
+            if( used[i] )
+                shares[i] = ( time - costs[i].fixedTime ) /
+                            ( costs[i].renderTime + costs[i].areaTime );
+        return shares;
+    }
+}
+
 int64_t LoadEqualizer::_getTotalTime()
 {
     const LBFrameData& frameData = _history.front();
@@ -496,7 +823,7 @@ int64_t LoadEqualizer::_getTotalTime()
     for( LBDatas::const_iterator i = items.begin(); i != items.end(); ++i )
     {
         const Data& data = *i;
-        totalTime += data.time;
+        totalTime += int64_t( float( data.time ) * data.weight );
     }
     return totalTime;
 }
@@ -532,6 +859,11 @@ void LoadEqualizer::_computeSplit()
     // sort load items for each of the split directions
     LBDatas items( frameData.second );
     _removeEmpty( items );
+    _updateCostMap( frameData );
+
+    // balance the time of an average resource
+    for( Data& data : items )
+        data.time = int64_t( float( data.time ) * data.weight );
 
     LBDatas sortedData[3] = { items, items, items };
 
@@ -579,6 +911,50 @@ void LoadEqualizer::_removeEmpty( LBDatas& items )
     }
 }
 
+void LoadEqualizer::_updateCostMap( const LBFrameData& frameData )
+{
+    // The fake data set or an already integrated frame carry no new samples
+    if( frameData.first == 0 || frameData.first == _costMapFrame )
+        return;
+    _costMapFrame = frameData.first;
+    _resetCostMap( false );
+
+    const LBDatas& items = frameData.second;
+    if( _calibration.isEnabled() && _costMap.hasData( ))
+        _updateCalibration( items );
+
+    for( LBDatas::const_iterator i = items.begin(); i != items.end(); ++i )
+    {
+        const Data& data = *i;
+        if( data.area.hasArea() && data.range.hasData( ))
+            _updateCostMap( data, float( data.time ) * data.weight );
+    }
+}
+
+void LoadEqualizer::_updateCostMap( const Data& data, const float time )
+{
+    if( getMode() == MODE_DB )
+    {
+        const Viewport range( data.range.start, 0.f, data.range.getSize(),
+                              1.f );
+        _costMap.update( range, range, time );
+    }
+    else
+        _costMap.update( data.area, data.vp, time );
+}
+
+void LoadEqualizer::_resetCostMap( const bool force )
+{
+    const bool isDB = getMode() == MODE_DB;
+    const size_t width = isDB ? 256 : 64;
+    const size_t height = isDB ? 1 : 64;
+    if( force || _costMap.getWidth() != width ||
+        _costMap.getHeight() != height )
+    {
+        _costMap.reset( width, height );
+    }
+}
+
 void LoadEqualizer::_computeSplit( Node* node, const float time,
                                    LBDatas* datas, const Viewport& vp,
                                    const Range& range )
@@ -605,6 +981,12 @@ void LoadEqualizer::_computeSplit( Node* node, const float time,
                            time * node->left->resources / node->resources : 0.f;
     float timeLeft = LB_MIN( leftTime, time ); // correct for fp rounding error
 
+    // Integrate the cost density of the recent frames to find the split
+    // directly, instead of approaching it through damped steps.
+    const bool useCostMap = _costMap.hasData() && node->resources > 0.f;
+    const float leftShare = useCostMap ?
+                            node->left->resources / node->resources : 0.f;
+
     switch( node->mode )
     {
         case MODE_VERTICAL:
@@ -613,6 +995,11 @@ void LoadEqualizer::_computeSplit( Node* node, const float time,
 
             float splitPos = vp.x;
             const float end = vp.getXEnd();
+            if( useCostMap )
+            {
+                splitPos = _costMap.splitX( vp, leftShare );
+                timeLeft = 0.f;
+            }
 
             while( timeLeft > std::numeric_limits< float >::epsilon() &&
                    splitPos < end )
@@ -705,7 +1092,7 @@ void LoadEqualizer::_computeSplit( Node* node, const float time,
             }
 
             LBLOG( LOG_LB2 ) << "Should split at X " << splitPos << std::endl;
-            if( getDamping() < 1.f )
+            if( getDamping() < 1.f && !useCostMap )
                 splitPos = (1.f - getDamping()) * splitPos +
                             getDamping() * node->split;
             LBLOG( LOG_LB2 ) << "Dampened split at X " << splitPos << std::endl;
@@ -780,6 +1167,11 @@ void LoadEqualizer::_computeSplit( Node* node, const float time,
             LBASSERT( range == Range::ALL );
             float splitPos = vp.y;
             const float end = vp.getYEnd();
+            if( useCostMap )
+            {
+                splitPos = _costMap.splitY( vp, leftShare );
+                timeLeft = 0.f;
+            }
 
             while( timeLeft > std::numeric_limits< float >::epsilon() &&
                    splitPos < end )
@@ -873,7 +1265,7 @@ void LoadEqualizer::_computeSplit( Node* node, const float time,
             }
 
             LBLOG( LOG_LB2 ) << "Should split at Y " << splitPos << std::endl;
-            if( getDamping() < 1.f )
+            if( getDamping() < 1.f && !useCostMap )
                 splitPos = (1.f - getDamping( )) * splitPos +
                             getDamping() * node->split;
             LBLOG( LOG_LB2 ) << "Dampened split at Y " << splitPos << std::endl;
@@ -942,6 +1334,12 @@ void LoadEqualizer::_computeSplit( Node* node, const float time,
             LBASSERT( vp == Viewport::FULL );
             float splitPos = range.start;
             const float end = range.end;
+            if( useCostMap )
+            {
+                const Viewport area( range.start, 0.f, range.getSize(), 1.f );
+                splitPos = _costMap.splitX( area, leftShare );
+                timeLeft = 0.f;
+            }
 
             while( timeLeft > std::numeric_limits< float >::epsilon() &&
                    splitPos < end )
@@ -1013,7 +1411,7 @@ void LoadEqualizer::_computeSplit( Node* node, const float time,
                 }
             }
             LBLOG( LOG_LB2 ) << "Should split at " << splitPos << std::endl;
-            if( getDamping() < 1.f )
+            if( getDamping() < 1.f && !useCostMap )
                 splitPos = (1.f - getDamping( )) * splitPos +
                             getDamping() * node->split;
             LBLOG( LOG_LB2 ) << "Dampened split at " << splitPos << std::endl;
@@ -1072,9 +1470,11 @@ void LoadEqualizer::_assign( Compound* compound, const Viewport& vp,
     // save data for later use
     Data data;
     data.vp      = vp;
+    data.area    = vp;
     data.range   = range;
     data.channel = compound->getChannel();
     data.taskID  = compound->getTaskID();
+    data.weight  = _getWeight( compound );
 
     const Compound* destCompound = getCompound();
     if( destCompound->getChannel() == compound->getChannel( ))
@@ -1137,6 +1537,9 @@ std::ostream& operator << ( std::ostream& os, const LoadEqualizer* lb )
     if( lb->getResistancef() != .0f )
         os << "    resistance " << lb->getResistancef() << std::endl;
 
+    if( lb->getCalibrationFrames() > 0 )
+        os << "    calibrate " << lb->getCalibrationFrames() << std::endl;
+
     os << '}' << std::endl << lunchbox::enableFlush;
     return os;
 }
@@ -20,7 +20,9 @@
 #define EQS_LOADEQUALIZER_H
 
 #include "../channelListener.h" // base class
+#include "costMap.h"            // member
 #include "equalizer.h"          // base class
+#include "resourceCalibration.h" // member
 
 #include <eq/fabric/range.h>    // member
 #include <eq/fabric/viewport.h> // member
@@ -55,6 +57,31 @@ public:
 
     uint32_t getType() const final { return fabric::LOAD_EQUALIZER; }
 
+    /** The predicted cost of one child. @internal */
+    struct ChildCost
+    {
+        ChildCost() : renderTime( 0.f ), fixedTime( 0.f ), areaTime( 0.f ) {}
+
+        float renderTime; //!< time to render all work, 0 if unused
+        float fixedTime;  //!< transmit time independent of the share
+        float areaTime;   //!< transmit time of the full area
+    };
+    typedef std::vector< ChildCost > ChildCosts;
+
+    /**
+     * Compute the share of the work for each child.
+     *
+     * A child with the share s finishes after
+     * s * ( renderTime + areaTime ) + fixedTime. The shares equalize this
+     * time over all children which get work, which minimizes the time until
+     * the last child has delivered its image.
+     *
+     * @return the share of each child, summing up to one.
+     * @internal
+     */
+    EQSERVER_API static std::vector< float >
+    computeShares( const ChildCosts& costs );
+
 protected:
     void notifyChildAdded( Compound*, Compound* ) override
     { LBASSERT( !_tree ); }
@@ -89,14 +116,20 @@ private:
     struct Data
     {
         Data() : channel( 0 ), taskID( 0 ), destTaskID( 0 )
-               , time( -1 ), assembleTime( 0 ) {}
+               , time( -1 ), assembleTime( 0 ), transmitTime( 0 )
+               , compressTime( 0 ), ratio( 1.f ), weight( 1.f ) {}
         Channel* channel;
         uint32_t taskID;
         uint32_t destTaskID;
         Viewport vp;
+        Viewport area; //!< vp before applying the ROI
         Range    range;
-        int64_t  time;
+        int64_t  time; //!< render time
         int64_t  assembleTime;
+        int64_t  transmitTime; //!< readback, compression and transmission
+        int64_t  compressTime;
+        float    ratio; //!< compressed / uncompressed size
+        float    weight; //!< relative speed of the channel
     };
 
     typedef std::vector< Data > LBDatas;
@@ -104,6 +137,12 @@ private:
 
     std::deque< LBFrameData > _history;
 
+    CostMap  _costMap;      //!< cost density of the recent frames
+    uint32_t _costMapFrame; //!< last frame integrated into _costMap
+
+    ResourceCalibration _calibration; //!< relative speed of the children
+    uint32_t _calibrationFrame; //!< last frame rendered for the calibration
+
     //-------------------- Methods --------------------
     /** @return true if we have a valid LB tree */
     Node* _buildTree( const Compounds& children );
@@ -129,10 +168,44 @@ private:
     void _updateLeaf( Node* node );
     void _updateNode( Node* node, const Viewport& vp, const Range& range );
 
+    /** Rebalance the leaf resources to include the image transmission. */
+    void _updateTransmitTime();
+    void _getLeaves( Node* node, LBNodes& leaves );
+    void _updateResources( Node* node );
+
+    /** @return the predicted transmit time of the image of the given data. */
+    float _getTransmitTime( Compound* child, const Data& data );
+
     /** Adjust the split of each node based on the front-most _history. */
     void _computeSplit();
     void _removeEmpty( LBDatas& items );
 
+    /** Refine the cost map with the given, complete frame data. */
+    void _updateCostMap( const LBFrameData& frameData );
+    void _updateCostMap( const Data& data, float time );
+    void _resetCostMap( bool force );
+
+    /**
+     * Let all children render everything while calibrating, and measure
+     * their speed from the completed calibration frames.
+     *
+     * @return true if the children have been assigned for calibration.
+     */
+    bool _calibrate( uint32_t frameNumber );
+
+    /** Refine the speed of the children with a complete frame. */
+    void _updateCalibration( const LBDatas& items );
+
+    /** Initialize the cost map from a complete calibration frame. */
+    void _seedCostMap( const LBDatas& items );
+
+    /** @return the relative speed of the given child. */
+    float _getWeight( const Compound* child ) const;
+
+    /** @return the data of the given channel, or 0. */
+    static const Data* _findData( const LBDatas& items,
+                                  const Channel* channel );
+
     void _computeSplit( Node* node, const float time, LBDatas* sortedData,
                         const Viewport& vp, const Range& range );
     void _assign( Compound* compound, const Viewport& vp,
@@ -0,0 +1,108 @@
+
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "resourceCalibration.h"
+
+#include <lunchbox/debug.h>
+
+namespace eq
+{
+namespace server
+{
+
+ResourceCalibration::ResourceCalibration()
+    : _nFrames( 0 )
+    , _nSamples( 0 )
+    , _rate( 0.f )
+{}
+
+void ResourceCalibration::reset( const size_t nChildren,
+                                 const uint32_t nFrames, const float rate )
+{
+    _speeds.assign( nChildren, 0.f );
+    _counts.assign( nChildren, 0 );
+    _nFrames = nFrames;
+    _nSamples = 0;
+    _rate = rate;
+}
+
+void ResourceCalibration::addFrame( const Floats& work, const Floats& times )
+{
+    LBASSERT( work.size() == _speeds.size( ));
+    LBASSERT( times.size() == _speeds.size( ));
+    if( !isEnabled( ))
+        return;
+
+    Floats samples( _speeds.size(), 0.f );
+    for( size_t i = 0; i < samples.size(); ++i )
+        if( work[i] > 0.f && times[i] > 0.f )
+            samples[i] = work[i] / times[i];
+
+    if( isCalibrating( ))
+    {
+        if( _nSamples++ == 0 ) // contains one-time setup costs
+            return;
+
+        for( size_t i = 0; i < samples.size(); ++i )
+        {
+            if( samples[i] <= 0.f )
+                continue;
+            const float count = float( ++_counts[i] );
+            _speeds[i] += ( samples[i] - _speeds[i] ) / count;
+        }
+        return;
+    }
+
+    // The work of different frames is not comparable, only use the relative
+    // speeds of the children measured in this frame.
+    float measured = 0.f;
+    float expected = 0.f;
+    for( size_t i = 0; i < samples.size(); ++i )
+    {
+        if( samples[i] <= 0.f || _speeds[i] <= 0.f )
+            continue;
+        measured += samples[i];
+        expected += _speeds[i];
+    }
+    if( measured <= 0.f )
+        return;
+
+    const float scale = expected / measured;
+    for( size_t i = 0; i < samples.size(); ++i )
+        if( samples[i] > 0.f && _speeds[i] > 0.f )
+            _speeds[i] += _rate * ( samples[i] * scale - _speeds[i] );
+}
+
+float ResourceCalibration::getWeight( const size_t child ) const
+{
+    if( isCalibrating() || child >= _speeds.size() || _speeds[ child ] <= 0.f )
+        return 1.f;
+
+    float sum = 0.f;
+    size_t nSpeeds = 0;
+    for( const float speed : _speeds )
+    {
+        if( speed <= 0.f )
+            continue;
+        sum += speed;
+        ++nSpeeds;
+    }
+    return _speeds[ child ] * float( nSpeeds ) / sum;
+}
+
+}
+}
@@ -0,0 +1,90 @@
+
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQS_RESOURCECALIBRATION_H
+#define EQS_RESOURCECALIBRATION_H
+
+#include <eq/server/api.h>
+
+#include <lunchbox/types.h>
+#include <vector>
+
+namespace eq
+{
+namespace server
+{
+/**
+ * Measures the relative speed of the children of a load-balanced compound.
+ *
+ * During the calibration, all children render the same work. The first frame
+ * is ignored since it contains one-time setup costs, the following frames are
+ * averaged. Afterwards, each frame refines the speeds using a slow
+ * exponentially weighted moving average, which follows a changing load of the
+ * resources without reacting to the noise of single frames.
+ */
+class ResourceCalibration
+{
+public:
+    typedef std::vector< float > Floats;
+
+    EQSERVER_API ResourceCalibration();
+
+    /**
+     * Start a new calibration.
+     *
+     * @param nChildren the number of children.
+     * @param nFrames the number of measured frames, 0 disables calibration.
+     * @param rate the weight of a new frame after the calibration.
+     */
+    EQSERVER_API void reset( size_t nChildren, uint32_t nFrames,
+                             float rate = .05f );
+
+    /** @return true if the calibration is enabled. */
+    bool isEnabled() const { return _nFrames > 0; }
+
+    /** @return true while all children have to render the same work. */
+    bool isCalibrating() const
+        { return isEnabled() && _nSamples <= _nFrames; }
+
+    /**
+     * Add the measurements of one frame.
+     *
+     * The work is in arbitrary units, and only has to be comparable between
+     * the children of one frame. Children with no work or time are ignored.
+     *
+     * @param work the work done by each child.
+     * @param times the time used by each child.
+     */
+    EQSERVER_API void addFrame( const Floats& work, const Floats& times );
+
+    /**
+     * @return the speed of the given child relative to the average of all
+     *         measured children, 1 if unknown.
+     */
+    EQSERVER_API float getWeight( size_t child ) const;
+
+private:
+    Floats _speeds; // work per time, 0 if unknown
+    std::vector< uint32_t > _counts; // number of calibration samples
+    uint32_t _nFrames;
+    uint32_t _nSamples;
+    float _rate;
+};
+}
+}
+
+#endif // EQS_RESOURCECALIBRATION_H
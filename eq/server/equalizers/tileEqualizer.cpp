@@ -19,19 +19,29 @@
 
 #include "tileEqualizer.h"
 
+#include "../channel.h"
 #include "../compound.h"
 #include "../compoundVisitor.h"
 #include "../config.h"
+#include "../log.h"
 #include "../server.h"
 #include "../tileQueue.h"
 #include "../view.h"
 
+#include <eq/fabric/statistic.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 namespace eq
 {
 namespace server
 {
 namespace
 {
+static const int32_t MINSIZE = 16; // pixels
+static const float HYSTERESIS = .1f; // relative change of the tile area
 
 TileQueue* _findQueue( const std::string& name, const TileQueues& queues )
 {
@@ -56,8 +66,19 @@ public:
     /** Visit a leaf compound. */
     virtual VisitorResult visitLeaf( Compound* compound )
     {
-        if( _findQueue( _name, compound->getInputTileQueues( )))
+        Channel* channel = compound->getChannel();
+        if( channel && std::find( _channels.begin(), _channels.end(),
+                                  channel ) == _channels.end( ))
+        {
+            _channels.push_back( channel );
+        }
+
+        TileQueue* queue = _findQueue( _name, compound->getInputTileQueues( ));
+        if( queue )
+        {
+            queue->setTileSize( _tileSize );
             return TRAVERSE_CONTINUE;
+        }
 
         // reset compound viewport to (0, 0, 1, 1) (#108)
         if( !compound->getViewport().hasArea() )
@@ -74,9 +95,13 @@ public:
         return TRAVERSE_CONTINUE;
     }
 
+    /** @return the channels of all visited leaf compounds. */
+    const Channels& getChannels() const { return _channels; }
+
 private:
     const eq::fabric::Vector2i& _tileSize;
     const std::string& _name;
+    Channels _channels;
 };
 
 class InputQueueDestroyer : public CompoundVisitor
@@ -123,6 +148,13 @@ TileEqualizer::TileEqualizer( const TileEqualizer& from )
 {
 }
 
+TileEqualizer::~TileEqualizer()
+{
+    for( Channel* channel : _channels )
+        channel->removeListener( this );
+    _channels.clear();
+}
+
 std::string TileEqualizer::_getQueueName() const
 {
     std::ostringstream name;
@@ -140,6 +172,7 @@ void TileEqualizer::_createQueues( Compound* compound )
         ServerPtr server = compound->getServer();
         server->registerObject( output );
         output->setTileSize( getTileSize( ));
+        output->setTileStrategy( getTileStrategy( ));
         output->setName( name );
         output->setAutoObsolete( compound->getConfig()->getLatency( ));
 
@@ -148,6 +181,41 @@ void TileEqualizer::_createQueues( Compound* compound )
 
     InputQueueCreator creator( getTileSize(), name );
     compound->accept( creator );
+
+    // Subscribe to the tile load of all channels for the automatic tile size
+    _channels = creator.getChannels();
+    for( Channel* channel : _channels )
+        channel->addListener( this );
+}
+
+void TileEqualizer::_updateQueues( Compound* compound )
+{
+    const std::string& name = _getQueueName();
+    TileQueue* output = _findQueue( name, compound->getOutputTileQueues( ));
+    if( !output )
+        return;
+
+    output->setTileStrategy( getTileStrategy( ));
+    _updateNodeWeights( output );
+    if( output->getTileSize() == getTileSize( ))
+        return;
+
+    output->setTileSize( getTileSize( ));
+    InputQueueCreator updater( getTileSize(), name );
+    compound->accept( updater );
+}
+
+void TileEqualizer::_updateNodeWeights( TileQueue* queue ) const
+{
+    // size the tile ranges once the throughput of all channels is known
+    if( _rates.size() < _channels.size( ))
+        return;
+
+    std::map< const Node*, float > weights;
+    for( const auto& rate : _rates )
+        weights[ rate.first->getNode() ] += rate.second;
+    for( const auto& weight : weights )
+        queue->setNodeWeight( weight.first, weight.second );
 }
 
 void TileEqualizer::_destroyQueues( Compound* compound )
@@ -166,16 +234,169 @@ void TileEqualizer::_destroyQueues( Compound* compound )
     InputQueueDestroyer destroyer( name );
     compound->accept( destroyer );
     _created = false;
+
+    for( Channel* channel : _channels )
+        channel->removeListener( this );
+    _channels.clear();
+    _history.clear();
+    _rates.clear();
 }
 
 void TileEqualizer::notifyUpdatePre( Compound* compound,
-                                     const uint32_t /*frame*/ )
+                                     const uint32_t frameNumber )
 {
     if( isActive() && !_created )
         _createQueues( compound );
 
     if( !isActive() && _created )
         _destroyQueues( compound );
+
+    if( !_created )
+        return;
+
+    if( hasAutoTileSize() && !isFrozen( ))
+        _updateTileSize( compound, frameNumber );
+    else
+        _history.clear();
+
+    _updateQueues( compound );
+}
+
+void TileEqualizer::_updateTileSize( Compound* compound,
+                                     const uint32_t frameNumber )
+{
+    // use the youngest frame for which all channels have reported
+    const size_t nChannels = _channels.size();
+    std::deque< LoadFrame >::reverse_iterator i = _history.rbegin();
+    while( i != _history.rend() && i->second.nChannels < nChannels )
+        ++i;
+
+    if( i != _history.rend( ))
+    {
+        const PixelViewport& pvp = compound->getInheritPixelViewport();
+        const Vector2i& size = computeTileSize( getTileSize(), pvp, i->second );
+
+        if( size == getTileSize( )) // drop the used and all older frames
+            _history.erase( _history.begin(), i.base( ));
+        else
+        {
+            LBLOG( LOG_LB1 ) << "Tile size " << getTileSize() << " -> " << size
+                             << " after frame " << i->first << std::endl;
+            setTileSize( size );
+            // pending frames are drawn with the old tile size
+            _history.clear();
+        }
+    }
+
+    // don't leak the history of frames which never finish
+    const size_t maxHistory = compound->getConfig()->getLatency() + 2;
+    while( _history.size() > maxHistory )
+        _history.pop_front();
+
+    _history.push_back( LoadFrame( frameNumber, Load( )));
+}
+
+Vector2i TileEqualizer::computeTileSize( const Vector2i& size,
+                                         const PixelViewport& pvp,
+                                         const Load& load ) const
+{
+    if( load.nTiles == 0 || load.nChannels == 0 || load.maxTileTime <= 0 ||
+        size.x() <= 0 || size.y() <= 0 || !pvp.hasArea( ))
+    {
+        return size;
+    }
+
+    // Each channel draws area / ( tileArea * nChannels ) tiles, each paying
+    // the queue overhead. The channel drawing the slowest tile last finishes
+    // up to maxTileTime later than the others. The sum
+    //   overhead * area / ( tileArea * nChannels ) + rate * tileArea
+    // is minimal for tileArea = sqrt( overhead * area / ( nChannels * rate )).
+    const float tileArea = float( size.x( )) * float( size.y( ));
+    const float overhead = float( load.idleTime ) / float( load.nTiles );
+    const float rate = float( load.maxTileTime ) / tileArea;
+    const float optimum = std::sqrt( std::max( overhead, 0.f ) *
+                                     float( pvp.getArea( )) /
+                                     ( float( load.nChannels ) * rate ));
+
+    const float damping = std::min( std::max( getDamping(), 0.f ), 1.f );
+    const float area = ( 1.f - damping ) * optimum + damping * tileArea;
+    if( std::abs( area - tileArea ) < HYSTERESIS * tileArea )
+        return size;
+
+    // keep the aspect ratio, round to multiples of the minimum size
+    const float scale = std::sqrt( area / tileArea );
+    Vector2i newSize;
+    for( size_t j = 0; j < 2; ++j )
+    {
+        const int32_t max = std::max( j == 0 ? pvp.w : pvp.h, MINSIZE );
+        int32_t value = int32_t( float( size[j] ) * scale + .5f );
+        value = ( value + MINSIZE / 2 ) / MINSIZE * MINSIZE;
+        newSize[j] = std::min( std::max( value, MINSIZE ), max );
+    }
+    return newSize;
+}
+
+void TileEqualizer::notifyLoadData( Channel* channel,
+                                    const uint32_t frameNumber,
+                                    const Statistics& statistics,
+                                    const Viewport& /*region*/ )
+{
+    LoadFrame* frame = 0;
+    for( LoadFrame& data : _history )
+        if( data.first == frameNumber )
+            frame = &data;
+    if( !frame )
+        return;
+
+    // Draw is sampled per tile, clear and readback once for all tiles. The
+    // remainder of the tile loop is spent waiting on the queue.
+    Load& load = frame->second;
+    int64_t startTime = std::numeric_limits< int64_t >::max();
+    int64_t endTime = 0;
+    int64_t busyTime = 0;
+    int64_t drawTime = 0;
+    uint32_t nTiles = 0;
+    for( const Statistic& stat : statistics )
+    {
+        const int64_t time = stat.endTime - stat.startTime;
+        switch( stat.type )
+        {
+        case Statistic::CHANNEL_DRAW:
+            ++nTiles;
+            drawTime += time;
+            load.drawTime += time;
+            load.maxTileTime = std::max( load.maxTileTime, time );
+            break;
+        case Statistic::CHANNEL_CLEAR:
+        case Statistic::CHANNEL_READBACK:
+            break;
+        default:
+            continue;
+        }
+        busyTime += time;
+        startTime = std::min( startTime, stat.startTime );
+        endTime = std::max( endTime, stat.endTime );
+    }
+
+    ++load.nChannels;
+    if( nTiles == 0 )
+        return;
+
+    load.nTiles += nTiles;
+    load.idleTime += std::max( endTime - startTime - busyTime, int64_t( 0 ));
+
+    const float rate = float( nTiles ) / float( std::max( drawTime,
+                                                          int64_t( 1 )));
+    std::map< const Channel*, float >::iterator j = _rates.find( channel );
+    if( j == _rates.end( ))
+        _rates[ channel ] = rate;
+    else
+    {
+        const float damping = std::min( std::max( getDamping(), 0.f ), 1.f );
+        j->second = ( 1.f - damping ) * rate + damping * j->second;
+    }
+    LBLOG( LOG_LB2 ) << nTiles << " tiles on " << channel->getName()
+                     << " frame " << frameNumber << std::endl;
 }
 
 std::ostream& operator << ( std::ostream& os, const TileEqualizer* lb )
@@ -186,8 +407,13 @@ std::ostream& operator << ( std::ostream& os, const TileEqualizer* lb )
            << "tile_equalizer" << std::endl
            << "{" << std::endl
            << "    name \"" << lb->getName() << "\"" << std::endl
-           << "    size " << lb->getTileSize() << std::endl
-           << "}" << std::endl << lunchbox::enableFlush;
+           << "    size " << lb->getTileSize() << std::endl;
+        if( lb->hasAutoTileSize( ))
+            os << "    size AUTO" << std::endl
+               << "    damping " << lb->getDamping() << std::endl;
+        if( lb->getTileStrategy() != fabric::Equalizer::TILE_ZIGZAG )
+            os << "    strategy " << lb->getTileStrategy() << std::endl;
+        os << "}" << std::endl << lunchbox::enableFlush;
     }
     return os;
 }
@@ -19,7 +19,11 @@
 #ifndef EQS_TILEEQUALIZER_H
 #define EQS_TILEEQUALIZER_H
 
-#include "equalizer.h"
+#include "../channelListener.h" // base class
+#include "equalizer.h"           // base class
+
+#include <deque>
+#include <map>
 
 namespace eq
 {
@@ -28,12 +32,31 @@ namespace server
 
 std::ostream& operator << ( std::ostream& os, const TileEqualizer* );
 
-class TileEqualizer : public Equalizer
+/**
+ * Distributes the tiles of the attached compound through a tile queue.
+ *
+ * With an automatic tile size, the size is adapted each frame to balance the
+ * per-tile queue overhead against the load imbalance caused by the last tile.
+ */
+class TileEqualizer : public Equalizer, protected ChannelListener
 {
 public:
     EQSERVER_API TileEqualizer();
     TileEqualizer( const TileEqualizer& from );
-    ~TileEqualizer() {}
+    ~TileEqualizer();
+
+    /** The load of one frame drawn from the tile queue. */
+    struct Load
+    {
+        Load() : nTiles( 0 ), nChannels( 0 ), drawTime( 0 ), idleTime( 0 )
+               , maxTileTime( 0 ) {}
+
+        uint32_t nTiles;     //!< number of tiles drawn
+        uint32_t nChannels;  //!< number of channels which reported
+        int64_t drawTime;    //!< sum of the tile draw times
+        int64_t idleTime;    //!< sum of the time spent between tiles
+        int64_t maxTileTime; //!< draw time of the slowest tile
+    };
 
     /** @sa CompoundListener::notifyUpdatePre */
     void notifyUpdatePre( Compound* compound,
@@ -46,17 +69,47 @@ public:
 
     uint32_t getType() const final { return fabric::TILE_EQUALIZER; }
 
+    /**
+     * Compute the tile size for the next frame.
+     *
+     * @param size the tile size used for the given load.
+     * @param pvp the area covered by the tiles.
+     * @param load the load of one frame drawn with the given size.
+     * @return the new tile size, damped by the equalizer damping.
+     * @internal
+     */
+    EQSERVER_API Vector2i computeTileSize( const Vector2i& size,
+                                           const PixelViewport& pvp,
+                                           const Load& load ) const;
+
 protected:
     void notifyChildAdded( Compound*, Compound* ) override {}
     void notifyChildRemove( Compound*, Compound* ) override {}
 
+    /** @sa ChannelListener::notifyLoadData */
+    void notifyLoadData( Channel* channel, uint32_t frameNumber,
+                         const Statistics& statistics,
+                         const Viewport& region ) final;
+
 private:
     std::string _getQueueName() const;
     void _destroyQueues( Compound* compound );
     void _createQueues( Compound* compound );
+    void _updateQueues( Compound* compound );
+    void _updateTileSize( Compound* compound, uint32_t frameNumber );
+    void _updateNodeWeights( TileQueue* queue ) const;
 
     bool _created;
     std::string _name;
+
+    /** The channels drawing the tiles, listened to for an auto size. */
+    Channels _channels;
+
+    typedef std::pair< uint32_t, Load > LoadFrame;
+    std::deque< LoadFrame > _history;
+
+    /** The damped tiles per millisecond drawn by each channel. */
+    std::map< const Channel*, float > _rates;
 };
 
 } //server
@@ -37,6 +37,8 @@ std::ostream& operator << ( std::ostream& os, const TreeEqualizer::Node* );
 
 TreeEqualizer::TreeEqualizer()
         : _tree( 0 )
+        , _calibrationFrame( 0 )
+        , _sampledFrame( 0 )
 {
     LBINFO << "New TreeEqualizer @" << (void*)this << std::endl;
 }
@@ -45,6 +47,8 @@ TreeEqualizer::TreeEqualizer( const TreeEqualizer& from )
         : Equalizer( from )
         , ChannelListener( from )
         , _tree( 0 )
+        , _calibrationFrame( 0 )
+        , _sampledFrame( 0 )
 {}
 
 TreeEqualizer::~TreeEqualizer()
@@ -55,7 +59,7 @@ TreeEqualizer::~TreeEqualizer()
 }
 
 void TreeEqualizer::notifyUpdatePre( Compound* compound,
-                                     const uint32_t /*frame*/ )
+                                     const uint32_t frameNumber )
 {
     if( isFrozen() || !compound->isActive( ) || !isActive( ))
         return;
@@ -75,11 +79,15 @@ void TreeEqualizer::notifyUpdatePre( Compound* compound,
               return;
           default:
               _tree = _buildTree( children );
+              _calibration.reset( children.size(), getCalibrationFrames( ));
         }
     }
 
     // compute new data
     _update( _tree );
+    if( _calibrate( frameNumber ))
+        return;
+
     _split( _tree );
     _assign( _tree, Viewport(), Range( ));
     LBLOG( LOG_LB2 ) << "LB tree: " << _tree;
@@ -117,6 +125,111 @@ TreeEqualizer::Node* TreeEqualizer::_buildTree( const Compounds& compounds )
     return node;
 }
 
+bool TreeEqualizer::_calibrate( const uint32_t frameNumber )
+{
+    if( !_calibration.isEnabled( ))
+        return false;
+
+    LBNodes leaves;
+    _getLeaves( _tree, leaves );
+    if( _calibration.isCalibrating( ))
+    {
+        // add the oldest frame reported by all children, if not yet added
+        uint32_t frame = std::numeric_limits< uint32_t >::max();
+        ResourceCalibration::Floats work( leaves.size(), 0.f );
+        ResourceCalibration::Floats times( leaves.size(), 0.f );
+        for( size_t i = 0; i < leaves.size(); ++i )
+        {
+            const Node* leaf = leaves[i];
+            if( leaf->resources <= 0.f )
+                continue;
+            frame = LB_MIN( frame, leaf->frame );
+            work[i] = 1.f;
+            times[i] = float( leaf->time );
+        }
+
+        if( frame > _sampledFrame &&
+            frame != std::numeric_limits< uint32_t >::max( ))
+        {
+            _sampledFrame = frame;
+            _calibration.addFrame( work, times );
+            if( !_calibration.isCalibrating( ))
+            {
+                _seedSplit( _tree );
+                LBLOG( LOG_LB1 ) << "Calibrated LB tree: " << _tree;
+            }
+        }
+    }
+
+    if( _calibration.isCalibrating( ))
+    {
+        _calibrationFrame = frameNumber;
+        for( Node* leaf : leaves )
+        {
+            Compound* compound = leaf->compound;
+            if( leaf->resources > 0.f )
+            {
+                compound->setViewport( Viewport( ));
+                compound->setRange( Range( ));
+            }
+            else if( getMode() == MODE_DB )
+                compound->setRange( Range( 0.f, 0.f ));
+            else
+                compound->setViewport( Viewport( 0.f, 0.f, 0.f, 0.f ));
+        }
+        return true;
+    }
+
+    // The times are still from calibration frames and would move the splits
+    for( const Node* leaf : leaves )
+    {
+        if( leaf->resources > 0.f && leaf->frame <= _calibrationFrame )
+        {
+            _assign( _tree, Viewport(), Range( ));
+            return true;
+        }
+    }
+    return false;
+}
+
+float TreeEqualizer::_seedSplit( Node* node )
+{
+    if( node->compound )
+        return node->resources * _getWeight( node->compound );
+
+    const float left = _seedSplit( node->left );
+    const float right = _seedSplit( node->right );
+    if( left + right > 0.f )
+    {
+        node->split = left / ( left + right );
+        node->oldsplit = node->split;
+    }
+    return left + right;
+}
+
+float TreeEqualizer::_getWeight( const Compound* child ) const
+{
+    const Compounds& children = getCompound()->getChildren();
+    for( size_t i = 0; i < children.size(); ++i )
+        if( children[i] == child )
+            return _calibration.getWeight( i );
+    return 1.f;
+}
+
+void TreeEqualizer::_getLeaves( Node* node, LBNodes& leaves )
+{
+    if( !node )
+        return;
+
+    if( node->compound )
+        leaves.push_back( node );
+    else
+    {
+        _getLeaves( node->left, leaves );
+        _getLeaves( node->right, leaves );
+    }
+}
+
 void TreeEqualizer::_clearTree( Node* node )
 {
     if( !node )
@@ -136,21 +249,22 @@ void TreeEqualizer::_clearTree( Node* node )
 }
 
 void TreeEqualizer::notifyLoadData( Channel* channel,
-                                    const uint32_t /*frame*/,
+                                    const uint32_t frameNumber,
                                     const Statistics& statistics,
                                     const Viewport& /*region*/ )
 {
-    _notifyLoadData( _tree, channel, statistics );
+    _notifyLoadData( _tree, channel, frameNumber, statistics );
 }
 
 void TreeEqualizer::_notifyLoadData( Node* node, Channel* channel,
+                                     const uint32_t frameNumber,
                                      const Statistics& statistics )
 {
     if( !node )
         return;
 
-    _notifyLoadData( node->left, channel, statistics );
-    _notifyLoadData( node->right, channel, statistics );
+    _notifyLoadData( node->left, channel, frameNumber, statistics );
+    _notifyLoadData( node->right, channel, frameNumber, statistics );
 
     if( !node->compound || node->compound->getChannel() != channel )
         return;
@@ -197,6 +311,7 @@ void TreeEqualizer::_notifyLoadData( Node* node, Channel* channel,
     node->time = endTime - startTime;
     node->time = LB_MAX( node->time, 1 );
     node->time = LB_MAX( node->time, timeTransmit );
+    node->frame = frameNumber;
 }
 
 void TreeEqualizer::_update( Node* node )
@@ -632,6 +747,9 @@ std::ostream& operator << ( std::ostream& os, const TreeEqualizer* lb )
     if( lb->getResistancef() != .0f )
         os << "    resistance " << lb->getResistancef() << std::endl;
 
+    if( lb->getCalibrationFrames() > 0 )
+        os << "    calibrate " << lb->getCalibrationFrames() << std::endl;
+
     os << '}' << std::endl << lunchbox::enableFlush;
     return os;
 }
@@ -21,6 +21,7 @@
 
 #include "../channelListener.h" // base class
 #include "equalizer.h"          // base class
+#include "resourceCalibration.h" // member
 
 #include <eq/fabric/range.h>    // member
 #include <eq/fabric/viewport.h> // member
@@ -65,7 +66,7 @@ namespace server
         {
             Node() : left(0), right(0), compound(0), mode( MODE_VERTICAL )
                    , resources( 0.0f ), split( 0.5f ), oldsplit( 0.0f ), boundaryf( 0.0f )
-                   , resistancef( 0.0f ), time( 1 ) {}
+                   , resistancef( 0.0f ), time( 1 ), frame( 0 ) {}
             ~Node() { delete left; delete right; }
 
             Node*     left;      //<! Left child (only on non-leafs)
@@ -81,12 +82,17 @@ namespace server
             Vector2i  resistance2i;
             Vector2i  maxSize;
             int64_t   time;
+            uint32_t  frame;     //<! Frame of the time (only on leafs)
         };
         friend std::ostream& operator << ( std::ostream& os, const Node* node );
         typedef std::vector< Node* > LBNodes;
 
         Node* _tree; // <! The binary split tree of all children
 
+        ResourceCalibration _calibration; //!< relative speed of the children
+        uint32_t _calibrationFrame; //!< last frame rendered for calibration
+        uint32_t _sampledFrame; //!< last frame added to _calibration
+
         //-------------------- Methods --------------------
         /** @return true if we have a valid LB tree */
         Node* _buildTree( const Compounds& children );
@@ -95,11 +101,28 @@ namespace server
         void _clearTree( Node* node );
 
         void _notifyLoadData( Node* node, Channel* channel,
+                              uint32_t frameNumber,
                               const Statistics& statistics );
 
         /** Update all node fields influencing the split */
         void _update( Node* node );
 
+        /**
+         * Let all children render everything while calibrating, and keep the
+         * calibrated splits until the children report regular frames.
+         *
+         * @return true if the children have been assigned.
+         */
+        bool _calibrate( uint32_t frameNumber );
+
+        /** Set the splits to the calibrated speed, @return the speed. */
+        float _seedSplit( Node* node );
+
+        /** @return the relative speed of the given child. */
+        float _getWeight( const Compound* child ) const;
+
+        void _getLeaves( Node* node, LBNodes& leaves );
+
         /** Adjust the split of each node based on the front-most _history. */
         void _split( Node* node );
         void _assign( Node* node, const Viewport& vp, const Range& range );
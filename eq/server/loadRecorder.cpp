@@ -0,0 +1,142 @@
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "loadRecorder.h"
+
+#include "channel.h"
+#include "compound.h"
+#include "compoundVisitor.h"
+#include "config.h"
+#include "global.h"
+#include "server.h"
+
+#include <eq/fabric/statistic.h>
+
+namespace eq
+{
+namespace server
+{
+namespace
+{
+const Compound* _getDestination( const Compound* compound )
+{
+    const Compound* destination = compound;
+    for( const Compound* i = compound->getParent(); i; i = i->getParent( ))
+        if( i->getChannel( ))
+            destination = i;
+    return destination;
+}
+
+class ChannelCollector : public CompoundVisitor
+{
+public:
+    explicit ChannelCollector( std::set< Channel* >& channels )
+        : _channels( channels ) {}
+
+    VisitorResult visit( Compound* compound ) override
+    {
+        Channel* channel = compound->getChannel();
+        if( channel )
+            _channels.insert( channel );
+        return TRAVERSE_CONTINUE;
+    }
+
+private:
+    std::set< Channel* >& _channels;
+};
+
+class TaskRecorder : public CompoundVisitor
+{
+public:
+    TaskRecorder( std::ostream& os, const uint32_t frameNumber )
+        : _os( os ), _frameNumber( frameNumber ) {}
+
+    VisitorResult visit( const Compound* compound ) override
+    {
+        if( !compound->getChannel() || !compound->isActive( ))
+            return TRAVERSE_CONTINUE;
+
+        const Viewport& vp = compound->getInheritViewport();
+        const Range& range = compound->getInheritRange();
+        _os << "#trace task " << _frameNumber << ' ' << compound->getTaskID()
+            << ' ' << _getDestination( compound )->getTaskID() << ' '
+            << vp.x << ' ' << vp.y << ' ' << vp.w << ' ' << vp.h << ' '
+            << range.start << ' ' << range.end << '\n';
+        return TRAVERSE_CONTINUE;
+    }
+
+private:
+    std::ostream& _os;
+    const uint32_t _frameNumber;
+};
+}
+
+LoadRecorder::LoadRecorder( Config& config, const std::string& filename )
+    : _config( config )
+    , _file( filename.c_str( ))
+{
+    if( !_file.good( ))
+    {
+        LBWARN << "Can't open load trace " << filename << std::endl;
+        return;
+    }
+
+    _file << Global::instance() << *config.getServer() << std::endl;
+
+    ChannelCollector collector( _channels );
+    for( Compound* compound : config.getCompounds( ))
+        compound->accept( collector );
+    for( Channel* channel : _channels )
+        channel->addListener( this );
+
+    LBINFO << "Recording load trace of " << _channels.size()
+           << " channels to " << filename << std::endl;
+}
+
+LoadRecorder::~LoadRecorder()
+{
+    for( Channel* channel : _channels )
+        channel->removeListener( this );
+}
+
+void LoadRecorder::recordFrame( const uint32_t frameNumber )
+{
+    if( !_file.good( ))
+        return;
+
+    TaskRecorder recorder( _file, frameNumber );
+    for( Compound* compound : _config.getCompounds( ))
+        compound->accept( recorder );
+}
+
+void LoadRecorder::notifyLoadData( Channel*, const uint32_t frameNumber,
+                                   const Statistics& statistics,
+                                   const Viewport& region )
+{
+    if( !_file.good( ))
+        return;
+
+    _file << "#trace load " << frameNumber << ' ' << region.x << ' '
+          << region.y << ' ' << region.w << ' ' << region.h << ' '
+          << statistics.size();
+    for( const Statistic& stat : statistics )
+        _file << ' ' << int( stat.type ) << ' ' << stat.task << ' '
+              << stat.startTime << ' ' << stat.endTime;
+    _file << std::endl;
+}
+
+}
+}
@@ -0,0 +1,70 @@
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQSERVER_LOADRECORDER_H
+#define EQSERVER_LOADRECORDER_H
+
+#include "channelListener.h" // base class
+#include "types.h"
+
+#include <fstream>
+#include <set>
+
+namespace eq
+{
+namespace server
+{
+/**
+ * Records the equalizer input of a running config into a load trace.
+ *
+ * The trace is a loadable config file, followed by one comment line per
+ * compound and frame and per received load data set:
+ * @verbatim
+   #trace task <frame> <task> <destination task> <vp x y w h> <range start end>
+   #trace load <frame> <region x y w h> <n> n*( <type> <task> <start> <end> )
+   @endverbatim
+ * The task lines describe the inherit viewport and range of each compound
+ * after the equalizers updated the frame. Traces are replayed by the
+ * equalizerBenchmark tool. Enabled by setting EQ_LOAD_TRACE to the name of
+ * the trace file.
+ */
+class LoadRecorder : protected ChannelListener
+{
+public:
+    /** Write the config and start listening on all its channels. */
+    LoadRecorder( Config& config, const std::string& filename );
+    virtual ~LoadRecorder();
+
+    /** @return true if the trace file is writable. */
+    bool isGood() const { return _file.good(); }
+
+    /** Record the assignment of all compounds for a started frame. */
+    void recordFrame( uint32_t frameNumber );
+
+protected:
+    /** @sa ChannelListener::notifyLoadData */
+    void notifyLoadData( Channel* channel, uint32_t frameNumber,
+                         const Statistics& statistics,
+                         const Viewport& region ) final;
+
+private:
+    Config& _config;
+    std::ofstream _file;
+    std::set< Channel* > _channels;
+};
+}
+}
+#endif // EQSERVER_LOADRECORDER_H
@@ -102,6 +102,7 @@
 %token EQTOKEN_GLOBAL
 %token EQTOKEN_CHANNEL_IATTR_HINT_STATISTICS
 %token EQTOKEN_CHANNEL_IATTR_HINT_SENDTOKEN
+%token EQTOKEN_CHANNEL_IATTR_HINT_TILE_PIPELINE
 %token EQTOKEN_CHANNEL_SATTR_DUMP_IMAGE
 %token EQTOKEN_COMPOUND_IATTR_STEREO_MODE
 %token EQTOKEN_COMPOUND_IATTR_STEREO_ANAGLYPH_LEFT_MASK
@@ -118,6 +119,7 @@
 %token EQTOKEN_NODE_CATTR_LAUNCH_COMMAND_QUOTE
 %token EQTOKEN_NODE_IATTR_THREAD_MODEL
 %token EQTOKEN_NODE_IATTR_HINT_AFFINITY
+%token EQTOKEN_NODE_IATTR_HINT_ZERO_COPY
 %token EQTOKEN_NODE_IATTR_HINT_STATISTICS
 %token EQTOKEN_NODE_IATTR_LAUNCH_TIMEOUT
 %token EQTOKEN_PIPE_IATTR_HINT_CUDA_GL_INTEROP
@@ -159,10 +161,12 @@
 %token EQTOKEN_HINT_DECORATION
 %token EQTOKEN_HINT_STATISTICS
 %token EQTOKEN_HINT_SENDTOKEN
+%token EQTOKEN_HINT_TILE_PIPELINE
 %token EQTOKEN_HINT_SWAPSYNC
 %token EQTOKEN_HINT_DRAWABLE
 %token EQTOKEN_HINT_THREAD
 %token EQTOKEN_HINT_AFFINITY
+%token EQTOKEN_HINT_ZERO_COPY
 %token EQTOKEN_HINT_CUDA_GL_INTEROP
 %token EQTOKEN_HINT_SCREENSAVER
 %token EQTOKEN_HINT_GRAB_POINTER
@@ -296,6 +300,12 @@
 %token EQTOKEN_INTEGER
 %token EQTOKEN_UNSIGNED
 %token EQTOKEN_SIZE
+%token EQTOKEN_STRATEGY
+%token EQTOKEN_CALIBRATE
+%token EQTOKEN_ZIGZAG
+%token EQTOKEN_RASTER
+%token EQTOKEN_SPIRAL
+%token EQTOKEN_SQUARE
 %token EQTOKEN_CORE
 %token EQTOKEN_SOCKET
 %token EQTOKEN_DEFLECT_HOST
@@ -310,6 +320,7 @@
     co::ConnectionType   _connectionType;
     eq::server::LoadEqualizer::Mode _loadEqualizerMode;
     eq::server::TreeEqualizer::Mode _treeEqualizerMode;
+    eq::fabric::Equalizer::TileStrategy _tileStrategy;
     float                   _viewport[4];
 }
 
@@ -320,6 +331,7 @@
 %type <_connectionType>   connectionType;
 %type <_loadEqualizerMode> loadEqualizerMode;
 %type <_treeEqualizerMode> treeEqualizerMode;
+%type <_tileStrategy>     tileStrategy;
 %type <_viewport>         viewport;
 %type <_float>            FLOAT;
 
@@ -395,6 +407,11 @@ global:
          eq::server::Global::instance()->setNodeIAttribute(
              eq::server::Node::IATTR_HINT_AFFINITY, $2 );
      }
+     | EQTOKEN_NODE_IATTR_HINT_ZERO_COPY IATTR
+     {
+         eq::server::Global::instance()->setNodeIAttribute(
+             eq::server::Node::IATTR_HINT_ZERO_COPY, $2 );
+     }
      | EQTOKEN_NODE_IATTR_LAUNCH_TIMEOUT UNSIGNED
      {
          eq::server::Global::instance()->setNodeIAttribute(
@@ -525,6 +542,11 @@ global:
          eq::server::Global::instance()->setChannelIAttribute(
              eq::server::Channel::IATTR_HINT_SENDTOKEN, $2 );
      }
+     | EQTOKEN_CHANNEL_IATTR_HINT_TILE_PIPELINE IATTR
+     {
+         eq::server::Global::instance()->setChannelIAttribute(
+             eq::server::Channel::IATTR_HINT_TILE_PIPELINE, $2 );
+     }
      | EQTOKEN_COMPOUND_IATTR_STEREO_MODE IATTR
      {
          eq::server::Global::instance()->setCompoundIAttribute(
@@ -662,6 +684,8 @@ nodeAttribute:
         }
     | EQTOKEN_HINT_AFFINITY IATTR
         { node->setIAttribute( eq::server::Node::IATTR_HINT_AFFINITY, $2 ); }
+    | EQTOKEN_HINT_ZERO_COPY IATTR
+        { node->setIAttribute( eq::server::Node::IATTR_HINT_ZERO_COPY, $2 ); }
 
 
 pipe: EQTOKEN_PIPE '{'
@@ -782,6 +806,9 @@ channelAttribute:
     | EQTOKEN_HINT_SENDTOKEN IATTR
         { channel->setIAttribute( eq::server::Channel::IATTR_HINT_SENDTOKEN,
                                   $2 ); }
+    | EQTOKEN_HINT_TILE_PIPELINE IATTR
+        { channel->setIAttribute(
+              eq::server::Channel::IATTR_HINT_TILE_PIPELINE, $2 ); }
     | EQTOKEN_DUMP_IMAGE STRING
         { channel->setSAttribute( eq::server::Channel::SATTR_DUMP_IMAGE,
                                   $2 ); }
@@ -1211,6 +1238,7 @@ loadEqualizerField:
     | EQTOKEN_RESISTANCE '[' UNSIGNED UNSIGNED ']'
         { loadEqualizer->setResistance( eq::fabric::Vector2i( $3, $4 )); }
     | EQTOKEN_RESISTANCE FLOAT  { loadEqualizer->setResistance( $2 ); }
+    | EQTOKEN_CALIBRATE UNSIGNED { loadEqualizer->setCalibrationFrames( $2 ); }
 
 loadEqualizerMode:
     EQTOKEN_2D           { $$ = eq::server::LoadEqualizer::MODE_2D; }
@@ -1228,6 +1256,7 @@ treeEqualizerField:
     | EQTOKEN_RESISTANCE '[' UNSIGNED UNSIGNED ']'
         { treeEqualizer->setResistance( eq::fabric::Vector2i( $3, $4 )); }
     | EQTOKEN_RESISTANCE FLOAT  { treeEqualizer->setResistance( $2 ); }
+    | EQTOKEN_CALIBRATE UNSIGNED { treeEqualizer->setCalibrationFrames( $2 ); }
 
 treeEqualizerMode:
     EQTOKEN_2D           { $$ = eq::server::TreeEqualizer::MODE_2D; }
@@ -1240,6 +1269,15 @@ tileEqualizerField:
     EQTOKEN_NAME STRING                   { tileEqualizer->setName( $2 ); }
     | EQTOKEN_SIZE '[' UNSIGNED UNSIGNED ']'
                    { tileEqualizer->setTileSize( eq::fabric::Vector2i( $3, $4 )); }
+    | EQTOKEN_SIZE EQTOKEN_AUTO      { tileEqualizer->setAutoTileSize( true ); }
+    | EQTOKEN_DAMPING FLOAT          { tileEqualizer->setDamping( $2 ); }
+    | EQTOKEN_STRATEGY tileStrategy  { tileEqualizer->setTileStrategy( $2 ); }
+
+tileStrategy:
+    EQTOKEN_ZIGZAG   { $$ = eq::fabric::Equalizer::TILE_ZIGZAG; }
+    | EQTOKEN_RASTER { $$ = eq::fabric::Equalizer::TILE_RASTER; }
+    | EQTOKEN_SPIRAL { $$ = eq::fabric::Equalizer::TILE_SPIRAL; }
+    | EQTOKEN_SQUARE { $$ = eq::fabric::Equalizer::TILE_SQUARE; }
 
 swapBarrier:
     EQTOKEN_SWAPBARRIER '{' { swapBarrier = new eq::server::SwapBarrier; }
@@ -1297,6 +1335,7 @@ tileQueueField:
     EQTOKEN_NAME STRING { tileQueue->setName( $2 ); }
     | EQTOKEN_SIZE '[' UNSIGNED UNSIGNED ']'
         { tileQueue->setTileSize( eq::fabric::Vector2i( $3, $4 )); }
+    | EQTOKEN_STRATEGY tileStrategy { tileQueue->setTileStrategy( $2 ); }
 
 compoundAttributes: /*null*/ | compoundAttributes compoundAttribute
 compoundAttribute:
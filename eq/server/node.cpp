@@ -670,12 +670,14 @@ bool Node::_cmdFrameFinishReply( co::ICommand& cmd )
     co::ObjectICommand command( cmd );
     LBVERB << "handle frame finish reply " << command << std::endl;
 
-    const uint32_t frameNumber = command.read< uint32_t >();
+    finishFrame( command.read< uint32_t >( ));
+    return true;
+}
 
+void Node::finishFrame( const uint32_t frameNumber )
+{
     _finishedFrame = frameNumber;
     getConfig()->notifyNodeFrameFinished( frameNumber );
-
-    return true;
 }
 
 void Node::output( std::ostream& os ) const
@@ -751,6 +753,7 @@ void Node::output( std::ostream& os ) const
         os << ( i== Node::IATTR_LAUNCH_TIMEOUT ? "launch_timeout       " :
                 i== Node::IATTR_THREAD_MODEL   ? "thread_model         " :
                 i== Node::IATTR_HINT_AFFINITY  ? "hint_affinity        " :
+                i== Node::IATTR_HINT_ZERO_COPY ? "hint_zero_copy       " :
                 "ERROR" )
            << static_cast< fabric::IAttribute >( value ) << std::endl;
     }
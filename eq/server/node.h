@@ -96,6 +96,9 @@ public:
 
     /** @return the number of the last finished frame. @internal */
     uint32_t getFinishedFrame() const { return _finishedFrame; }
+
+    /** Mark the given frame finished and notify the config. @internal */
+    void finishFrame( const uint32_t frameNumber );
     //@}
 
     /**
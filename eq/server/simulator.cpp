@@ -0,0 +1,246 @@
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "simulator.h"
+
+#include "canvas.h"
+#include "channel.h"
+#include "compound.h"
+#include "compoundUpdateActivateVisitor.h"
+#include "compoundUpdateDataVisitor.h"
+#include "compoundVisitor.h"
+#include "config.h"
+#include "layout.h"
+#include "node.h"
+#include "observer.h"
+#include "pipe.h"
+#include "view.h"
+#include "window.h"
+
+#include <eq/fabric/statistic.h>
+
+#include <cmath>
+
+namespace eq
+{
+namespace server
+{
+namespace
+{
+// Used for pipes without a configured pixel viewport
+const PixelViewport _defaultPVP( 0, 0, 1920, 1200 );
+
+class SampleCollector : public CompoundVisitor
+{
+public:
+    explicit SampleCollector( Simulator::Samples& samples )
+        : _samples( samples ) {}
+
+    VisitorResult visit( Compound* compound ) override
+    {
+        if( !compound->getChannel() || !compound->isActive() ||
+            !compound->testInheritTask( fabric::TASK_DRAW ) ||
+            !compound->getInheritPixelViewport().hasArea() ||
+            !compound->getInheritRange().hasData( ))
+        {
+            return TRAVERSE_CONTINUE;
+        }
+
+        const Compound* destination = compound;
+        for( const Compound* i = compound->getParent(); i; i = i->getParent())
+            if( i->getChannel( ))
+                destination = i;
+
+        Simulator::Sample sample;
+        sample.compound = compound;
+        sample.destination = destination->getTaskID();
+        sample.vp = compound->getInheritViewport();
+        sample.range = compound->getInheritRange();
+        sample.time = 0.f;
+        _samples.push_back( sample );
+        return TRAVERSE_CONTINUE;
+    }
+
+private:
+    Simulator::Samples& _samples;
+};
+}
+
+Simulator::Simulator( Config& config, const CostFunction& cost )
+    : _config( config )
+    , _cost( cost )
+    , _latency( config.getLatency( ))
+    , _frameNumber( 0 )
+    , _time( 0 )
+{
+    for( Node* node : config.getNodes( ))
+        for( Pipe* pipe : node->getPipes( ))
+            if( !pipe->getPixelViewport().hasArea( ))
+                pipe->setPixelViewport( _defaultPVP );
+
+    // local part of Config::_init
+    for( Compound* compound : config.getCompounds( ))
+        compound->init();
+    for( Observer* observer : config.getObservers( ))
+        observer->init();
+    for( Canvas* canvas : config.getCanvases( ))
+        canvas->init();
+    for( Layout* layout : config.getLayouts( ))
+        for( View* view : layout->getViews( ))
+            view->init();
+
+    // all activated resources are running
+    for( Node* node : config.getNodes( ))
+        for( Pipe* pipe : node->getPipes( ))
+            for( Window* window : pipe->getWindows( ))
+                for( Channel* channel : window->getChannels( ))
+                    if( channel->isActive( ))
+                        channel->setState( STATE_RUNNING );
+
+    _update(); // set up active state for the first equalizer update
+}
+
+Simulator::~Simulator()
+{
+    if( !_netNode )
+        return;
+
+    _config.setState( STATE_STOPPED );
+    for( Node* node : _config.getNodes( ))
+    {
+        if( !node->isRunning( ))
+            continue;
+        node->setState( STATE_STOPPED );
+        node->setNode( 0 );
+    }
+    _config.deregister();
+}
+
+void Simulator::setNetNode( co::NodePtr netNode )
+{
+    LBASSERT( !_netNode );
+    LBASSERT( netNode );
+    LBASSERT( _config.getCurrentFrame() == _frameNumber );
+
+    _netNode = netNode;
+    _config.register_();
+
+    // local part of Config::_startNodes
+    for( Node* node : _config.getNodes( ))
+    {
+        if( !node->isActive( ))
+            continue;
+
+        node->setNode( netNode );
+        node->setState( STATE_RUNNING );
+        for( Pipe* pipe : node->getPipes( ))
+        {
+            if( !pipe->isActive( ))
+                continue;
+
+            pipe->setState( STATE_RUNNING );
+            for( Window* window : pipe->getWindows( ))
+                if( window->isActive( ))
+                    window->setState( STATE_RUNNING );
+        }
+    }
+    _config.setState( STATE_RUNNING );
+}
+
+void Simulator::_update()
+{
+    const uint32_t frameNumber = _frameNumber;
+    _config.updateCompounds( [ frameNumber ]( Compound* compound )
+    {
+        CompoundUpdateActivateVisitor updateActivateVisitor( frameNumber );
+        compound->accept( updateActivateVisitor );
+
+        CompoundUpdateDataVisitor updateDataVisitor( frameNumber );
+        compound->accept( updateDataVisitor );
+    });
+}
+
+const Simulator::Samples& Simulator::runFrame()
+{
+    ++_frameNumber;
+    if( _netNode )
+        _startFrame();
+    else
+        _update();
+
+    _samples.clear();
+    SampleCollector collector( _samples );
+    for( Compound* compound : _config.getCompounds( ))
+        compound->accept( collector );
+
+    // tasks of one channel are rendered sequentially
+    ChannelStatistics statistics;
+    std::map< Channel*, int64_t > channelTimes;
+    int64_t frameTime = 1;
+    for( Sample& sample : _samples )
+    {
+        const float usage = sample.compound->getUsage();
+        sample.time = _cost( sample, _frameNumber );
+        if( usage > 0.f )
+            sample.time /= usage;
+
+        Channel* channel = sample.compound->getChannel();
+        int64_t& channelTime = channelTimes[ channel ];
+
+        Statistic stat = Statistic();
+        stat.type = Statistic::CHANNEL_DRAW;
+        stat.frameNumber = _frameNumber;
+        stat.task = sample.compound->getTaskID();
+        stat.startTime = _time + channelTime;
+        channelTime += std::max( int64_t( std::llround( sample.time )),
+                                 int64_t( 1 ));
+        stat.endTime = _time + channelTime;
+        statistics[ channel ].push_back( stat );
+
+        frameTime = std::max( frameTime, channelTime );
+    }
+    _time += frameTime;
+
+    _pending.push_back( FrameStatistics( _frameNumber, statistics ));
+    if( _frameNumber > _latency )
+        _deliver( _frameNumber - _latency );
+    return _samples;
+}
+
+void Simulator::_startFrame()
+{
+    _config.startFrame( uint128_t( 0, _frameNumber ));
+    LBASSERT( _config.getCurrentFrame() == _frameNumber );
+
+    // there are no render clients, the nodes finish the frame at once
+    for( Node* node : _config.getNodes( ))
+        if( node->isRunning( ))
+            node->finishFrame( _frameNumber );
+}
+
+void Simulator::_deliver( const uint32_t frameNumber )
+{
+    while( !_pending.empty() && _pending.front().first <= frameNumber )
+    {
+        const FrameStatistics& frame = _pending.front();
+        for( const auto& i : frame.second )
+            i.first->fireLoadData( frame.first, i.second, Viewport::FULL );
+        _pending.pop_front();
+    }
+}
+
+}
+}
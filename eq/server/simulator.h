@@ -0,0 +1,106 @@
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQSERVER_SIMULATOR_H
+#define EQSERVER_SIMULATOR_H
+
+#include <eq/server/api.h>
+#include "types.h"
+
+#include <eq/fabric/range.h>    // member
+#include <eq/fabric/viewport.h> // member
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <vector>
+
+namespace eq
+{
+namespace server
+{
+/**
+ * Runs the equalizers of a loaded config without render clients.
+ *
+ * The config is initialized locally, and each simulated frame updates all
+ * compounds and feeds the render times of a cost model back to the
+ * equalizers as channel load data. Used to benchmark and test load balancing
+ * on machines without GPUs.
+ */
+class Simulator
+{
+public:
+    /** A rendering task of a simulated frame. */
+    struct Sample
+    {
+        Compound* compound;
+        uint32_t destination; //!< task ID of the destination compound
+        Viewport vp;          //!< inherit viewport wrt the destination
+        Range range;          //!< inherit database range
+        float time;           //!< simulated render time in ms
+    };
+    typedef std::vector< Sample > Samples;
+
+    /**
+     * The cost model, returning the time in ms to render the sample's area
+     * in the given frame. The time is divided by the compound usage.
+     */
+    typedef std::function< float( const Sample&, uint32_t ) > CostFunction;
+
+    /** Initialize the compounds of the config for simulation. */
+    EQSERVER_API Simulator( Config& config, const CostFunction& cost );
+    EQSERVER_API ~Simulator();
+
+    /** Set the number of frames load data is delivered late. */
+    void setLatency( const uint32_t latency ) { _latency = latency; }
+
+    /**
+     * Start the following frames like the running config does.
+     *
+     * Registers the config with its server, which has to listen, and sets all
+     * active nodes, pipes and windows running. Each frame is started by
+     * Config::_startFrame(), which updates the compounds and sends the tasks
+     * of all nodes to the given network node. The node has to discard them.
+     * All nodes finish each frame as soon as it has been started.
+     */
+    EQSERVER_API void setNetNode( co::NodePtr netNode );
+
+    /** Update the compounds and render the next frame. */
+    EQSERVER_API const Samples& runFrame();
+
+    /** @return the number of the last simulated frame. */
+    uint32_t getFrameNumber() const { return _frameNumber; }
+
+private:
+    typedef std::map< Channel*, Statistics > ChannelStatistics;
+    typedef std::pair< uint32_t, ChannelStatistics > FrameStatistics;
+
+    Config& _config;
+    const CostFunction _cost;
+    uint32_t _latency;
+    uint32_t _frameNumber;
+    int64_t _time;
+    Samples _samples;
+    std::deque< FrameStatistics > _pending;
+    co::NodePtr _netNode;
+
+    void _update();
+    void _startFrame();
+    void _deliver( uint32_t frameNumber );
+};
+}
+}
+#endif // EQSERVER_SIMULATOR_H
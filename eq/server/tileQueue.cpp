@@ -23,16 +23,24 @@
 #include <co/dataOStream.h>
 #include <co/queueItem.h>
 
+#include <algorithm>
+
 namespace eq
 {
 namespace server
 {
+namespace
+{
+static const uint32_t MAX_BATCH = 8; // tiles per request
+static const uint32_t BATCHES_PER_CHANNEL = 4; // minimum requests per channel
+}
 
 TileQueue::TileQueue()
         : co::Object()
         , _compound( 0 )
         , _name()
         , _size( 0, 0 )
+        , _strategy( fabric::Equalizer::TILE_ZIGZAG )
 {
     for( unsigned i = 0; i < NUM_EYES; ++i )
     {
@@ -46,6 +54,7 @@ TileQueue::TileQueue( const TileQueue& from )
         , _compound( 0 )
         , _name( from._name )
         , _size( from._size )
+        , _strategy( from._strategy )
 {
     for( unsigned i = 0; i < NUM_EYES; ++i )
     {
@@ -63,7 +72,101 @@ void TileQueue::addTile( const Tile& tile, const fabric::Eye eye )
 {
     uint32_t index = lunchbox::getIndexOfLastBit(eye);
     LBASSERT( index < NUM_EYES );
-    _queueMaster[index]->_queue.push() << tile;
+    LBASSERT( _queueMaster[index] );
+    _tiles[index].push_back( tile );
+}
+
+void TileQueue::addConsumer( const Node* node )
+{
+    const size_t index = _findConsumer( node );
+    if( index < _consumers.size( ))
+    {
+        ++_consumers[ index ].nChannels;
+        return;
+    }
+
+    Consumer consumer;
+    consumer.node = node;
+    consumer.nChannels = 1;
+    for( unsigned i = 0; i < NUM_EYES; ++i )
+        consumer.nTiles[i] = 0;
+    _consumers.push_back( consumer );
+}
+
+void TileQueue::setNodeWeight( const Node* node, const float weight )
+{
+    _weights[ node ] = weight;
+}
+
+size_t TileQueue::_findConsumer( const Node* node ) const
+{
+    for( size_t i = 0; i < _consumers.size(); ++i )
+        if( _consumers[i].node == node )
+            return i;
+    return _consumers.size();
+}
+
+float TileQueue::_getWeight( const Consumer& consumer ) const
+{
+    std::map< const Node*, float >::const_iterator i =
+        _weights.find( consumer.node );
+    if( i == _weights.end() || i->second <= 0.f )
+        return float( consumer.nChannels );
+    return i->second;
+}
+
+void TileQueue::distributeTiles()
+{
+    if( _consumers.empty( )) // no input queue, serve all tiles from one range
+    {
+        Consumer consumer;
+        consumer.node = 0;
+        consumer.nChannels = 1;
+        for( unsigned i = 0; i < NUM_EYES; ++i )
+            consumer.nTiles[i] = 0;
+        _consumers.push_back( consumer );
+    }
+
+    float totalWeight = 0.f;
+    for( const Consumer& consumer : _consumers )
+        totalWeight += _getWeight( consumer );
+
+    for( unsigned i = 0; i < NUM_EYES; ++i )
+    {
+        LatencyQueue* queue = _queueMaster[i];
+        if( !queue )
+            continue;
+
+        while( queue->_queues.size() < _consumers.size( ))
+        {
+            co::QueueMaster* master = new co::QueueMaster;
+            getLocalNode()->registerObject( master );
+            master->setAutoObsolete( 1 ); // current + in use by render nodes
+            queue->_queues.push_back( master );
+        }
+
+        // contiguous ranges of the strategy order keep neighboring tiles on
+        // one node
+        const std::vector< Tile >& tiles = _tiles[i];
+        float weight = 0.f;
+        size_t begin = 0;
+        for( size_t j = 0; j < _consumers.size(); ++j )
+        {
+            Consumer& consumer = _consumers[j];
+            weight += _getWeight( consumer );
+
+            const size_t end = ( j == _consumers.size() - 1 ) ? tiles.size() :
+                       size_t( float( tiles.size( )) * weight / totalWeight +
+                               .5f );
+            co::QueueMaster* master = queue->_queues[j];
+            for( size_t k = begin; k < end; ++k )
+                master->push() << tiles[k];
+
+            consumer.nTiles[i] = end - begin;
+            begin = end;
+        }
+        _tiles[i].clear();
+    }
 }
 
 void TileQueue::cycleData( const uint32_t frameNumber, const Compound* compound)
@@ -87,17 +190,17 @@ void TileQueue::cycleData( const uint32_t frameNumber, const Compound* compound)
         else // still used - allocate new data
         {
             queue = new LatencyQueue;
-
-            getLocalNode()->registerObject( &queue->_queue );
-            queue->_queue.setAutoObsolete( 1 ); // current + in use by render nodes
         }
 
-        queue->_queue.clear();
+        for( co::QueueMaster* master : queue->_queues )
+            master->clear();
         queue->_frameNumber = frameNumber;
 
         _queues.push_front( queue );
         _queueMaster[i] = queue;
+        _tiles[i].clear();
     }
+    _consumers.clear();
 }
 
 void TileQueue::setOutputQueue( TileQueue* queue, const Compound* compound )
@@ -126,7 +229,11 @@ void TileQueue::flush()
     {
         LatencyQueue* queue = _queues.front();
         _queues.pop_front();
-        getLocalNode()->deregisterObject( &queue->_queue );
+        for( co::QueueMaster* master : queue->_queues )
+        {
+            getLocalNode()->deregisterObject( master );
+            delete master;
+        }
         delete queue;
     }
 
@@ -141,13 +248,54 @@ void TileQueue::unsetData()
     }
 }
 
-uint128_t TileQueue::getQueueMasterID( const Eye eye ) const
+std::vector< uint128_t > TileQueue::getQueueMasterIDs( const Eye eye,
+                                                       const Node* node ) const
 {
-    uint32_t index = lunchbox::getIndexOfLastBit(eye);
-    LatencyQueue* queue = _queueMaster[ index ];
-    if ( queue )
-        return queue->_queue.getID();
-    return uint128_t();
+    std::vector< uint128_t > ids;
+    const uint32_t index = lunchbox::getIndexOfLastBit( eye );
+    const LatencyQueue* queue = _queueMaster[ index ];
+    if( !queue || queue->_queues.size() < _consumers.size( ))
+        return ids;
+
+    // Own range first, then steal from the slowest node, which is most likely
+    // to have tiles left. Equal nodes are visited starting after the own one
+    // to spread the thieves.
+    const size_t own = _findConsumer( node );
+    const size_t nConsumers = _consumers.size();
+    std::vector< std::pair< float, size_t > > victims;
+    for( size_t i = 1; i <= nConsumers; ++i )
+    {
+        const size_t j = ( own + i ) % nConsumers;
+        if( j == own || _consumers[j].nTiles[ index ] == 0 )
+            continue;
+        const Consumer& consumer = _consumers[j];
+        victims.push_back( std::make_pair( _getWeight( consumer ) /
+                                           float( consumer.nChannels ), j ));
+    }
+    std::stable_sort( victims.begin(), victims.end(),
+                      []( const std::pair< float, size_t >& a,
+                          const std::pair< float, size_t >& b )
+                          { return a.first < b.first; });
+
+    if( own < nConsumers )
+        ids.push_back( queue->_queues[ own ]->getID( ));
+    for( const std::pair< float, size_t >& victim : victims )
+        ids.push_back( queue->_queues[ victim.second ]->getID( ));
+    return ids;
+}
+
+uint32_t TileQueue::getBatchSize( const Eye eye, const Node* node ) const
+{
+    const size_t own = _findConsumer( node );
+    if( own >= _consumers.size( ))
+        return 1;
+
+    const Consumer& consumer = _consumers[ own ];
+    const uint32_t index = lunchbox::getIndexOfLastBit( eye );
+    const size_t batch = consumer.nTiles[ index ] /
+                         ( consumer.nChannels * BATCHES_PER_CHANNEL );
+    return uint32_t( std::max( size_t( 1 ),
+                               std::min( batch, size_t( MAX_BATCH ))));
 }
 
 std::ostream& operator << ( std::ostream& os, const TileQueue* tileQueue )
@@ -165,6 +313,11 @@ std::ostream& operator << ( std::ostream& os, const TileQueue* tileQueue )
     if( size != Vector2i::ZERO )
         os << "size      " << size << std::endl;
 
+    const fabric::Equalizer::TileStrategy strategy =
+        tileQueue->getTileStrategy();
+    if( strategy != fabric::Equalizer::TILE_ZIGZAG )
+        os << "strategy  " << strategy << std::endl;
+
     os << lunchbox::exdent << "}" << std::endl << lunchbox::enableFlush;
     return os;
 }
@@ -22,6 +22,8 @@
 #include "compound.h"
 #include "types.h"
 
+#include <eq/fabric/equalizer.h> // enum TileStrategy
+#include <eq/fabric/tile.h> // member
 #include <lunchbox/bitOperation.h> // function getIndexOfLastBit
 #include <co/queueMaster.h>
 
@@ -60,8 +62,35 @@ namespace server
         /** @return the tile size. */
         const Vector2i& getTileSize() const { return _size; }
 
+        /** Set the order in which the tiles are generated. */
+        void setTileStrategy( const fabric::Equalizer::TileStrategy strategy )
+            { _strategy = strategy; }
+
+        /** @return the order in which the tiles are generated. */
+        fabric::Equalizer::TileStrategy getTileStrategy() const
+            { return _strategy; }
+
         /** Add a tile to the queue. */
-        void addTile( const Tile& tile, const Eye eye );
+        EQSERVER_API void addTile( const Tile& tile, const Eye eye );
+
+        /**
+         * Add a channel of the given node consuming the current frame.
+         *
+         * The tiles are partitioned into contiguous ranges, one per node of
+         * all consumers. Each node takes tiles from its own range first.
+         */
+        EQSERVER_API void addConsumer( const Node* node );
+
+        /**
+         * Set the relative tile throughput of a node.
+         *
+         * Used to size the tile range of the node, and to steal first from
+         * the slowest node. Defaults to the number of consuming channels.
+         */
+        EQSERVER_API void setNodeWeight( const Node* node, const float weight );
+
+        /** Partition the added tiles into the queues of all consumers. */
+        EQSERVER_API void distributeTiles();
 
         /**
          * Cycle the current tile queue.
@@ -71,7 +100,8 @@ namespace server
          * @param frameNumber the current frame number.
          * @param compound the compound holding the output frame.
          */
-        void cycleData( const uint32_t frameNumber, const Compound* compound );
+        EQSERVER_API void cycleData( const uint32_t frameNumber,
+                                     const Compound* compound );
 
         void setOutputQueue( TileQueue* queue, const Compound* compound );
         const TileQueue* getOutputQueue( const Eye eye ) const
@@ -85,10 +115,19 @@ namespace server
         void unsetData();
 
         /** Reset the frame and delete all tile datas. */
-        void flush();
+        EQSERVER_API void flush();
         //@}
 
-        uint128_t getQueueMasterID( const Eye eye ) const;
+        /**
+         * @return the identifiers of the tile queues used by the given node,
+         *         its own range first, then the ranges to steal from.
+         */
+        EQSERVER_API std::vector< uint128_t >
+        getQueueMasterIDs( const Eye eye, const Node* node ) const;
+
+        /** @return the number of tiles to take at once from the own range. */
+        EQSERVER_API uint32_t getBatchSize( const Eye eye,
+                                            const Node* node ) const;
 
     protected:
         EQSERVER_API virtual ChangeType getChangeType() const
@@ -101,8 +140,16 @@ namespace server
         struct LatencyQueue
         {
             uint32_t _frameNumber;
-            co::QueueMaster _queue;
+            std::vector< co::QueueMaster* > _queues; // one per tile range
+        };
+
+        struct Consumer
+        {
+            const Node* node;
+            uint32_t nChannels;
+            size_t nTiles[ NUM_EYES ]; // size of the tile range
         };
+        typedef std::vector< Consumer > Consumers;
 
         /** The parent compound. */
         Compound* _compound;
@@ -113,12 +160,27 @@ namespace server
         /** The size of each tile in the queue. */
         Vector2i _size;
 
+        /** The order of the tiles in the queue. */
+        fabric::Equalizer::TileStrategy _strategy;
+
         /** The collage queue pool. */
         std::deque< LatencyQueue* > _queues;
 
         /** the currently used tile queues */
         LatencyQueue* _queueMaster[ NUM_EYES ];
 
+        /** The tiles of the current frame, in strategy order. */
+        std::vector< Tile > _tiles[ NUM_EYES ];
+
+        /** The nodes drawing the tiles of the current frame. */
+        Consumers _consumers;
+
+        /** The tile throughput per node, set by the equalizer. */
+        std::map< const Node*, float > _weights;
+
+        size_t _findConsumer( const Node* node ) const;
+        float _getWeight( const Consumer& consumer ) const;
+
         /** The current output queue. */
         TileQueue* _outputQueue[ NUM_EYES ];
     };
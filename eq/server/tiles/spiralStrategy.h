@@ -42,11 +42,15 @@ namespace tiles
                 for( x = level, y = level+1; y < dimY-level; ++y )
                     tiles.push_back( Vector2i( x, y ));
 
-                for( x = level+1, y = dimY-1-level; x < dimX-1-level; ++x )
-                    tiles.push_back( Vector2i( x, y ));
+                // skip the top row and right column of a degenerate ring,
+                // they are covered by the left column and bottom row
+                if( dimY-1-level > level )
+                    for( x = level+1, y = dimY-1-level; x < dimX-1-level; ++x )
+                        tiles.push_back( Vector2i( x, y ));
 
-                for( x = dimX-1-level, y = dimY-1-level; y > level ; --y )
-                    tiles.push_back( Vector2i( x, y ));
+                if( dimX-1-level > level )
+                    for( x = dimX-1-level, y = dimY-1-level; y > level; --y )
+                        tiles.push_back( Vector2i( x, y ));
 
                 for( x = dimX-1-level, y = level; x > level-1 ; --x )
                     tiles.push_back( Vector2i( x, y ));
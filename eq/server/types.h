@@ -45,6 +45,7 @@ class FrameData;
 class FramerateEqualizer;
 class Layout;
 class LoadEqualizer;
+class LoadRecorder;
 class MonitorEqualizer;
 class Node;
 class NodeFactory;
@@ -599,12 +599,17 @@ void Channel::_drawModel( const Model* scene )
     state.setRange( triply::Range( &getRange().start ));
 
     const eq::Pipe* pipe = getPipe();
+    state.setFrameNumber( pipe->getCurrentFrame( ));
     const GLuint program = state.getProgram( pipe );
     if( program != VertexBufferState::INVALID )
         glUseProgram( program );
 
     scene->cullDraw( state );
 
+    // keep the application redrawing until the drawn leaves are resident
+    if( scene->isPaging( ))
+        getConfig()->sendEvent( MODEL_PAGING );
+
     state.setChannel( 0 );
     if( program != VertexBufferState::INVALID )
         glUseProgram( 0 );
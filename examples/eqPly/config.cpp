@@ -56,7 +56,13 @@ Config::Config( eq::ServerPtr parent )
 Config::~Config()
 {
     for( ModelsCIter i = _models.begin(); i != _models.end(); ++i )
-        delete *i;
+    {
+        const Model* model = *i;
+        if( model->isOutOfCore( ))
+            LBINFO << "Paging of " << model->getName() << ": "
+                   << model->getPagingStats() << std::endl;
+        delete model;
+    }
     _models.clear();
 
     for( ModelDistsCIter i = _modelDist.begin(); i != _modelDist.end(); ++i )
@@ -147,6 +153,8 @@ void Config::_loadModels()
 
             if( _initData.useInvertedFaces() )
                 model->useInvertedFaces();
+            if( _initData.getOutOfCoreBudget() > 0 )
+                model->useOutOfCore( _initData.getOutOfCoreBudget( ));
 
             if( !model->readFromFile( filename.c_str( )))
             {
@@ -329,7 +337,15 @@ bool Config::_needNewFrame()
         return true;
     }
 
-    return ( _spinX != 0 || _spinY != 0 || _advance != 0 || _redraw );
+    if( _spinX != 0 || _spinY != 0 || _advance != 0 || _redraw )
+        return true;
+
+    // redraw until the visible leaves of the local models are paged in,
+    // renderers on other nodes send MODEL_PAGING events
+    for( ModelsCIter i = _models.begin(); i != _models.end(); ++i )
+        if( (*i)->isPaging( ))
+            return true;
+    return false;
 }
 
 bool Config::handleEvent( const eq::ConfigEvent* event )
@@ -493,6 +509,10 @@ bool Config::handleEvent( eq::EventICommand command )
             _numFramesAA = 0;
         return false;
 
+    case MODEL_PAGING:
+        _redraw = true;
+        return true;
+
     default:
         break;
     }
@@ -38,7 +38,8 @@ namespace eqPly
 
 enum ConfigEventType
 {
-    IDLE_AA_LEFT = eq::Event::USER
+    IDLE_AA_LEFT = eq::Event::USER,
+    MODEL_PAGING    // a renderer is waiting for model data
 };
 
 }
@@ -58,6 +58,7 @@ InitData::InitData()
     , _invFaces( false )
     , _logo( true )
     , _roi ( true )
+    , _outOfCoreBudget( 0 )
 {}
 
 InitData::~InitData()
@@ -68,13 +69,13 @@ InitData::~InitData()
 void InitData::getInstanceData( co::DataOStream& os )
 {
     os << _frameDataID << _windowSystem << _renderMode << _useGLSL << _invFaces
-       << _logo << _roi;
+       << _logo << _roi << _outOfCoreBudget;
 }
 
 void InitData::applyInstanceData( co::DataIStream& is )
 {
     is >> _frameDataID >> _windowSystem >> _renderMode >> _useGLSL >> _invFaces
-       >> _logo >> _roi;
+       >> _logo >> _roi >> _outOfCoreBudget;
     LBASSERT( _frameDataID != 0 );
 }
 
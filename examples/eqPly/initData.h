@@ -50,6 +50,7 @@ namespace eqPly
         bool               useInvertedFaces() const { return _invFaces; }
         bool               showLogo() const         { return _logo; }
         bool               useROI() const           { return _roi; }
+        size_t getOutOfCoreBudget() const { return size_t( _outOfCoreBudget ); }
 
     protected:
         virtual void getInstanceData( co::DataOStream& os );
@@ -63,6 +64,8 @@ namespace eqPly
         void enableInvertedFaces() { _invFaces = true; }
         void disableLogo()         { _logo     = false; }
         void disableROI()          { _roi      = false; }
+        void setOutOfCoreBudget( const size_t bytes )
+            { _outOfCoreBudget = bytes; }
 
     private:
         eq::uint128_t      _frameDataID;
@@ -72,6 +75,7 @@ namespace eqPly
         bool               _invFaces;
         bool               _logo;
         bool               _roi;
+        uint64_t           _outOfCoreBudget;
     };
 }
 
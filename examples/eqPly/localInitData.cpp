@@ -71,6 +71,7 @@ LocalInitData& LocalInitData::operator = ( const LocalInitData& from )
         disableLogo();
     if( !from.useROI( ))
         disableROI();
+    setOutOfCoreBudget( from.getOutOfCoreBudget( ));
 
     return *this;
 }
@@ -101,6 +102,7 @@ void LocalInitData::parseArguments( const int argc, char** argv )
     bool userDefinedInvertFaces( false );
     bool userDefinedDisableLogo( false );
     bool userDefinedDisableROI( false );
+    size_t userDefinedOutOfCore( 0 );
 
     const std::string& desc = EqPly::getHelp();
     po::options_description options( desc + " Version " +
@@ -136,7 +138,10 @@ void LocalInitData::parseArguments( const int argc, char** argv )
           "Disable overlay logo" )
         ( "disableROI,d",
           po::bool_switch(&userDefinedDisableROI)->default_value( false ),
-          "Disable region of interest (ROI)" );
+          "Disable region of interest (ROI)" )
+        ( "outOfCore,k", po::value<size_t>( &userDefinedOutOfCore ),
+          "Page model data on demand, using the given host and GPU memory "
+          "in MB" );
 
     po::variables_map variableMap;
 
@@ -202,6 +207,9 @@ void LocalInitData::parseArguments( const int argc, char** argv )
 
     if( userDefinedDisableROI )
         disableROI();
+
+    if( userDefinedOutOfCore > 0 )
+        setOutOfCoreBudget( userDefinedOutOfCore * 1024 * 1024 );
 }
 
 }
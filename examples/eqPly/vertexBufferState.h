@@ -61,8 +61,14 @@ public:
     GLuint newBufferObject( const void* key ) override
         { return _objectManager.newBuffer( key ); }
 
+    void deleteDisplayList( const void* key ) override
+        { _objectManager.deleteList( key ); }
+
+    void deleteBufferObject( const void* key ) override
+        { _objectManager.deleteBuffer( key ); }
+
     void deleteAll()  override
-        { _objectManager.deleteAll(); }
+        { _objectManager.deleteAll(); resetObjects(); }
 
     GLuint getProgram( const void* key )
         { return _objectManager.getProgram( key ); }
@@ -86,6 +86,7 @@ bool Window::configInitGL( const eq::uint128_t& initID )
 
     const Config*   config   = static_cast< const Config* >( getConfig( ));
     const InitData& initData = config->getInitData();
+    _state->setObjectBudget( initData.getOutOfCoreBudget( ));
 
     if( initData.showLogo( ))
         _loadLogo();
@@ -98,6 +99,9 @@ bool Window::configInitGL( const eq::uint128_t& initID )
 
 bool Window::configExitGL()
 {
+    if( _state && _state->getObjectStats().loads > 0 )
+        LBINFO << "GL objects of " << getName() << ": "
+               << _state->getObjectStats() << std::endl;
     if( _state && !_state->isShared( ))
         _state->deleteAll();
 
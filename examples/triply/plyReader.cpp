@@ -0,0 +1,682 @@
+
+/* Copyright (c) 2016, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of Eyescale Software GmbH nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "plyReader.h"
+#include "vertexData.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+using namespace triply;
+
+namespace
+{
+// size of the chunks of ascii data decoded by one thread
+const size_t ASCII_CHUNK_SIZE = 4 * 1024 * 1024;
+
+bool _isLittleEndian()
+{
+    unsigned char test[2] = { 1, 0 };
+    short x;
+    memcpy( &x, test, sizeof( x ));
+    return x == 1;
+}
+
+template< class T > T _get( const char* ptr )
+{
+    T value;
+    memcpy( &value, ptr, sizeof( T )); // binary data is not aligned
+    return value;
+}
+
+/*  Splits one line of ascii data into numbers.  */
+class Tokenizer
+{
+public:
+    Tokenizer( const char* begin, const char* end )
+        : _ptr( begin ), _end( end ) {}
+
+    bool skip()
+    {
+        const char* token;
+        return _next( token ) > 0;
+    }
+
+    bool read( double& value )
+    {
+        const char* token;
+        const size_t length = _next( token );
+        char buffer[64];
+        if( length == 0 || length >= sizeof( buffer ))
+            return false;
+
+        // the mapped data is not null-terminated
+        memcpy( buffer, token, length );
+        buffer[ length ] = 0;
+        char* last;
+        value = strtod( buffer, &last );
+        return last == buffer + length;
+    }
+
+    bool read( int64_t& value )
+    {
+        const char* token;
+        const size_t length = _next( token );
+        if( length == 0 )
+            return false;
+
+        const char* const end = token + length;
+        const bool negative = ( *token == '-' );
+        if( *token == '-' || *token == '+' )
+            ++token;
+        if( token == end )
+            return false;
+
+        value = 0;
+        for( ; token < end; ++token )
+        {
+            if( *token < '0' || *token > '9' )
+                return false;
+            value = value * 10 + ( *token - '0' );
+        }
+        if( negative )
+            value = -value;
+        return true;
+    }
+
+private:
+    const char* _ptr;
+    const char* const _end;
+
+    size_t _next( const char*& token )
+    {
+        while( _ptr < _end && isspace( static_cast< unsigned char >( *_ptr )))
+            ++_ptr;
+        token = _ptr;
+        while( _ptr < _end && !isspace( static_cast< unsigned char >( *_ptr )))
+            ++_ptr;
+        return _ptr - token;
+    }
+};
+
+/*  Count the lines starting in the given data.  */
+size_t _countLines( const char* begin, const char* end )
+{
+    if( begin == end )
+        return 0;
+
+    size_t nLines = std::count( begin, end, '\n' );
+    if( *( end - 1 ) != '\n' ) // last line without newline
+        ++nLines;
+    return nLines;
+}
+}
+
+
+/*  Map the file and determine the element layout.  */
+PlyReader::PlyReader( const std::string& filename )
+    : _data( 0 )
+    , _size( 0 )
+    , _ascii( false )
+    , _supported( false )
+    , _vertex( 0 )
+    , _face( 0 )
+    , _indices( 0 )
+{
+    for( size_t i = 0; i < 3; ++i )
+    {
+        _position[i] = 0;
+        _color[i] = 0;
+    }
+
+    if( !_file.map( filename ))
+        return;
+
+    _supported = _parseHeader() && _setupLayout();
+}
+
+
+/*  Read the header lines up to end_header.  */
+bool PlyReader::_parseHeader()
+{
+    const char* ptr = _file.getAddress< char >();
+    const char* const end = ptr + _file.getSize();
+    bool hasMagic = false;
+    bool hasFormat = false;
+
+    while( ptr < end )
+    {
+        const char* eol = static_cast< const char* >(
+            memchr( ptr, '\n', end - ptr ));
+        if( !eol )
+            return false;
+
+        std::string line( ptr, eol );
+        ptr = eol + 1;
+        if( !line.empty() && line[ line.length() - 1 ] == '\r' )
+            line.erase( line.length() - 1 );
+
+        std::istringstream stream( line );
+        std::string keyword;
+        stream >> keyword;
+
+        if( !hasMagic )
+        {
+            if( keyword != "ply" )
+                return false;
+            hasMagic = true;
+        }
+        else if( keyword == "format" )
+        {
+            std::string format;
+            stream >> format;
+            if( format == "ascii" )
+                _ascii = true;
+            else if( format != "binary_little_endian" || !_isLittleEndian( ))
+                return false;
+            hasFormat = true;
+        }
+        else if( keyword == "element" )
+        {
+            Element element;
+            element.count = 0;
+            element.size = 0;
+            element.start = 0;
+            stream >> element.name >> element.count;
+            if( !stream )
+                return false;
+            _elements.push_back( element );
+        }
+        else if( keyword == "property" )
+        {
+            if( _elements.empty( ))
+                return false;
+
+            Property property;
+            property.countType = TYPE_NONE;
+            property.offset = 0;
+
+            std::string type;
+            stream >> type;
+            if( type == "list" )
+            {
+                std::string countType;
+                stream >> countType >> type;
+                property.countType = _getType( countType );
+                if( property.countType == TYPE_NONE ||
+                    property.countType >= TYPE_FLOAT32 )
+                {
+                    return false;
+                }
+            }
+            property.type = _getType( type );
+            stream >> property.name;
+            if( !stream || property.type == TYPE_NONE )
+                return false;
+
+            _elements.back().properties.push_back( property );
+        }
+        else if( keyword == "end_header" )
+        {
+            _data = ptr;
+            _size = end - ptr;
+            return hasFormat;
+        }
+        // comment and obj_info lines are ignored
+    }
+    return false;
+}
+
+
+/*  Find the vertex and face properties, reject layouts needing plyfile.  */
+bool PlyReader::_setupLayout()
+{
+    for( size_t i = 0; i < _elements.size(); ++i )
+    {
+        if( _elements[i].name == "vertex" )
+            _vertex = &_elements[i];
+        else if( _elements[i].name == "face" )
+            _face = &_elements[i];
+    }
+    if( !_vertex || !_face )
+        return false;
+
+    static const char* const positionNames[] = { "x", "y", "z" };
+    static const char* const colorNames[] = { "red", "green", "blue" };
+    for( size_t i = 0; i < _vertex->properties.size(); ++i )
+    {
+        const Property& property = _vertex->properties[i];
+        for( size_t j = 0; j < 3; ++j )
+        {
+            if( property.name == positionNames[j] )
+                _position[j] = &property;
+            else if( property.name == colorNames[j] )
+                _color[j] = &property;
+        }
+    }
+
+    for( size_t i = 0; i < 3; ++i )
+    {
+        if( !_position[i] || _position[i]->countType != TYPE_NONE )
+            return false;
+        // colors are read if all three components are available
+        if( bool( _color[i] ) != bool( _color[0] ) ||
+            ( _color[i] && _color[i]->countType != TYPE_NONE ))
+        {
+            return false;
+        }
+    }
+
+    for( size_t i = 0; i < _face->properties.size(); ++i )
+    {
+        const Property& property = _face->properties[i];
+        if( property.countType == TYPE_NONE )
+            continue;
+        if( _indices || property.type >= TYPE_FLOAT32 ||
+            ( property.name != "vertex_indices" &&
+              property.name != "vertex_index" ))
+        {
+            return false;
+        }
+        _indices = &property;
+    }
+    if( !_indices )
+        return false;
+
+    if( !_ascii )
+        return _setupBinaryOffsets();
+
+    // each ascii element is stored on one line
+    size_t start = 0;
+    for( size_t i = 0; i < _elements.size(); ++i )
+    {
+        _elements[i].start = start;
+        start += _elements[i].count;
+    }
+    return true;
+}
+
+
+/*  Compute the byte offsets of the elements and properties.
+
+    Faces are assumed to be triangles, which makes them fixed-size. The
+    assumption is verified while decoding.
+*/
+bool PlyReader::_setupBinaryOffsets()
+{
+    size_t start = 0;
+    size_t nFound = 0;
+    for( size_t i = 0; i < _elements.size() && nFound < 2; ++i )
+    {
+        Element& element = _elements[i];
+        element.start = start;
+        element.size = 0;
+
+        for( size_t j = 0; j < element.properties.size(); ++j )
+        {
+            Property& property = element.properties[j];
+            property.offset = element.size;
+
+            if( property.countType == TYPE_NONE )
+                element.size += _getSize( property.type );
+            else if( &property == _indices )
+                element.size += _getSize( property.countType ) +
+                                3 * _getSize( property.type );
+            else // variable size, the following elements can't be located
+                return false;
+        }
+
+        start += element.size * element.count;
+        if( &element == _vertex || &element == _face )
+            ++nFound;
+    }
+    return start <= _size;
+}
+
+
+/*  Decode the vertex, color and triangle data.  */
+bool PlyReader::read( VertexData& data, const bool invertFaces ) const
+{
+    if( !_supported )
+        return false;
+
+    data.vertices.clear();
+    data.vertices.resize( _vertex->count );
+    if( _color[0] )
+    {
+        data.colors.clear();
+        data.colors.resize( _vertex->count );
+    }
+    data.triangles.clear();
+    data.triangles.resize( _face->count );
+
+    return _ascii ? _readAscii( data, invertFaces ) :
+                    _readBinary( data, invertFaces );
+}
+
+
+bool PlyReader::_readBinary( VertexData& data, const bool invertFaces ) const
+{
+    const char* const vertices = _data + _vertex->start;
+    const bool hasColors = _color[0] != 0;
+
+#pragma omp parallel for
+    for( ssize_t i = 0; i < ssize_t( _vertex->count ); ++i )
+    {
+        const char* const element = vertices + i * _vertex->size;
+        Vertex& vertex = data.vertices[i];
+        for( size_t j = 0; j < 3; ++j )
+            vertex[j] = float( _getValue( element + _position[j]->offset,
+                                          _position[j]->type ));
+        if( !hasColors )
+            continue;
+
+        Color& color = data.colors[i];
+        for( size_t j = 0; j < 3; ++j )
+            color[j] = uint8_t( _getInteger( element + _color[j]->offset,
+                                             _color[j]->type ));
+    }
+
+    const char* const faces = _data + _face->start + _indices->offset;
+    const Type countType = _indices->countType;
+    const Type indexType = _indices->type;
+    const size_t indexSize = _getSize( indexType );
+    const size_t countSize = _getSize( countType );
+    const size_t ind1 = invertFaces ? 2 : 0;
+    const size_t ind3 = invertFaces ? 0 : 2;
+    size_t nPolygons = 0;
+
+#pragma omp parallel for reduction( +: nPolygons )
+    for( ssize_t i = 0; i < ssize_t( _face->count ); ++i )
+    {
+        const char* const element = faces + i * _face->size;
+        if( _getInteger( element, countType ) != 3 )
+        {
+            ++nPolygons;
+            continue;
+        }
+
+        const char* const indices = element + countSize;
+        data.triangles[i] = Triangle(
+            Index( _getInteger( indices + ind1 * indexSize, indexType )),
+            Index( _getInteger( indices + indexSize, indexType )),
+            Index( _getInteger( indices + ind3 * indexSize, indexType )));
+    }
+
+    if( nPolygons > 0 )
+        throw MeshException( "Error reading PLY file. Encountered a "
+                             "face which does not have three vertices." );
+    return true;
+}
+
+
+/*  Decode ascii data in chunks of whole lines. The lines of each chunk are
+    counted first, which yields the element index of the first line of every
+    chunk for the parallel decoding.  */
+bool PlyReader::_readAscii( VertexData& data, const bool invertFaces ) const
+{
+    const char* const end = _data + _size;
+    std::vector< const char* > chunks( 1, _data );
+    while( chunks.back() < end )
+    {
+        const char* const begin = chunks.back();
+        const char* next = begin + std::min( ASCII_CHUNK_SIZE,
+                                             size_t( end - begin ));
+        next = static_cast< const char* >( memchr( next, '\n', end - next ));
+        chunks.push_back( next ? next + 1 : end );
+    }
+    const ssize_t nChunks = ssize_t( chunks.size( )) - 1;
+
+    std::vector< size_t > firstLines( chunks.size(), 0 );
+#pragma omp parallel for
+    for( ssize_t i = 0; i < nChunks; ++i )
+        firstLines[ i + 1 ] = _countLines( chunks[i], chunks[ i + 1 ] );
+    for( size_t i = 1; i < firstLines.size(); ++i )
+        firstLines[i] += firstLines[ i - 1 ];
+
+    if( firstLines.back() < _vertex->start + _vertex->count ||
+        firstLines.back() < _face->start + _face->count )
+    {
+        return false;
+    }
+
+    const bool hasColors = _color[0] != 0;
+    size_t nInvalid = 0;
+    size_t nPolygons = 0;
+
+#pragma omp parallel for schedule( dynamic ) reduction( +: nInvalid, nPolygons )
+    for( ssize_t i = 0; i < nChunks; ++i )
+    {
+        const char* const chunkEnd = chunks[ i + 1 ];
+        size_t line = firstLines[i];
+        for( const char* ptr = chunks[i]; ptr < chunkEnd; ++line )
+        {
+            const char* eol = static_cast< const char* >(
+                memchr( ptr, '\n', chunkEnd - ptr ));
+            if( !eol )
+                eol = chunkEnd;
+
+            // unsigned wrap-around excludes lines before the element
+            const size_t vertex = line - _vertex->start;
+            const size_t face = line - _face->start;
+            if( vertex < _vertex->count )
+            {
+                Color* color = hasColors ? &data.colors[ vertex ] : 0;
+                if( !_parseVertex( ptr, eol, data.vertices[ vertex ], color ))
+                    ++nInvalid;
+            }
+            else if( face < _face->count )
+            {
+                const size_t nIndices = _parseFace( ptr, eol,
+                                                    data.triangles[ face ],
+                                                    invertFaces );
+                if( nIndices == 0 )
+                    ++nInvalid;
+                else if( nIndices != 3 )
+                    ++nPolygons;
+            }
+
+            ptr = ( eol < chunkEnd ) ? eol + 1 : chunkEnd;
+        }
+    }
+
+    if( nPolygons > 0 )
+        throw MeshException( "Error reading PLY file. Encountered a "
+                             "face which does not have three vertices." );
+    return nInvalid == 0;
+}
+
+
+/*  Parse one line of vertex data, returns false on malformed data.  */
+bool PlyReader::_parseVertex( const char* begin, const char* end,
+                              Vertex& vertex, Color* color ) const
+{
+    Tokenizer tokenizer( begin, end );
+    for( size_t i = 0; i < _vertex->properties.size(); ++i )
+    {
+        const Property* property = &_vertex->properties[i];
+        double value = 0.;
+
+        if( property->countType != TYPE_NONE )
+        {
+            int64_t count = 0;
+            if( !tokenizer.read( count ) || count < 0 )
+                return false;
+            for( int64_t j = 0; j < count; ++j )
+                if( !tokenizer.skip( ))
+                    return false;
+            continue;
+        }
+
+        if( !tokenizer.read( value ))
+            return false;
+
+        for( size_t j = 0; j < 3; ++j )
+        {
+            if( property == _position[j] )
+                vertex[j] = float( value );
+            else if( color && property == _color[j] )
+                (*color)[j] = uint8_t( int64_t( value ));
+        }
+    }
+    return true;
+}
+
+
+/*  Parse one line of face data, returns the number of face vertices or 0 on
+    malformed data.  */
+size_t PlyReader::_parseFace( const char* begin, const char* end,
+                              Triangle& triangle, const bool invertFaces ) const
+{
+    Tokenizer tokenizer( begin, end );
+    size_t nIndices = 0;
+    for( size_t i = 0; i < _face->properties.size(); ++i )
+    {
+        const Property* property = &_face->properties[i];
+        if( property->countType == TYPE_NONE )
+        {
+            if( !tokenizer.skip( ))
+                return 0;
+            continue;
+        }
+
+        int64_t count = 0;
+        if( !tokenizer.read( count ) || count < 0 )
+            return 0;
+        if( property != _indices )
+        {
+            for( int64_t j = 0; j < count; ++j )
+                if( !tokenizer.skip( ))
+                    return 0;
+            continue;
+        }
+
+        nIndices = size_t( count );
+        if( nIndices != 3 )
+            return nIndices;
+
+        int64_t indices[3];
+        for( size_t j = 0; j < 3; ++j )
+            if( !tokenizer.read( indices[j] ))
+                return 0;
+
+        triangle = Triangle( Index( indices[ invertFaces ? 2 : 0 ] ),
+                             Index( indices[1] ),
+                             Index( indices[ invertFaces ? 0 : 2 ] ));
+    }
+    return nIndices;
+}
+
+
+PlyReader::Type PlyReader::_getType( const std::string& name )
+{
+    if( name == "char" || name == "int8" )
+        return TYPE_INT8;
+    if( name == "uchar" || name == "uint8" )
+        return TYPE_UINT8;
+    if( name == "short" || name == "int16" )
+        return TYPE_INT16;
+    if( name == "ushort" || name == "uint16" )
+        return TYPE_UINT16;
+    if( name == "int" || name == "int32" )
+        return TYPE_INT32;
+    if( name == "uint" || name == "uint32" )
+        return TYPE_UINT32;
+    if( name == "float" || name == "float32" )
+        return TYPE_FLOAT32;
+    if( name == "double" || name == "float64" )
+        return TYPE_FLOAT64;
+    return TYPE_NONE;
+}
+
+
+size_t PlyReader::_getSize( const Type type )
+{
+    switch( type )
+    {
+    case TYPE_INT8:
+    case TYPE_UINT8:
+        return 1;
+    case TYPE_INT16:
+    case TYPE_UINT16:
+        return 2;
+    case TYPE_INT32:
+    case TYPE_UINT32:
+    case TYPE_FLOAT32:
+        return 4;
+    case TYPE_FLOAT64:
+        return 8;
+    case TYPE_NONE:
+    default:
+        return 0;
+    }
+}
+
+
+double PlyReader::_getValue( const char* ptr, const Type type )
+{
+    switch( type )
+    {
+    case TYPE_FLOAT32:
+        return _get< float >( ptr );
+    case TYPE_FLOAT64:
+        return _get< double >( ptr );
+    default:
+        return double( _getInteger( ptr, type ));
+    }
+}
+
+
+int64_t PlyReader::_getInteger( const char* ptr, const Type type )
+{
+    switch( type )
+    {
+    case TYPE_INT8:
+        return _get< int8_t >( ptr );
+    case TYPE_UINT8:
+        return _get< uint8_t >( ptr );
+    case TYPE_INT16:
+        return _get< int16_t >( ptr );
+    case TYPE_UINT16:
+        return _get< uint16_t >( ptr );
+    case TYPE_INT32:
+        return _get< int32_t >( ptr );
+    case TYPE_UINT32:
+        return _get< uint32_t >( ptr );
+    case TYPE_FLOAT32:
+        return int64_t( _get< float >( ptr ));
+    case TYPE_FLOAT64:
+        return int64_t( _get< double >( ptr ));
+    case TYPE_NONE:
+    default:
+        return 0;
+    }
+}
@@ -0,0 +1,123 @@
+
+/* Copyright (c) 2016, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of Eyescale Software GmbH nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef PLYLIB_PLYREADER_H
+#define PLYLIB_PLYREADER_H
+
+#include "typedefs.h"
+#include <lunchbox/memoryMap.h>
+#include <vector>
+
+namespace triply
+{
+    /*  Reads ascii and binary little endian PLY files from a memory mapped
+        file. The element layout is taken from the header, and the vertex and
+        face data is decoded in parallel chunks straight into the VertexData.
+        Files which can't be decoded this way are left to the plyfile parser.
+    */
+    class PlyReader
+    {
+    public:
+        explicit PlyReader( const std::string& filename );
+
+        /*  @return true if the file layout is supported by this reader.  */
+        bool isSupported() const { return _supported; }
+
+        /*  Decode the vertex, color and triangle data of the file.
+
+            Returns false if the data does not match the header, in which case
+            the file should be read using the plyfile parser. Throws a
+            MeshException if a face is not a triangle.
+        */
+        bool read( VertexData& data, bool invertFaces ) const;
+
+    private:
+        enum Type
+        {
+            TYPE_NONE,
+            TYPE_INT8,
+            TYPE_UINT8,
+            TYPE_INT16,
+            TYPE_UINT16,
+            TYPE_INT32,
+            TYPE_UINT32,
+            TYPE_FLOAT32,
+            TYPE_FLOAT64
+        };
+
+        struct Property
+        {
+            std::string name;
+            Type        type;       // value type, index type for lists
+            Type        countType;  // TYPE_NONE for scalar properties
+            size_t      offset;     // byte offset in a binary element
+        };
+
+        struct Element
+        {
+            std::string             name;
+            size_t                  count;
+            size_t                  size;   // binary bytes per element
+            size_t                  start;  // first byte or line of the data
+            std::vector< Property > properties;
+        };
+
+        lunchbox::MemoryMap     _file;
+        const char*             _data;  // first byte after the header
+        size_t                  _size;  // bytes after the header
+        bool                    _ascii;
+        bool                    _supported;
+        std::vector< Element >  _elements;
+
+        const Element*  _vertex;
+        const Element*  _face;
+        const Property* _position[3];
+        const Property* _color[3];
+        const Property* _indices;
+
+        bool _parseHeader();
+        bool _setupLayout();
+        bool _setupBinaryOffsets();
+
+        bool _readBinary( VertexData& data, bool invertFaces ) const;
+        bool _readAscii( VertexData& data, bool invertFaces ) const;
+        bool _parseVertex( const char* begin, const char* end,
+                           Vertex& vertex, Color* color ) const;
+        size_t _parseFace( const char* begin, const char* end,
+                           Triangle& triangle, bool invertFaces ) const;
+
+        static Type _getType( const std::string& name );
+        static size_t _getSize( Type type );
+        static double _getValue( const char* ptr, Type type );
+        static int64_t _getInteger( const char* ptr, Type type );
+    };
+}
+
+
+#endif // PLYLIB_PLYREADER_H
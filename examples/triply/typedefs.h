@@ -73,7 +73,9 @@ namespace triply
 // class forward declarations
 class VertexBufferBase;
 class VertexBufferData;
+class VertexBufferLeaf;
 class VertexBufferNode;
+class VertexBufferPager;
 class VertexBufferRoot;
 class VertexBufferState;
 class VertexData;
@@ -133,7 +135,7 @@ typedef ArrayWrapper< float, 2 >    Range;
 const Index             LEAF_SIZE( 21845 );
 
 // binary mesh file version, increment if changing the file format
-const unsigned short    FILE_VERSION( 0x0118 );
+const unsigned short    FILE_VERSION( 0x0201 );
 
 // enumeration for the sort axis
 enum Axis
@@ -182,6 +184,30 @@ enum NodeType
     LEAF_TYPE = 0xef
 };
 
+// counters of the on-demand paging of leaf data
+struct PagingStats
+{
+    PagingStats() : hits( 0 ), misses( 0 ), loads( 0 ), evictions( 0 )
+                  , bytes( 0 ), latency( 0.f ) {}
+
+    size_t hits;      // leaves which were resident when drawn
+    size_t misses;    // leaves which were not resident when drawn
+    size_t loads;     // leaves made resident
+    size_t evictions; // leaves released to stay within the memory budget
+    size_t bytes;     // memory used by the resident leaves
+    float  latency;   // summed time from the first miss to resident, in ms
+};
+inline std::ostream& operator << ( std::ostream& os, const PagingStats& stats )
+{
+    os << stats.hits << " hits, " << stats.misses << " misses, " << stats.loads
+       << " loads, " << stats.evictions << " evictions, " << stats.bytes
+       << " bytes resident";
+    if( stats.latency > 0.f )
+        os << ", " << stats.latency / float( stats.loads )
+           << " ms average latency";
+    return os;
+}
+
 // helper function for MMF (memory mapped file) reading
 inline void memRead( char* destination, char** source, size_t length )
 {
@@ -33,6 +33,7 @@
 
 #include <triply/api.h>
 #include "typedefs.h"
+#include "vertexBufferCache.h"
 #include <fstream>
 
 namespace eqPly
@@ -71,19 +72,26 @@ protected:
             _range[1] = 1.0f;
         }
 
-    virtual void toStream( std::ostream& os )
+    virtual void toStream( std::ostream& os ) = 0;
+    virtual void fromMemory( char** addr, VertexBufferData& globalData ) = 0;
+
+    /*  Copy the common node data into a cache record.  */
+    void toCache( cache::Node& node ) const
         {
-            os.write( reinterpret_cast< char* >( &_boundingSphere ),
-                      sizeof( BoundingSphere ) );
-            os.write( reinterpret_cast< char* >( &_range ), sizeof( Range ) );
+            memset( &node, 0, sizeof( node ));
+            for( size_t i = 0; i < 4; ++i )
+                node.boundingSphere[i] = _boundingSphere[i];
+            node.range[0] = _range[0];
+            node.range[1] = _range[1];
         }
 
-    virtual void fromMemory( char** addr, VertexBufferData& /*globalData*/ )
+    /*  Copy the common node data from a cache record.  */
+    void fromCache( const cache::Node& node )
         {
-            memRead( reinterpret_cast< char* >( &_boundingSphere ), addr,
-                     sizeof( BoundingSphere ) );
-            memRead( reinterpret_cast< char* >( &_range ), addr,
-                     sizeof( Range ) );
+            for( size_t i = 0; i < 4; ++i )
+                _boundingSphere[i] = node.boundingSphere[i];
+            _range[0] = node.range[0];
+            _range[1] = node.range[1];
         }
 
     virtual void setupTree( VertexData& data, const Index start,
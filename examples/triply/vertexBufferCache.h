@@ -0,0 +1,184 @@
+
+/* Copyright (c) 2016, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of Eyescale Software GmbH nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef PLYLIB_VERTEXBUFFERCACHE_H
+#define PLYLIB_VERTEXBUFFERCACHE_H
+
+#include "typedefs.h"
+#include <cmath>
+
+/*  Layout of the binary model cache.
+
+    The cache starts with a Header, followed by sections aligned to
+    ALIGNMENT bytes: the kd-tree nodes in depth-first order, the quantized
+    positions, the encoded normals, the colors (if any) and the indices. All
+    fields have a fixed size, the byte order of the writer is recorded in the
+    header. Positions are stored as three 16 bit values relative to the
+    bounding box of their leaf, normals as two 16 bit octahedral coordinates.
+    The header checksum covers the header and the nodes, each leaf node holds
+    the checksum of its data, which is verified when the leaf is read.
+*/
+namespace triply
+{
+namespace cache
+{
+    const char     MAGIC[8] = { 'T', 'R', 'I', 'P', 'L', 'Y', 0, 0 };
+    const uint32_t ENDIANNESS = 0x01020304;
+    const uint64_t ALIGNMENT = 64;
+    const uint32_t FLAG_COLORS = 0x1;
+
+    struct Header
+    {
+        char     magic[8];
+        uint32_t version;       // FILE_VERSION
+        uint32_t endianness;    // ENDIANNESS in the byte order of the writer
+        uint32_t flags;
+        uint32_t nodeSize;      // sizeof( Node )
+        uint64_t nNodes;
+        uint64_t nVertices;
+        uint64_t nIndices;
+        uint64_t nodes;         // section offsets from the start of the file
+        uint64_t positions;
+        uint64_t normals;
+        uint64_t colors;
+        uint64_t indices;
+        uint64_t size;          // total file size
+        uint64_t checksum;      // of the header and the nodes section
+    };
+
+    struct Node
+    {
+        uint32_t type;          // NodeType
+        uint32_t vertexLength;  // leaf only
+        float    boundingSphere[4];
+        float    range[2];
+        float    boundingBox[6]; // leaf only, min and max
+        uint64_t vertexStart;   // leaf only
+        uint64_t indexStart;    // leaf only
+        uint64_t indexLength;   // leaf only
+        uint64_t checksum;      // leaf only, see leafChecksum()
+    };
+
+    typedef vmml::vector< 3, uint16_t > Position;
+    typedef vmml::vector< 2, int16_t >  Normal;
+
+    /*  @return the type of the node record at the given address.  */
+    inline uint32_t peekType( const char* addr )
+    {
+        uint32_t type;
+        memcpy( &type, addr, sizeof( type ));
+        return type;
+    }
+
+    /*  @return the given offset rounded up to the section alignment.  */
+    inline uint64_t align( const uint64_t offset )
+    {
+        return ( offset + ALIGNMENT - 1 ) / ALIGNMENT * ALIGNMENT;
+    }
+
+    /*  @return the FNV-1a hash of the given data, continuing from hash.  */
+    inline uint64_t checksum( const void* data, const size_t size,
+                              uint64_t hash = 0xcbf29ce484222325ull )
+    {
+        const uint8_t* bytes = static_cast< const uint8_t* >( data );
+        for( size_t i = 0; i < size; ++i )
+        {
+            hash ^= bytes[i];
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    /*  @return the checksum of the data of a leaf, colors may be 0.  */
+    inline uint64_t leafChecksum( const Position* positions,
+                                  const Normal* normals, const Color* colors,
+                                  const size_t nVertices,
+                                  const ShortIndex* indices,
+                                  const size_t nIndices )
+    {
+        uint64_t hash = checksum( positions, nVertices * sizeof( Position ));
+        hash = checksum( normals, nVertices * sizeof( Normal ), hash );
+        if( colors )
+            hash = checksum( colors, nVertices * sizeof( Color ), hash );
+        return checksum( indices, nIndices * sizeof( ShortIndex ), hash );
+    }
+
+    inline float sign( const float value ) { return value < 0.f ? -1.f : 1.f; }
+
+    /*  Encode a unit normal with an octahedral projection.  */
+    inline Normal encodeNormal( const triply::Normal& normal )
+    {
+        const float length = std::abs( normal[0] ) + std::abs( normal[1] ) +
+                             std::abs( normal[2] );
+        if( length == 0.f )
+            return Normal( 0, 0 );
+
+        float u = normal[0] / length;
+        float v = normal[1] / length;
+        if( normal[2] < 0.f ) // fold the lower hemisphere
+        {
+            const float foldedU = ( 1.f - std::abs( v )) * sign( u );
+            v = ( 1.f - std::abs( u )) * sign( v );
+            u = foldedU;
+        }
+        return Normal( int16_t( std::floor( u * 32767.f + .5f )),
+                       int16_t( std::floor( v * 32767.f + .5f )));
+    }
+
+    inline triply::Normal decodeNormal( const Normal& encoded )
+    {
+        float u = float( encoded[0] ) / 32767.f;
+        float v = float( encoded[1] ) / 32767.f;
+        const float z = 1.f - std::abs( u ) - std::abs( v );
+        if( z < 0.f )
+        {
+            const float unfoldedU = ( 1.f - std::abs( v )) * sign( u );
+            v = ( 1.f - std::abs( u )) * sign( v );
+            u = unfoldedU;
+        }
+        triply::Normal normal( u, v, z );
+        normal.normalize();
+        return normal;
+    }
+
+    /*  Decode the quantized positions of a leaf with the given bbox.  */
+    inline void decodePositions( const Position* positions, const size_t count,
+                                 const BoundingBox& box, Vertex* vertices )
+    {
+        const Vertex scale = ( box[1] - box[0] ) / 65535.f;
+        for( size_t i = 0; i < count; ++i )
+            for( size_t j = 0; j < 3; ++j )
+                vertices[i][j] = box[0][j] +
+                                 float( positions[i][j] ) * scale[j];
+    }
+}
+}
+
+
+#endif // PLYLIB_VERTEXBUFFERCACHE_H
@@ -30,17 +30,77 @@
 #include "vertexBufferDist.h"
 
 #include "vertexBufferLeaf.h"
+#include "vertexBufferPager.h"
 #include "vertexBufferRoot.h"
 
+#include <unordered_map>
+
 namespace triply
 {
 
+/*  Fetches the data of leaves by mapping their objects from the master.  */
+class VertexBufferDist::LeafSource : public VertexBufferPager::Source
+{
+public:
+    LeafSource( co::LocalNodePtr localNode, co::NodePtr master,
+                const bool colors )
+        : _localNode( localNode ), _master( master ), _colors( colors ) {}
+
+    /*  Register the object of a leaf, called while the tree is mapped.  */
+    void add( const VertexBufferLeaf* leaf, const eq::uint128_t& id )
+        { _ids[ leaf ] = id; }
+
+    VertexBufferPager::Datas load(
+        const VertexBufferPager::Leaves& leaves ) override
+    {
+        // request all leaves before waiting for the first one
+        std::vector< std::unique_ptr< VertexBufferDist > > dists;
+        std::vector< co::f_bool_t > syncs;
+        for( size_t i = 0; i < leaves.size(); ++i )
+        {
+            const IDMap::const_iterator id = _ids.find( leaves[i] );
+            LBASSERT( id != _ids.end( ));
+
+            dists.push_back( std::unique_ptr< VertexBufferDist >(
+                                 new VertexBufferDist ));
+            syncs.push_back( _localNode->syncObject( dists.back().get(),
+                                                     id->second, _master ));
+        }
+
+        VertexBufferPager::Datas data( leaves.size( ));
+        for( size_t i = 0; i < leaves.size(); ++i )
+        {
+            if( syncs[i].wait( ))
+                data[i] = dists[i]->_leafData;
+            else
+                LBWARN << "Mapping of model leaf failed" << std::endl;
+
+            // only the data is kept, the object is deleted when returning
+            if( dists[i]->isAttached( ))
+                _localNode->unmapObject( dists[i].get( ));
+        }
+        return data;
+    }
+
+    bool hasColors() const override { return _colors; }
+
+private:
+    typedef std::unordered_map< const VertexBufferLeaf*,
+                                eq::uint128_t > IDMap;
+
+    co::LocalNodePtr _localNode;
+    co::NodePtr _master;
+    const bool _colors;
+    IDMap _ids;
+};
+
 VertexBufferDist::VertexBufferDist()
     : _root( 0 )
     , _node( 0 )
     , _left( 0 )
     , _right( 0 )
     , _isRoot( false )
+    , _source( 0 )
 {}
 
 VertexBufferDist::VertexBufferDist( VertexBufferRoot* root )
@@ -49,6 +109,7 @@ VertexBufferDist::VertexBufferDist( VertexBufferRoot* root )
     , _left( 0 )
     , _right( 0 )
     , _isRoot( true )
+    , _source( 0 )
 {
     if( root->getLeft( ))
         _left = new VertexBufferDist( root, root->getLeft( ));
@@ -64,6 +125,7 @@ VertexBufferDist::VertexBufferDist( VertexBufferRoot* root,
         , _left( 0 )
         , _right( 0 )
         , _isRoot( false )
+        , _source( 0 )
 {
     if( !node )
         return;
@@ -127,32 +189,28 @@ void VertexBufferDist::getInstanceData( co::DataOStream& os )
     LBASSERT( _node );
     os << _isRoot;
 
-    if( _left && _right )
-    {
-        os << _left->getID() << _right->getID();
-
-        if( _isRoot )
-        {
-            LBASSERT( _root );
-            const VertexBufferData& data = _root->_data;
-
-            os << data.vertices << data.colors << data.normals << data.indices
-               << _root->_name;
-        }
-    }
-    else
+    if( !_left || !_right )
     {
+        // leaf data, mapped by the renderers when they need it
         os << eq::uint128_t() << eq::uint128_t();
 
-        LBASSERT( dynamic_cast< const VertexBufferLeaf* >( _node ));
-        const VertexBufferLeaf* leaf =
-            static_cast< const VertexBufferLeaf* >( _node );
+        const std::shared_ptr< const VertexBufferData > data = _getLeafData();
+        os << data->vertices << data->colors << data->normals << data->indices;
+        return;
+    }
 
-        os << leaf->_boundingBox[0] << leaf->_boundingBox[1]
-           << uint64_t( leaf->_vertexStart ) << uint64_t( leaf->_indexStart )
-           << uint64_t( leaf->_indexLength ) << leaf->_vertexLength;
+    os << _left->getID() << _right->getID();
+    if( _isRoot )
+    {
+        LBASSERT( _root );
+        // out-of-core models are paged in from the cache on each node
+        os << _root->_name
+           << uint64_t( _root->isOutOfCore() ? _root->_pagingBudget : 0 )
+           << _root->hasColors();
     }
 
+    _left->_writeChild( os );
+    _right->_writeChild( os );
     os << _node->_boundingSphere << _node->_range;
 }
 
@@ -160,64 +218,145 @@ void VertexBufferDist::applyInstanceData( co::DataIStream& is )
 {
     LBASSERT( !_node );
 
-    VertexBufferNode* node = 0;
-    VertexBufferBase* base = 0;
-
     eq::uint128_t leftID, rightID;
     is >> _isRoot >> leftID >> rightID;
 
-    if( leftID != 0 && rightID != 0 )
+    if( leftID == 0 || rightID == 0 )
     {
-        if( _isRoot )
-        {
-            VertexBufferRoot* root = new VertexBufferRoot;
-            VertexBufferData& data = root->_data;
+        LBASSERT( !_isRoot );
+        std::shared_ptr< VertexBufferData > data( new VertexBufferData );
+        is >> data->vertices >> data->colors >> data->normals >> data->indices;
+        _leafData = data;
+        return;
+    }
 
-            is >> data.vertices >> data.colors >> data.normals >> data.indices
-               >> root->_name;
+    VertexBufferNode* node = 0;
+    std::unique_ptr< LeafSource > source;
+    if( _isRoot )
+    {
+        VertexBufferRoot* root = new VertexBufferRoot;
+        uint64_t pagingBudget;
+        bool hasColors;
+        is >> root->_name >> pagingBudget >> hasColors;
+        root->useOutOfCore( size_t( pagingBudget ));
+
+        source.reset( new LeafSource( is.getLocalNode(), is.getRemoteNode(),
+                                      hasColors ));
+        _source = source.get();
+        node  = root;
+        _root = root;
+    }
+    else
+    {
+        LBASSERT( _root && _source );
+        node = new VertexBufferNode;
+    }
 
-            node  = root;
-            _root = root;
-        }
-        else
-        {
-            LBASSERT( _root );
-            node = new VertexBufferNode;
-        }
+    std::vector< co::f_bool_t > syncs;
+    VertexBufferBase* left = _readChild( is, leftID, _left, syncs );
+    VertexBufferBase* right = _readChild( is, rightID, _right, syncs );
+    is >> node->_boundingSphere >> node->_range;
 
-        base   = node;
-        _left  = new VertexBufferDist( _root, 0 );
-        _right = new VertexBufferDist( _root, 0 );
-        co::NodePtr from = is.getRemoteNode();
-        co::LocalNodePtr to = is.getLocalNode();
-        co::f_bool_t leftSync = to->syncObject( _left, leftID, from );
-        co::f_bool_t rightSync = to->syncObject( _right, rightID, from );
+    for( size_t i = 0; i < syncs.size(); ++i )
+        LBCHECK( syncs[i].wait( ));
 
-        LBCHECK( leftSync.wait() && rightSync.wait( ));
+    node->_left  = _left ? _left->_node : left;
+    node->_right = _right ? _right->_node : right;
+    _node = node;
 
-        node->_left  = _left->_node;
-        node->_right = _right->_node;
-    }
-    else
+    if( !_isRoot )
+        return;
+
+    _source = 0;
+    if( _root->_pagingBudget > 0 )
     {
-        LBASSERT( !_isRoot );
-        VertexBufferData& data = _root->_data;
-        VertexBufferLeaf* leaf = new VertexBufferLeaf( data );
+        if( _root->_pageFromCache( ))
+            return;
+        LBWARN << "Can't page model data from the cache of " << _root->_name
+               << ", fetching it from the master" << std::endl;
+    }
+    _root->_pageFromMaster( new VertexBufferPager( source.release(),
+                                                   _root->_getPagingBudget( )));
+}
+
+/*  Describe a child in the instance data of its parent. Leaves are described
+    completely, so that their objects are only mapped for their data.  */
+void VertexBufferDist::_writeChild( co::DataOStream& os ) const
+{
+    const bool isLeaf = !_left || !_right;
+    os << isLeaf;
+    if( !isLeaf )
+        return;
+
+    LBASSERT( dynamic_cast< const VertexBufferLeaf* >( _node ));
+    const VertexBufferLeaf* leaf =
+        static_cast< const VertexBufferLeaf* >( _node );
 
-        uint64_t i1, i2, i3;
-        is >> leaf->_boundingBox[0] >> leaf->_boundingBox[1]
-           >> i1 >> i2 >> i3 >> leaf->_vertexLength;
-        leaf->_vertexStart = size_t( i1 );
-        leaf->_indexStart = size_t( i2 );
-        leaf->_indexLength = size_t( i3 );
+    os << leaf->_boundingBox[0] << leaf->_boundingBox[1]
+       << uint64_t( leaf->_vertexStart ) << uint64_t( leaf->_indexStart )
+       << uint64_t( leaf->_indexLength ) << leaf->_vertexLength
+       << leaf->_checksum << leaf->_boundingSphere << leaf->_range;
+}
 
-        base = leaf;
+/*  Read a child description. Leaves are created right away, the mapping of
+    inner nodes is started and added to syncs.  */
+VertexBufferBase* VertexBufferDist::_readChild(
+    co::DataIStream& is, const eq::uint128_t& id, VertexBufferDist*& child,
+    std::vector< co::f_bool_t >& syncs )
+{
+    bool isLeaf;
+    is >> isLeaf;
+
+    if( !isLeaf )
+    {
+        child = new VertexBufferDist( _root, 0 );
+        child->_source = _source;
+        syncs.push_back( is.getLocalNode()->syncObject( child, id,
+                                                        is.getRemoteNode( )));
+        return 0;
     }
 
-    LBASSERT( base );
-    is >> base->_boundingSphere >> base->_range;
+    VertexBufferLeaf* leaf = new VertexBufferLeaf( _root->_data );
+
+    uint64_t i1, i2, i3;
+    is >> leaf->_boundingBox[0] >> leaf->_boundingBox[1]
+       >> i1 >> i2 >> i3 >> leaf->_vertexLength
+       >> leaf->_checksum >> leaf->_boundingSphere >> leaf->_range;
+    leaf->_vertexStart = size_t( i1 );
+    leaf->_indexStart = size_t( i2 );
+    leaf->_indexLength = size_t( i3 );
 
-    _node = base;
+    _source->add( leaf, id );
+    return leaf;
+}
+
+/*  @return the leaf-local data of the leaf held by this object.  */
+std::shared_ptr< const VertexBufferData > VertexBufferDist::_getLeafData() const
+{
+    LBASSERT( dynamic_cast< const VertexBufferLeaf* >( _node ));
+    const VertexBufferLeaf* leaf =
+        static_cast< const VertexBufferLeaf* >( _node );
+
+    if( _root->_pager )
+        return _root->_pager->read( leaf );
+
+    const VertexBufferData& global = _root->_data;
+    const Index vertexStart = leaf->_vertexStart;
+    const Index vertexEnd = vertexStart + leaf->_vertexLength;
+    const Index indexStart = leaf->_indexStart;
+    const Index indexEnd = indexStart + leaf->_indexLength;
+
+    std::shared_ptr< VertexBufferData > data( new VertexBufferData );
+    data->vertices.assign( global.vertices.begin() + vertexStart,
+                           global.vertices.begin() + vertexEnd );
+    data->normals.assign( global.normals.begin() + vertexStart,
+                          global.normals.begin() + vertexEnd );
+    if( !global.colors.empty( ))
+        data->colors.assign( global.colors.begin() + vertexStart,
+                             global.colors.begin() + vertexEnd );
+    data->indices.assign( global.indices.begin() + indexStart,
+                          global.indices.begin() + indexEnd );
+    return data;
 }
 
 }
@@ -35,10 +35,17 @@
 #include "typedefs.h"
 
 #include <co/co.h>
+#include <memory>
+#include <vector>
 
 namespace triply
 {
-/** Uses co::Object to distribute a model, holds a VertexBufferBase node. */
+/**
+ * Uses co::Object to distribute a model, holds a VertexBufferBase node.
+ *
+ * The kd-tree is mapped up front, the data of each leaf is a separate object
+ * which renderers map on demand for the leaves in and around their range.
+ */
 class VertexBufferDist : public co::Object
 {
 public:
@@ -60,11 +67,21 @@ protected:
     TRIPLY_API virtual void applyInstanceData( co::DataIStream& is );
 
 private:
+    class LeafSource;
+
     VertexBufferRoot* _root;
     VertexBufferBase* _node;
     VertexBufferDist* _left;
     VertexBufferDist* _right;
     bool _isRoot;
+    LeafSource* _source; // fetches the leaf data of a mapped tree
+    std::shared_ptr< const VertexBufferData > _leafData;
+
+    void _writeChild( co::DataOStream& os ) const;
+    VertexBufferBase* _readChild( co::DataIStream& is, const eq::uint128_t& id,
+                                  VertexBufferDist*& child,
+                                  std::vector< co::f_bool_t >& syncs );
+    std::shared_ptr< const VertexBufferData > _getLeafData() const;
 };
 }
 
@@ -30,6 +30,7 @@
 
 #include "vertexBufferLeaf.h"
 #include "vertexBufferData.h"
+#include "vertexBufferPager.h"
 #include "vertexBufferState.h"
 #include "vertexData.h"
 #include <map>
@@ -43,14 +44,40 @@ void VertexBufferLeaf::setupTree( VertexData& data, const Index start,
                                   const size_t depth,
                                   VertexBufferData& globalData,
                                   boost::progress_display& progress )
+{
+    const Index indexStart = globalData.indices.size();
+    globalData.indices.resize( indexStart + 3 * length );
+
+    std::vector< Index > vertices;
+    _setupIndices( data, start, length, axis, indexStart, vertices );
+
+    const Index vertexStart = globalData.vertices.size();
+    const Index vertexEnd = vertexStart + vertices.size();
+    globalData.vertices.resize( vertexEnd );
+    if( !data.colors.empty( ))
+        globalData.colors.resize( vertexEnd );
+    globalData.normals.resize( vertexEnd );
+
+    _setupVertices( data, vertices, vertexStart );
+    if( depth == 3 )
+        ++progress;
+}
+
+
+/*  Sort and reindex the triangles into the preallocated global indices.
+    Collects the original indices of the used vertices in their new order. Only
+    touches this leaf's part of the global data, and may run concurrently with
+    the setup of other leaves.  */
+void VertexBufferLeaf::_setupIndices( VertexData& data, const Index start,
+                                      const Index length, const Axis axis,
+                                      const Index indexStart,
+                                      std::vector< Index >& vertices )
 {
     data.sort( start, length, axis );
-    _vertexStart = globalData.vertices.size();
-    _vertexLength = 0;
-    _indexStart = globalData.indices.size();
+    _indexStart = indexStart;
     _indexLength = 0;
-
-    const bool hasColors = !data.colors.empty();
+    _vertexLength = 0;
+    vertices.clear();
 
     // stores the new indices (relative to _start)
     std::map< Index, ShortIndex > newIndex;
@@ -65,17 +92,32 @@ void VertexBufferLeaf::setupTree( VertexData& data, const Index start,
                 newIndex[i] = _vertexLength++;
                 // assert number of vertices does not exceed SmallIndex range
                 PLYLIBASSERT( _vertexLength );
-                globalData.vertices.push_back( data.vertices[i] );
-                if( hasColors )
-                    globalData.colors.push_back( data.colors[i] );
-                globalData.normals.push_back( data.normals[i] );
+                vertices.push_back( i );
             }
-            globalData.indices.push_back( newIndex[i] );
+            _globalData.indices[ _indexStart + _indexLength ] = newIndex[i];
             ++_indexLength;
         }
     }
-    if( depth == 3 )
-        ++progress;
+}
+
+
+/*  Copy the used vertices into the preallocated global vertex data.  */
+void VertexBufferLeaf::_setupVertices( const VertexData& data,
+                                       const std::vector< Index >& vertices,
+                                       const Index vertexStart )
+{
+    PLYLIBASSERT( vertices.size() == _vertexLength );
+    _vertexStart = vertexStart;
+
+    const bool hasColors = !data.colors.empty();
+    for( size_t i = 0; i < vertices.size(); ++i )
+    {
+        const Index vertex = vertices[i];
+        _globalData.vertices[ _vertexStart + i ] = data.vertices[ vertex ];
+        if( hasColors )
+            _globalData.colors[ _vertexStart + i ] = data.colors[ vertex ];
+        _globalData.normals[ _vertexStart + i ] = data.normals[ vertex ];
+    }
 }
 
 
@@ -183,11 +225,51 @@ void VertexBufferLeaf::updateRange()
     _range[1] = _range[0] + 1.0f * _indexLength / _globalData.indices.size();
 }
 
+/*  Get the vertex data of the leaf, queue it for paging if not resident.  */
+bool VertexBufferLeaf::getGeometry( Geometry& geometry ) const
+{
+    const VertexBufferData* data = &_globalData;
+    Index vertexStart = _vertexStart;
+    Index indexStart = _indexStart;
+
+    if( _pager )
+    {
+        geometry.paged = _pager->get( this );
+        if( !geometry.paged )
+            return false;
+
+        data = geometry.paged.get();
+        vertexStart = 0;
+        indexStart = 0;
+    }
+    else if( _indexStart + _indexLength > data->indices.size( ))
+        return false; // out-of-core tree without a pager, has no vertex data
+
+    if( _indexLength == 0 || data->indices.empty( ))
+        return false;
+
+    geometry.vertices = &data->vertices[ vertexStart ];
+    geometry.normals = &data->normals[ vertexStart ];
+    geometry.colors = data->colors.empty() ? 0 : &data->colors[ vertexStart ];
+    geometry.indices = &data->indices[ indexStart ];
+    return true;
+}
+
+/*  @return the memory used by the GL objects of the leaf.  */
+size_t VertexBufferLeaf::getObjectSize( const VertexBufferState& state ) const
+{
+    size_t vertexSize = sizeof( Vertex ) + sizeof( Normal );
+    if( state.useColors( ))
+        vertexSize += sizeof( Color );
+    return _vertexLength * vertexSize + _indexLength * sizeof( ShortIndex );
+}
+
 #define glewGetContext state.glewGetContext
 
 /*  Set up rendering of the leaf nodes.  */
 void VertexBufferLeaf::setupRendering( VertexBufferState& state,
-                                       GLuint* data ) const
+                                       GLuint* data,
+                                       const Geometry& geometry ) const
 {
     switch( state.getRenderMode() )
     {
@@ -202,13 +284,13 @@ void VertexBufferLeaf::setupRendering( VertexBufferState& state,
             data[VERTEX_OBJECT] = state.newBufferObject( charThis + 0 );
         glBindBuffer( GL_ARRAY_BUFFER, data[VERTEX_OBJECT] );
         glBufferData( GL_ARRAY_BUFFER, _vertexLength * sizeof( Vertex ),
-                        &_globalData.vertices[_vertexStart], GL_STATIC_DRAW );
+                        geometry.vertices, GL_STATIC_DRAW );
 
         if( data[NORMAL_OBJECT] == state.INVALID )
             data[NORMAL_OBJECT] = state.newBufferObject( charThis + 1 );
         glBindBuffer( GL_ARRAY_BUFFER, data[NORMAL_OBJECT] );
         glBufferData( GL_ARRAY_BUFFER, _vertexLength * sizeof( Normal ),
-                        &_globalData.normals[_vertexStart], GL_STATIC_DRAW );
+                        geometry.normals, GL_STATIC_DRAW );
 
         if( data[COLOR_OBJECT] == state.INVALID )
             data[COLOR_OBJECT] = state.newBufferObject( charThis + 2 );
@@ -216,7 +298,7 @@ void VertexBufferLeaf::setupRendering( VertexBufferState& state,
         {
             glBindBuffer( GL_ARRAY_BUFFER, data[COLOR_OBJECT] );
             glBufferData( GL_ARRAY_BUFFER, _vertexLength * sizeof( Color ),
-                            &_globalData.colors[_vertexStart], GL_STATIC_DRAW );
+                            geometry.colors, GL_STATIC_DRAW );
         }
 
         if( data[INDEX_OBJECT] == state.INVALID )
@@ -224,7 +306,7 @@ void VertexBufferLeaf::setupRendering( VertexBufferState& state,
         glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, data[INDEX_OBJECT] );
         glBufferData( GL_ELEMENT_ARRAY_BUFFER,
                         _indexLength * sizeof( ShortIndex ),
-                        &_globalData.indices[_indexStart], GL_STATIC_DRAW );
+                        geometry.indices, GL_STATIC_DRAW );
 
         break;
     }
@@ -239,13 +321,23 @@ void VertexBufferLeaf::setupRendering( VertexBufferState& state,
             data[0] = state.newDisplayList( key );
         }
         glNewList( data[0], GL_COMPILE );
-        renderImmediate( state );
+        renderImmediate( state, geometry );
         glEndList();
         break;
     }
     }
 }
 
+/*  Delete the GL objects of the leaf, called on eviction by the state.  */
+void VertexBufferLeaf::releaseRendering( VertexBufferState& state ) const
+{
+    const char* charThis = reinterpret_cast< const char* >( this );
+    state.deleteDisplayList( charThis );
+    state.deleteDisplayList( charThis + 1 );
+    for( int i = 0; i < 4; ++i )
+        state.deleteBufferObject( charThis + i );
+}
+
 /*  Draw the leaf.  */
 void VertexBufferLeaf::draw( VertexBufferState& state ) const
 {
@@ -256,8 +348,12 @@ void VertexBufferLeaf::draw( VertexBufferState& state ) const
     switch( state.getRenderMode() )
     {
       case RENDER_MODE_IMMEDIATE:
-          renderImmediate( state );
+      {
+          Geometry geometry;
+          if( getGeometry( geometry ))
+              renderImmediate( state, geometry );
           return;
+      }
       case RENDER_MODE_BUFFER_OBJECT:
           renderBufferObject( state );
           return;
@@ -279,8 +375,15 @@ void VertexBufferLeaf::renderBufferObject( VertexBufferState& state ) const
         buffers[NORMAL_OBJECT] == state.INVALID ||
         buffers[COLOR_OBJECT] == state.INVALID ||
         buffers[INDEX_OBJECT] == state.INVALID )
-
-        setupRendering( state, buffers );
+    {
+        Geometry geometry;
+        if( !getGeometry( geometry ))
+            return;
+        setupRendering( state, buffers, geometry );
+        state.addObjects( this, getObjectSize( state ));
+    }
+    else
+        state.useObjects( this );
 
     if( state.useColors() )
     {
@@ -307,7 +410,15 @@ void VertexBufferLeaf::renderDisplayList( VertexBufferState& state ) const
     GLuint displayList = state.getDisplayList( key );
 
     if( displayList == state.INVALID )
-        setupRendering( state, &displayList );
+    {
+        Geometry geometry;
+        if( !getGeometry( geometry ))
+            return;
+        setupRendering( state, &displayList, geometry );
+        state.addObjects( this, getObjectSize( state ));
+    }
+    else
+        state.useObjects( this );
 
     glCallList( displayList );
 }
@@ -315,54 +426,61 @@ void VertexBufferLeaf::renderDisplayList( VertexBufferState& state ) const
 
 /*  Render the leaf with immediate mode primitives or vertex arrays.  */
 inline
-void VertexBufferLeaf::renderImmediate( VertexBufferState& state ) const
+void VertexBufferLeaf::renderImmediate( VertexBufferState& state,
+                                        const Geometry& geometry ) const
 {
     glBegin( GL_TRIANGLES );
     for( Index offset = 0; offset < _indexLength; ++offset )
     {
-        const Index i =_vertexStart + _globalData.indices[_indexStart + offset];
+        const Index i = geometry.indices[ offset ];
         if( state.useColors() )
-            glColor3ubv( &_globalData.colors[i][0] );
-        glNormal3fv( &_globalData.normals[i][0] );
-        glVertex3fv( &_globalData.vertices[i][0] );
+            glColor3ubv( &geometry.colors[i][0] );
+        glNormal3fv( &geometry.normals[i][0] );
+        glVertex3fv( &geometry.vertices[i][0] );
     }
     glEnd();
 }
 
 
 /*  Read leaf node from memory.  */
-void VertexBufferLeaf::fromMemory( char** addr, VertexBufferData& globalData )
+void VertexBufferLeaf::fromMemory( char** addr, VertexBufferData& )
 {
-    size_t nodeType;
-    memRead( reinterpret_cast< char* >( &nodeType ), addr, sizeof( size_t ) );
-    if( nodeType != LEAF_TYPE )
+    cache::Node node;
+    memRead( reinterpret_cast< char* >( &node ), addr, sizeof( node ));
+    if( node.type != LEAF_TYPE )
         throw MeshException( "Error reading binary file. Expected a leaf "
                              "node, but found something else instead." );
-    VertexBufferBase::fromMemory( addr, globalData );
-    memRead( reinterpret_cast< char* >( &_boundingBox ), addr,
-             sizeof( BoundingBox ) );
-    memRead( reinterpret_cast< char* >( &_vertexStart ), addr,
-             sizeof( Index ) );
-    memRead( reinterpret_cast< char* >( &_vertexLength ), addr,
-             sizeof( ShortIndex ) );
-    memRead( reinterpret_cast< char* >( &_indexStart ), addr,
-             sizeof( Index ) );
-    memRead( reinterpret_cast< char* >( &_indexLength ), addr,
-             sizeof( Index ) );
+    fromCache( node );
+    for( size_t i = 0; i < 3; ++i )
+    {
+        _boundingBox[0][i] = node.boundingBox[i];
+        _boundingBox[1][i] = node.boundingBox[ i + 3 ];
+    }
+    _vertexStart = Index( node.vertexStart );
+    _vertexLength = ShortIndex( node.vertexLength );
+    _indexStart = Index( node.indexStart );
+    _indexLength = Index( node.indexLength );
+    _checksum = node.checksum;
 }
 
 
 /*  Write leaf node to output stream.  */
 void VertexBufferLeaf::toStream( std::ostream& os )
 {
-    size_t nodeType = LEAF_TYPE;
-    os.write( reinterpret_cast< char* >( &nodeType ), sizeof( size_t ));
-    VertexBufferBase::toStream( os );
-    os.write( reinterpret_cast< char* >( &_boundingBox ), sizeof( BoundingBox));
-    os.write( reinterpret_cast< char* >( &_vertexStart ), sizeof( Index ));
-    os.write( reinterpret_cast< char* >( &_vertexLength ),sizeof( ShortIndex ));
-    os.write( reinterpret_cast< char* >( &_indexStart ), sizeof( Index ));
-    os.write( reinterpret_cast< char* >( &_indexLength ), sizeof( Index ));
+    cache::Node node;
+    toCache( node );
+    node.type = LEAF_TYPE;
+    for( size_t i = 0; i < 3; ++i )
+    {
+        node.boundingBox[i] = _boundingBox[0][i];
+        node.boundingBox[ i + 3 ] = _boundingBox[1][i];
+    }
+    node.vertexStart = _vertexStart;
+    node.vertexLength = _vertexLength;
+    node.indexStart = _indexStart;
+    node.indexLength = _indexLength;
+    node.checksum = _checksum;
+    os.write( reinterpret_cast< const char* >( &node ), sizeof( node ));
 }
 
 }
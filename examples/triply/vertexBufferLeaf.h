@@ -31,6 +31,8 @@
 #define PLYLIB_VERTEXBUFFERLEAF_H
 
 #include "vertexBufferBase.h"
+#include <memory>
+#include <vector>
 
 namespace triply
 {
@@ -39,8 +41,9 @@ class VertexBufferLeaf : public VertexBufferBase
 {
 public:
     explicit VertexBufferLeaf( VertexBufferData& data )
-        : _globalData( data ), _vertexStart( 0 ), _indexStart( 0 )
-        , _indexLength( 0 ), _vertexLength( 0 ) {}
+        : _globalData( data ), _pager( 0 ), _vertexStart( 0 )
+        , _indexStart( 0 ), _indexLength( 0 ), _checksum( 0 )
+        , _vertexLength( 0 ) {}
     virtual ~VertexBufferLeaf() {}
 
     virtual void draw( VertexBufferState& state ) const;
@@ -59,17 +62,46 @@ protected:
     virtual void updateRange();
 
 private:
-    void setupRendering( VertexBufferState& state, GLuint* data ) const;
-    void renderImmediate( VertexBufferState& state ) const;
+    void _setupIndices( VertexData& data, Index start, Index length,
+                        Axis axis, Index indexStart,
+                        std::vector< Index >& vertices );
+    void _setupVertices( const VertexData& data,
+                         const std::vector< Index >& vertices,
+                         Index vertexStart );
+
+    /*  The vertex data of the leaf, from the global data or paged in.  */
+    struct Geometry
+    {
+        const Vertex*     vertices;
+        const Normal*     normals;
+        const Color*      colors;
+        const ShortIndex* indices;
+        std::shared_ptr< const VertexBufferData > paged;
+    };
+    bool getGeometry( Geometry& geometry ) const;
+    size_t getObjectSize( const VertexBufferState& state ) const;
+
+    void setupRendering( VertexBufferState& state, GLuint* data,
+                         const Geometry& geometry ) const;
+    void releaseRendering( VertexBufferState& state ) const;
+    void renderImmediate( VertexBufferState& state,
+                          const Geometry& geometry ) const;
     void renderDisplayList( VertexBufferState& state ) const;
     void renderBufferObject( VertexBufferState& state ) const;
 
+    friend class CacheSource;
     friend class VertexBufferDist;
+    friend class VertexBufferNode;
+    friend class VertexBufferPager;
+    friend class VertexBufferRoot;
+    friend class VertexBufferState;
     VertexBufferData&   _globalData;
+    VertexBufferPager*  _pager; // pages the data in if the model is out-of-core
     BoundingBox         _boundingBox;
     Index               _vertexStart;
     Index               _indexStart;
     Index               _indexLength;
+    uint64_t            _checksum; // of the leaf data in the model cache
     ShortIndex          _vertexLength;
 };
 }
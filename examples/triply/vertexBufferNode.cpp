@@ -29,9 +29,12 @@
 
 
 #include "vertexBufferNode.h"
+#include "vertexBufferData.h"
 #include "vertexBufferLeaf.h"
 #include "vertexBufferState.h"
 #include "vertexData.h"
+#include <lunchbox/omp.h>
+#include <algorithm>
 #include <set>
 
 namespace triply
@@ -39,6 +42,11 @@ namespace triply
 
 /*  Destructor, clears up children as well.  */
 VertexBufferNode::~VertexBufferNode()
+{
+    clear();
+}
+
+void VertexBufferNode::clear()
 {
     delete _left;
     delete _right;
@@ -51,14 +59,118 @@ inline static bool _subdivide( const Index length, const size_t depth )
     return ( length > LEAF_SIZE ) || ( depth < 3 && length > 1 );
 }
 
-/*  Continue kd-tree setup, create intermediary or leaf nodes as required.  */
+/*  A kd-tree node and the range of triangles it is set up from.  */
+struct VertexBufferNode::Subtree
+{
+    Subtree() : node( 0 ), start( 0 ), length( 0 ), axis( AXIS_X ),
+                depth( 0 ), isLeaf( false ) {}
+    Subtree( VertexBufferBase* node_, const Index start_, const Index length_,
+             const Axis axis_, const size_t depth_, const bool isLeaf_ )
+        : node( node_ ), start( start_ ), length( length_ ), axis( axis_ )
+        , depth( depth_ ), isLeaf( isLeaf_ ) {}
+
+    bool operator < ( const Subtree& rhs ) const { return start < rhs.start; }
+
+    VertexBufferBase* node;
+    Index start;
+    Index length;
+    Axis axis;
+    size_t depth;
+    bool isLeaf;
+};
+
+/*  Continue kd-tree setup, create intermediary or leaf nodes as required.
+
+    The tree is split level by level, partitioning all nodes of one level
+    concurrently. The first levels have fewer nodes than threads and use the
+    parallel partition of the data instead. Afterwards all leaves are reindexed
+    concurrently, and their vertices are merged into the global data in
+    depth-first order.
+*/
 void VertexBufferNode::setupTree( VertexData& data, const Index start,
                                   const Index length, const Axis axis,
                                   const size_t depth,
                                   VertexBufferData& globalData,
                                   boost::progress_display& progress )
 {
-    data.sort( start, length, axis );
+    const size_t nThreads = lunchbox::OMP::getNThreads();
+    std::vector< Subtree > nodes( 1, Subtree( this, start, length, axis,
+                                              depth, false ));
+    std::vector< Subtree > leaves;
+    size_t nProgress = 0;
+
+    while( !nodes.empty( ))
+    {
+        std::vector< Subtree > children( nodes.size() * 2 );
+#pragma omp parallel for schedule( dynamic ) if( nodes.size() >= nThreads )
+        for( ssize_t i = 0; i < ssize_t( nodes.size( )); ++i )
+        {
+            VertexBufferNode* node =
+                static_cast< VertexBufferNode* >( nodes[i].node );
+            node->_split( data, nodes[i], globalData, &children[ 2 * i ] );
+        }
+
+        nodes.clear();
+        for( size_t i = 0; i < children.size(); ++i )
+        {
+            if( children[i].depth == 3 )
+                ++nProgress;
+            if( children[i].isLeaf )
+                leaves.push_back( children[i] );
+            else
+                nodes.push_back( children[i] );
+        }
+    }
+
+    // the triangle ranges of the leaves are in depth-first order
+    std::sort( leaves.begin(), leaves.end( ));
+    const Index indexStart = globalData.indices.size();
+    globalData.indices.resize( indexStart + 3 * length );
+
+    std::vector< std::vector< Index > > vertices( leaves.size( ));
+#pragma omp parallel for schedule( dynamic )
+    for( ssize_t i = 0; i < ssize_t( leaves.size( )); ++i )
+    {
+        const Subtree& leaf = leaves[i];
+        static_cast< VertexBufferLeaf* >( leaf.node )->_setupIndices(
+            data, leaf.start, leaf.length, leaf.axis,
+            indexStart + 3 * ( leaf.start - start ), vertices[i] );
+    }
+
+    std::vector< Index > vertexStarts( leaves.size( ));
+    Index vertexEnd = globalData.vertices.size();
+    for( size_t i = 0; i < leaves.size(); ++i )
+    {
+        vertexStarts[i] = vertexEnd;
+        vertexEnd += vertices[i].size();
+    }
+    globalData.vertices.resize( vertexEnd );
+    if( !data.colors.empty( ))
+        globalData.colors.resize( vertexEnd );
+    globalData.normals.resize( vertexEnd );
+
+#pragma omp parallel for schedule( dynamic )
+    for( ssize_t i = 0; i < ssize_t( leaves.size( )); ++i )
+    {
+        static_cast< VertexBufferLeaf* >( leaves[i].node )->_setupVertices(
+            data, vertices[i], vertexStarts[i] );
+        std::vector< Index >().swap( vertices[i] );
+    }
+
+    progress += nProgress;
+}
+
+
+/*  Partition the node's triangles and create its two children.  */
+void VertexBufferNode::_split( VertexData& data, const Subtree& subtree,
+                               VertexBufferData& globalData,
+                               Subtree* children )
+{
+    const Index start = subtree.start;
+    const Index length = subtree.length;
+    const size_t depth = subtree.depth;
+
+    data.partition( start, length, subtree.axis );
     const Index median = start + ( length / 2 );
 
     // left child will include elements smaller than the median
@@ -86,14 +198,10 @@ void VertexBufferNode::setupTree( VertexData& data, const Index start,
     const Axis newAxisRight = subdivideRight ?
                         data.getLongestAxis( median, rightLength ) : AXIS_X;
 
-    static_cast< VertexBufferNode* >
-            ( _left )->setupTree( data, start, leftLength, newAxisLeft, depth+1,
-                                  globalData, progress );
-    static_cast< VertexBufferNode* >
-        ( _right )->setupTree( data, median, rightLength, newAxisRight, depth+1,
-                               globalData, progress );
-    if( depth == 3 )
-        ++progress;
+    children[0] = Subtree( _left, start, leftLength, newAxisLeft, depth + 1,
+                           !subdivideLeft );
+    children[1] = Subtree( _right, median, rightLength, newAxisRight,
+                           depth + 1, !subdivideRight );
 }
 
 
@@ -150,19 +258,18 @@ void VertexBufferNode::draw( VertexBufferState& state ) const
 void VertexBufferNode::fromMemory( char** addr, VertexBufferData& globalData )
 {
     // read node itself
-    size_t nodeType;
-    memRead( reinterpret_cast< char* >( &nodeType ), addr, sizeof( size_t ) );
-    if( nodeType != NODE_TYPE )
+    cache::Node node;
+    memRead( reinterpret_cast< char* >( &node ), addr, sizeof( node ));
+    if( node.type != NODE_TYPE )
         throw MeshException( "Error reading binary file. Expected a regular "
                              "node, but found something else instead." );
-    VertexBufferBase::fromMemory( addr, globalData );
+    fromCache( node );
 
     // read left child (peek ahead)
-    memRead( reinterpret_cast< char* >( &nodeType ), addr, sizeof( size_t ) );
+    uint32_t nodeType = cache::peekType( *addr );
     if( nodeType != NODE_TYPE && nodeType != LEAF_TYPE )
         throw MeshException( "Error reading binary file. Expected either a "
                              "regular or a leaf node, but found neither." );
-    *addr -= sizeof( size_t );
     if( nodeType == NODE_TYPE )
         _left = new VertexBufferNode;
     else
@@ -170,11 +277,10 @@ void VertexBufferNode::fromMemory( char** addr, VertexBufferData& globalData )
     static_cast< VertexBufferNode* >( _left )->fromMemory( addr, globalData );
 
     // read right child (peek ahead)
-    memRead( reinterpret_cast< char* >( &nodeType ), addr, sizeof( size_t ) );
+    nodeType = cache::peekType( *addr );
     if( nodeType != NODE_TYPE && nodeType != LEAF_TYPE )
         throw MeshException( "Error reading binary file. Expected either a "
                              "regular or a leaf node, but found neither." );
-    *addr -= sizeof( size_t );
     if( nodeType == NODE_TYPE )
         _right = new VertexBufferNode;
     else
@@ -186,9 +292,10 @@ void VertexBufferNode::fromMemory( char** addr, VertexBufferData& globalData )
 /*  Write node to output stream and continue with remaining nodes.  */
 void VertexBufferNode::toStream( std::ostream& os )
 {
-    size_t nodeType = NODE_TYPE;
-    os.write( reinterpret_cast< char* >( &nodeType ), sizeof( size_t ) );
-    VertexBufferBase::toStream( os );
+    cache::Node node;
+    toCache( node );
+    node.type = NODE_TYPE;
+    os.write( reinterpret_cast< const char* >( &node ), sizeof( node ));
     static_cast< VertexBufferNode* >( _left )->toStream( os );
     static_cast< VertexBufferNode* >( _right )->toStream( os );
 }
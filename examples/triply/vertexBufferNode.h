@@ -64,7 +64,14 @@ protected:
     TRIPLY_API const BoundingSphere& updateBoundingSphere() override;
     TRIPLY_API void updateRange() override;
 
+    /*  Delete the subtrees of this node.  */
+    void clear();
+
 private:
+    struct Subtree;
+    void _split( VertexData& data, const Subtree& subtree,
+                 VertexBufferData& globalData, Subtree* children );
+
     friend class VertexBufferDist;
     VertexBufferBase*   _left;
     VertexBufferBase*   _right;
@@ -0,0 +1,388 @@
+
+/* Copyright (c) 2016, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of Eyescale Software GmbH nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+#include "vertexBufferPager.h"
+#include "vertexBufferLeaf.h"
+
+#include <lunchbox/scopedMutex.h>
+#include <lunchbox/thread.h>
+
+namespace triply
+{
+namespace
+{
+// maximum number of leaves loaded by the source at once
+const size_t MAX_BATCH( 64 );
+// number of failed loads before a leaf is given up
+const unsigned MAX_ATTEMPTS( 3 );
+}
+
+class VertexBufferPager::Loader : public lunchbox::Thread
+{
+public:
+    explicit Loader( VertexBufferPager& pager ) : _pager( pager ) {}
+
+protected:
+    bool init() override { setName( "PlyPager" ); return true; }
+
+    void run() override
+    {
+        while( true )
+        {
+            const VertexBufferLeaf* leaf = _pager._queue.pop();
+            if( !leaf )
+                return; // exit thread
+
+            // batch the queued leaves, remote sources fetch them in parallel
+            Leaves leaves( 1, leaf );
+            bool exit = false;
+            while( leaves.size() < MAX_BATCH && _pager._queue.tryPop( leaf ))
+            {
+                if( !leaf )
+                {
+                    exit = true;
+                    break;
+                }
+                leaves.push_back( leaf );
+            }
+
+            const Datas data = _pager._source->load( leaves );
+            for( size_t i = 0; i < leaves.size(); ++i )
+                _pager._insert( leaves[i], data[i] );
+
+            if( exit )
+                return;
+        }
+    }
+
+private:
+    VertexBufferPager& _pager;
+};
+
+VertexBufferPager::VertexBufferPager( Source* source, const size_t budget )
+    : _source( source )
+    , _budget( budget )
+    , _queued( 0 )
+    , _frame( 0 )
+    , _frameBytes( 0 )
+    , _exceeded( 0 )
+    , _loader( new Loader( *this ))
+{
+    _loader->start();
+}
+
+VertexBufferPager::~VertexBufferPager()
+{
+    _queue.clear();
+    _queue.push( 0 ); // wake up to exit
+    _loader->join();
+}
+
+void VertexBufferPager::setFrameNumber( const uint32_t frame )
+{
+    lunchbox::ScopedWrite mutex( _lock );
+    if( frame == _frame || ( frame < _frame && frame > 0 ))
+        return; // same frame or late pipe
+
+    _frame = frame;
+    _frameBytes = 0;
+}
+
+VertexBufferPager::DataPtr VertexBufferPager::get(
+    const VertexBufferLeaf* leaf )
+{
+    lunchbox::ScopedWrite mutex( _lock );
+    EntryMap::iterator i = _entries.find( leaf );
+    if( i != _entries.end( ))
+    {
+        ++_stats.hits;
+        _used.splice( _used.begin(), _used, i->second.used );
+        if( _frame > 0 && i->second.frame != _frame )
+        {
+            i->second.frame = _frame;
+            _frameBytes += i->second.size;
+        }
+        return i->second.data;
+    }
+
+    ++_stats.misses;
+    if( _frame == 0 )
+    {
+        _request( leaf, 0 );
+        return DataPtr();
+    }
+
+    RequestMap::iterator request = _requests.find( leaf );
+    if( request != _requests.end() && request->second.frame == _frame )
+        return DataPtr(); // accounted for this frame already
+
+    // loading it would release leaves drawn in this frame
+    const size_t size = _getSize( leaf );
+    if( _frameBytes + size > _budget )
+    {
+        if( _exceeded == 0 )
+            PLYLIBWARN << "Paging budget of " << _budget / 1048576 << " MB "
+                       << "too small for the visible model data, not all "
+                       << "leaves are drawn" << std::endl;
+        _exceeded = _frame;
+        return DataPtr();
+    }
+
+    _frameBytes += size;
+    if( request == _requests.end( ))
+        _request( leaf, _frame );
+    else
+        request->second.frame = _frame;
+    return DataPtr();
+}
+
+bool VertexBufferPager::isPrefetched( const Range& range ) const
+{
+    lunchbox::ScopedWrite mutex( _lock );
+    return _isPrefetched( range );
+}
+
+void VertexBufferPager::prefetch( const Range& range, const Leaves& leaves )
+{
+    lunchbox::ScopedWrite mutex( _lock );
+    for( size_t i = 0; i < leaves.size(); ++i )
+    {
+        const VertexBufferLeaf* leaf = leaves[i];
+        if( _entries.find( leaf ) != _entries.end() ||
+            _requests.find( leaf ) != _requests.end( ))
+        {
+            continue;
+        }
+
+        // prefetching must not release drawn leaves, the range is walked
+        // again on the next call
+        if( _stats.bytes + _queued + _getSize( leaf ) > _budget )
+            return;
+        _request( leaf, 0 );
+    }
+
+    if( !_isPrefetched( range ))
+        _prefetched.push_back( range );
+}
+
+VertexBufferPager::DataPtr VertexBufferPager::read(
+    const VertexBufferLeaf* leaf )
+{
+    {
+        lunchbox::ScopedWrite mutex( _lock );
+        EntryMap::iterator i = _entries.find( leaf );
+        if( i != _entries.end( ))
+            return i->second.data;
+    }
+    return _source->load( Leaves( 1, leaf )).front();
+}
+
+bool VertexBufferPager::isLoading() const
+{
+    lunchbox::ScopedWrite mutex( _lock );
+    if( _frame == 0 || _exceeded != _frame )
+        return !_requests.empty();
+
+    // the other missing leaves do not fit, don't keep the application
+    // redrawing for them
+    for( RequestMap::const_iterator i = _requests.begin();
+         i != _requests.end(); ++i )
+    {
+        if( i->second.frame == _frame )
+            return true;
+    }
+    return false;
+}
+
+PagingStats VertexBufferPager::getStats() const
+{
+    lunchbox::ScopedWrite mutex( _lock );
+    return _stats;
+}
+
+/*  @return the size of the data of the leaf once it is loaded.  */
+size_t VertexBufferPager::_getSize( const VertexBufferLeaf* leaf ) const
+{
+    size_t vertexSize = sizeof( Vertex ) + sizeof( Normal );
+    if( _source->hasColors( ))
+        vertexSize += sizeof( Color );
+    return leaf->_vertexLength * vertexSize +
+           leaf->_indexLength * sizeof( ShortIndex );
+}
+
+/*  Call with the lock held.  */
+bool VertexBufferPager::_isPrefetched( const Range& range ) const
+{
+    for( size_t i = 0; i < _prefetched.size(); ++i )
+        if( _prefetched[i][0] == range[0] && _prefetched[i][1] == range[1] )
+            return true;
+    return false;
+}
+
+/*  Queue the leaf unless it is queued already, call with the lock held.  */
+void VertexBufferPager::_request( const VertexBufferLeaf* leaf,
+                                  const uint32_t frame )
+{
+    const Request request = { _clock.getTimef(), frame };
+    if( _requests.insert( std::make_pair( leaf, request )).second )
+    {
+        _queued += _getSize( leaf );
+        _queue.push( leaf );
+    }
+}
+
+void VertexBufferPager::_insert( const VertexBufferLeaf* leaf, DataPtr data )
+{
+    lunchbox::ScopedWrite mutex( _lock );
+    if( !data && ++_failures[ leaf ] >= MAX_ATTEMPTS )
+    {
+        // empty data is not drawn, but resident and not requested again
+        PLYLIBERROR << "Loading of a model leaf failed " << MAX_ATTEMPTS
+                    << " times, not drawing the leaf" << std::endl;
+        data.reset( new VertexBufferData );
+    }
+
+    const size_t size = !data ? 0 :
+                        data->vertices.size() * sizeof( Vertex ) +
+                        data->normals.size() * sizeof( Normal ) +
+                        data->colors.size() * sizeof( Color ) +
+                        data->indices.size() * sizeof( ShortIndex );
+
+    uint32_t frame = 0;
+    RequestMap::iterator request = _requests.find( leaf );
+    if( request != _requests.end( ))
+    {
+        _stats.latency += _clock.getTimef() - request->second.time;
+        _queued -= _getSize( leaf );
+        frame = request->second.frame;
+        _requests.erase( request );
+    }
+
+    // other failed loads are requested again on the next miss
+    if( !data || _entries.find( leaf ) != _entries.end( ))
+        return;
+
+    _used.push_front( leaf );
+    const Entry entry = { data, _used.begin(), size, frame };
+    _entries[ leaf ] = entry;
+    _stats.bytes += size;
+    ++_stats.loads;
+
+    // release least recently used leaves, renderers may still hold their data
+    while( _stats.bytes > _budget && _used.size() > 1 )
+    {
+        EntryMap::iterator i = _entries.find( _used.back( ));
+        if( _frame > 0 && i->second.frame == _frame )
+            break; // all resident leaves are drawn in this frame
+
+        _stats.bytes -= i->second.size;
+        ++_stats.evictions;
+
+        // prefetch the ranges of the released leaf again
+        const float* range = i->first->getRange();
+        for( size_t j = 0; j < _prefetched.size(); )
+        {
+            if( range[0] >= _prefetched[j][1] || range[1] < _prefetched[j][0] )
+                ++j;
+            else
+            {
+                _prefetched[j] = _prefetched.back();
+                _prefetched.pop_back();
+            }
+        }
+
+        _entries.erase( i );
+        _used.pop_back();
+    }
+}
+
+CacheSource::CacheSource( lunchbox::MemoryMap* file,
+                          const cache::Header& header )
+    : _file( file )
+    , _positions( reinterpret_cast< const cache::Position* >(
+                      file->getAddress< char >() + header.positions ))
+    , _normals( reinterpret_cast< const cache::Normal* >(
+                    file->getAddress< char >() + header.normals ))
+    , _colors( header.flags & cache::FLAG_COLORS ?
+               reinterpret_cast< const Color* >(
+                   file->getAddress< char >() + header.colors ) : 0 )
+    , _indices( reinterpret_cast< const ShortIndex* >(
+                    file->getAddress< char >() + header.indices ))
+{}
+
+VertexBufferPager::Datas CacheSource::load(
+    const VertexBufferPager::Leaves& leaves )
+{
+    VertexBufferPager::Datas data( leaves.size( ));
+#pragma omp parallel for
+    for( ssize_t i = 0; i < ssize_t( leaves.size( )); ++i )
+        data[i] = _load( leaves[i] );
+    return data;
+}
+
+/*  Verify and decode the leaf data, reading the mapped cache pages in on
+    first use.  */
+VertexBufferPager::DataPtr CacheSource::_load(
+    const VertexBufferLeaf* leaf ) const
+{
+    const Index start = leaf->_vertexStart;
+    const Index length = leaf->_vertexLength;
+    const ShortIndex* indices = _indices + leaf->_indexStart;
+
+    if( leaf->_checksum != cache::leafChecksum( _positions + start,
+                                                _normals + start,
+                                                _colors ? _colors + start : 0,
+                                                length, indices,
+                                                leaf->_indexLength ))
+    {
+        // empty data is not drawn, but resident and not requested again
+        PLYLIBERROR << "Checksum mismatch of the cached leaf data at vertex "
+                    << start << ", not drawing the leaf" << std::endl;
+        return VertexBufferPager::DataPtr( new VertexBufferData );
+    }
+
+    std::shared_ptr< VertexBufferData > data( new VertexBufferData );
+    data->vertices.resize( length );
+    if( length > 0 )
+        cache::decodePositions( _positions + start, length,
+                                leaf->_boundingBox, &data->vertices[0] );
+
+    data->normals.resize( length );
+    for( Index i = 0; i < length; ++i )
+        data->normals[i] = cache::decodeNormal( _normals[ start + i ] );
+
+    if( _colors )
+        data->colors.assign( _colors + start, _colors + start + length );
+
+    data->indices.assign( indices, indices + leaf->_indexLength );
+    return data;
+}
+
+}
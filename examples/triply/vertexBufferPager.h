@@ -0,0 +1,174 @@
+
+/* Copyright (c) 2016, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of Eyescale Software GmbH nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef PLYLIB_VERTEXBUFFERPAGER_H
+#define PLYLIB_VERTEXBUFFERPAGER_H
+
+#include "vertexBufferCache.h"
+#include "vertexBufferData.h"
+
+#include <lunchbox/clock.h>
+#include <lunchbox/lock.h>
+#include <lunchbox/memoryMap.h>
+#include <lunchbox/mtQueue.h>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace triply
+{
+    /*  Pages the data of leaves in on demand from a Source.
+
+        Leaves missing at draw time are queued for a loader thread, which
+        loads them in batches into leaf-local VertexBufferData. The least
+        recently drawn leaves are released when the resident data exceeds the
+        budget, except for the leaves drawn in the current frame. Leaves which
+        do not fit next to them are not loaded for the current frame.
+    */
+    class VertexBufferPager
+    {
+    public:
+        typedef std::shared_ptr< const VertexBufferData > DataPtr;
+        typedef std::vector< const VertexBufferLeaf* > Leaves;
+        typedef std::vector< DataPtr > Datas;
+
+        /*  Provides the leaf-local data of leaves.  */
+        class Source
+        {
+        public:
+            virtual ~Source() {}
+
+            /*  @return the data of the leaves, 0 for leaves failing to load.
+                Called concurrently by the loader thread and by read().  */
+            virtual Datas load( const Leaves& leaves ) = 0;
+            virtual bool hasColors() const = 0;
+        };
+
+        /*  Page from the given source, the pager takes its ownership.  */
+        VertexBufferPager( Source* source, size_t budget );
+        ~VertexBufferPager();
+
+        /*  Start a frame of draws, 0 disables the protection of the
+            leaves drawn in the current frame.  */
+        void setFrameNumber( uint32_t frame );
+
+        /*  @return the data of the leaf, or 0 if it is not resident yet.  */
+        DataPtr get( const VertexBufferLeaf* leaf );
+
+        /*  @return true if all leaves of the given range were prefetched and
+                    none of them was released since.  */
+        bool isPrefetched( const Range& range ) const;
+
+        /*  Queue the leaves of the given range for loading, as long as the
+            resident and the queued data fit into the budget.  */
+        void prefetch( const Range& range, const Leaves& leaves );
+
+        /*  @return the data of the leaf, loaded synchronously if needed.  */
+        DataPtr read( const VertexBufferLeaf* leaf );
+
+        /*  @return true if leaves are queued for loading, false if the
+                    leaves of the current frame exceed the budget.  */
+        bool isLoading() const;
+
+        bool hasColors() const { return _source->hasColors(); }
+        PagingStats getStats() const;
+
+    private:
+        class Loader;
+        typedef std::list< const VertexBufferLeaf* > LeafList;
+
+        struct Entry
+        {
+            DataPtr            data;
+            LeafList::iterator used;
+            size_t             size;
+            uint32_t           frame; // last frame drawing the leaf
+        };
+        struct Request
+        {
+            float    time;  // of the first request
+            uint32_t frame; // last frame missing the leaf, 0 for prefetches
+        };
+        typedef std::unordered_map< const VertexBufferLeaf*, Entry > EntryMap;
+        typedef std::unordered_map< const VertexBufferLeaf*,
+                                    Request > RequestMap;
+        typedef std::unordered_map< const VertexBufferLeaf*,
+                                    unsigned > FailureMap;
+
+        std::unique_ptr< Source > _source;
+        const size_t           _budget;
+
+        mutable lunchbox::Lock _lock;
+        EntryMap    _entries;
+        LeafList    _used;      // most recently used first
+        RequestMap  _requests;  // queued leaves
+        size_t      _queued;    // estimated size of the queued leaves
+        uint32_t    _frame;
+        size_t      _frameBytes; // of the leaves drawn in the current frame
+        uint32_t    _exceeded;   // last frame exceeding the budget
+        FailureMap  _failures;   // number of failed loads of each leaf
+        std::vector< Range > _prefetched;
+        PagingStats _stats;
+        lunchbox::Clock _clock;
+
+        lunchbox::MTQueue< const VertexBufferLeaf* > _queue;
+        std::unique_ptr< Loader > _loader;
+
+        size_t _getSize( const VertexBufferLeaf* leaf ) const;
+        bool _isPrefetched( const Range& range ) const;
+        void _request( const VertexBufferLeaf* leaf, uint32_t frame );
+        void _insert( const VertexBufferLeaf* leaf, DataPtr data );
+    };
+
+    /*  Decodes leaves from a mapped model cache. Leaves with a checksum
+        mismatch are loaded without data.  */
+    class CacheSource : public VertexBufferPager::Source
+    {
+    public:
+        /*  Read from the given cache file, taking its ownership.  */
+        CacheSource( lunchbox::MemoryMap* file, const cache::Header& header );
+
+        VertexBufferPager::Datas load(
+            const VertexBufferPager::Leaves& leaves ) override;
+        bool hasColors() const override { return _colors != 0; }
+
+    private:
+        std::unique_ptr< lunchbox::MemoryMap > _file;
+        const cache::Position* _positions;
+        const cache::Normal*   _normals;
+        const Color*           _colors;
+        const ShortIndex*      _indices;
+
+        VertexBufferPager::DataPtr _load( const VertexBufferLeaf* leaf ) const;
+    };
+}
+
+
+#endif // PLYLIB_VERTEXBUFFERPAGER_H
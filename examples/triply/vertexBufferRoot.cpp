@@ -29,29 +29,57 @@
 
 
 #include "vertexBufferRoot.h"
+#include "vertexBufferLeaf.h"
+#include "vertexBufferPager.h"
 #include "vertexBufferState.h"
 #include "vertexData.h"
+#include <lunchbox/memoryMap.h>
 #include <vmmlib/frustumCuller.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <string>
 #include <sstream>
-#include <fcntl.h>
-#include <sys/types.h>
-#include <sys/stat.h>
-#ifndef _WIN32
-#   include <sys/mman.h>
-#endif
 
 namespace triply
 {
 
 using vmml::FrustumCullerf;
 
-/*  Determine number of bits used by the current architecture.  */
-size_t getArchitectureBits();
-/*  Determine whether the current architecture is little endian or not.  */
-bool isArchitectureLittleEndian();
-/*  Construct architecture dependent file name.  */
-std::string getArchitectureFilename( const std::string& filename );
+/*  Construct the file name of the binary model cache.  */
+std::string getCacheFilename( const std::string& filename );
+
+namespace
+{
+// leaves this far outside of the range of a renderer are paged in ahead
+const float PREFETCH_MARGIN( .05f );
+}
+
+VertexBufferRoot::VertexBufferRoot()
+    : VertexBufferNode()
+    , _invertFaces( false )
+    , _pagingBudget( 0 )
+{}
+
+VertexBufferRoot::~VertexBufferRoot()
+{
+    _pager.reset(); // stop loading before the leaves are deleted
+}
+
+bool VertexBufferRoot::hasColors() const
+{
+    return _pager ? _pager->hasColors() : !_data.colors.empty();
+}
+
+bool VertexBufferRoot::isPaging() const
+{
+    return _pager && _pager->isLoading();
+}
+
+PagingStats VertexBufferRoot::getPagingStats() const
+{
+    return _pager ? _pager->getStats() : PagingStats();
+}
 
 /*  Begin kd-tree setup, go through full range starting with x axis.  */
 void VertexBufferRoot::setupTree( VertexData& data,
@@ -72,6 +100,8 @@ void VertexBufferRoot::setupTree( VertexData& data,
 void VertexBufferRoot::cullDraw( VertexBufferState& state ) const
 {
     _beginRendering( state );
+    if( _pager )
+        _pager->setFrameNumber( state.getFrameNumber( ));
 
 #ifdef LOGCULL
     size_t verticesRendered = 0;
@@ -155,6 +185,8 @@ void VertexBufferRoot::cullDraw( VertexBufferState& state ) const
     }
 
     _endRendering( state );
+    if( _pager )
+        _prefetch( range );
 
 #ifdef LOGCULL
     const size_t verticesTotal = model->getNumberOfVertices();
@@ -165,6 +197,47 @@ void VertexBufferRoot::cullDraw( VertexBufferState& state ) const
 #endif
 }
 
+/*  Queue the leaves around the given range for paging, so that they are
+    resident when a load balancer moves the range boundaries. The range is
+    widened to multiples of the margin. Windows are walked until all their
+    leaves are queued, and again when one of their leaves is released.  */
+void VertexBufferRoot::_prefetch( const Range& range ) const
+{
+    Range window;
+    window[0] = std::max( 0.f, ( std::floor( range[0] / PREFETCH_MARGIN ) -
+                                 1.f ) * PREFETCH_MARGIN );
+    window[1] = std::min( 1.f, ( std::ceil( range[1] / PREFETCH_MARGIN ) +
+                                 1.f ) * PREFETCH_MARGIN );
+    if( _pager->isPrefetched( window ))
+        return;
+
+    VertexBufferPager::Leaves leaves;
+    std::vector< const VertexBufferBase* > candidates( 1, this );
+    while( !candidates.empty( ))
+    {
+        const VertexBufferBase* treeNode = candidates.back();
+        candidates.pop_back();
+
+        if( treeNode->getRange()[0] >= window[1] ||
+            treeNode->getRange()[1] < window[0] )
+        {
+            continue;
+        }
+
+        const VertexBufferBase* left  = treeNode->getLeft();
+        const VertexBufferBase* right = treeNode->getRight();
+        if( !left && !right )
+            leaves.push_back(
+                static_cast< const VertexBufferLeaf* >( treeNode ));
+
+        // visit the leaves in range order
+        if( right )
+            candidates.push_back( right );
+        if( left )
+            candidates.push_back( left );
+    }
+    _pager->prefetch( window, leaves );
+}
 
 /*  Set up the common OpenGL state for rendering of all nodes.  */
 void VertexBufferRoot::_beginRendering( VertexBufferState& state ) const
@@ -218,31 +291,90 @@ void VertexBufferRoot::_endRendering( VertexBufferState& state ) const
 }
 
 
-/*  Determine number of bits used by the current architecture.  */
-size_t getArchitectureBits()
+/*  Construct the file name of the binary model cache.  */
+std::string getCacheFilename( const std::string& filename )
 {
-    return ( sizeof( void* ) * 8 );
+    return filename + ".bin";
 }
 
+namespace
+{
+static_assert( sizeof( cache::Header ) == 104, "Cache header size changed" );
+static_assert( sizeof( cache::Node ) == 88, "Cache node size changed" );
 
-/*  Determine whether the current architecture is little endian or not.  */
-bool isArchitectureLittleEndian()
+/*  Collect the leaves of the given subtree.  */
+void _collectLeaves( VertexBufferBase* node,
+                     std::vector< VertexBufferLeaf* >& leaves )
 {
-    unsigned char test[2] = { 1, 0 };
-    short* x = reinterpret_cast< short* >( test );
-    return ( *x == 1 );
+    if( !node->getLeft() && !node->getRight( ))
+    {
+        leaves.push_back( static_cast< VertexBufferLeaf* >( node ));
+        return;
+    }
+    _collectLeaves( node->getLeft(), leaves );
+    _collectLeaves( node->getRight(), leaves );
 }
 
-
-/*  Construct architecture dependent file name.  */
-std::string getArchitectureFilename( const std::string& filename )
+/*  Read and validate the cache header.  */
+cache::Header _readHeader( const char* start, const size_t size )
 {
-    std::ostringstream oss;
-    oss << filename << ( isArchitectureLittleEndian() ? ".le" : ".be" );
-    oss << getArchitectureBits() << ".bin";
-    return oss.str();
+    cache::Header header;
+    if( size < sizeof( header ))
+        throw MeshException( "Error reading binary file. File too small." );
+    memcpy( &header, start, sizeof( header ));
+
+    if( memcmp( header.magic, cache::MAGIC, sizeof( header.magic )) != 0 )
+        throw MeshException( "Error reading binary file. Not a model cache." );
+    if( header.version != FILE_VERSION )
+        throw MeshException( "Error reading binary file. Version in file "
+                             "does not match the expected version." );
+    if( header.endianness != cache::ENDIANNESS )
+        throw MeshException( "Error reading binary file. File was written on "
+                             "a machine with a different byte order." );
+    if( header.nodeSize != sizeof( cache::Node ) || header.size != size ||
+        header.nNodes > size / sizeof( cache::Node ) ||
+        header.nodes + header.nNodes * sizeof( cache::Node ) > size )
+    {
+        throw MeshException( "Error reading binary file. File is truncated "
+                             "or has an unexpected layout." );
+    }
+
+    cache::Header unsummed = header;
+    unsummed.checksum = 0;
+    const uint64_t checksum =
+        cache::checksum( start + header.nodes,
+                         header.nNodes * sizeof( cache::Node ),
+                         cache::checksum( &unsummed, sizeof( unsummed )));
+    if( checksum != header.checksum )
+        throw MeshException( "Error reading binary file. Checksum mismatch." );
+
+    const bool hasColors = ( header.flags & cache::FLAG_COLORS ) != 0;
+    const uint64_t nVertices = header.nVertices;
+    const uint64_t nIndices = header.nIndices;
+    if( header.positions + nVertices * sizeof( cache::Position ) > size ||
+        header.normals + nVertices * sizeof( cache::Normal ) > size ||
+        ( hasColors && header.colors + nVertices * sizeof( Color ) > size ) ||
+        header.indices + nIndices * sizeof( ShortIndex ) > size )
+    {
+        throw MeshException( "Error reading binary file. Data sections exceed "
+                             "the file size." );
+    }
+    return header;
 }
 
+/*  Pad the stream with zeros up to the given offset, and write the data.  */
+void _writeSection( std::ostream& os, uint64_t& position,
+                    const uint64_t offset, const void* data,
+                    const size_t size )
+{
+    static const char padding[ cache::ALIGNMENT ] = { 0 };
+    if( offset > position )
+        os.write( padding, std::streamsize( offset - position ));
+    if( size > 0 )
+        os.write( static_cast< const char* >( data ), std::streamsize( size ));
+    position = offset + size;
+}
+}
 
 /*  Functions extracted out of readFromFile to enhance readability.  */
 bool VertexBufferRoot::_constructFromPly( const std::string& filename )
@@ -268,111 +400,75 @@ bool VertexBufferRoot::_constructFromPly( const std::string& filename )
     ++progress;
     if( !writeToFile( filename ))
         PLYLIBWARN << "Unable to write binary representation." << std::endl;
+    else if( _pagingBudget > 0 && !_readBinary( getCacheFilename( filename )))
+        PLYLIBWARN << "Unable to page model data, keeping it resident."
+                   << std::endl;
 
     ++progress;
     return true;
 }
 
-bool VertexBufferRoot::_readBinary( std::string filename )
+bool VertexBufferRoot::_readBinary( const std::string& filename )
 {
-#ifdef WIN32
-
-    // replace dir delimiters since '\' is often used as escape char
-    for( size_t i=0; i<filename.length(); ++i )
-        if( filename[i] == '\\' )
-            filename[i] = '/';
-
-    // try to open binary file
-    HANDLE file = CreateFile( filename.c_str(), GENERIC_READ, FILE_SHARE_READ,
-                              0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0 );
-    if( file == INVALID_HANDLE_VALUE )
+    std::unique_ptr< lunchbox::MemoryMap > file( new lunchbox::MemoryMap );
+    const char* addr = static_cast< const char* >( file->map( filename ));
+    if( !addr )
         return false;
 
     PLYLIBINFO << "Reading cached binary representation." << std::endl;
-
-    // create a file mapping
-    HANDLE map = CreateFileMapping( file, 0, PAGE_READONLY, 0, 0,
-                                    filename.c_str( ));
-    CloseHandle( file );
-    if( !map )
+    const bool hasTree = getLeft() != 0; // constructed from the PLY file
+    try
     {
-        PLYLIBERROR << "Unable to read binary file, file mapping failed."
-                  << std::endl;
-        return false;
-    }
-
-    // get a view of the mapping
-    char* addr   = static_cast< char* >( MapViewOfFile( map, FILE_MAP_READ, 0,
-                                                        0, 0 ) );
-    bool  result = false;
-
-    if( addr )
-    {
-        try
-        {
-            fromMemory( addr );
-            result = true;
-        }
-        catch( const std::exception& e )
+        if( _pagingBudget == 0 )
         {
-            PLYLIBERROR << "Unable to read binary file, an exception occured:  "
-                      << e.what() << std::endl;
+            fromMemory( addr, file->getSize( ));
+            return true;
         }
-        UnmapViewOfFile( addr );
+
+        const cache::Header header = _readHeader( addr, file->getSize( ));
+        if( !hasTree )
+            _readTree( addr, header );
+        const std::vector< VertexBufferLeaf* > leaves = _getLeaves( header );
+        _startPaging( new VertexBufferPager(
+                          new CacheSource( file.release(), header ),
+                          _getPagingBudget( )),
+                      leaves );
+        return true;
     }
-    else
+    catch( const std::exception& e )
     {
-        PLYLIBERROR << "Unable to read binary file, memory mapping failed."
-                  << std::endl;
-        return false;
+        PLYLIBERROR << "Unable to read binary file, an exception occured:  "
+                    << e.what() << std::endl;
     }
 
-    CloseHandle( map );
-    return result;
-
-#else
-    // try to open binary file
-    int fd = open( filename.c_str(), O_RDONLY );
-    if( fd < 0 )
-        return false;
-
-    // retrieving file information
-    struct stat status;
-    fstat( fd, &status );
-
-    // create memory mapped file
-    char* addr   = static_cast< char* >( mmap( 0, status.st_size, PROT_READ,
-                                               MAP_SHARED, fd, 0 ) );
-    bool  result = false;
-    if( addr != MAP_FAILED )
-    {
-        try
-        {
-            fromMemory( addr );
-            result = true;
-        }
-        catch( const std::exception& e )
-        {
-            PLYLIBERROR << "Unable to read binary file, an exception occured:  "
-                      << e.what() << std::endl;
-        }
-        munmap( addr, status.st_size );
-    }
-    else
+    // drop the partially read tree, it is rebuilt from the PLY file
+    if( !hasTree )
     {
-        PLYLIBERROR << "Unable to read binary file, memory mapping failed."
-                  << std::endl;
+        clear();
+        _data.clear();
     }
+    return false;
+}
 
-    close( fd );
-    return result;
-#endif
+/*  Page the data of a distributed tree in from the local model cache.  */
+bool VertexBufferRoot::_pageFromCache()
+{
+    PLYLIBASSERT( _pagingBudget > 0 && getLeft( ));
+    return _readBinary( getCacheFilename( _name ));
+}
+
+/*  Page the data of a distributed tree in from its master.  */
+void VertexBufferRoot::_pageFromMaster( VertexBufferPager* pager )
+{
+    std::vector< VertexBufferLeaf* > leaves;
+    _collectLeaves( this, leaves );
+    _startPaging( pager, leaves );
 }
 
 /*  Read binary kd-tree representation, construct from ply if unavailable.  */
 bool VertexBufferRoot::readFromFile( const std::string& filename )
 {
-    if( _readBinary( getArchitectureFilename( filename )))
+    if( _readBinary( getCacheFilename( filename )))
     {
         _name = filename;
         return true;
@@ -388,9 +484,16 @@ bool VertexBufferRoot::readFromFile( const std::string& filename )
 /*  Write binary representation of the kd-tree to file.  */
 bool VertexBufferRoot::writeToFile( const std::string& filename )
 {
+    if( _pager )
+    {
+        PLYLIBERROR << "Unable to write binary file of an out-of-core model."
+                    << std::endl;
+        return false;
+    }
+
     bool result = false;
 
-    std::ofstream output( getArchitectureFilename( filename ).c_str(),
+    std::ofstream output( getCacheFilename( filename ).c_str(),
                           std::ios::out | std::ios::binary );
     if( output )
     {
@@ -417,34 +520,211 @@ bool VertexBufferRoot::writeToFile( const std::string& filename )
 }
 
 
-/*  Read root node from memory and continue with other nodes.  */
-void VertexBufferRoot::fromMemory( char* start )
+/*  Read the cache header and the kd-tree, then decode the vertex data.  */
+void VertexBufferRoot::fromMemory( const char* start, const size_t size )
 {
-    char** addr = &start;
-    size_t version;
-    memRead( reinterpret_cast< char* >( &version ), addr, sizeof( size_t ) );
-    if( version != FILE_VERSION )
-        throw MeshException( "Error reading binary file. Version in file "
-                             "does not match the expected version." );
-    size_t nodeType;
-    memRead( reinterpret_cast< char* >( &nodeType ), addr, sizeof( size_t ) );
-    if( nodeType != ROOT_TYPE )
+    const cache::Header header = _readHeader( start, size );
+    _readTree( start, header );
+    const std::vector< VertexBufferLeaf* > leaves = _getLeaves( header );
+
+    const bool hasColors = ( header.flags & cache::FLAG_COLORS ) != 0;
+    const uint64_t nVertices = header.nVertices;
+    const uint64_t nIndices = header.nIndices;
+    _data.clear();
+    _data.vertices.resize( nVertices );
+    _data.normals.resize( nVertices );
+    if( hasColors )
+        _data.colors.resize( nVertices );
+    _data.indices.resize( nIndices );
+
+    const cache::Position* positions =
+        reinterpret_cast< const cache::Position* >( start + header.positions );
+    const cache::Normal* normals =
+        reinterpret_cast< const cache::Normal* >( start + header.normals );
+    const Color* colors = hasColors ?
+        reinterpret_cast< const Color* >( start + header.colors ) : 0;
+    const ShortIndex* indices =
+        reinterpret_cast< const ShortIndex* >( start + header.indices );
+
+    // positions are relative to the bounding box of their leaf
+    bool valid = true;
+#pragma omp parallel for schedule( dynamic ) reduction( &&: valid )
+    for( ssize_t i = 0; i < ssize_t( leaves.size( )); ++i )
+    {
+        const VertexBufferLeaf* leaf = leaves[i];
+        const Index vertexStart = leaf->_vertexStart;
+        valid = valid && leaf->_checksum == cache::leafChecksum(
+            positions + vertexStart, normals + vertexStart,
+            colors ? colors + vertexStart : 0, leaf->_vertexLength,
+            indices + leaf->_indexStart, leaf->_indexLength );
+        cache::decodePositions( positions + vertexStart,
+                                leaf->_vertexLength, leaf->_boundingBox,
+                                &_data.vertices[ vertexStart ] );
+    }
+    if( !valid )
+        throw MeshException( "Error reading binary file. Checksum mismatch "
+                             "of the leaf data." );
+
+#pragma omp parallel for
+    for( ssize_t i = 0; i < ssize_t( nVertices ); ++i )
+        _data.normals[i] = cache::decodeNormal( normals[i] );
+
+    if( hasColors && nVertices > 0 )
+        memcpy( &_data.colors[0], colors, nVertices * sizeof( Color ));
+    if( nIndices > 0 )
+        memcpy( &_data.indices[0], indices, nIndices * sizeof( ShortIndex ));
+}
+
+
+/*  Read the kd-tree from the node section of the cache.  */
+void VertexBufferRoot::_readTree( const char* start,
+                                  const cache::Header& header )
+{
+    const char* nodes = start + header.nodes;
+    char* addr = const_cast< char* >( nodes );
+    if( cache::peekType( addr ) != NODE_TYPE )
         throw MeshException( "Error reading binary file. Expected the root "
                              "node, but found something else instead." );
-    _data.fromMemory( addr );
-    VertexBufferNode::fromMemory( addr, _data );
+    VertexBufferNode::fromMemory( &addr, _data );
+    if( addr != nodes + header.nNodes * sizeof( cache::Node ))
+        throw MeshException( "Error reading binary file. Node count does not "
+                             "match the kd-tree." );
+}
+
+
+/*  Collect the leaves and check that their data is within the cache.  */
+std::vector< VertexBufferLeaf* > VertexBufferRoot::_getLeaves(
+    const cache::Header& header )
+{
+    std::vector< VertexBufferLeaf* > leaves;
+    _collectLeaves( this, leaves );
+    for( size_t i = 0; i < leaves.size(); ++i )
+    {
+        const VertexBufferLeaf* leaf = leaves[i];
+        if( leaf->_vertexStart + leaf->_vertexLength > header.nVertices ||
+            leaf->_indexStart + leaf->_indexLength > header.nIndices )
+        {
+            throw MeshException( "Error reading binary file. Leaf data "
+                                 "exceeds the data sections." );
+        }
+    }
+    return leaves;
+}
+
+
+/*  @return the memory available to the pager, unlimited if in-core.  */
+size_t VertexBufferRoot::_getPagingBudget() const
+{
+    return _pagingBudget > 0 ? _pagingBudget :
+                               std::numeric_limits< size_t >::max();
+}
+
+/*  Hand the leaves over to a pager and release the resident vertex data.  */
+void VertexBufferRoot::_startPaging(
+    VertexBufferPager* pager, const std::vector< VertexBufferLeaf* >& leaves )
+{
+    _pager.reset( pager );
+    for( size_t i = 0; i < leaves.size(); ++i )
+        leaves[i]->_pager = pager;
+
+    _data = VertexBufferData();
+    if( _pagingBudget > 0 )
+        PLYLIBINFO << "Paging " << leaves.size() << " leaves with a budget of "
+                   << _pagingBudget / 1048576 << " MB" << std::endl;
+    else
+        PLYLIBINFO << "Paging " << leaves.size() << " leaves" << std::endl;
 }
 
 
-/*  Write root node to output stream and continue with other nodes.  */
+/*  Write the cache header, the kd-tree and the encoded vertex data.  */
 void VertexBufferRoot::toStream( std:: ostream& os )
 {
-    size_t version = FILE_VERSION;
-    os.write( reinterpret_cast< char* >( &version ), sizeof( size_t ) );
-    size_t nodeType = ROOT_TYPE;
-    os.write( reinterpret_cast< char* >( &nodeType ), sizeof( size_t ) );
-    _data.toStream( os );
-    VertexBufferNode::toStream( os );
+    const uint64_t nVertices = _data.vertices.size();
+    const uint64_t nIndices = _data.indices.size();
+    const bool hasColors = !_data.colors.empty();
+
+    // quantize the positions relative to the bounding box of their leaf
+    std::vector< VertexBufferLeaf* > leaves;
+    _collectLeaves( this, leaves );
+    std::vector< cache::Position > positions( nVertices );
+#pragma omp parallel for schedule( dynamic )
+    for( ssize_t i = 0; i < ssize_t( leaves.size( )); ++i )
+    {
+        const VertexBufferLeaf* leaf = leaves[i];
+        const BoundingBox& box = leaf->_boundingBox;
+        const Vertex extent = box[1] - box[0];
+
+        for( Index j = leaf->_vertexStart;
+             j < leaf->_vertexStart + leaf->_vertexLength; ++j )
+        {
+            for( size_t k = 0; k < 3; ++k )
+            {
+                const float value = extent[k] > 0.f ?
+                    ( _data.vertices[j][k] - box[0][k] ) / extent[k] : 0.f;
+                const float clamped = std::min( std::max( value, 0.f ), 1.f );
+                positions[j][k] = uint16_t( clamped * 65535.f + .5f );
+            }
+        }
+    }
+
+    std::vector< cache::Normal > normals( nVertices );
+#pragma omp parallel for
+    for( ssize_t i = 0; i < ssize_t( nVertices ); ++i )
+        normals[i] = cache::encodeNormal( _data.normals[i] );
+
+    // the leaf checksums are written with the nodes
+#pragma omp parallel for schedule( dynamic )
+    for( ssize_t i = 0; i < ssize_t( leaves.size( )); ++i )
+    {
+        VertexBufferLeaf* leaf = leaves[i];
+        const Index vertexStart = leaf->_vertexStart;
+        leaf->_checksum = cache::leafChecksum(
+            positions.data() + vertexStart, normals.data() + vertexStart,
+            hasColors ? _data.colors.data() + vertexStart : 0,
+            leaf->_vertexLength, _data.indices.data() + leaf->_indexStart,
+            leaf->_indexLength );
+    }
+
+    std::ostringstream tree;
+    VertexBufferNode::toStream( tree );
+    const std::string nodes = tree.str();
+
+    cache::Header header;
+    memset( &header, 0, sizeof( header ));
+    memcpy( header.magic, cache::MAGIC, sizeof( header.magic ));
+    header.version = FILE_VERSION;
+    header.endianness = cache::ENDIANNESS;
+    header.flags = hasColors ? cache::FLAG_COLORS : 0;
+    header.nodeSize = sizeof( cache::Node );
+    header.nNodes = nodes.size() / sizeof( cache::Node );
+    header.nVertices = nVertices;
+    header.nIndices = nIndices;
+    header.nodes = cache::align( sizeof( header ));
+    header.positions = cache::align( header.nodes + nodes.size( ));
+    header.normals = cache::align( header.positions +
+                                   nVertices * sizeof( cache::Position ));
+    header.colors = cache::align( header.normals +
+                                  nVertices * sizeof( cache::Normal ));
+    header.indices = cache::align( header.colors +
+                                   ( hasColors ? nVertices * sizeof( Color ) :
+                                                 0 ));
+    header.size = header.indices + nIndices * sizeof( ShortIndex );
+    header.checksum = cache::checksum( nodes.data(), nodes.size(),
+                                       cache::checksum( &header,
+                                                        sizeof( header )));
+
+    uint64_t position = 0;
+    _writeSection( os, position, 0, &header, sizeof( header ));
+    _writeSection( os, position, header.nodes, nodes.data(), nodes.size( ));
+    _writeSection( os, position, header.positions, positions.data(),
+                   positions.size() * sizeof( cache::Position ));
+    _writeSection( os, position, header.normals, normals.data(),
+                   normals.size() * sizeof( cache::Normal ));
+    if( hasColors )
+        _writeSection( os, position, header.colors, _data.colors.data(),
+                       nVertices * sizeof( Color ));
+    _writeSection( os, position, header.indices, _data.indices.data(),
+                   nIndices * sizeof( ShortIndex ));
 }
 
 }
@@ -34,6 +34,8 @@
 #include <triply/api.h>
 #include "vertexBufferData.h"
 #include "vertexBufferNode.h"
+#include <memory>
+#include <vector>
 
 namespace triply
 {
@@ -41,7 +43,8 @@ namespace triply
 class VertexBufferRoot : public VertexBufferNode
 {
 public:
-    TRIPLY_API VertexBufferRoot() : VertexBufferNode(), _invertFaces(false) {}
+    TRIPLY_API VertexBufferRoot();
+    TRIPLY_API virtual ~VertexBufferRoot();
 
     TRIPLY_API virtual void cullDraw( VertexBufferState& state ) const;
     TRIPLY_API virtual void draw( VertexBufferState& state ) const;
@@ -49,19 +52,39 @@ public:
     TRIPLY_API void setupTree( VertexData& data, boost::progress_display&  );
     TRIPLY_API bool writeToFile( const std::string& filename );
     TRIPLY_API bool readFromFile( const std::string& filename );
-    bool hasColors() const { return !_data.colors.empty(); }
+    TRIPLY_API bool hasColors() const;
 
     void useInvertedFaces() { _invertFaces = true; }
 
+    /*  Keep only the kd-tree resident and page the leaf data in on demand
+        from the model cache, using at most the given memory. Call before
+        readFromFile.  */
+    void useOutOfCore( const size_t budget ) { _pagingBudget = budget; }
+
+    /*  @return true if the leaf data is paged in, from the model cache or
+                from the master of a distributed model.  */
+    bool isOutOfCore() const { return _pager.get() != 0; }
+    TRIPLY_API bool isPaging() const;
+    TRIPLY_API PagingStats getPagingStats() const;
+
     const std::string& getName() const { return _name; }
 
 protected:
-    TRIPLY_API virtual void toStream( std::ostream& os );
-    TRIPLY_API virtual void fromMemory( char* start );
+    TRIPLY_API void toStream( std::ostream& os ) override;
+    TRIPLY_API virtual void fromMemory( const char* start, size_t size );
 
 private:
     bool _constructFromPly( const std::string& filename );
-    bool _readBinary( std::string filename );
+    bool _readBinary( const std::string& filename );
+    bool _pageFromCache();
+    void _pageFromMaster( VertexBufferPager* pager );
+    void _readTree( const char* start, const cache::Header& header );
+    std::vector< VertexBufferLeaf* > _getLeaves(
+        const cache::Header& header );
+    size_t _getPagingBudget() const;
+    void _startPaging( VertexBufferPager* pager,
+                       const std::vector< VertexBufferLeaf* >& leaves );
+    void _prefetch( const Range& range ) const;
 
     void _beginRendering( VertexBufferState& state ) const;
     void _endRendering( VertexBufferState& state ) const;
@@ -70,6 +93,8 @@ private:
     VertexBufferData _data;
     bool             _invertFaces;
     std::string      _name;
+    size_t           _pagingBudget;
+    std::unique_ptr< VertexBufferPager > _pager;
 };
 }
 
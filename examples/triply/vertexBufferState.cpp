@@ -28,14 +28,17 @@
 
 
 #include "vertexBufferState.h"
+#include "vertexBufferLeaf.h"
 
 namespace triply
 {
 VertexBufferState::VertexBufferState( const GLEWContext* glewContext )
-        : _glewContext( glewContext )
+        : _frameNumber( 0 )
+        , _glewContext( glewContext )
         , _renderMode( RENDER_MODE_DISPLAY_LIST )
         , _useColors( false )
         , _useFrustumCulling( true )
+        , _objectBudget( 0 )
 {
     _range[0] = 0.f;
     _range[1] = 1.f;
@@ -112,6 +115,65 @@ Vector4f VertexBufferState::getRegion() const
     return _region;
 }
 
+void VertexBufferState::addObjects( const VertexBufferLeaf* leaf,
+                                    const size_t size )
+{
+    ++_objectStats.misses;
+    ++_objectStats.loads;
+
+    const ObjectType type = getRenderMode() == RENDER_MODE_BUFFER_OBJECT ?
+                             OBJECTS_BUFFERS :
+                             useColors() ? OBJECTS_COLOR_LIST : OBJECTS_LIST;
+    ObjectMap::iterator i = _objects.find( leaf );
+    if( i == _objects.end( ))
+    {
+        _usedObjects.push_front( leaf );
+        Objects objects = { _usedObjects.begin(), 0, { 0 }};
+        i = _objects.insert( std::make_pair( leaf, objects )).first;
+    }
+    else
+        _usedObjects.splice( _usedObjects.begin(), _usedObjects,
+                             i->second.used );
+
+    // objects of a type tracked already were deleted by a state sharing them
+    Objects& objects = i->second;
+    _objectStats.bytes -= objects.sizes[ type ];
+    objects.size -= objects.sizes[ type ];
+    objects.sizes[ type ] = size;
+    objects.size += size;
+    _objectStats.bytes += size;
+
+    if( _objectBudget == 0 )
+        return;
+
+    while( _objectStats.bytes > _objectBudget && _usedObjects.size() > 1 )
+    {
+        const VertexBufferLeaf* evicted = _usedObjects.back();
+        i = _objects.find( evicted );
+        _objectStats.bytes -= i->second.size;
+        ++_objectStats.evictions;
+        _objects.erase( i );
+        _usedObjects.pop_back();
+        evicted->releaseRendering( *this );
+    }
+}
+
+void VertexBufferState::useObjects( const VertexBufferLeaf* leaf )
+{
+    ++_objectStats.hits;
+    ObjectMap::iterator i = _objects.find( leaf );
+    if( i != _objects.end( ))
+        _usedObjects.splice( _usedObjects.begin(), _usedObjects,
+                             i->second.used );
+}
+
+void VertexBufferState::resetObjects()
+{
+    _objects.clear();
+    _usedObjects.clear();
+    _objectStats.bytes = 0;
+}
+
 GLuint VertexBufferStateSimple::getDisplayList( const void* key )
 {
     if( _displayLists.find( key ) == _displayLists.end() )
@@ -140,6 +202,26 @@ GLuint VertexBufferStateSimple::newBufferObject( const void* key )
     return _bufferObjects[key];
 }
 
+void VertexBufferStateSimple::deleteDisplayList( const void* key )
+{
+    GLMap::iterator i = _displayLists.find( key );
+    if( i == _displayLists.end( ))
+        return;
+
+    glDeleteLists( i->second, 1 );
+    _displayLists.erase( i );
+}
+
+void VertexBufferStateSimple::deleteBufferObject( const void* key )
+{
+    GLMap::iterator i = _bufferObjects.find( key );
+    if( i == _bufferObjects.end( ))
+        return;
+
+    glDeleteBuffers( 1, &i->second );
+    _bufferObjects.erase( i );
+}
+
 void VertexBufferStateSimple::deleteAll()
 {
     for( GLMapCIter i = _displayLists.begin(); i != _displayLists.end(); ++i )
@@ -150,6 +232,7 @@ void VertexBufferStateSimple::deleteAll()
 
     _displayLists.clear();
     _bufferObjects.clear();
+    resetObjects();
 }
 
 }
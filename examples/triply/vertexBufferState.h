@@ -33,7 +33,9 @@
 
 #include <triply/api.h>
 #include "typedefs.h"
+#include <list>
 #include <map>
+#include <unordered_map>
 
 namespace triply
 {
@@ -63,6 +65,11 @@ public:
     TRIPLY_API void setRange( const Range& range ) { _range = range; }
     TRIPLY_API const Range& getRange() const { return _range; }
 
+    /*  The frame drawn, protects its leaves from paging, 0 if unknown.  */
+    TRIPLY_API void setFrameNumber( const uint32_t frame )
+        { _frameNumber = frame; }
+    TRIPLY_API uint32_t getFrameNumber() const { return _frameNumber; }
+
     TRIPLY_API void resetRegion();
     TRIPLY_API void updateRegion( const BoundingBox& box );
     TRIPLY_API virtual void declareRegion( const Vector4f& ) {}
@@ -72,8 +79,23 @@ public:
     TRIPLY_API virtual GLuint newDisplayList( const void* key ) = 0;
     TRIPLY_API virtual GLuint getBufferObject( const void* key ) = 0;
     TRIPLY_API virtual GLuint newBufferObject( const void* key ) = 0;
+    TRIPLY_API virtual void deleteDisplayList( const void* key ) = 0;
+    TRIPLY_API virtual void deleteBufferObject( const void* key ) = 0;
     TRIPLY_API virtual void deleteAll() = 0;
 
+    /*  Limit the memory of the leaf GL objects, 0 for no limit.  */
+    TRIPLY_API void setObjectBudget( const size_t bytes )
+        { _objectBudget = bytes; }
+    TRIPLY_API const PagingStats& getObjectStats() const
+        { return _objectStats; }
+
+    /*  Track the GL objects created for a leaf, releasing the least recently
+        used ones when exceeding the budget. Objects created again replace
+        the tracked ones, they were released through another state sharing
+        the GL objects.  */
+    TRIPLY_API void addObjects( const VertexBufferLeaf* leaf, size_t size );
+    TRIPLY_API void useObjects( const VertexBufferLeaf* leaf );
+
     TRIPLY_API const GLEWContext* glewGetContext() const
         { return _glewContext; }
 
@@ -83,13 +105,37 @@ protected:
 
     Matrix4f      _pmvMatrix; //!< projection * modelView matrix
     Range         _range; //!< normalized [0,1] part of the model to draw
+    uint32_t      _frameNumber;
     const GLEWContext* const _glewContext;
     RenderMode    _renderMode;
     Vector4f      _region; //!< normalized x1 y1 x2 y2 region from cullDraw
     bool          _useColors;
     bool          _useFrustumCulling;
 
+    /*  Forget the tracked leaf GL objects, to be called by deleteAll().  */
+    TRIPLY_API void resetObjects();
+
 private:
+    typedef std::list< const VertexBufferLeaf* > LeafList;
+    enum ObjectType // the GL objects of a leaf created by draw()
+    {
+        OBJECTS_LIST,
+        OBJECTS_COLOR_LIST,
+        OBJECTS_BUFFERS,
+        OBJECTS_ALL // must be last
+    };
+    struct Objects
+    {
+        LeafList::iterator used;
+        size_t             size;
+        size_t             sizes[ OBJECTS_ALL ];
+    };
+    typedef std::unordered_map< const VertexBufferLeaf*, Objects > ObjectMap;
+
+    size_t        _objectBudget;
+    PagingStats   _objectStats;
+    ObjectMap     _objects;
+    LeafList      _usedObjects; //!< most recently used first
 };
 
 
@@ -108,6 +154,8 @@ public:
     TRIPLY_API virtual GLuint newDisplayList( const void* key );
     TRIPLY_API virtual GLuint getBufferObject( const void* key );
     TRIPLY_API virtual GLuint newBufferObject( const void* key );
+    TRIPLY_API virtual void deleteDisplayList( const void* key );
+    TRIPLY_API virtual void deleteBufferObject( const void* key );
     TRIPLY_API virtual void deleteAll();
 
 private:
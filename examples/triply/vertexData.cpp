@@ -29,6 +29,7 @@
 
 #include "vertexData.h"
 #include "ply.h"
+#include "plyReader.h"
 
 #include <cstdlib>
 #include <algorithm>
@@ -36,8 +37,10 @@
 #if (( __GNUC__ > 4 ) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 4)) )
 #  include <parallel/algorithm>
 using __gnu_parallel::sort;
+using __gnu_parallel::nth_element;
 #else
 using std::sort;
+using std::nth_element;
 #endif
 
 using namespace triply;
@@ -148,6 +151,31 @@ void VertexData::readTriangles( PlyFile* file, const int nFaces )
 /*  Open a PLY file and read vertex, color and index data.  */
 bool VertexData::readPlyFile( const std::string& filename )
 {
+    {
+        // decode common layouts from the mapped file in parallel
+        const PlyReader reader( filename );
+        if( reader.isSupported( ))
+        {
+            try
+            {
+                if( reader.read( *this, _invertFaces ))
+                    return true;
+
+                PLYLIBINFO << "PLY data does not match its header, using "
+                           << "generic PLY parser." << std::endl;
+                vertices.clear();
+                colors.clear();
+                triangles.clear();
+            }
+            catch( const std::exception& e )
+            {
+                PLYLIBERROR << "Unable to read PLY file, an exception "
+                            << "occured:  " << e.what() << std::endl;
+                return false;
+            }
+        }
+    }
+
     int     nPlyElems;
     char**  elemNames;
     int     fileType;
@@ -408,3 +436,18 @@ void VertexData::sort( const Index start, const Index length, const Axis axis )
     ::sort( triangles.begin() + start, triangles.begin() + start + length,
             _TriangleSort( *this, axis ) );
 }
+
+
+/*  Partition the index data from start to start + length at its median along
+    the given axis, without sorting the two halves.  */
+void VertexData::partition( const Index start, const Index length,
+                            const Axis axis )
+{
+    PLYLIBASSERT( length > 0 );
+    PLYLIBASSERT( start + length <= triangles.size() );
+
+    ::nth_element( triangles.begin() + start,
+                   triangles.begin() + start + length / 2,
+                   triangles.begin() + start + length,
+                   _TriangleSort( *this, axis ) );
+}
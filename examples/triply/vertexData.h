@@ -49,6 +49,8 @@ namespace triply
 
         TRIPLY_API bool readPlyFile( const std::string& file );
         TRIPLY_API void sort( const Index start, const Index length, const Axis axis );
+        TRIPLY_API void partition( const Index start, const Index length,
+                                   const Axis axis );
         TRIPLY_API void scale( const float baseSize = 2.0f );
         TRIPLY_API void calculateNormals();
         TRIPLY_API void calculateBoundingBox();
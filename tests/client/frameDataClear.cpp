@@ -0,0 +1,97 @@
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests that images referencing their pixels in a received command release the
+// command when the frame data is cleared, and not only when the recycled images
+// are reused.
+
+#include <lunchbox/test.h>
+
+#include <eq/frameData.h>
+#include <eq/image.h>
+#include <eq/init.h>
+#include <eq/nodeFactory.h>
+#include <eq/pixelData.h>
+#include <pression/plugins/compressor.h>
+
+#include <co/buffer.h>
+#include <co/bufferCache.h>
+#include <co/commands.h>
+#include <co/iCommand.h>
+
+namespace
+{
+const eq::PixelViewport pvp( 0, 0, 64, 32 );
+const uint64_t headerSize = sizeof( uint64_t ) + 2 * sizeof( uint32_t );
+
+/** @return a received command carrying the RGBA pixels of the viewport. */
+co::BufferPtr _newCommandBuffer( co::BufferCache& cache )
+{
+    const uint64_t size = headerSize + pvp.getArea() * 4;
+    co::BufferPtr buffer = cache.alloc( size );
+    buffer->resize( size );
+
+    uint8_t* data = buffer->getData();
+    *reinterpret_cast< uint64_t* >( data ) = size;
+    data += sizeof( uint64_t );
+    *reinterpret_cast< uint32_t* >( data ) = co::COMMANDTYPE_NODE;
+    data += sizeof( uint32_t );
+    *reinterpret_cast< uint32_t* >( data ) = co::CMD_NODE_CUSTOM;
+    return buffer;
+}
+}
+
+int main( int argc, char **argv )
+{
+    eq::NodeFactory nodeFactory;
+    TEST( eq::init( argc, argv, &nodeFactory ));
+
+    co::BufferCache cache( 1 );
+    co::BufferPtr buffer = _newCommandBuffer( cache );
+    const int32_t refCount = buffer->getRefCount();
+
+    eq::FrameDataPtr frameData = new eq::FrameData;
+    eq::Image* image = frameData->newImage( eq::Frame::TYPE_MEMORY,
+                                            eq::DrawableConfig( ));
+    image->setPixelViewport( pvp );
+    {
+        const co::ICommand command( 0, 0, buffer, false );
+        TEST( command.isValid( ));
+
+        eq::PixelData pixels;
+        pixels.internalFormat = EQ_COMPRESSOR_DATATYPE_RGBA;
+        pixels.externalFormat = EQ_COMPRESSOR_DATATYPE_RGBA;
+        pixels.pixelSize = 4;
+        pixels.pvp = pvp;
+        pixels.pixels = buffer->getData() + headerSize;
+        image->setPixelData( eq::Frame::BUFFER_COLOR, pixels, command );
+        TEST( image->getPixelPointer( eq::Frame::BUFFER_COLOR ) ==
+              pixels.pixels );
+    }
+    TESTINFO( buffer->getRefCount() == refCount + 1,
+              buffer->getRefCount() << " references" );
+
+    frameData->clear();
+    TEST( frameData->getImages().empty( ));
+    TESTINFO( buffer->getRefCount() == refCount,
+              buffer->getRefCount() << " references" );
+
+    frameData->flush();
+    frameData = 0;
+    buffer = 0;
+    TEST( eq::exit( ));
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,75 @@
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests that images compressed in concurrent row bands decompress to the
+// original pixel data.
+
+#include <lunchbox/test.h>
+
+#include <eq/image.h>
+#include <eq/init.h>
+#include <eq/nodeFactory.h>
+#include <eq/pixelData.h>
+#include <pression/plugins/compressor.h>
+
+#include <cstring>
+
+int main( int argc, char **argv )
+{
+    eq::NodeFactory nodeFactory;
+    TEST( eq::init( argc, argv, &nodeFactory ));
+
+    const eq::Frame::Buffer buffer = eq::Frame::BUFFER_COLOR;
+    eq::Image image;
+    TEST( image.readImage( "images/teapot.rgb", buffer ));
+    image.useCompressor( buffer, EQ_COMPRESSOR_RLE_4_BYTE );
+
+    const eq::PixelViewport& pvp = image.getPixelViewport();
+    const uint8_t* pixels = image.getPixelPointer( buffer );
+    const size_t rowSize = pvp.w * image.getPixelSize( buffer );
+    const size_t nBandsList[] = { 1, 2, 7, 16 };
+
+    for( const size_t nBands : nBandsList )
+    {
+        std::vector< const eq::PixelData* > bands( nBands );
+#pragma omp parallel for
+        for( int64_t i = 0; i < int64_t( nBands ); ++i )
+            bands[i] = &image.compressPixelData( buffer, size_t( i ), nBands );
+
+        int32_t y = pvp.y;
+        for( size_t i = 0; i < nBands; ++i )
+        {
+            const eq::PixelData& band = *bands[i];
+            TESTINFO( band.pvp.x == pvp.x && band.pvp.w == pvp.w &&
+                      band.pvp.y == y, band.pvp << " in " << pvp );
+            TEST( band.compressedData.isCompressed( ));
+            y += band.pvp.h;
+
+            eq::Image decoded;
+            decoded.setPixelViewport( band.pvp );
+            decoded.setPixelData( buffer, band );
+            TEST( decoded.getPixelDataSize( buffer ) == band.pvp.h * rowSize );
+            TESTINFO( memcmp( decoded.getPixelPointer( buffer ),
+                              pixels + ( band.pvp.y - pvp.y ) * rowSize,
+                              band.pvp.h * rowSize ) == 0,
+                      "band " << i << " of " << nBands );
+        }
+        TEST( y == pvp.getYEnd( ));
+    }
+
+    TEST( eq::exit( ));
+    return EXIT_SUCCESS;
+}
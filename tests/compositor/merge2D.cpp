@@ -0,0 +1,135 @@
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests the CPU 2D compositing of tiles, which only clears the reused result
+// image if the tiles do not cover it.
+
+#include <lunchbox/test.h>
+
+#include <eq/compositor.h>
+#include <eq/image.h>
+#include <eq/imageOp.h>
+#include <eq/init.h>
+#include <eq/nodeFactory.h>
+#include <eq/pixelData.h>
+#include <pression/plugins/compressor.h>
+
+#include <lunchbox/rng.h>
+
+#include <cstring>
+#include <vector>
+
+namespace
+{
+// Covers [0,0]x[100,60] with a gap-free, partially overlapping tiling
+const size_t nImages = 4;
+const eq::PixelViewport pvps[ nImages ] = {
+    eq::PixelViewport( 0, 0, 60, 30 ),
+    eq::PixelViewport( 50, 0, 50, 35 ),
+    eq::PixelViewport( 0, 30, 51, 30 ),
+    eq::PixelViewport( 51, 35, 49, 25 )
+};
+
+eq::ImageOps _getOps( eq::Image* images, const size_t nOps )
+{
+    eq::ImageOps ops;
+    for( size_t i = 0; i < nOps; ++i )
+    {
+        eq::ImageOp op;
+        op.image = &images[i];
+        op.buffers = eq::Frame::BUFFER_COLOR;
+        ops.push_back( op );
+    }
+    return ops;
+}
+
+// The color of the destination pixel, merging the first nOps images in order
+uint32_t _getColor( const std::vector< uint32_t >* colors, const size_t nOps,
+                    const int32_t x, const int32_t y )
+{
+    const uint8_t background[4] = { 0, 0, 0, 255 };
+    uint32_t color;
+    memcpy( &color, background, 4 );
+
+    for( size_t i = 0; i < nOps; ++i )
+    {
+        const eq::PixelViewport& pvp = pvps[ i ];
+        if( x >= pvp.x && x < pvp.getXEnd() && y >= pvp.y &&
+            y < pvp.getYEnd( ))
+        {
+            color = colors[i][ ( y - pvp.y ) * pvp.w + x - pvp.x ];
+        }
+    }
+    return color;
+}
+
+void _test( eq::Image* images, const std::vector< uint32_t >* colors,
+            const size_t nOps )
+{
+    const eq::Image* result =
+        eq::Compositor::mergeImagesCPU( _getOps( images, nOps ), false );
+    TEST( result );
+    TEST( !result->hasPixelData( eq::Frame::BUFFER_DEPTH ));
+
+    const eq::PixelViewport& pvp = result->getPixelViewport();
+    const uint32_t* data = reinterpret_cast< const uint32_t* >(
+        result->getPixelPointer( eq::Frame::BUFFER_COLOR ));
+    for( int32_t y = 0; y < pvp.h; ++y )
+        for( int32_t x = 0; x < pvp.w; ++x )
+            TESTINFO( data[ y * pvp.w + x ] ==
+                      _getColor( colors, nOps, x + pvp.x, y + pvp.y ),
+                      nOps << " images, pixel " << x << ", " << y );
+}
+}
+
+int main( int argc, char** argv )
+{
+    eq::NodeFactory nodeFactory;
+    TEST( eq::init( argc, argv, &nodeFactory ));
+
+    lunchbox::RNG rng;
+    eq::Image images[ nImages ];
+    std::vector< uint32_t > colors[ nImages ];
+
+    for( size_t i = 0; i < nImages; ++i )
+    {
+        const eq::PixelViewport& pvp = pvps[ i ];
+        colors[i].resize( pvp.getArea( ));
+        for( uint32_t& color : colors[i] )
+            color = rng.get< uint32_t >();
+
+        eq::PixelData data;
+        data.internalFormat = EQ_COMPRESSOR_DATATYPE_RGBA;
+        data.externalFormat = EQ_COMPRESSOR_DATATYPE_RGBA;
+        data.pixelSize = 4;
+        data.pvp = pvp;
+        data.pixels = colors[i].data();
+
+        images[i].setPixelViewport( pvp );
+        images[i].setPixelData( eq::Frame::BUFFER_COLOR, data );
+        TEST( images[i].hasPixelData( eq::Frame::BUFFER_COLOR ));
+    }
+
+    // covered destination, merged without clearing
+    _test( images, colors, nImages );
+
+    // uncovered pixels of the reused result image have to be cleared
+    _test( images, colors, 3 );
+    _test( images, colors, nImages );
+
+    TEST( eq::exit( ));
+    return EXIT_SUCCESS;
+}
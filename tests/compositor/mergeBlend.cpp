@@ -0,0 +1,197 @@
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests that the CPU alpha-blending is bit-exact with the scalar reference
+// implementation for 8 bit and float RGBA images, and within the rounding error
+// for half float RGBA images.
+
+#include <lunchbox/test.h>
+
+#include <eq/compositor.h>
+#include <eq/image.h>
+#include <eq/imageOp.h>
+#include <eq/init.h>
+#include <eq/nodeFactory.h>
+#include <eq/pixelData.h>
+#include <pression/plugins/compressor.h>
+
+#include <lunchbox/rng.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+const size_t nImages = 4;
+const eq::PixelViewport pvps[ nImages ] = {
+    eq::PixelViewport( 0, 0, 333, 201 ),
+    eq::PixelViewport( 17, 5, 300, 190 ),
+    eq::PixelViewport( 3, 40, 329, 150 ),
+    eq::PixelViewport( 100, 7, 15, 97 )
+};
+
+// half floats are stored as uint16_t, rounded to nearest even
+uint16_t _toHalf( const float value )
+{
+    uint32_t bits;
+    memcpy( &bits, &value, sizeof( bits ));
+    const uint16_t sign = uint16_t(( bits >> 16 ) & 0x8000 );
+    const float magnitude = std::abs( value );
+    if( magnitude < 6.103515625e-05f ) // denormal, steps of 2^-24
+        return sign | uint16_t( std::nearbyint( magnitude * 16777216.f ));
+
+    const uint32_t rounded = ( bits & 0x7fffffff ) + 0xfff +
+                             (( bits >> 13 ) & 1 );
+    return sign | uint16_t(( rounded >> 13 ) - ( 112 << 10 ));
+}
+
+float _toFloat( const uint16_t half )
+{
+    const float sign = ( half & 0x8000 ) ? -1.f : 1.f;
+    const int exponent = ( half >> 10 ) & 0x1f;
+    const int mantissa = half & 0x3ff;
+    if( exponent == 0 )
+        return sign * std::ldexp( float( mantissa ), -24 );
+    return sign * std::ldexp( float( mantissa | 0x400 ), exponent - 25 );
+}
+
+template< typename T >
+void _blend( T* dst, const T* src );
+
+template<> void _blend( uint8_t* dst, const uint8_t* src )
+{
+    dst[0] = LB_MIN( src[0] + (src[3]*dst[0] >> 8), 255 );
+    dst[1] = LB_MIN( src[1] + (src[3]*dst[1] >> 8), 255 );
+    dst[2] = LB_MIN( src[2] + (src[3]*dst[2] >> 8), 255 );
+    dst[3] =                   src[3]*dst[3] >> 8;
+}
+
+template<> void _blend( float* dst, const float* src )
+{
+    dst[0] = src[0] + src[3] * dst[0];
+    dst[1] = src[1] + src[3] * dst[1];
+    dst[2] = src[2] + src[3] * dst[2];
+    dst[3] =          src[3] * dst[3];
+}
+
+template<> void _blend( uint16_t* dst, const uint16_t* src )
+{
+    const float alpha = _toFloat( src[3] );
+    for( size_t i = 0; i < 3; ++i )
+        dst[i] = _toHalf( _toFloat( src[i] ) + alpha * _toFloat( dst[i] ));
+    dst[3] = _toHalf( alpha * _toFloat( dst[3] ));
+}
+
+uint8_t _random( lunchbox::RNG& rng, uint8_t ) { return rng.get< uint8_t >(); }
+float _random( lunchbox::RNG& rng, float )
+    { return float( rng.get< uint16_t >( )) / 65535.f; }
+uint16_t _random( lunchbox::RNG& rng, uint16_t )
+    { return _toHalf( _random( rng, float( ))); }
+
+bool _isEqual( const uint8_t a, const uint8_t b ) { return a == b; }
+bool _isEqual( const float a, const float b ) { return a == b; }
+
+// The compositor rounds ties differently, the error propagates through the
+// layers. Positive halves are ordered like their bit patterns.
+bool _isEqual( const uint16_t a, const uint16_t b )
+    { return std::abs( int( a ) - int( b )) <= 2; }
+
+template< typename T >
+void _testBlend( const uint32_t format, const T opaque )
+{
+    lunchbox::RNG rng;
+    eq::Image images[ nImages ];
+    std::vector< T > colors[ nImages ];
+    eq::ImageOps ops;
+    eq::PixelViewport destPVP;
+
+    for( size_t i = 0; i < nImages; ++i )
+    {
+        const eq::PixelViewport& pvp = pvps[ i ];
+        colors[i].resize( pvp.getArea() * 4 );
+        for( T& value : colors[i] )
+            value = _random( rng, T( ));
+
+        eq::PixelData data;
+        data.internalFormat = format;
+        data.externalFormat = format;
+        data.pixelSize = 4 * sizeof( T );
+        data.pvp = pvp;
+        data.pixels = colors[i].data();
+
+        images[i].setPixelViewport( pvp );
+        images[i].setPixelData( eq::Frame::BUFFER_COLOR, data );
+        TEST( images[i].hasPixelData( eq::Frame::BUFFER_COLOR ));
+        TEST( images[i].hasAlpha( ));
+
+        eq::ImageOp op;
+        op.image = &images[i];
+        op.buffers = eq::Frame::BUFFER_COLOR;
+        ops.push_back( op );
+        destPVP.merge( pvp );
+    }
+
+    // scalar reference, background is opaque black
+    std::vector< T > reference( destPVP.getArea() * 4, T( 0 ));
+    for( size_t i = 3; i < reference.size(); i += 4 )
+        reference[i] = opaque;
+
+    for( size_t i = 0; i < nImages; ++i )
+    {
+        const eq::PixelViewport& pvp = pvps[ i ];
+        for( int32_t y = 0; y < pvp.h; ++y )
+        {
+            for( int32_t x = 0; x < pvp.w; ++x )
+            {
+                const size_t src = y * pvp.w + x;
+                const size_t dst = ( pvp.y - destPVP.y + y ) * destPVP.w +
+                                   pvp.x - destPVP.x + x;
+                _blend( &reference[ dst * 4 ], &colors[i][ src * 4 ] );
+            }
+        }
+    }
+
+    const eq::Image* result = eq::Compositor::mergeImagesCPU( ops, true );
+    TEST( result );
+    TESTINFO( result->getPixelViewport() == destPVP,
+              result->getPixelViewport() << " != " << destPVP );
+    TEST( result->getPixelDataSize( eq::Frame::BUFFER_COLOR ) ==
+          reference.size() * sizeof( T ));
+
+    const T* pixels = reinterpret_cast< const T* >(
+        result->getPixelPointer( eq::Frame::BUFFER_COLOR ));
+    for( size_t i = 0; i < reference.size(); ++i )
+        TESTINFO( _isEqual( pixels[i], reference[i] ),
+                  "value " << i << ": " << double( pixels[i] ) << " != "
+                  << double( reference[i] ));
+}
+}
+
+int main( int argc, char** argv )
+{
+    eq::NodeFactory nodeFactory;
+    TEST( eq::init( argc, argv, &nodeFactory ));
+
+    _testBlend< uint8_t >( EQ_COMPRESSOR_DATATYPE_RGBA, 255 );
+    _testBlend< uint8_t >( EQ_COMPRESSOR_DATATYPE_BGRA, 255 );
+    _testBlend< float >( EQ_COMPRESSOR_DATATYPE_RGBA32F, 1.f );
+    _testBlend< uint16_t >( EQ_COMPRESSOR_DATATYPE_RGBA16F, _toHalf( 1.f ));
+
+    TEST( eq::exit( ));
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,232 @@
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests that the CPU depth compositing is bit-exact with the scalar reference
+// implementation, using images with odd widths and overlapping viewports, with
+// and without foreground spans. Each depth-merge kernel supported by the CPU is
+// compared against the scalar kernel.
+
+#include <lunchbox/test.h>
+
+#include <eq/compositor.h>
+#include <eq/detail/cpuCompositor.h>
+#include <eq/image.h>
+#include <eq/imageOp.h>
+#include <eq/init.h>
+#include <eq/nodeFactory.h>
+#include <eq/pixelData.h>
+#include <pression/plugins/compressor.h>
+
+#include <lunchbox/rng.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+const size_t nImages = 5;
+const eq::PixelViewport pvps[ nImages ] = {
+    eq::PixelViewport( 0, 0, 333, 201 ),
+    eq::PixelViewport( 17, 5, 300, 190 ),
+    eq::PixelViewport( 3, 40, 331, 150 ),
+    eq::PixelViewport( 1, 1, 1, 1 ),
+    eq::PixelViewport( 100, 7, 15, 97 )
+};
+
+void _setPixels( eq::Image& image, const eq::Frame::Buffer buffer,
+                 const uint32_t internalFormat, const uint32_t externalFormat,
+                 const std::vector< uint32_t >& pixels )
+{
+    eq::PixelData data;
+    data.internalFormat = internalFormat;
+    data.externalFormat = externalFormat;
+    data.pixelSize = 4;
+    data.pvp = image.getPixelViewport();
+    data.pixels = const_cast< uint32_t* >( pixels.data( ));
+    image.setPixelData( buffer, data );
+}
+
+void _testKernels( lunchbox::RNG& rng )
+{
+    namespace cpu = eq::detail::cpuCompositor;
+
+    // all lengths up to a few AVX-512 iterations, to cover the row tails
+    for( size_t n = 0; n < 67; ++n )
+    {
+        std::vector< uint32_t > color( n ), depth( n ), destColor( n ),
+                                destDepth( n );
+        for( size_t i = 0; i < n; ++i )
+        {
+            color[i] = rng.get< uint32_t >();
+            destColor[i] = rng.get< uint32_t >();
+            depth[i] = rng.get< uint8_t >(); // provoke equal depth values
+            destDepth[i] = rng.get< uint8_t >();
+        }
+
+        std::vector< uint32_t > refColor = destColor, refDepth = destDepth;
+        cpu::mergeDepth( cpu::ISA_SCALAR, refColor.data(), refDepth.data(),
+                         color.data(), depth.data(), n );
+
+        for( int i = cpu::ISA_SSE41; i <= cpu::ISA_AVX512; ++i )
+        {
+            const cpu::ISA isa = cpu::ISA( i );
+            if( !cpu::isSupported( isa ))
+                continue;
+
+            std::vector< uint32_t > outColor = destColor, outDepth = destDepth;
+            cpu::mergeDepth( isa, outColor.data(), outDepth.data(),
+                             color.data(), depth.data(), n );
+            TESTINFO( outColor == refColor && outDepth == refDepth,
+                      cpu::getName( isa ) << " kernel, " << n << " pixels" );
+        }
+    }
+}
+}
+
+int main( int argc, char** argv )
+{
+    eq::NodeFactory nodeFactory;
+    TEST( eq::init( argc, argv, &nodeFactory ));
+
+    lunchbox::RNG rng;
+    _testKernels( rng );
+
+    eq::Image images[ nImages ];
+    std::vector< uint32_t > colors[ nImages ];
+    std::vector< uint32_t > depths[ nImages ];
+    eq::ImageOps ops;
+    eq::PixelViewport destPVP;
+
+    for( size_t i = 0; i < nImages; ++i )
+    {
+        const eq::PixelViewport& pvp = pvps[ i ];
+        const size_t area = pvp.getArea();
+        colors[i].resize( area );
+        depths[i].resize( area );
+        for( size_t j = 0; j < area; ++j )
+        {
+            colors[i][j] = rng.get< uint32_t >();
+            // provoke equal depth values and background pixels
+            switch( rng.get< uint8_t >() % 4 )
+            {
+            case 0:  depths[i][j] = 0xffffffffu; break;
+            case 1:  depths[i][j] = rng.get< uint8_t >(); break;
+            default: depths[i][j] = rng.get< uint32_t >(); break;
+            }
+        }
+
+        images[i].setPixelViewport( pvp );
+        _setPixels( images[i], eq::Frame::BUFFER_COLOR,
+                    EQ_COMPRESSOR_DATATYPE_RGBA, EQ_COMPRESSOR_DATATYPE_RGBA,
+                    colors[i] );
+        _setPixels( images[i], eq::Frame::BUFFER_DEPTH,
+                    EQ_COMPRESSOR_DATATYPE_DEPTH,
+                    EQ_COMPRESSOR_DATATYPE_DEPTH_UNSIGNED_INT, depths[i] );
+        TEST( images[i].hasPixelData( eq::Frame::BUFFER_COLOR ));
+        TEST( images[i].hasPixelData( eq::Frame::BUFFER_DEPTH ));
+
+        eq::ImageOp op;
+        op.image = &images[i];
+        op.buffers = eq::Frame::BUFFER_COLOR | eq::Frame::BUFFER_DEPTH;
+        ops.push_back( op );
+        destPVP.merge( pvp );
+    }
+
+    // scalar reference, background is opaque black at the far plane
+    const size_t destArea = destPVP.getArea();
+    std::vector< uint32_t > refColor( destArea );
+    std::vector< uint32_t > refDepth( destArea, 0xffffffffu );
+    const uint8_t background[4] = { 0, 0, 0, 255 };
+    uint32_t backgroundColor;
+    memcpy( &backgroundColor, background, 4 );
+    std::fill( refColor.begin(), refColor.end(), backgroundColor );
+
+    for( size_t i = 0; i < nImages; ++i )
+    {
+        const eq::PixelViewport& pvp = pvps[ i ];
+        for( int32_t y = 0; y < pvp.h; ++y )
+        {
+            for( int32_t x = 0; x < pvp.w; ++x )
+            {
+                const size_t src = y * pvp.w + x;
+                const size_t dst = ( pvp.y - destPVP.y + y ) * destPVP.w +
+                                   pvp.x - destPVP.x + x;
+                if( refDepth[ dst ] > depths[i][ src ] )
+                {
+                    refColor[ dst ] = colors[i][ src ];
+                    refDepth[ dst ] = depths[i][ src ];
+                }
+            }
+        }
+    }
+
+    const eq::Image* result = eq::Compositor::mergeImagesCPU( ops, false );
+    TEST( result );
+    TESTINFO( result->getPixelViewport() == destPVP,
+              result->getPixelViewport() << " != " << destPVP );
+    TEST( result->getPixelDataSize( eq::Frame::BUFFER_COLOR ) ==
+          destArea * 4 );
+    TEST( result->getPixelDataSize( eq::Frame::BUFFER_DEPTH ) ==
+          destArea * 4 );
+
+    TEST( memcmp( result->getPixelPointer( eq::Frame::BUFFER_COLOR ),
+                  refColor.data(), destArea * 4 ) == 0 );
+    TEST( memcmp( result->getPixelPointer( eq::Frame::BUFFER_DEPTH ),
+                  refDepth.data(), destArea * 4 ) == 0 );
+
+    // foreground spans cover all foreground pixels and produce the same result
+    for( size_t i = 0; i < nImages; ++i )
+    {
+        TEST( !images[i].hasSpans( ));
+        TEST( images[i].computeSpans( ));
+        TEST( images[i].hasSpans( ));
+
+        const eq::PixelViewport& pvp = pvps[ i ];
+        for( int32_t y = 0; y < pvp.h; ++y )
+        {
+            size_t nSpans = 0;
+            const eq::Vector2i* spans = images[i].getSpans( y, nSpans );
+            TEST( images[i].isBackground( y, y + 1 ) == ( nSpans == 0 ));
+
+            int32_t x = 0;
+            for( size_t j = 0; j < nSpans; ++j )
+            {
+                TEST( spans[j].x() >= x && spans[j].x() < spans[j].y( ));
+                TEST( spans[j].y() <= pvp.w );
+                for( ; x < spans[j].x(); ++x )
+                    TEST( depths[i][ y * pvp.w + x ] == 0xffffffffu );
+                x = spans[j].y();
+            }
+            for( ; x < pvp.w; ++x )
+                TEST( depths[i][ y * pvp.w + x ] == 0xffffffffu );
+        }
+    }
+
+    result = eq::Compositor::mergeImagesCPU( ops, false );
+    TEST( result );
+    TEST( memcmp( result->getPixelPointer( eq::Frame::BUFFER_COLOR ),
+                  refColor.data(), destArea * 4 ) == 0 );
+    TEST( memcmp( result->getPixelPointer( eq::Frame::BUFFER_DEPTH ),
+                  refDepth.data(), destArea * 4 ) == 0 );
+
+    // modifying the pixel data invalidates the spans
+    images[0].setPixelViewport( pvps[0] );
+    TEST( !images[0].hasSpans( ));
+
+    TEST( eq::exit( ));
+    return EXIT_SUCCESS;
+}
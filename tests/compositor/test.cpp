@@ -21,13 +21,79 @@
 #include <eq/frame.h>
 #include <eq/frameData.h>
 #include <eq/image.h>
+#include <eq/imageOp.h>
 #include <eq/init.h>
 #include <eq/nodeFactory.h>
 #include <eq/fabric/drawableConfig.h>
 #include <lunchbox/clock.h>
 
+#include <cstring>
+
 // Tests the functionality of the compositor and computes the performance.
 
+namespace
+{
+eq::ImageOps _getImageOps( const eq::Frames& frames )
+{
+    eq::ImageOps ops;
+    for( const eq::Frame* frame : frames )
+    {
+        for( const eq::Image* image : frame->getImages( ))
+        {
+            eq::ImageOp op( frame, image );
+            op.offset = frame->getOffset();
+            ops.push_back( op );
+        }
+    }
+    return ops;
+}
+
+// Benchmarks the CPU merge strategies against each other and verifies that
+// they produce the same result as the sequential merge.
+void _testStrategies( const std::string& name, const eq::Frames& frames,
+                      const bool blend, const float size )
+{
+    static const char* names[] = { "sequential", "bands", "tree", "auto" };
+    const eq::ImageOps ops = _getImageOps( frames );
+    const eq::Frame::Buffer buffers[] = { eq::Frame::BUFFER_COLOR,
+                                          eq::Frame::BUFFER_DEPTH };
+    std::vector< uint8_t > reference[2];
+
+    for( int i = eq::Compositor::MERGE_SEQUENTIAL;
+         i <= eq::Compositor::MERGE_AUTO; ++i )
+    {
+        const eq::Compositor::MergeStrategy strategy =
+            eq::Compositor::MergeStrategy( i );
+        TEST( eq::Compositor::mergeImagesCPU( ops, blend, strategy ));
+
+        lunchbox::Clock clock;
+        const eq::Image* result = eq::Compositor::mergeImagesCPU( ops, blend,
+                                                                  strategy );
+        const float time = clock.getTimef();
+        TEST( result );
+
+        std::cout << name << " " << names[i] << ": " << time << " ms ("
+                  << 1000.0f * size / time / 1024.0f / 1024.0f << " MB/s)"
+                  << std::endl;
+
+        for( size_t j = 0; j < 2; ++j )
+        {
+            if( !result->hasPixelData( buffers[j] ))
+                continue;
+
+            const uint8_t* data = result->getPixelPointer( buffers[j] );
+            const size_t nBytes = result->getPixelDataSize( buffers[j] );
+            if( strategy == eq::Compositor::MERGE_SEQUENTIAL )
+                reference[j].assign( data, data + nBytes );
+            else
+                TESTINFO( nBytes == reference[j].size() &&
+                          memcmp( data, reference[j].data(), nBytes ) == 0,
+                          name << " " << names[i] );
+        }
+    }
+}
+}
+
 int main( int, char **argv )
 {
     eq::NodeFactory nodeFactory;
@@ -143,6 +209,9 @@ int main( int, char **argv )
               << 5000.0f * size * 2.f / time / 1024.0f / 1024.0f << " MB/s)"
               << std::endl;
 
+    _testStrategies( std::string( argv[0] ) + ": DB 15 images", frames, false,
+                     5.f * size * 2.f );
+
     // 3) alpha-blend assembly test
     frameData->clear();
     frameData->setBuffers( eq::Frame::BUFFER_COLOR );
@@ -187,6 +256,9 @@ int main( int, char **argv )
     std::cout << argv[0] << ": Alpha 15 images: " << time << " ms ("
          << 5000.0f * size / time / 1024.0f / 1024.0f << " MB/s)" << std::endl;
 
+    _testStrategies( std::string( argv[0] ) + ": Alpha 15 images", frames,
+                     true, 5.f * size );
+
     TEST( eq::exit( ));
 
     return EXIT_SUCCESS;
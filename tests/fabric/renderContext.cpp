@@ -0,0 +1,206 @@
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests that a render context serialized as a delta against the previous
+// context decodes to the original, for each field and for all fields changed,
+// and that an unchanged context is sent as the dirty mask only.
+
+#include <lunchbox/test.h>
+#include <eq/fabric/renderContext.h>
+#include <eq/types.h>
+
+#include <co/dataIStream.h>
+#include <co/dataOStream.h>
+#include <co/init.h>
+#include <co/localNode.h>
+#include <co/object.h>
+
+#include <functional>
+
+using eq::fabric::RenderContext;
+
+namespace
+{
+typedef std::function< void( RenderContext& ) > Change;
+
+/** Transmits a context as the delta against the previous context. */
+class Delta : public co::Object
+{
+public:
+    Delta( const RenderContext& context_, const RenderContext& previous_,
+           const bool readMask_ = false )
+        : context( context_ ), previous( previous_ ), readMask( readMask_ )
+        , mask( 0 ), remaining( 0 ) {}
+
+    RenderContext context;
+    const RenderContext previous;
+    const bool readMask;
+    uint32_t mask;
+    uint64_t remaining;
+
+protected:
+    ChangeType getChangeType() const final { return STATIC; }
+
+    void getInstanceData( co::DataOStream& os ) final
+        { context.serialize( os, previous ); }
+
+    void applyInstanceData( co::DataIStream& is ) final
+    {
+        if( readMask )
+            is >> mask;
+        else
+            context.deserialize( is );
+        remaining = is.getRemainingBufferSize();
+    }
+};
+
+bool _equal( const RenderContext& a, const RenderContext& b )
+{
+    return a.frustum == b.frustum && a.ortho == b.ortho &&
+           a.headTransform == b.headTransform &&
+           a.orthoTransform == b.orthoTransform && a.view == b.view &&
+           a.frameID == b.frameID && a.pvp == b.pvp && a.pixel == b.pixel &&
+           a.overdraw == b.overdraw && a.vp == b.vp && a.offset == b.offset &&
+           a.range == b.range && a.subPixel == b.subPixel &&
+           a.zoom == b.zoom && a.buffer == b.buffer && a.taskID == b.taskID &&
+           a.period == b.period && a.phase == b.phase && a.eye == b.eye &&
+           a.bufferMask == b.bufferMask && a.quality == b.quality &&
+           a.qualityStage == b.qualityStage &&
+           a.qualityRatio == b.qualityRatio;
+}
+
+/** @return the context decoded from the delta of context to previous. */
+RenderContext _transmit( co::LocalNodePtr node, const RenderContext& context,
+                         const RenderContext& previous )
+{
+    Delta master( context, previous );
+    Delta slave( previous, previous );
+    TEST( node->registerObject( &master ));
+    TEST( node->mapObject( &slave, master.getID( )));
+    TESTINFO( slave.remaining == 0, slave.remaining << " bytes left" );
+
+    node->unmapObject( &slave );
+    node->deregisterObject( &master );
+    return slave.context;
+}
+
+/** @return the dirty mask of the delta of context to previous. */
+uint32_t _getMask( co::LocalNodePtr node, const RenderContext& context,
+                   const RenderContext& previous, uint64_t& remaining )
+{
+    Delta master( context, previous );
+    Delta slave( previous, previous, true /* readMask */ );
+    TEST( node->registerObject( &master ));
+    TEST( node->mapObject( &slave, master.getID( )));
+
+    node->unmapObject( &slave );
+    node->deregisterObject( &master );
+    remaining = slave.remaining;
+    return slave.mask;
+}
+
+void _testRoundTrip( co::LocalNodePtr node, const RenderContext& context,
+                     const RenderContext& previous )
+{
+    const RenderContext& result = _transmit( node, context, previous );
+    TESTINFO( _equal( result, context ), result << " != " << context );
+}
+}
+
+int main( int argc, char** argv )
+{
+    TEST( co::init( argc, argv ));
+    co::LocalNodePtr node = new co::LocalNode;
+    TEST( node->listen( ));
+
+    // one change per dirty bit
+    std::vector< Change > changes;
+    changes.push_back( []( RenderContext& ctx )
+        { ctx.frustum = eq::Frustumf( -2.f, 2.f, -1.f, 1.f, .1f, 10.f );
+          ctx.ortho = eq::Frustumf( -4.f, 4.f, -3.f, 3.f, .2f, 20.f ); });
+    changes.push_back( []( RenderContext& ctx )
+        { ctx.headTransform( 0, 3 ) = 1.f; ctx.orthoTransform( 1, 3 ) = 2.f; });
+    changes.push_back( []( RenderContext& ctx )
+        { ctx.view = co::ObjectVersion( eq::uint128_t( 42, 17 ),
+                                        eq::uint128_t( 3 )); });
+    changes.push_back( []( RenderContext& ctx )
+        { ctx.frameID = eq::uint128_t( 7, 11 ); });
+    changes.push_back( []( RenderContext& ctx )
+        { ctx.pvp = eq::PixelViewport( 10, 20, 640, 480 ); });
+    changes.push_back( []( RenderContext& ctx )
+        { ctx.pixel = eq::Pixel( 1, 4 ); });
+    changes.push_back( []( RenderContext& ctx )
+        { ctx.overdraw = eq::Vector4i( 1, 2, 3, 4 ); });
+    changes.push_back( []( RenderContext& ctx )
+        { ctx.vp = eq::Viewport( .25f, .5f, .5f, .25f ); });
+    changes.push_back( []( RenderContext& ctx )
+        { ctx.offset = eq::Vector2i( 160, 120 ); });
+    changes.push_back( []( RenderContext& ctx )
+        { ctx.range = eq::Range( .25f, .75f ); });
+    changes.push_back( []( RenderContext& ctx )
+        { ctx.subPixel = eq::SubPixel( 2, 8 ); });
+    changes.push_back( []( RenderContext& ctx )
+        { ctx.zoom = eq::Zoom( .5f, 2.f ); });
+    changes.push_back( []( RenderContext& ctx )
+        { ctx.buffer = 0x0404; }); // GL_FRONT
+    changes.push_back( []( RenderContext& ctx ) { ctx.taskID = 5; });
+    changes.push_back( []( RenderContext& ctx )
+        { ctx.period = 3; ctx.phase = 2; });
+    changes.push_back( []( RenderContext& ctx )
+        { ctx.eye = eq::fabric::EYE_LEFT; });
+    changes.push_back( []( RenderContext& ctx )
+        { ctx.bufferMask = eq::fabric::ColorMask( false, true, true ); });
+    changes.push_back( []( RenderContext& ctx )
+        { ctx.quality = .5f; ctx.qualityStage = 1; ctx.qualityRatio = .3f; });
+
+    const RenderContext initial;
+    RenderContext all;
+    uint32_t masks = 0;
+    uint64_t remaining = 0;
+    for( const Change& change : changes )
+    {
+        RenderContext context;
+        change( context );
+
+        // each change sets its own dirty bit
+        const uint32_t mask = _getMask( node, context, initial, remaining );
+        TESTINFO( mask != 0 && ( mask & ( mask - 1 )) == 0, mask );
+        TESTINFO( ( masks & mask ) == 0, mask );
+        masks |= mask;
+
+        _testRoundTrip( node, context, initial );
+        // changing back to the initial value is a change, too
+        _testRoundTrip( node, initial, context );
+        change( all );
+    }
+
+    _testRoundTrip( node, all, initial );
+    _testRoundTrip( node, initial, all );
+
+    // unchanged: only the dirty mask is sent
+    const RenderContext contexts[] = { initial, all };
+    for( const RenderContext& context : contexts )
+    {
+        _testRoundTrip( node, context, context );
+        TEST( _getMask( node, context, context, remaining ) == 0 );
+        TESTINFO( remaining == 0, remaining << " bytes left" );
+    }
+
+    TEST( node->close( ));
+    node = 0;
+    TEST( co::exit( ));
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,70 @@
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests that the load equalizer cost map balances a skewed load in a few frames
+
+#include <lunchbox/test.h>
+#include <eq/server/equalizers/costMap.h>
+
+#include <cmath>
+
+using namespace eq::server;
+
+namespace
+{
+// The left quarter of the screen is four times as expensive as the rest
+float _getCost( const eq::fabric::Viewport& vp )
+{
+    const float heavy = std::max( 0.f, std::min( vp.getXEnd(), .25f ) - vp.x );
+    return ( vp.w + 3.f * heavy ) * vp.h;
+}
+}
+
+int main( int, char** )
+{
+    CostMap map;
+    map.reset( 64, 64 );
+    TEST( !map.hasData( ));
+
+    const eq::fabric::Viewport full;
+    float split = .5f;
+    for( size_t i = 0; i < 5; ++i )
+    {
+        const eq::fabric::Viewport left( 0.f, 0.f, split, 1.f );
+        const eq::fabric::Viewport right( split, 0.f, 1.f - split, 1.f );
+        map.update( left, left, _getCost( left ));
+        map.update( right, right, _getCost( right ));
+        TEST( map.hasData( ));
+        split = map.splitX( full, .5f );
+    }
+
+    const eq::fabric::Viewport left( 0.f, 0.f, split, 1.f );
+    const eq::fabric::Viewport right( split, 0.f, 1.f - split, 1.f );
+    TESTINFO( std::abs( _getCost( left ) - _getCost( right )) < .02f,
+              split << ": " << _getCost( left ) << " vs " << _getCost( right ));
+    TESTINFO( std::abs( map.getCost( full ) - _getCost( full )) < .01f,
+              map.getCost( full ));
+
+    // The bottom half was not rendered (ROI), no cost is estimated for it
+    const eq::fabric::Viewport top( 0.f, .5f, 1.f, .5f );
+    const eq::fabric::Viewport bottom( 0.f, 0.f, 1.f, .5f );
+    map.update( full, top, _getCost( top ));
+    TESTINFO( map.getCost( bottom ) < .01f, map.getCost( bottom ));
+    TESTINFO( std::abs( map.splitY( full, .5f ) - .75f ) < .01f,
+              map.splitY( full, .5f ));
+
+    return EXIT_SUCCESS;
+}
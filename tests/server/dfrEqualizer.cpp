@@ -0,0 +1,76 @@
+
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests that the quality controller of the DFR equalizer finds the quality
+// level reaching the target frame time, and recovers after saturation.
+
+#include <lunchbox/test.h>
+#include <eq/server/equalizers/dfrEqualizer.h>
+
+#include <cmath>
+
+using eq::server::DFREqualizer;
+
+namespace
+{
+const float maxLevel = 3.f;
+
+// relative frame time error of a frame rendered at the given quality level
+float _getError( const float fullTime, const float level )
+{
+    return fullTime / ( 1.f + level ) - 1.f;
+}
+
+float _run( DFREqualizer::Controller& controller, const float fullTime,
+            const size_t frames )
+{
+    for( size_t i = 0; i < frames; ++i )
+        controller.update( _getError( fullTime, controller.getLevel( )), 1.f,
+                           maxLevel );
+    return controller.getLevel();
+}
+}
+
+int main( int, char** )
+{
+    DFREqualizer::Controller controller;
+    TEST( controller.getLevel() == 0.f );
+
+    // fast enough at full quality
+    TEST( _run( controller, .5f, 100 ) == 0.f );
+
+    // 60% too slow at full quality, on target at level .6
+    float level = _run( controller, 1.6f, 300 );
+    TESTINFO( std::abs( level - .6f ) < .01f, level );
+    TESTINFO( std::abs( _getError( 1.6f, level )) < .01f,
+              _getError( 1.6f, level ));
+
+    // too slow for the whole ladder
+    level = _run( controller, 10.f, 100 );
+    TESTINFO( level == maxLevel, level );
+
+    // no wind-up while saturated: back to full quality quickly
+    level = _run( controller, .5f, 60 );
+    TESTINFO( level == 0.f, level );
+
+    controller.update( 1.f, 1.f, maxLevel );
+    TEST( controller.getLevel() > 0.f );
+    controller.reset();
+    TEST( controller.getLevel() == 0.f );
+
+    return EXIT_SUCCESS;
+}
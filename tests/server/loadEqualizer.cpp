@@ -0,0 +1,96 @@
+
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests that the load equalizer shares equalize the predicted completion time
+// of children with different render and transmit costs.
+
+#include <lunchbox/test.h>
+#include <eq/server/equalizers/loadEqualizer.h>
+
+#include <cmath>
+
+using namespace eq::server;
+
+namespace
+{
+float _getTime( const LoadEqualizer::ChildCost& cost, const float share )
+{
+    return share * ( cost.renderTime + cost.areaTime ) + cost.fixedTime;
+}
+
+float _getSum( const std::vector< float >& shares )
+{
+    float sum = 0.f;
+    for( const float share : shares )
+        sum += share;
+    return sum;
+}
+}
+
+int main( int, char** )
+{
+    LoadEqualizer::ChildCosts costs( 4 );
+    for( LoadEqualizer::ChildCost& cost : costs )
+        cost.renderTime = 100.f;
+
+    // no transmission: equal shares
+    std::vector< float > shares = LoadEqualizer::computeShares( costs );
+    TEST( shares.size() == 4 );
+    for( const float share : shares )
+        TESTINFO( std::abs( share - .25f ) < .0001f, share );
+
+    // unused children get nothing
+    costs[3].renderTime = 0.f;
+    shares = LoadEqualizer::computeShares( costs );
+    TEST( shares[3] == 0.f );
+    TESTINFO( std::abs( shares[0] - 1.f / 3.f ) < .0001f, shares[0] );
+    costs[3].renderTime = 100.f;
+
+    // 2D: remote children pay per area, the local one renders more
+    costs[1].areaTime = 50.f;
+    costs[2].areaTime = 50.f;
+    costs[3].areaTime = 100.f;
+    shares = LoadEqualizer::computeShares( costs );
+    TESTINFO( std::abs( _getSum( shares ) - 1.f ) < .0001f, _getSum( shares ));
+    TEST( shares[0] > shares[1] && shares[1] > shares[3] );
+    for( size_t i = 1; i < 4; ++i )
+        TESTINFO( std::abs( _getTime( costs[i], shares[i] ) -
+                            _getTime( costs[0], shares[0] )) < .01f,
+                  _getTime( costs[i], shares[i] ));
+
+    // DB: full images cost the same for any range
+    for( LoadEqualizer::ChildCost& cost : costs )
+        cost.areaTime = 0.f;
+    costs[1].fixedTime = 10.f;
+    costs[2].fixedTime = 10.f;
+    costs[3].fixedTime = 20.f;
+    shares = LoadEqualizer::computeShares( costs );
+    TESTINFO( std::abs( _getSum( shares ) - 1.f ) < .0001f, _getSum( shares ));
+    for( size_t i = 1; i < 4; ++i )
+        TESTINFO( std::abs( _getTime( costs[i], shares[i] ) -
+                            _getTime( costs[0], shares[0] )) < .01f,
+                  _getTime( costs[i], shares[i] ));
+
+    // a child which can't transmit before the others finish gets no work
+    costs[3].fixedTime = 1000.f;
+    shares = LoadEqualizer::computeShares( costs );
+    TEST( shares[3] == 0.f );
+    TESTINFO( std::abs( _getSum( shares ) - 1.f ) < .0001f, _getSum( shares ));
+    TEST( _getTime( costs[0], shares[0] ) < costs[3].fixedTime );
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,91 @@
+
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests the speed measurement of heterogeneous resources during and after the
+// calibration frames.
+
+#include <lunchbox/test.h>
+#include <eq/server/equalizers/resourceCalibration.h>
+
+#include <cmath>
+
+using eq::server::ResourceCalibration;
+
+int main( int, char** )
+{
+    ResourceCalibration calibration;
+    TEST( !calibration.isEnabled( ));
+    TEST( calibration.getWeight( 0 ) == 1.f );
+
+    calibration.reset( 3, 0 );
+    TEST( !calibration.isEnabled( ));
+    TEST( !calibration.isCalibrating( ));
+
+    // child 1 is twice as fast, child 2 does not render
+    calibration.reset( 3, 4 );
+    TEST( calibration.isCalibrating( ));
+
+    ResourceCalibration::Floats work( 3, 1.f );
+    work[2] = 0.f;
+    ResourceCalibration::Floats times( 3, 0.f );
+    times[0] = 1000.f; // setup costs of the first frame are ignored
+    times[1] = 10.f;
+    calibration.addFrame( work, times );
+    TEST( calibration.isCalibrating( ));
+
+    for( size_t i = 0; i < 4; ++i )
+    {
+        TEST( calibration.isCalibrating( ));
+        TEST( calibration.getWeight( 0 ) == 1.f );
+        times[0] = 20.f;
+        times[1] = 10.f;
+        calibration.addFrame( work, times );
+    }
+    TEST( !calibration.isCalibrating( ));
+    TESTINFO( std::abs( calibration.getWeight( 0 ) - 2.f / 3.f ) < .0001f,
+              calibration.getWeight( 0 ));
+    TESTINFO( std::abs( calibration.getWeight( 1 ) - 4.f / 3.f ) < .0001f,
+              calibration.getWeight( 1 ));
+    TEST( calibration.getWeight( 2 ) == 1.f );
+
+    // A balanced frame of any size doesn't change the speeds
+    work[0] = 100.f;
+    work[1] = 200.f;
+    times[0] = 50.f;
+    times[1] = 50.f;
+    calibration.addFrame( work, times );
+    TESTINFO( std::abs( calibration.getWeight( 0 ) - 2.f / 3.f ) < .0001f,
+              calibration.getWeight( 0 ));
+
+    // child 0 became as fast as child 1, the speeds follow slowly
+    work[0] = 1.f;
+    work[1] = 1.f;
+    times[0] = 10.f;
+    times[1] = 10.f;
+    calibration.addFrame( work, times );
+    const float weight = calibration.getWeight( 0 );
+    TESTINFO( weight > 2.f / 3.f && weight < .75f, weight );
+
+    for( size_t i = 0; i < 200; ++i )
+        calibration.addFrame( work, times );
+    TESTINFO( std::abs( calibration.getWeight( 0 ) - 1.f ) < .01f,
+              calibration.getWeight( 0 ));
+    TESTINFO( std::abs( calibration.getWeight( 1 ) - 1.f ) < .01f,
+              calibration.getWeight( 1 ));
+
+    return EXIT_SUCCESS;
+}
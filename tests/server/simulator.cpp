@@ -0,0 +1,90 @@
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests that a simulated 2D load equalizer balances a skewed load
+
+#include <lunchbox/test.h>
+
+#include <eq/server/config.h>
+#include <eq/server/global.h>
+#include <eq/server/init.h>
+#include <eq/server/loader.h>
+#include <eq/server/server.h>
+#include <eq/server/simulator.h>
+
+#include <algorithm>
+
+#define CONFIG "server{ config{ appNode{ pipe {                                \
+    window { viewport [ 0 0 800 600 ] channel { name \"channel0\" }}           \
+    window { viewport [ 0 0 800 600 ] channel { name \"channel1\" }}           \
+    window { viewport [ 0 0 800 600 ] channel { name \"channel2\" }}           \
+    window { viewport [ 0 0 800 600 ] channel { name \"channel3\" }}}}         \
+    compound { channel \"channel0\" load_equalizer { mode 2D }                 \
+        wall { bottom_left  [ -.8 -.5 -1 ]                                     \
+               bottom_right [  .8 -.5 -1 ]                                     \
+               top_left     [ -.8  .5 -1 ] }                                   \
+        compound {}                                                            \
+        compound { channel \"channel1\" }                                      \
+        compound { channel \"channel2\" }                                      \
+        compound { channel \"channel3\" }}}}"
+
+namespace
+{
+// 100 ms for the full view, the left quarter is four times as expensive
+float _getCost( const eq::server::Simulator::Sample& sample, uint32_t )
+{
+    const eq::fabric::Viewport& vp = sample.vp;
+    const float heavy = std::max( 0.f, std::min( vp.getXEnd(), .25f ) - vp.x );
+    return 100.f * ( vp.w + 3.f * heavy ) * vp.h / 1.75f;
+}
+}
+
+int main( int argc, char** argv )
+{
+    TEST( eq::server::init( argc, argv ));
+
+    eq::server::Loader loader;
+    eq::server::ServerPtr server = loader.parseServer( CONFIG );
+    TEST( server );
+    TEST( server->getConfigs().size() == 1 );
+
+    eq::server::Config* config = server->getConfigs().front();
+    eq::server::Simulator simulator( *config, _getCost );
+
+    float imbalance = 0.f;
+    for( size_t i = 0; i < 30; ++i )
+    {
+        const eq::server::Simulator::Samples& samples = simulator.runFrame();
+        TESTINFO( samples.size() == 4, samples.size( ));
+
+        float total = 0.f;
+        float maximum = 0.f;
+        for( const eq::server::Simulator::Sample& sample : samples )
+        {
+            total += sample.time;
+            maximum = std::max( maximum, sample.time );
+        }
+        TESTINFO( total > 99.f && total < 101.f, total );
+        imbalance = maximum / ( total / 4.f ) - 1.f;
+    }
+    TESTINFO( imbalance < .1f, imbalance );
+    TEST( simulator.getFrameNumber() == 30 );
+
+    eq::server::Global::clear();
+    server->deleteConfigs(); // break server <-> config ref circle
+    TEST( eq::server::exit( ));
+    return EXIT_SUCCESS;
+}
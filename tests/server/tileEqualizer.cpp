@@ -0,0 +1,118 @@
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests that all tile strategies queue each tile once, and that the automatic
+// tile size grows with the queue overhead and shrinks with a skewed load.
+
+#include <lunchbox/test.h>
+#include <eq/server/equalizers/tileEqualizer.h>
+
+#include <eq/server/tiles/rasterStrategy.h>
+#include <eq/server/tiles/spiralStrategy.h>
+#include <eq/server/tiles/squareStrategy.h>
+#include <eq/server/tiles/zigzagStrategy.h>
+
+#include <set>
+
+using namespace eq::server;
+
+namespace
+{
+template< class S > void _testStrategy( S strategy )
+{
+    for( int32_t x = 1; x < 12; ++x )
+    {
+        for( int32_t y = 1; y < 12; ++y )
+        {
+            std::vector< Vector2i > tiles;
+            strategy( tiles, Vector2i( x, y ));
+            TESTINFO( tiles.size() == size_t( x * y ),
+                      tiles.size() << " tiles for " << x << "x" << y );
+
+            std::set< std::pair< int32_t, int32_t > > unique;
+            for( const Vector2i& tile : tiles )
+            {
+                TEST( tile.x() >= 0 && tile.x() < x );
+                TEST( tile.y() >= 0 && tile.y() < y );
+                unique.insert( std::make_pair( tile.x(), tile.y( )));
+            }
+            TESTINFO( unique.size() == size_t( x * y ),
+                      unique.size() << " unique tiles for " << x << "x" << y );
+        }
+    }
+}
+}
+
+int main( int, char** )
+{
+    _testStrategy( tiles::RasterStrategy( ));
+    _testStrategy( tiles::SpiralStrategy( ));
+    _testStrategy( tiles::SquareStrategy( ));
+    _testStrategy( []( std::vector< Vector2i >& tiles, const Vector2i& dim )
+                       { tiles::generateZigzag( tiles, dim ); });
+
+    TileEqualizer equalizer;
+    equalizer.setDamping( 0.f );
+
+    const Vector2i size( 64, 64 );
+    const PixelViewport pvp( 0, 0, 1024, 1024 );
+
+    // uniform 10ms tiles on four channels
+    TileEqualizer::Load load;
+    load.nTiles = 256;
+    load.nChannels = 4;
+    load.drawTime = 2560;
+    load.maxTileTime = 10;
+
+    // no data or full damping keep the size
+    TEST( equalizer.computeTileSize( size, pvp, TileEqualizer::Load( )) ==
+          size );
+    equalizer.setDamping( 1.f );
+    load.idleTime = 2560;
+    TEST( equalizer.computeTileSize( size, pvp, load ) == size );
+    equalizer.setDamping( 0.f );
+
+    // 10ms queue overhead per tile: larger tiles
+    const Vector2i larger = equalizer.computeTileSize( size, pvp, load );
+    TESTINFO( larger.x() > size.x() && larger.x() == larger.y(), larger );
+    TEST( larger.x() % 16 == 0 );
+
+    // optimal size is stable
+    load.maxTileTime = 10 * larger.x() * larger.y() / ( size.x() * size.y( ));
+    load.nTiles = 1024 * 1024 / ( larger.x() * larger.y( ));
+    load.idleTime = load.nTiles * 10;
+    TESTINFO( equalizer.computeTileSize( larger, pvp, load ) == larger,
+              equalizer.computeTileSize( larger, pvp, load ));
+
+    // one 200ms hot spot tile, 1ms queue overhead: smaller tiles
+    load.nTiles = 256;
+    load.maxTileTime = 200;
+    load.idleTime = 256;
+    const Vector2i smaller = equalizer.computeTileSize( size, pvp, load );
+    TESTINFO( smaller.x() < size.x() && smaller.x() >= 16, smaller );
+
+    // no queue overhead: smallest tiles
+    load.idleTime = 0;
+    TEST( equalizer.computeTileSize( size, pvp, load ) == Vector2i( 16, 16 ));
+
+    // tiles never exceed the area
+    const PixelViewport small( 0, 0, 100, 50 );
+    load.idleTime = 256000;
+    const Vector2i clamped = equalizer.computeTileSize( size, small, load );
+    TESTINFO( clamped.x() <= 100 && clamped.y() <= 50, clamped );
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,207 @@
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests that the tiles of a frame are split into one contiguous range per
+// consuming node, sized by the node weights, that each node steals from the
+// slowest node first and that the batch sizes follow the range sizes.
+
+#include <lunchbox/test.h>
+
+#include <eq/server/compound.h>
+#include <eq/server/config.h>
+#include <eq/server/global.h>
+#include <eq/server/init.h>
+#include <eq/server/loader.h>
+#include <eq/server/node.h>
+#include <eq/server/server.h>
+#include <eq/server/simulator.h>
+#include <eq/server/tileQueue.h>
+
+#include <co/localNode.h>
+#include <co/objectICommand.h>
+#include <co/queueSlave.h>
+
+#define CONFIG "server{ config{ appNode{ pipe {                                \
+    window { viewport [ 0 0 800 600 ] channel { name \"channel\" }}}}          \
+    compound { channel \"channel\"                                             \
+        wall { bottom_left  [ -.8 -.5 -1 ]                                     \
+               bottom_right [  .8 -.5 -1 ]                                     \
+               top_left     [ -.8  .5 -1 ] }}}}"
+
+using namespace eq::server;
+
+namespace
+{
+const eq::fabric::Eye eye = eq::fabric::EYE_CYCLOP;
+typedef std::vector< uint128_t > IDs;
+
+float _getCost( const Simulator::Sample&, uint32_t ) { return 10.f; }
+
+/** Queue nTiles tiles, numbered by their x position, and distribute them. */
+void _addTiles( TileQueue& queue, const size_t nTiles )
+{
+    for( size_t i = 0; i < nTiles; ++i )
+        queue.addTile( eq::fabric::Tile( PixelViewport( int32_t( i ), 0, 1, 1 ),
+                                         eq::fabric::Viewport( )), eye );
+    queue.distributeTiles();
+}
+
+/** @return the numbers of the tiles in the given queue, in queue order. */
+std::vector< int32_t > _pop( co::LocalNodePtr node, const uint128_t& id )
+{
+    co::QueueSlave slave;
+    TEST( node->mapObject( &slave, id ));
+
+    std::vector< int32_t > tiles;
+    for( ;; )
+    {
+        co::ObjectICommand command = slave.pop( 1000 );
+        if( !command.isValid( ))
+            break;
+        tiles.push_back( command.read< eq::fabric::Tile >().pvp.x );
+    }
+    node->unmapObject( &slave );
+    return tiles;
+}
+
+/** Test that the given range holds the tiles [begin, end) in order. */
+void _testRange( co::LocalNodePtr node, const uint128_t& id,
+                 const int32_t begin, const int32_t end )
+{
+    const std::vector< int32_t >& tiles = _pop( node, id );
+    TESTINFO( tiles.size() == size_t( end - begin ),
+              tiles.size() << " tiles, expected " << end - begin );
+    for( size_t i = 0; i < tiles.size(); ++i )
+        TESTINFO( tiles[i] == begin + int32_t( i ),
+                  "tile " << tiles[i] << " at " << begin + int32_t( i ));
+}
+}
+
+int main( int argc, char** argv )
+{
+    TEST( eq::server::init( argc, argv ));
+
+    Loader loader;
+    ServerPtr server = loader.parseServer( CONFIG );
+    TEST( server );
+    Config* config = server->getConfigs().front();
+
+    // sets up the active eye of the compound used by cycleData
+    Simulator simulator( *config, _getCost );
+    simulator.runFrame();
+    const Compound* compound = config->getCompounds().front();
+
+    const Node* a = config->getNodes().front();
+    const Node* b = new Node( config ); // owned by config
+    const Node* c = new Node( config );
+
+    co::LocalNodePtr node = new co::LocalNode;
+    TEST( node->listen( ));
+
+    TileQueue queue;
+    TEST( node->registerObject( &queue ));
+
+    // no consumers: one range with all tiles, served to any node
+    queue.cycleData( 1, compound );
+    _addTiles( queue, 10 );
+    IDs ids = queue.getQueueMasterIDs( eye, a );
+    TESTINFO( ids.size() == 1, ids.size( ));
+    TEST( queue.getBatchSize( eye, a ) == 1 );
+    _testRange( node, ids.front(), 0, 10 );
+
+    // default weights are the number of channels: a 50, b 25, c 25 tiles
+    queue.cycleData( 2, compound );
+    queue.addConsumer( a );
+    queue.addConsumer( a );
+    queue.addConsumer( b );
+    queue.addConsumer( c );
+    _addTiles( queue, 100 );
+
+    ids = queue.getQueueMasterIDs( eye, a );
+    TESTINFO( ids.size() == 3, ids.size( ));
+    const IDs idsB = queue.getQueueMasterIDs( eye, b );
+    const IDs idsC = queue.getQueueMasterIDs( eye, c );
+    TEST( idsB.size() == 3 && idsC.size() == 3 );
+
+    // own range first, equal victims visited starting after the own node
+    TEST( idsB[0] == ids[1] && idsB[1] == ids[2] && idsB[2] == ids[0] );
+    TEST( idsC[0] == ids[2] && idsC[1] == ids[0] && idsC[2] == ids[1] );
+
+    // 50 tiles on two channels and 25 on one: four batches per channel
+    TESTINFO( queue.getBatchSize( eye, a ) == 6, queue.getBatchSize( eye, a ));
+    TESTINFO( queue.getBatchSize( eye, b ) == 6, queue.getBatchSize( eye, b ));
+
+    _testRange( node, ids[0], 0, 50 );
+    _testRange( node, ids[1], 50, 75 );
+    _testRange( node, ids[2], 75, 100 );
+
+    // measured weights a 2, b 4, c 1: a 29, b 57, c 14 tiles
+    queue.setNodeWeight( a, 2.f );
+    queue.setNodeWeight( b, 4.f );
+    queue.setNodeWeight( c, 1.f );
+    queue.cycleData( 3, compound );
+    queue.addConsumer( a );
+    queue.addConsumer( a );
+    queue.addConsumer( b );
+    queue.addConsumer( c );
+    _addTiles( queue, 100 );
+
+    // a steals from c (1 per channel) before b (4 per channel)
+    const IDs stealA = queue.getQueueMasterIDs( eye, a );
+    const IDs stealB = queue.getQueueMasterIDs( eye, b );
+    TEST( stealA.size() == 3 && stealB.size() == 3 );
+    TEST( stealB[0] != stealA[0] );
+    TEST( stealA[1] == stealB[1] ); // both steal from c first
+    TEST( stealB[2] == stealA[0] );
+
+    TESTINFO( queue.getBatchSize( eye, a ) == 3, queue.getBatchSize( eye, a ));
+    TESTINFO( queue.getBatchSize( eye, b ) == 8, queue.getBatchSize( eye, b ));
+    TESTINFO( queue.getBatchSize( eye, c ) == 3, queue.getBatchSize( eye, c ));
+
+    _testRange( node, stealA[0], 0, 29 );
+    _testRange( node, stealB[0], 29, 86 );
+    _testRange( node, stealA[1], 86, 100 );
+
+    // an unknown node has no range, takes single tiles and steals from all
+    const Node* d = new Node( config );
+    TEST( queue.getBatchSize( eye, d ) == 1 );
+    TEST( queue.getQueueMasterIDs( eye, d ).size() == 3 );
+
+    // few tiles: batches of one, empty ranges are not stolen from
+    queue.setNodeWeight( a, 0.f );
+    queue.setNodeWeight( b, 0.f );
+    queue.setNodeWeight( c, 0.f );
+    queue.cycleData( 4, compound );
+    queue.addConsumer( a );
+    queue.addConsumer( b );
+    queue.addConsumer( c );
+    _addTiles( queue, 1 );
+
+    TEST( queue.getBatchSize( eye, a ) == 1 );
+    ids = queue.getQueueMasterIDs( eye, b );
+    TESTINFO( ids.size() == 1, ids.size( )); // a and c have no tile
+    _testRange( node, ids.front(), 0, 1 );
+
+    queue.flush();
+    node->deregisterObject( &queue );
+    TEST( node->close( ));
+    node = 0;
+
+    Global::clear();
+    server->deleteConfigs(); // break server <-> config ref circle
+    TEST( eq::server::exit( ));
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,458 @@
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Benchmarks the CPU compositor using synthetic images of configurable size,
+// overlap, pixel format and count. Each merge mode (2D, DB, blend) is run with
+// each merge strategy, and the results can be written as CSV and JSON to track
+// the compositing performance across releases.
+
+#include <eq/compositor.h>
+#include <eq/image.h>
+#include <eq/imageOp.h>
+#include <eq/init.h>
+#include <eq/nodeFactory.h>
+#include <eq/pixelData.h>
+#include <pression/plugins/compressor.h>
+
+#include <lunchbox/clock.h>
+#include <lunchbox/omp.h>
+#include <lunchbox/rng.h>
+
+#pragma warning( disable: 4275 )
+#include <boost/program_options.hpp>
+#pragma warning( default: 4275 )
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace po = boost::program_options;
+
+namespace
+{
+enum Mode
+{
+    MODE_2D,   //!< copy color
+    MODE_DB,   //!< depth-merge color and depth
+    MODE_BLEND //!< alpha-blend color
+};
+
+const char* const modeNames[] = { "2d", "db", "blend" };
+const char* const strategyNames[] = { "sequential", "bands", "tree", "auto" };
+
+const char* const formatNames[] = { "rgba8", "rgba16f", "rgba32f" };
+
+struct Format
+{
+    uint32_t token;
+    uint32_t pixelSize;
+};
+
+const Format formats[] = {
+    { EQ_COMPRESSOR_DATATYPE_RGBA,    4 },
+    { EQ_COMPRESSOR_DATATYPE_RGBA16F, 8 },
+    { EQ_COMPRESSOR_DATATYPE_RGBA32F, 16 }
+};
+
+struct Options
+{
+    int32_t width;
+    int32_t height;
+    size_t nImages;
+    float overlap;    //!< horizontal overlap of neighboring images [0,1]
+    float background; //!< fraction of background pixels in DB images
+    bool spans;       //!< compute foreground spans of DB images
+    size_t warmup;
+    size_t iterations;
+};
+
+struct Result
+{
+    Mode mode;
+    size_t format;
+    eq::Compositor::MergeStrategy strategy;
+    size_t nBytes;    //!< input bytes per merge
+    double mean;      //!< merge time, ms
+    double gbps;      //!< input throughput, GB/s
+    double percentile[3]; //!< p50, p90, p99 of the merge time, ms
+};
+
+const double percentiles[] = { .5, .9, .99 };
+
+/** A set of synthetic input images for one mode and format. */
+class Inputs
+{
+public:
+    Inputs( const Options& options, const Mode mode, const Format& format,
+            lunchbox::RNG& rng )
+        : nBytes( 0 )
+    {
+        const int32_t stride =
+            int32_t( float( options.width ) * ( 1.f - options.overlap ) + .5f );
+
+        for( size_t i = 0; i < options.nImages; ++i )
+        {
+            _images.emplace_back( new eq::Image );
+            eq::Image& image = *_images.back();
+            const eq::PixelViewport pvp( int32_t( i ) * stride, 0,
+                                         options.width, options.height );
+            image.setPixelViewport( pvp );
+
+            _colors.emplace_back( pvp.getArea() * format.pixelSize );
+            _fillColor( _colors.back(), format, rng );
+            _setPixels( image, eq::Frame::BUFFER_COLOR, format.token,
+                        format.token, format.pixelSize, _colors.back( ));
+
+            eq::ImageOp op;
+            op.image = &image;
+            op.buffers = eq::Frame::BUFFER_COLOR;
+
+            if( mode == MODE_DB )
+            {
+                _depths.emplace_back( pvp.getArea() * 4 );
+                _fillDepth( _depths.back(), options.background, rng );
+                _setPixels( image, eq::Frame::BUFFER_DEPTH,
+                            EQ_COMPRESSOR_DATATYPE_DEPTH,
+                            EQ_COMPRESSOR_DATATYPE_DEPTH_UNSIGNED_INT, 4,
+                            _depths.back( ));
+                op.buffers |= eq::Frame::BUFFER_DEPTH;
+                nBytes += _depths.back().size();
+                if( options.spans )
+                    image.computeSpans();
+            }
+            nBytes += _colors.back().size();
+            ops.push_back( op );
+        }
+    }
+
+    eq::ImageOps ops;
+    size_t nBytes;
+
+private:
+    typedef std::vector< uint8_t > Buffer;
+
+    std::vector< std::unique_ptr< eq::Image > > _images;
+    std::vector< Buffer > _colors;
+    std::vector< Buffer > _depths;
+
+    static void _setPixels( eq::Image& image, const eq::Frame::Buffer buffer,
+                            const uint32_t internalFormat,
+                            const uint32_t externalFormat,
+                            const uint32_t pixelSize, Buffer& pixels )
+    {
+        eq::PixelData data;
+        data.internalFormat = internalFormat;
+        data.externalFormat = externalFormat;
+        data.pixelSize = pixelSize;
+        data.pvp = image.getPixelViewport();
+        data.pixels = pixels.data();
+        image.setPixelData( buffer, data );
+    }
+
+    static void _fillColor( Buffer& buffer, const Format& format,
+                            lunchbox::RNG& rng )
+    {
+        switch( format.pixelSize )
+        {
+        case 8:
+        {
+            // half floats in [2^-14, 1)
+            uint16_t* data = reinterpret_cast< uint16_t* >( buffer.data( ));
+            for( size_t i = 0; i < buffer.size() / 2; ++i )
+                data[i] = uint16_t(( 1 + rng.get< uint16_t >() % 14 ) << 10 |
+                                   ( rng.get< uint16_t >() & 0x3ff ));
+            return;
+        }
+        case 16:
+        {
+            float* data = reinterpret_cast< float* >( buffer.data( ));
+            for( size_t i = 0; i < buffer.size() / 4; ++i )
+                data[i] = float( rng.get< uint16_t >( )) / 65536.f;
+            return;
+        }
+        default:
+            for( uint8_t& value : buffer )
+                value = rng.get< uint8_t >();
+        }
+    }
+
+    static void _fillDepth( Buffer& buffer, const float background,
+                            lunchbox::RNG& rng )
+    {
+        uint32_t* data = reinterpret_cast< uint32_t* >( buffer.data( ));
+        for( size_t i = 0; i < buffer.size() / 4; ++i )
+            data[i] = float( rng.get< uint16_t >( )) / 65536.f < background ?
+                          0xffffffffu : rng.get< uint32_t >();
+    }
+};
+
+bool _isSupported( const Mode mode, const Format& format )
+{
+    // depth-compositing of float colors is not implemented
+    return mode != MODE_DB || format.pixelSize == 4;
+}
+
+bool _run( const Options& options, const Inputs& inputs, const Mode mode,
+           const eq::Compositor::MergeStrategy strategy, Result& result )
+{
+    const bool blend = mode == MODE_BLEND;
+    for( size_t i = 0; i < options.warmup; ++i )
+        if( !eq::Compositor::mergeImagesCPU( inputs.ops, blend, strategy ))
+            return false;
+
+    std::vector< double > times;
+    times.reserve( options.iterations );
+    lunchbox::Clock clock;
+    for( size_t i = 0; i < options.iterations; ++i )
+    {
+        clock.reset();
+        if( !eq::Compositor::mergeImagesCPU( inputs.ops, blend, strategy ))
+            return false;
+        times.push_back( clock.getTimed( ));
+    }
+
+    double total = 0.;
+    for( const double time : times )
+        total += time;
+    std::sort( times.begin(), times.end( ));
+
+    result.nBytes = inputs.nBytes;
+    result.mean = total / double( times.size( ));
+    result.gbps = double( inputs.nBytes ) / result.mean / 1e6;
+    for( size_t i = 0; i < 3; ++i )
+    {
+        const size_t index = size_t( percentiles[i] *
+                                     double( times.size() - 1 ) + .5 );
+        result.percentile[i] = times[ index ];
+    }
+    return true;
+}
+
+void _writeCSV( std::ostream& os, const Options& options,
+                const std::vector< Result >& results )
+{
+    os << "mode,format,strategy,width,height,images,overlap,iterations,"
+       << "bytes,mean_ms,gbps,p50_merge_ms,p90_merge_ms,p99_merge_ms"
+       << std::endl;
+    for( const Result& result : results )
+        os << modeNames[ result.mode ] << ','
+           << formatNames[ result.format ] << ','
+           << strategyNames[ result.strategy ] << ',' << options.width << ','
+           << options.height << ',' << options.nImages << ','
+           << options.overlap << ',' << options.iterations << ','
+           << result.nBytes << ',' << result.mean << ',' << result.gbps << ','
+           << result.percentile[0] << ',' << result.percentile[1] << ','
+           << result.percentile[2] << std::endl;
+}
+
+void _writeJSON( std::ostream& os, const Options& options,
+                 const std::vector< Result >& results )
+{
+    const char* isa = ::getenv( "EQ_CPU_COMPOSITOR_ISA" );
+    os << "{" << std::endl
+       << "  \"width\": " << options.width << "," << std::endl
+       << "  \"height\": " << options.height << "," << std::endl
+       << "  \"images\": " << options.nImages << "," << std::endl
+       << "  \"overlap\": " << options.overlap << "," << std::endl
+       << "  \"background\": " << options.background << "," << std::endl
+       << "  \"spans\": " << ( options.spans ? "true" : "false" ) << ","
+       << std::endl
+       << "  \"warmup\": " << options.warmup << "," << std::endl
+       << "  \"iterations\": " << options.iterations << "," << std::endl
+       << "  \"threads\": " << lunchbox::OMP::getNThreads() << "," << std::endl
+       << "  \"isa\": \"" << ( isa ? isa : "auto" ) << "\"," << std::endl
+       << "  \"results\": [" << std::endl;
+
+    for( size_t i = 0; i < results.size(); ++i )
+    {
+        const Result& result = results[i];
+        os << "    { \"mode\": \"" << modeNames[ result.mode ]
+           << "\", \"format\": \"" << formatNames[ result.format ]
+           << "\", \"strategy\": \"" << strategyNames[ result.strategy ]
+           << "\", \"bytes\": " << result.nBytes
+           << ", \"mean_ms\": " << result.mean
+           << ", \"gbps\": " << result.gbps
+           << ", \"p50_merge_ms\": " << result.percentile[0]
+           << ", \"p90_merge_ms\": " << result.percentile[1]
+           << ", \"p99_merge_ms\": " << result.percentile[2] << " }"
+           << ( i + 1 < results.size() ? "," : "" ) << std::endl;
+    }
+    os << "  ]" << std::endl << "}" << std::endl;
+}
+
+template< class T >
+bool _parse( const std::vector< std::string >& names, const char* const* known,
+             const size_t nKnown, std::vector< T >& values )
+{
+    for( size_t i = 0; i < nKnown; ++i )
+        if( names.empty() ||
+            std::find( names.begin(), names.end(), known[i] ) != names.end( ))
+        {
+            values.push_back( T( i ));
+        }
+
+    return values.size() == ( names.empty() ? nKnown : names.size( ));
+}
+}
+
+int main( int argc, char** argv )
+{
+    Options options;
+    std::vector< std::string > modeArgs;
+    std::vector< std::string > formatArgs;
+    std::vector< std::string > strategyArgs;
+    std::string csvFile;
+    std::string jsonFile;
+    bool showHelp = false;
+
+    po::options_description description(
+        "Usage: compositorBenchmark [options]\nOptions" );
+    description.add_options()
+        ( "help,h", po::bool_switch( &showHelp )->default_value( false ),
+          "produce help message" )
+        ( "width,x", po::value< int32_t >( &options.width )->default_value(
+            1920 ), "width of each input image" )
+        ( "height,y", po::value< int32_t >( &options.height )->default_value(
+            1080 ), "height of each input image" )
+        ( "images,n", po::value< size_t >( &options.nImages )->default_value(
+            4 ), "number of input images" )
+        ( "overlap,o", po::value< float >( &options.overlap )->default_value(
+            1.f ), "horizontal overlap of neighboring images, 0 to 1" )
+        ( "background,b", po::value< float >(
+            &options.background )->default_value( .25f ),
+          "fraction of background pixels in depth images, 0 to 1" )
+        ( "spans", po::bool_switch( &options.spans )->default_value( false ),
+          "skip background pixels of depth images using foreground spans" )
+        ( "mode,m", po::value< std::vector< std::string > >(
+            &modeArgs )->multitoken(), "merge modes: 2d db blend (all)" )
+        ( "format,f", po::value< std::vector< std::string > >(
+            &formatArgs )->multitoken(),
+          "color formats: rgba8 rgba16f rgba32f (all)" )
+        ( "strategy,s", po::value< std::vector< std::string > >(
+            &strategyArgs )->multitoken(),
+          "merge strategies: sequential bands tree auto (all)" )
+        ( "warmup,w", po::value< size_t >( &options.warmup )->default_value(
+            3 ), "number of untimed merges per case" )
+        ( "iterations,i", po::value< size_t >(
+            &options.iterations )->default_value( 20 ),
+          "number of timed merges per case" )
+        ( "csv", po::value< std::string >( &csvFile ), "write CSV results" )
+        ( "json", po::value< std::string >( &jsonFile ),
+          "write JSON results" );
+
+    try
+    {
+        po::variables_map variableMap;
+        po::store( po::command_line_parser( argc, argv ).options(
+                       description ).allow_unregistered().run(), variableMap );
+        po::notify( variableMap );
+    }
+    catch( const std::exception& e )
+    {
+        std::cerr << e.what() << std::endl << description << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector< Mode > modes;
+    std::vector< size_t > formatIndices;
+    std::vector< eq::Compositor::MergeStrategy > strategies;
+    if( !_parse( modeArgs, modeNames, 3, modes ) ||
+        !_parse( formatArgs, formatNames, 3, formatIndices ) ||
+        !_parse( strategyArgs, strategyNames, 4, strategies ))
+    {
+        showHelp = true;
+    }
+
+    if( showHelp || options.width <= 0 || options.height <= 0 ||
+        options.nImages == 0 || options.iterations == 0 ||
+        options.overlap < 0.f || options.overlap > 1.f )
+    {
+        std::cout << description << std::endl;
+        return showHelp ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    eq::NodeFactory nodeFactory;
+    if( !eq::init( argc, argv, &nodeFactory ))
+    {
+        std::cerr << "Equalizer initialization failed" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    lunchbox::RNG rng;
+    std::vector< Result > results;
+    bool ok = true;
+
+    std::cout << "   MODE,  FORMAT,   STRATEGY,    MEAN ms,       GB/s,"
+              << "     p50 ms,     p90 ms,     p99 ms" << std::endl;
+    for( const Mode mode : modes )
+    {
+        for( const size_t formatIndex : formatIndices )
+        {
+            const Format& format = formats[ formatIndex ];
+            if( !_isSupported( mode, format ))
+                continue;
+
+            const Inputs inputs( options, mode, format, rng );
+            for( const eq::Compositor::MergeStrategy strategy : strategies )
+            {
+                Result result;
+                result.mode = mode;
+                result.format = formatIndex;
+                result.strategy = strategy;
+                if( !_run( options, inputs, mode, strategy, result ))
+                {
+                    std::cerr << "CPU merge failed: " << modeNames[ mode ]
+                              << " " << formatNames[ formatIndex ] << " "
+                              << strategyNames[ strategy ] << std::endl;
+                    ok = false;
+                    continue;
+                }
+
+                std::cout << std::setw( 7 ) << modeNames[ mode ] << ", "
+                          << std::setw( 7 ) << formatNames[ formatIndex ]
+                          << ", "
+                          << std::setw( 10 ) << strategyNames[ strategy ]
+                          << ", " << std::setw( 10 ) << result.mean << ", "
+                          << std::setw( 10 ) << result.gbps << ", "
+                          << std::setw( 10 ) << result.percentile[0] << ", "
+                          << std::setw( 10 ) << result.percentile[1] << ", "
+                          << std::setw( 10 ) << result.percentile[2]
+                          << std::endl;
+                results.push_back( result );
+            }
+        }
+    }
+
+    if( !csvFile.empty( ))
+    {
+        std::ofstream csv( csvFile.c_str( ));
+        _writeCSV( csv, options, results );
+        ok = ok && csv.good();
+    }
+    if( !jsonFile.empty( ))
+    {
+        std::ofstream json( jsonFile.c_str( ));
+        _writeJSON( json, options, results );
+        ok = ok && json.good();
+    }
+
+    eq::exit();
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,671 @@
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Benchmarks the equalizers of a config without render clients. The config is
+// simulated using synthetic cost models, or using the cost density of a load
+// trace recorded from a running config with EQ_LOAD_TRACE. For each run, the
+// convergence time, the load imbalance and the jitter of the splits are
+// reported, and can be written as CSV and JSON to track the load balancing
+// quality across releases.
+
+#include <eq/server/channel.h>
+#include <eq/server/compound.h>
+#include <eq/server/config.h>
+#include <eq/server/equalizers/costMap.h>
+#include <eq/server/global.h>
+#include <eq/server/init.h>
+#include <eq/server/loader.h>
+#include <eq/server/server.h>
+#include <eq/server/simulator.h>
+
+#include <eq/fabric/statistic.h>
+#include <lunchbox/rng.h>
+
+#pragma warning( disable: 4275 )
+#include <boost/program_options.hpp>
+#pragma warning( default: 4275 )
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <sstream>
+#include <vector>
+
+namespace po = boost::program_options;
+
+using eq::server::CostMap;
+using eq::server::Simulator;
+using eq::fabric::Range;
+using eq::fabric::Viewport;
+
+namespace
+{
+enum Model
+{
+    MODEL_UNIFORM, //!< constant cost density
+    MODEL_SKEWED,  //!< left quarter (first quarter of range) 4x expensive
+    MODEL_HOTSPOT, //!< gaussian hot spot
+    MODEL_MOVING,  //!< gaussian hot spot moving on a circle
+    MODEL_TRACE    //!< cost density of a recorded load trace
+};
+
+const char* const modelNames[] = { "uniform", "skewed", "hotspot", "moving",
+                                   "trace" };
+const float _twoPi = 6.2831853f;
+const uint32_t _movingPeriod = 240; // frames per hot spot revolution
+
+struct Options
+{
+    std::string config;
+    std::string trace;
+    size_t frames;
+    int32_t latency;  //!< load data latency in frames, config latency if < 0
+    float cost;       //!< synthetic render time of the full view in ms
+    float noise;      //!< relative random noise on render times
+    float threshold;  //!< imbalance below which a frame is balanced
+};
+
+struct Result
+{
+    Model model;
+    size_t frames;
+    float meanTime;        //!< mean frame time in ms
+    float idealTime;       //!< mean frame time of a perfect balance in ms
+    int64_t converged;     //!< first frame of the balanced steady state or -1
+    float imbalance;       //!< mean imbalance of all frames
+    float steadyImbalance; //!< mean imbalance of the second half
+    float jitter;          //!< mean split movement per task and frame
+    float steadyJitter;    //!< mean split movement of the second half
+};
+
+float _gauss( const float distance2 )
+{
+    const float sigma = .1f;
+    return std::exp( -distance2 / ( 2.f * sigma * sigma ));
+}
+
+float _getCenter( const uint32_t frameNumber, const bool inX )
+{
+    const float angle = _twoPi * float( frameNumber % _movingPeriod ) /
+                        float( _movingPeriod );
+    return .5f + .3f * ( inX ? std::cos( angle ) : std::sin( angle ));
+}
+
+float _getDensity( const Model model, const float x, const float y,
+                   const uint32_t frameNumber )
+{
+    switch( model )
+    {
+    case MODEL_SKEWED:
+        return x < .25f ? 4.f : 1.f;
+    case MODEL_HOTSPOT:
+    {
+        const float dx = x - .3f;
+        const float dy = y - .6f;
+        return .2f + _gauss( dx * dx + dy * dy );
+    }
+    case MODEL_MOVING:
+    {
+        const float dx = x - _getCenter( frameNumber, true );
+        const float dy = y - _getCenter( frameNumber, false );
+        return .2f + _gauss( dx * dx + dy * dy );
+    }
+    default:
+        return 1.f;
+    }
+}
+
+float _getDensity( const Model model, const float position,
+                   const uint32_t frameNumber )
+{
+    switch( model )
+    {
+    case MODEL_SKEWED:
+        return position < .25f ? 4.f : 1.f;
+    case MODEL_HOTSPOT:
+        return .2f + _gauss(( position - .3f ) * ( position - .3f ));
+    case MODEL_MOVING:
+    {
+        const float d = position - _getCenter( frameNumber, true );
+        return .2f + _gauss( d * d );
+    }
+    default:
+        return 1.f;
+    }
+}
+
+// midpoint integration of the screen-space density over vp
+float _integrate( const Model model, const Viewport& vp,
+                  const uint32_t frameNumber )
+{
+    const size_t n = 16;
+    float sum = 0.f;
+    for( size_t y = 0; y < n; ++y )
+        for( size_t x = 0; x < n; ++x )
+            sum += _getDensity( model, vp.x + vp.w * ( x + .5f ) / n,
+                                vp.y + vp.h * ( y + .5f ) / n, frameNumber );
+    return sum * vp.w * vp.h / float( n * n );
+}
+
+// midpoint integration of the database density over range
+float _integrate( const Model model, const Range& range,
+                  const uint32_t frameNumber )
+{
+    const size_t n = 64;
+    const float size = range.end - range.start;
+    float sum = 0.f;
+    for( size_t i = 0; i < n; ++i )
+        sum += _getDensity( model, range.start + size * ( i + .5f ) / n,
+                            frameNumber );
+    return sum * size / float( n );
+}
+
+/** The cost density of a load trace, refined over the recorded frames. */
+class Trace
+{
+public:
+    bool load( const std::string& filename );
+
+    size_t getNumFrames() const { return _frames.size(); }
+
+    float getCost( const Simulator::Sample& sample,
+                   const uint32_t frameNumber ) const
+    {
+        const Destinations& destinations =
+            _frames[ ( frameNumber - 1 ) % _frames.size() ];
+        const auto i = destinations.find( sample.destination );
+        if( i == destinations.end( ))
+            return 0.f;
+
+        const Maps& maps = i->second;
+        const Viewport range( sample.range.start, 0.f,
+                              sample.range.end - sample.range.start, 1.f );
+        const float screenCost = maps.screen.getCost( Viewport::FULL );
+        const float rangeCost = maps.range.getCost( Viewport::FULL );
+        if( screenCost <= 0.f || rangeCost <= 0.f )
+            return 0.f;
+
+        return maps.total * maps.screen.getCost( sample.vp ) / screenCost *
+               maps.range.getCost( range ) / rangeCost;
+    }
+
+private:
+    struct Maps
+    {
+        Maps() : total( 0.f ) {}
+        CostMap screen; //!< screen-space density
+        CostMap range;  //!< database density
+        float total;    //!< frame render time of the destination
+    };
+    typedef std::map< uint32_t, Maps > Destinations; // by destination task
+
+    std::vector< Destinations > _frames;
+};
+
+bool Trace::load( const std::string& filename )
+{
+    struct Task
+    {
+        uint32_t destination;
+        Viewport vp;
+        Range range;
+    };
+    struct Load
+    {
+        Load() : start( std::numeric_limits< int64_t >::max( )), end( 0 ) {}
+        Viewport region;
+        int64_t start;
+        int64_t end;
+    };
+    std::map< uint32_t, std::map< uint32_t, Task > > tasks; // frame, task
+    std::map< uint32_t, std::map< uint32_t, Load > > loads; // frame, task
+
+    std::ifstream file( filename.c_str( ));
+    std::string line;
+    while( std::getline( file, line ))
+    {
+        if( line.compare( 0, 7, "#trace " ) != 0 )
+            continue;
+
+        std::istringstream is( line.substr( 7 ));
+        std::string type;
+        uint32_t frameNumber = 0;
+        is >> type >> frameNumber;
+        if( type == "task" )
+        {
+            uint32_t taskID = 0;
+            Task task;
+            is >> taskID >> task.destination >> task.vp.x >> task.vp.y
+               >> task.vp.w >> task.vp.h >> task.range.start >> task.range.end;
+            if( is )
+                tasks[ frameNumber ][ taskID ] = task;
+        }
+        else if( type == "load" )
+        {
+            Viewport region;
+            size_t nStatistics = 0;
+            is >> region.x >> region.y >> region.w >> region.h >> nStatistics;
+            for( size_t i = 0; i < nStatistics && is; ++i )
+            {
+                int statType = 0;
+                uint32_t taskID = 0;
+                int64_t start = 0;
+                int64_t end = 0;
+                is >> statType >> taskID >> start >> end;
+
+                // same render time as used by the LoadEqualizer
+                switch( statType )
+                {
+                case eq::fabric::Statistic::CHANNEL_CLEAR:
+                case eq::fabric::Statistic::CHANNEL_DRAW:
+                case eq::fabric::Statistic::CHANNEL_READBACK:
+                {
+                    Load& load = loads[ frameNumber ][ taskID ];
+                    load.region = region;
+                    load.start = std::min( load.start, start );
+                    load.end = std::max( load.end, end );
+                    break;
+                }
+                default:
+                    break;
+                }
+            }
+        }
+    }
+
+    // refine the cost maps of each destination over all frames
+    Destinations destinations;
+    for( const auto& frame : tasks )
+    {
+        const auto frameLoads = loads.find( frame.first );
+        if( frameLoads == loads.end( ))
+            continue;
+
+        for( auto& i : destinations )
+            i.second.total = 0.f;
+
+        for( const auto& i : frameLoads->second )
+        {
+            const auto task = frame.second.find( i.first );
+            if( task == frame.second.end( ))
+                continue;
+
+            const Task& data = task->second;
+            const Load& load = i.second;
+            Maps& maps = destinations[ data.destination ];
+            if( maps.screen.getWidth() == 0 )
+            {
+                maps.screen.reset( 64, 64 );
+                maps.range.reset( 256, 1 );
+            }
+
+            Viewport region = data.vp;
+            region.apply( load.region );
+            const Viewport range( data.range.start, 0.f,
+                                  data.range.end - data.range.start, 1.f );
+            const float time = float( std::max( load.end - load.start,
+                                                int64_t( 1 )));
+            maps.screen.update( data.vp, region, time );
+            maps.range.update( range, range, time );
+            maps.total += time;
+        }
+        _frames.push_back( destinations );
+    }
+    return !_frames.empty();
+}
+
+void _writeCSV( std::ostream& os, const Options& options,
+                const std::vector< Result >& results )
+{
+    os << "model,frames,latency,cost,noise,threshold,mean_ms,ideal_ms,"
+       << "converged,imbalance,steady_imbalance,jitter,steady_jitter"
+       << std::endl;
+    for( const Result& result : results )
+        os << modelNames[ result.model ] << ',' << result.frames << ','
+           << options.latency << ',' << options.cost << ',' << options.noise
+           << ',' << options.threshold << ',' << result.meanTime << ','
+           << result.idealTime << ',' << result.converged << ','
+           << result.imbalance << ',' << result.steadyImbalance << ','
+           << result.jitter << ',' << result.steadyJitter << std::endl;
+}
+
+void _writeJSON( std::ostream& os, const Options& options,
+                 const std::vector< Result >& results )
+{
+    os << "{" << std::endl
+       << "  \"config\": \"" << ( options.trace.empty() ? options.config :
+                                                          options.trace )
+       << "\"," << std::endl
+       << "  \"latency\": " << options.latency << "," << std::endl
+       << "  \"cost_ms\": " << options.cost << "," << std::endl
+       << "  \"noise\": " << options.noise << "," << std::endl
+       << "  \"threshold\": " << options.threshold << "," << std::endl
+       << "  \"results\": [" << std::endl;
+    for( size_t i = 0; i < results.size(); ++i )
+    {
+        const Result& result = results[i];
+        os << "    { \"model\": \"" << modelNames[ result.model ]
+           << "\", \"frames\": " << result.frames
+           << ", \"mean_ms\": " << result.meanTime
+           << ", \"ideal_ms\": " << result.idealTime
+           << ", \"converged\": " << result.converged
+           << ", \"imbalance\": " << result.imbalance
+           << ", \"steady_imbalance\": " << result.steadyImbalance
+           << ", \"jitter\": " << result.jitter
+           << ", \"steady_jitter\": " << result.steadyJitter << " }"
+           << ( i + 1 < results.size() ? "," : "" ) << std::endl;
+    }
+    os << "  ]" << std::endl << "}" << std::endl;
+}
+
+eq::server::ServerPtr _loadServer( const std::string& filename )
+{
+    eq::server::Loader loader;
+    eq::server::ServerPtr server = loader.loadFile( filename );
+    if( !server )
+        return server;
+
+    eq::server::Loader::addOutputCompounds( server );
+    eq::server::Loader::addDestinationViews( server );
+    eq::server::Loader::addDefaultObserver( server );
+    eq::server::Loader::convertTo11( server );
+    eq::server::Loader::convertTo12( server );
+    return server;
+}
+
+float _getMovement( const Simulator::Sample& sample, const Viewport& vp,
+                    const Range& range )
+{
+    return std::abs( sample.vp.x - vp.x ) + std::abs( sample.vp.y - vp.y ) +
+           std::abs( sample.vp.w - vp.w ) + std::abs( sample.vp.h - vp.h ) +
+           std::abs( sample.range.start - range.start ) +
+           std::abs( sample.range.end - range.end );
+}
+
+bool _run( const Options& options, const Model model, const Trace& trace,
+           lunchbox::RNG& rng, Result& result )
+{
+    const std::string& filename = model == MODEL_TRACE ? options.trace :
+                                                         options.config;
+    eq::server::ServerPtr server = _loadServer( filename );
+    if( !server || server->getConfigs().empty( ))
+    {
+        std::cerr << "Can't load " << filename << std::endl;
+        return false;
+    }
+
+    const float cost = options.cost;
+    const float noise = options.noise;
+    Simulator::CostFunction function;
+    if( model == MODEL_TRACE )
+        function = [ &trace ]( const Simulator::Sample& sample,
+                               const uint32_t frameNumber )
+            { return trace.getCost( sample, frameNumber ); };
+    else
+        function = [ model, cost ]( const Simulator::Sample& sample,
+                                    const uint32_t frameNumber )
+        {
+            return cost *
+                _integrate( model, sample.vp, frameNumber ) /
+                _integrate( model, Viewport::FULL, frameNumber ) *
+                _integrate( model, sample.range, frameNumber ) /
+                _integrate( model, Range::ALL, frameNumber );
+        };
+
+    eq::server::Config* config = server->getConfigs().front();
+    Simulator simulator( *config, [ &function, &rng, noise ](
+                             const Simulator::Sample& sample,
+                             const uint32_t frameNumber )
+        {
+            const float random = float( rng.get< uint16_t >( )) / 65535.f;
+            return function( sample, frameNumber ) *
+                   ( 1.f + noise * ( 2.f * random - 1.f ));
+        });
+    if( options.latency >= 0 )
+        simulator.setLatency( options.latency );
+
+    typedef std::pair< Viewport, Range > Split;
+    std::map< const eq::server::Compound*, Split > splits;
+    std::vector< float > imbalances;
+    std::vector< float > jitters;
+    double frameTimes = 0.;
+    double idealTimes = 0.;
+    size_t nChannels = 0;
+
+    for( size_t i = 0; i < options.frames; ++i )
+    {
+        const Simulator::Samples& samples = simulator.runFrame();
+
+        // tasks of one channel are rendered sequentially
+        std::map< const eq::server::Channel*, float > channelTimes;
+        float total = 0.f;
+        float movement = 0.f;
+        size_t nMoved = 0;
+        for( const Simulator::Sample& sample : samples )
+        {
+            channelTimes[ sample.compound->getChannel() ] += sample.time;
+            total += sample.time;
+
+            Split& split = splits[ sample.compound ];
+            if( i > 0 )
+            {
+                movement += _getMovement( sample, split.first, split.second );
+                ++nMoved;
+            }
+            split = Split( sample.vp, sample.range );
+        }
+
+        float frameTime = 0.f;
+        for( const auto& channelTime : channelTimes )
+            frameTime = std::max( frameTime, channelTime.second );
+        nChannels = std::max( nChannels, channelTimes.size( ));
+
+        const float idealTime = nChannels > 0 ? total / nChannels : 0.f;
+        frameTimes += frameTime;
+        idealTimes += idealTime;
+        imbalances.push_back( idealTime > 0.f ?
+                              frameTime / idealTime - 1.f : 0.f );
+        if( i > 0 )
+            jitters.push_back( nMoved > 0 ? movement / nMoved : 0.f );
+    }
+
+    const size_t nFrames = imbalances.size();
+    const size_t steady = nFrames / 2;
+    result.model = model;
+    result.frames = nFrames;
+    result.meanTime = float( frameTimes / nFrames );
+    result.idealTime = float( idealTimes / nFrames );
+    result.converged = -1;
+    for( size_t i = nFrames; i > 0 && imbalances[ i - 1 ] <= options.threshold;
+         --i )
+    {
+        result.converged = int64_t( i );
+    }
+
+    const auto mean = []( std::vector< float >::const_iterator begin,
+                          std::vector< float >::const_iterator end )
+    {
+        const size_t n = std::distance( begin, end );
+        return n > 0 ? std::accumulate( begin, end, 0.f ) / n : 0.f;
+    };
+    result.imbalance = mean( imbalances.begin(), imbalances.end( ));
+    result.steadyImbalance = mean( imbalances.begin() + steady,
+                                   imbalances.end( ));
+    result.jitter = mean( jitters.begin(), jitters.end( ));
+    result.steadyJitter = mean( jitters.begin() + std::min( steady,
+                                                            jitters.size( )),
+                                jitters.end( ));
+
+    eq::server::Global::clear();
+    server->deleteConfigs(); // break server <-> config ref circle
+    return true;
+}
+}
+
+int main( int argc, char** argv )
+{
+    Options options;
+    std::vector< std::string > modelArgs;
+    std::string csvFile;
+    std::string jsonFile;
+    float maxImbalance = 0.f;
+    bool showHelp = false;
+
+    po::options_description description(
+        "Usage: equalizerBenchmark [options]\nOptions" );
+    description.add_options()
+        ( "help,h", po::bool_switch( &showHelp )->default_value( false ),
+          "produce help message" )
+        ( "config,c", po::value< std::string >( &options.config ),
+          "config file simulated using the synthetic cost models" )
+        ( "trace,t", po::value< std::string >( &options.trace ),
+          "load trace to replay, recorded using EQ_LOAD_TRACE" )
+        ( "model,m", po::value< std::vector< std::string > >(
+            &modelArgs )->multitoken(),
+          "synthetic cost models: uniform skewed hotspot moving (all)" )
+        ( "frames,f", po::value< size_t >( &options.frames )->default_value(
+            0 ), "number of simulated frames, 0 for 200 or the trace length" )
+        ( "latency,l", po::value< int32_t >(
+            &options.latency )->default_value( -1 ),
+          "load data latency in frames, -1 for the config latency" )
+        ( "cost", po::value< float >( &options.cost )->default_value( 100.f ),
+          "synthetic render time of the full view in ms" )
+        ( "noise,n", po::value< float >( &options.noise )->default_value( 0.f ),
+          "relative random noise on render times, 0 to 1" )
+        ( "threshold", po::value< float >(
+            &options.threshold )->default_value( .05f ),
+          "imbalance below which a frame counts as balanced" )
+        ( "max-imbalance", po::value< float >( &maxImbalance ),
+          "fail if a steady state imbalance exceeds this value" )
+        ( "csv", po::value< std::string >( &csvFile ), "write CSV results" )
+        ( "json", po::value< std::string >( &jsonFile ),
+          "write JSON results" );
+
+    try
+    {
+        po::variables_map variableMap;
+        po::store( po::command_line_parser( argc, argv ).options(
+                       description ).allow_unregistered().run(), variableMap );
+        po::notify( variableMap );
+    }
+    catch( const std::exception& e )
+    {
+        std::cerr << e.what() << std::endl << description << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector< Model > models;
+    if( !options.config.empty( ))
+    {
+        for( size_t i = 0; i < MODEL_TRACE; ++i )
+            if( modelArgs.empty() ||
+                std::find( modelArgs.begin(), modelArgs.end(),
+                           modelNames[i] ) != modelArgs.end( ))
+            {
+                models.push_back( Model( i ));
+            }
+        if( models.size() != ( modelArgs.empty() ? size_t( MODEL_TRACE ) :
+                                                   modelArgs.size( )))
+        {
+            showHelp = true;
+        }
+    }
+    if( !options.trace.empty( ))
+        models.push_back( MODEL_TRACE );
+
+    if( showHelp || models.empty() || options.noise < 0.f ||
+        options.noise > 1.f )
+    {
+        std::cout << description << std::endl;
+        return showHelp ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    if( !eq::server::init( argc, argv ))
+    {
+        std::cerr << "Equalizer server initialization failed" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    Trace trace;
+    if( !options.trace.empty() && !trace.load( options.trace ))
+    {
+        std::cerr << "No load data in trace " << options.trace << std::endl;
+        eq::server::exit();
+        return EXIT_FAILURE;
+    }
+
+    lunchbox::RNG rng;
+    std::vector< Result > results;
+    bool ok = true;
+
+    std::cout << "  MODEL, FRAMES,    MEAN ms,   IDEAL ms, CONVERGED,"
+              << "  IMBALANCE,     STEADY,     JITTER,     STEADY" << std::endl;
+    for( const Model model : models )
+    {
+        Options runOptions = options;
+        if( runOptions.frames == 0 )
+            runOptions.frames = model == MODEL_TRACE ? trace.getNumFrames() :
+                                                       200;
+
+        Result result;
+        if( !_run( runOptions, model, trace, rng, result ))
+        {
+            ok = false;
+            continue;
+        }
+
+        std::cout << std::setw( 7 ) << modelNames[ model ] << ", "
+                  << std::setw( 6 ) << result.frames << ", "
+                  << std::setw( 10 ) << result.meanTime << ", "
+                  << std::setw( 10 ) << result.idealTime << ", "
+                  << std::setw( 9 ) << result.converged << ", "
+                  << std::setw( 10 ) << result.imbalance << ", "
+                  << std::setw( 10 ) << result.steadyImbalance << ", "
+                  << std::setw( 10 ) << result.jitter << ", "
+                  << std::setw( 10 ) << result.steadyJitter << std::endl;
+        results.push_back( result );
+
+        if( maxImbalance > 0.f && result.steadyImbalance > maxImbalance )
+        {
+            std::cerr << modelNames[ model ] << " steady state imbalance "
+                      << result.steadyImbalance << " exceeds " << maxImbalance
+                      << std::endl;
+            ok = false;
+        }
+    }
+
+    if( !csvFile.empty( ))
+    {
+        std::ofstream csv( csvFile.c_str( ));
+        _writeCSV( csv, options, results );
+        ok = ok && csv.good();
+    }
+    if( !jsonFile.empty( ))
+    {
+        std::ofstream json( jsonFile.c_str( ));
+        _writeJSON( json, options, results );
+        ok = ok && json.good();
+    }
+
+    eq::server::exit();
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
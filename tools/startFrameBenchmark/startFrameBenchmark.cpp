@@ -0,0 +1,300 @@
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Benchmarks the server-side cost of starting a frame against the number of
+// channels. A wall config with one root compound per segment is generated for
+// each channel count and each frame is started like a running config does,
+// with all node tasks sent to a local render client which discards them.
+// Optionally, each segment is load-balanced with a neighbour channel of the
+// same node. The compound and node updates run on the OpenMP worker threads,
+// use OMP_NUM_THREADS to compare against a serial update.
+
+#include <eq/server/compound.h>
+#include <eq/server/config.h>
+#include <eq/server/global.h>
+#include <eq/server/init.h>
+#include <eq/server/loader.h>
+#include <eq/server/server.h>
+#include <eq/server/simulator.h>
+
+#include <co/connectionDescription.h>
+#include <co/iCommand.h>
+#include <co/localNode.h>
+#include <lunchbox/clock.h>
+
+#pragma warning( disable: 4275 )
+#include <boost/program_options.hpp>
+#pragma warning( default: 4275 )
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace po = boost::program_options;
+
+using eq::server::Simulator;
+
+namespace
+{
+struct Options
+{
+    size_t channelsPerNode;
+    size_t frames;
+    bool loadBalance;
+};
+
+/** A render client which discards all received tasks. */
+class Sink : public co::LocalNode
+{
+public:
+    bool dispatchCommand( co::ICommand& command ) override
+    {
+        if( command.getType() == co::COMMANDTYPE_OBJECT )
+            return true;
+        return co::LocalNode::dispatchCommand( command );
+    }
+};
+
+bool _listen( co::LocalNode& node )
+{
+    co::ConnectionDescriptionPtr desc = new co::ConnectionDescription;
+    desc->type = co::CONNECTIONTYPE_TCPIP;
+    desc->setHostname( "127.0.0.1" );
+    node.addConnectionDescription( desc );
+    return node.listen();
+}
+
+size_t _getNumNodes( const size_t nChannels, const size_t channelsPerNode )
+{
+    return ( nChannels + channelsPerNode - 1 ) / channelsPerNode;
+}
+
+// the neighbour channel on the same node, or nChannels if there is none
+size_t _getPartner( const size_t channel, const size_t nChannels,
+                    const size_t channelsPerNode )
+{
+    const size_t partner = channel ^ 1;
+    if( partner >= nChannels ||
+        partner / channelsPerNode != channel / channelsPerNode )
+    {
+        return nChannels;
+    }
+    return partner;
+}
+
+std::string _createConfig( const size_t nChannels, const Options& options )
+{
+    const size_t nNodes = _getNumNodes( nChannels, options.channelsPerNode );
+    const size_t nColumns =
+        size_t( std::ceil( std::sqrt( double( nChannels ))));
+    const size_t nRows = ( nChannels + nColumns - 1 ) / nColumns;
+
+    std::ostringstream os;
+    os << "#Equalizer 1.1 ascii" << std::endl
+       << "server" << std::endl << "{" << std::endl
+       << "config" << std::endl << "{" << std::endl;
+
+    for( size_t node = 0; node < nNodes; ++node )
+    {
+        os << ( node == 0 ? "appNode" : "node" ) << std::endl
+           << "{" << std::endl;
+        const size_t end = std::min( nChannels,
+                                     ( node + 1 ) * options.channelsPerNode );
+        for( size_t i = node * options.channelsPerNode; i < end; ++i )
+            os << "pipe { window { viewport [ 0 0 1920 1200 ] "
+               << "channel { name \"channel" << i << "\" }}}" << std::endl;
+        os << "}" << std::endl;
+    }
+
+    os << "observer {}" << std::endl
+       << "layout { view { observer 0 }}" << std::endl
+       << "canvas" << std::endl << "{" << std::endl
+       << "layout 0" << std::endl
+       << "wall { bottom_left [ -1 -1 -1 ] bottom_right [ 1 -1 -1 ] "
+       << "top_left [ -1 1 -1 ] }" << std::endl;
+    for( size_t i = 0; i < nChannels; ++i )
+        os << "segment { channel \"channel" << i << "\" viewport [ "
+           << float( i % nColumns ) / float( nColumns ) << " "
+           << float( i / nColumns ) / float( nRows ) << " "
+           << 1.f / float( nColumns ) << " " << 1.f / float( nRows )
+           << " ] }" << std::endl;
+    os << "}" << std::endl;
+
+    for( size_t i = 0; i < nChannels; ++i )
+    {
+        os << "compound" << std::endl << "{" << std::endl
+           << "channel ( segment " << i << " view 0 )" << std::endl;
+
+        const size_t partner = _getPartner( i, nChannels,
+                                            options.channelsPerNode );
+        if( options.loadBalance && partner < nChannels )
+            os << "load_equalizer {}" << std::endl
+               << "compound {}" << std::endl
+               << "compound { channel \"channel" << partner
+               << "\" outputframe {}}" << std::endl
+               << "inputframe { name \"frame.channel" << partner << "\" }"
+               << std::endl;
+        os << "swapbarrier {}" << std::endl << "}" << std::endl;
+    }
+
+    os << "}" << std::endl << "}" << std::endl;
+    return os.str();
+}
+
+eq::server::ServerPtr _loadServer( const std::string& config )
+{
+    eq::server::Loader loader;
+    eq::server::ServerPtr server = loader.parseServer( config.c_str( ));
+    if( !server )
+        return server;
+
+    eq::server::Loader::addOutputCompounds( server );
+    eq::server::Loader::addDestinationViews( server );
+    eq::server::Loader::addDefaultObserver( server );
+    eq::server::Loader::convertTo11( server );
+    eq::server::Loader::convertTo12( server );
+    return server;
+}
+
+bool _run( const size_t nChannels, const Options& options )
+{
+    eq::server::ServerPtr server =
+        _loadServer( _createConfig( nChannels, options ));
+    if( !server || server->getConfigs().empty( ))
+    {
+        std::cerr << "Can't create config with " << nChannels << " channels"
+                  << std::endl;
+        return false;
+    }
+
+    // the render client of all nodes
+    co::LocalNodePtr sink = new Sink;
+    co::NodePtr netNode = new co::Node;
+    bool ok = _listen( *server ) && _listen( *sink );
+    if( ok )
+    {
+        for( co::ConnectionDescriptionPtr desc :
+                 sink->getConnectionDescriptions( ))
+        {
+            netNode->addConnectionDescription( desc );
+        }
+        ok = server->connect( netNode );
+    }
+
+    eq::server::Config* config = server->getConfigs().front();
+    const size_t nCompounds = config->getCompounds().size();
+    if( ok )
+    {
+        Simulator simulator( *config, []( const Simulator::Sample& sample,
+                                          const uint32_t )
+            { return 10.f * sample.vp.getArea() * sample.range.getSize(); });
+        simulator.setNetNode( netNode );
+
+        // let the equalizers settle and the allocations stabilize
+        const size_t warmup = std::max( options.frames / 10, size_t( 1 ));
+        for( size_t i = 0; i < warmup; ++i )
+            simulator.runFrame();
+
+        lunchbox::Clock clock;
+        for( size_t i = 0; i < options.frames; ++i )
+            simulator.runFrame();
+        const double time = clock.getTimed() / double( options.frames );
+
+        std::cout << std::setw( 8 ) << nChannels << ", "
+                  << std::setw( 5 )
+                  << _getNumNodes( nChannels, options.channelsPerNode ) << ", "
+                  << std::setw( 9 ) << nCompounds << ", "
+                  << std::setw( 10 ) << time << ", "
+                  << std::setw( 14 ) << time * 1000. / double( nChannels )
+                  << std::endl;
+    }
+    else
+        std::cerr << "Can't connect the local render client" << std::endl;
+
+    server->close();
+    sink->close();
+
+    eq::server::Global::clear();
+    server->deleteConfigs(); // break server <-> config ref circle
+    return ok;
+}
+}
+
+int main( int argc, char** argv )
+{
+    Options options;
+    std::vector< size_t > channels;
+    bool showHelp = false;
+
+    po::options_description description(
+        "Usage: startFrameBenchmark [options]\nOptions" );
+    description.add_options()
+        ( "help,h", po::bool_switch( &showHelp )->default_value( false ),
+          "produce help message" )
+        ( "channels,c", po::value< std::vector< size_t > >(
+            &channels )->multitoken(),
+          "channel counts to benchmark (4 8 16 32 64 128 160)" )
+        ( "channels-per-node,n", po::value< size_t >(
+            &options.channelsPerNode )->default_value( 4 ),
+          "number of channels of each node" )
+        ( "frames,f", po::value< size_t >( &options.frames )->default_value(
+            100 ), "number of measured frames" )
+        ( "load-balance,l", po::bool_switch(
+            &options.loadBalance )->default_value( false ),
+          "load-balance each segment with a neighbour channel" );
+
+    try
+    {
+        po::variables_map variableMap;
+        po::store( po::command_line_parser( argc, argv ).options(
+                       description ).allow_unregistered().run(), variableMap );
+        po::notify( variableMap );
+    }
+    catch( const std::exception& e )
+    {
+        std::cerr << e.what() << std::endl << description << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if( channels.empty( ))
+        channels = { 4, 8, 16, 32, 64, 128, 160 };
+
+    if( showHelp || options.channelsPerNode == 0 || options.frames == 0 ||
+        std::find( channels.begin(), channels.end(), 0 ) != channels.end( ))
+    {
+        std::cout << description << std::endl;
+        return showHelp ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    if( !eq::server::init( argc, argv ))
+    {
+        std::cerr << "Equalizer server initialization failed" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    bool ok = true;
+    std::cout << "CHANNELS, NODES, COMPOUNDS,   FRAME ms, PER CHANNEL us"
+              << std::endl;
+    for( const size_t nChannels : channels )
+        ok = _run( nChannels, options ) && ok;
+
+    eq::server::exit();
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}